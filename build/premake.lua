@@ -1,15 +1,25 @@
 local FRM_ROOT = "../extern/GfxSampleFramework/"
-dofile(FRM_ROOT .. "build/GfxSampleFramework_premake.lua")
+if os.istarget("windows") then
+	dofile(FRM_ROOT .. "build/GfxSampleFramework_premake.lua")
+end
 
 workspace "GfxSamples"
 	location(_ACTION)
-	platforms { "Win64" }
 	language "C++"
-	cppdialect "C++11"
+	cppdialect "C++14"
+	if os.istarget("windows") then
+		platforms { "Win64" }
+	else
+		platforms { "Linux64" }
+	end
 	filter { "platforms:Win64" }
 		system "windows"
 		architecture "x86_64"
 	filter {}
+	filter { "platforms:Linux64" }
+		system "linux"
+		architecture "x86_64"
+	filter {}
 
 	rtti "Off"
 	exceptionhandling "Off"
@@ -25,46 +35,101 @@ workspace "GfxSamples"
 		symbols "Off"
 		optimize "Full"
 	filter {}
-	
+
+ -- the samples depend on the framework (Windows only), the convolution library and command line tools build everywhere
+	if os.istarget("windows") then
+		group "libs"
+			GfxSampleFramework_Project(
+				FRM_ROOT,
+				FRM_ROOT .. "lib",
+				"../bin"
+				)
+		group ""
+
+	 -- symlink to common sample data in bin/sample_common (bin/common already points to GfxSampleFramework/data/common)
+		local projDir = "$(ProjectDir)..\\..\\"
+		local dataDir = projDir .. "data\\"
+		local binDir  = projDir .. "bin\\"
+		filter { "action:vs*" }
+			postbuildcommands({
+				"if not exist \"" .. binDir .. "sample_common\" mklink /j \"" .. binDir .. "sample_common\" \"" .. dataDir .. "common\"",
+				})
+		filter{}
+
+	 -- additional libs per project
+		local projLibs =
+		{
+			Convolution = { "ConvolutionLib" },
+		}
+
+	 -- create projects
+		local projList = dofile("projects.lua")
+		for name,fileList in pairs(projList) do
+			project(tostring(name))
+				kind "ConsoleApp"
+				targetdir "../bin"
+					GfxSampleFramework_Link()
+
+					vpaths({ ["*"] = { "../src/" .. tostring(name) .. "/**" } })
+					files(fileList)
+					files("../src/_sample.cpp")
+					includedirs("../src")
+					links(projLibs[tostring(name)] or {})
+
+					local projDataDir = dataDir .. tostring(name)
+					local projBinDir  = binDir  .. tostring(name)
+					filter { "action:vs*" }
+						postbuildcommands({
+						  -- make the project data dir
+							"if not exist " .. projDataDir .. " mkdir \"" .. projDataDir .. "\"",
+
+						  -- make link to project data dir in bin
+							"if not exist " .. projBinDir .. " mklink /j \"" .. projBinDir .. "\" \"" .. projDataDir .. "\"",
+							})
+					filter {}
+		end
+	end
+
 	group "libs"
-		GfxSampleFramework_Project(
-			FRM_ROOT,
-			FRM_ROOT .. "lib",
-			"../bin"
-			)
+		project "ConvolutionLib"
+			kind "StaticLib"
+			targetdir "../lib"
+			vpaths({ ["*"] = { "../src/ConvolutionLib/**" } })
+			files("../src/ConvolutionLib/**")
+			includedirs("../src")
 	group ""
 
- -- symlink to common sample data in bin/sample_common (bin/common already points to GfxSampleFramework/data/common)
-	local projDir = "$(ProjectDir)..\\..\\"
-	local dataDir = projDir .. "data\\"
-	local binDir  = projDir .. "bin\\"
-	filter { "action:vs*" }
-		postbuildcommands({
-			"if not exist \"" .. binDir .. "sample_common\" mklink /j \"" .. binDir .. "sample_common\" \"" .. dataDir .. "common\"",
-			})
-	filter{}
-
- -- create projects
-	local projList = dofile("projects.lua")
-	for name,fileList in pairs(projList) do
-		project(tostring(name))
+	group "tools"
+		project "ConvolutionBench"
 			kind "ConsoleApp"
 			targetdir "../bin"
-				GfxSampleFramework_Link()
+			vpaths({ ["*"] = { "../src/ConvolutionBench/**" } })
+			files("../src/ConvolutionBench/**")
+			includedirs("../src")
+			links { "ConvolutionLib" }
+			filter { "system:linux" }
+				links { "pthread" }
+			filter {}
 
-				vpaths({ ["*"] = { "../src/" .. tostring(name) .. "/**" } })
-				files(fileList)
-				files("../src/_sample.cpp")
-
-				local projDataDir = dataDir .. tostring(name)
-				local projBinDir  = binDir  .. tostring(name)
-				filter { "action:vs*" }
-					postbuildcommands({
-					  -- make the project data dir
-						"if not exist " .. projDataDir .. " mkdir \"" .. projDataDir .. "\"",
+		project "ConvolutionCli"
+			kind "ConsoleApp"
+			targetdir "../bin"
+			vpaths({ ["*"] = { "../src/ConvolutionCli/**" } })
+			files("../src/ConvolutionCli/**")
+			includedirs("../src")
+			links { "ConvolutionLib" }
+			filter { "system:linux" }
+				links { "pthread" }
+			filter {}
 
-					  -- make link to project data dir in bin
-						"if not exist " .. projBinDir .. " mklink /j \"" .. projBinDir .. "\" \"" .. projDataDir .. "\"",
-						})
-				filter {}
-	end
+		project "ConvolutionTest"
+			kind "ConsoleApp"
+			targetdir "../bin"
+			vpaths({ ["*"] = { "../src/ConvolutionTest/**", "../src/ConvolutionBench/Bench.*" } })
+			files({ "../src/ConvolutionTest/**", "../src/ConvolutionBench/Bench.h", "../src/ConvolutionBench/Bench.cpp" }) -- shares the test images with ConvolutionBench
+			includedirs("../src")
+			links { "ConvolutionLib" }
+			filter { "system:linux" }
+				links { "pthread" }
+			filter {}
+	group ""
@@ -7,6 +7,11 @@
 #define Mode_Separable          2
 #define Mode_SeparableBilinear  3
 #define Mode_Prefilter          4
+#define Mode_BoxRunningSum      5 // CPU only
+#define Mode_RecursiveGaussian  6 // CPU only
+#define Mode_IteratedBox        7 // CPU only
+#define Mode_Pyramid            8
+#define Mode_2dLarge            9 // CPU only
 
 #ifndef TYPE
 	#error TYPE not defined
@@ -16,4 +21,12 @@
 #endif
 #ifndef KERNEL_SIZE
 	#error KERNEL_SIZE not defined
-#endif
\ No newline at end of file
+#endif
+
+// All kernels are packed into a single buffer (see KernelBank), uWeightsBase/uOffsetsBase locate the current kernel.
+layout(std430) restrict readonly buffer bfKernelBank
+{
+	float uKernelBank[];
+};
+uniform int uWeightsBase;
+uniform int uOffsetsBase;
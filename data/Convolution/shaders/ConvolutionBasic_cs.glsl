@@ -5,23 +5,12 @@ uniform sampler2D txSrc;
 uniform writeonly image2D txDst;
 
 #if (MODE == Mode_2d || MODE == Mode_2dBilinear)
-	#define OffsetType vec2
-	#define GetOffset(_iuv, _i) (_iuv + uOffsets[_i])
+	#define GetOffset(_iuv, _i) (_iuv + vec2(uKernelBank[uOffsetsBase + (_i) * 2], uKernelBank[uOffsetsBase + (_i) * 2 + 1]))
 #else
-	#define OffsetType float
 	uniform vec2 uDirection;
-	#define GetOffset(_iuv, _i) (_iuv + vec2(uOffsets[_i]) * uDirection)
+	#define GetOffset(_iuv, _i) (_iuv + vec2(uKernelBank[uOffsetsBase + (_i)]) * uDirection)
 #endif
-#define GetWeight(_i) (uWeights[_i])
-
-layout(std430) restrict readonly buffer bfWeights
-{
-	float uWeights[];
-};
-layout(std430) restrict readonly buffer bfOffsets
-{
-	OffsetType uOffsets[];
-};
+#define GetWeight(_i) (uKernelBank[uWeightsBase + (_i)])
 
 void main()
 {
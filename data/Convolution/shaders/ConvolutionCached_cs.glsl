@@ -15,11 +15,7 @@
 uniform sampler2D txSrc;
 uniform writeonly image2D txDst;
 
-layout(std430) restrict readonly buffer bfWeights
-{
-	float uWeights[];
-};
-#define GetWeight(_i) (uWeights[_i])
+#define GetWeight(_i) (uKernelBank[uWeightsBase + (_i)])
 #define GetOffset(_i) (_i - KERNEL_SIZE / 2)
 
 #if PACK_TEXEL_CACHE
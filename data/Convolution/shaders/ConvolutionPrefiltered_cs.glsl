@@ -5,12 +5,37 @@
 
 #define ROTATE_KERNEL 1  // Randomly rotate the sampling kernel per pixel
 
+#ifndef SAMPLE_TABLES
+	#define SAMPLE_TABLES 0 // Optimized point sets + blue noise rotation texture (conv::SamplePatternSet)
+#endif
+#ifndef TEMPORAL
+	#define TEMPORAL 0      // Blend into txHistory (conv::PrefilterAccumulator)
+#endif
+
 uniform sampler2D txSrc;
 uniform writeonly image2D txDst;
 
+#if SAMPLE_TABLES
+ // point sets for 1..64 samples packed in order of sample count, the set for N samples starts at N * (N - 1) / 2
+	layout(std430) restrict readonly buffer bfSamplePatterns
+	{
+		vec2 uSamplePatterns[];
+	};
+	uniform sampler2D txRotation; // tiled, RG = (cos, sin) * 0.5 + 0.5
+#endif
+
+#if TEMPORAL
+	uniform sampler2D txHistory;                        // previous frame's result
+	uniform writeonly image2D txHistoryOut;
+	uniform float uHistoryAlpha;                        // weight of the current frame, 1 after a reset
+#endif
+
 uniform float uRadius;
 uniform float uLod;
 uniform int   uSampleCount;
+uniform int   uSampleBegin;      // this frame's slice of the pattern, see conv::GetPrefilterFrame()
+uniform int   uFrameSampleCount; // = uSampleCount if not TEMPORAL
+uniform vec2  uFrameRotation;    // (cos, sin)
 
 void main()
 {
@@ -23,7 +48,14 @@ void main()
 	vec2 texelSize = 1.0 / vec2(txSize);
 	vec2 uv  = iuv * texelSize;
 
-	#if ROTATE_KERNEL
+	#if SAMPLE_TABLES
+		vec2 cosSin = texelFetch(txRotation, ivec2(gl_GlobalInvocationID.xy) % textureSize(txRotation, 0), 0).xy * 2.0 - 1.0;
+		mat2 rotation = mat2(
+			 cosSin.x, cosSin.y,
+			-cosSin.y, cosSin.x
+			);
+		uint patternBase = uint(uSampleCount * (uSampleCount - 1) / 2);
+	#elif ROTATE_KERNEL
 		float theta =
 			#if 1
 				Noise_InterleavedGradient(iuv);
@@ -39,17 +71,32 @@ void main()
 			);
 	#endif 
 
+	mat2 frameRotation = mat2(
+		 uFrameRotation.x, uFrameRotation.y,
+		-uFrameRotation.y, uFrameRotation.x
+		);
+
 	vec4 ret = vec4(0.0);
 	float rn = 1.0 / float(uSampleCount);
-	for (uint i = 0; i < uSampleCount; ++i)
+	for (uint j = 0; j < uFrameSampleCount; ++j)
 	{
-		vec2 offset = Sampling_Hammersley2d(i, rn) * 2.0 - 1.0;
-		#if ROTATE_KERNEL
-			offset = rotation * offset;
+		uint i = (uSampleBegin + j) % uint(uSampleCount);
+		#if SAMPLE_TABLES
+			vec2 offset = rotation * (frameRotation * uSamplePatterns[patternBase + i]);
+		#else
+			vec2 offset = frameRotation * (Sampling_Hammersley2d(i, rn) * 2.0 - 1.0);
+			#if ROTATE_KERNEL
+				offset = rotation * offset;
+			#endif
 		#endif
 		ret += textureLod(txSrc, uv + offset * uRadius * texelSize, uLod);
 	}
-	ret = ret * rn;
+	ret = ret / float(uFrameSampleCount);
+
+	#if TEMPORAL
+		ret = mix(texelFetch(txHistory, ivec2(gl_GlobalInvocationID.xy), 0), ret, uHistoryAlpha);
+		imageStore(txHistoryOut, ivec2(gl_GlobalInvocationID.xy), ret);
+	#endif
 
 	imageStore(txDst, ivec2(gl_GlobalInvocationID.xy), ret);
 }
@@ -0,0 +1,49 @@
+#include "shaders/def.glsl"
+
+// Dual filter pyramid blur pass (Mode_Pyramid), UPSAMPLE selects the pass. Tap offsets are in source texels and must
+// match ConvolutionLib/Pyramid.cpp (the CPU reference).
+
+#ifndef UPSAMPLE
+	#error UPSAMPLE not defined
+#endif
+
+uniform sampler2D txSrc;
+uniform writeonly image2D txDst;
+
+uniform int uSrcLevel;
+
+void main()
+{
+	ivec2 txSize = ivec2(imageSize(txDst).xy);
+	if (any(greaterThanEqual(gl_GlobalInvocationID.xy, txSize))) 
+	{
+		return;
+	}
+	vec2 uv = (vec2(gl_GlobalInvocationID.xy) + 0.5) / vec2(txSize);
+	vec2 texelSize = 1.0 / vec2(textureSize(txSrc, uSrcLevel));
+	float lod = float(uSrcLevel);
+
+	vec4 ret = vec4(0.0);
+	#if UPSAMPLE
+	 // 8 tap tent
+		ret += textureLod(txSrc, uv + vec2(-1.0,  0.0) * texelSize, lod);
+		ret += textureLod(txSrc, uv + vec2( 1.0,  0.0) * texelSize, lod);
+		ret += textureLod(txSrc, uv + vec2( 0.0, -1.0) * texelSize, lod);
+		ret += textureLod(txSrc, uv + vec2( 0.0,  1.0) * texelSize, lod);
+		ret += textureLod(txSrc, uv + vec2(-0.5, -0.5) * texelSize, lod) * 2.0;
+		ret += textureLod(txSrc, uv + vec2( 0.5, -0.5) * texelSize, lod) * 2.0;
+		ret += textureLod(txSrc, uv + vec2(-0.5,  0.5) * texelSize, lod) * 2.0;
+		ret += textureLod(txSrc, uv + vec2( 0.5,  0.5) * texelSize, lod) * 2.0;
+		ret /= 12.0;
+	#else
+	 // 5 tap, the center tap is the average of the 4 source texels under the destination texel
+		ret += textureLod(txSrc, uv, lod) * 4.0;
+		ret += textureLod(txSrc, uv + vec2(-1.0, -1.0) * texelSize, lod);
+		ret += textureLod(txSrc, uv + vec2( 1.0, -1.0) * texelSize, lod);
+		ret += textureLod(txSrc, uv + vec2(-1.0,  1.0) * texelSize, lod);
+		ret += textureLod(txSrc, uv + vec2( 1.0,  1.0) * texelSize, lod);
+		ret /= 8.0;
+	#endif
+
+	imageStore(txDst, ivec2(gl_GlobalInvocationID.xy), ret);
+}
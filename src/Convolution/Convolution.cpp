@@ -13,241 +13,11 @@
 #include <frm/core/Texture.h>
 #include <frm/core/Window.h>
 
-using namespace frm;
-
-namespace {
-
-#define GAUSSIAN_USE_INTEGRATION 1
-
-inline float GaussianDistribution(float _d, float _sigma, float _sigma2)
-{
-	float d = (_d * _d) / (2.0f * _sigma2);
-	return 1.0f / (kTwoPi * _sigma2) * exp(-d);
-}
-
-// Evaluate GaussianDistribution() over the interval [_mind,_maxd] via trapezoidal integration.
-float GaussianIntegration(float _mind, float _maxd, float _sigma, float _sigma2, int _sampleCount = 64)
-{
-	const float w = 1.0f / (float)(_sampleCount - 1);
-	const float stepd = (_maxd - _mind) * w;
-	float ret = GaussianDistribution(_mind, _sigma, _sigma2);
-	float d = _mind + stepd;
-	for (int i = 1; i < _sampleCount - 1; ++i) 
-	{
-		ret += GaussianDistribution(d, _sigma, _sigma2) * 2.0f;
-		d += stepd;
-	}
-	ret += GaussianDistribution(d, _sigma, _sigma2);
-	return ret * stepd / 2.0f;
-}
-
-float KernelGaussian1d(int _size, float _sigma, float* weights_, bool _normalize = true)
-{
-	_size = _size | 1; // force _size to be odd
-
- // generate
-	const float sigma2 = _sigma * _sigma;
-	const int n = _size / 2;
-	float sum = 0.0f;
-	for (int i = 0; i < _size; ++i) 
-	{
-		float d = (float)(i - n);
-		#if GAUSSIAN_USE_INTEGRATION
-			weights_[i] = GaussianIntegration(d - 0.5f, d + 0.5f, _sigma, sigma2);
-		#else
-			weights_[i] = GaussianDistribution(d, _sigma, sigma2);
-		#endif
-		sum += weights_[i];
-	}
-
- // normalize
-	if (_normalize) 
-	{
-		for (int i = 0; i < _size; ++i) 
-		{
-			weights_[i] /= sum;
-		}
-	}
-	return sum;
-}
-
-float KernelGaussian2d(int _size, float _sigma, float* weights_, bool _normalize = true)
-{
-	_size = _size | 1; // force _size to be odd
-
- // generate first row
-	float sum = KernelGaussian1d(_size, _sigma, weights_, false); // not normalized because we overwrite the first row later
-	sum *= sum;	
-
- // derive subsequent rows from the first
-	for (int i = 1; i < _size; ++i) 
-	{
-		for (int j = 0; j < _size; ++j) 
-		{
-			int k = i * _size + j;
-			weights_[k] = (weights_[i] * weights_[j]) / (_normalize ? sum : 1.0f);
-		}
-	}
-
- // copy the first row from the last
-	for (int i = 0; i < _size; ++i) 
-	{
-		weights_[i] = weights_[(_size - 1) * _size + i];
-	}
-	return sum;
-}
-
-// Find sigma such that no weights are < _epsilon. Epsilon should be the smallest representable for the precision of the signal to be convolved e.g. 1/255 for 8-bit.
-float GaussianFindSigma(int _size, float _epsilon)
-{
-	float* tmp = FRM_NEW_ARRAY(float, _size);
-	const float d = (float)(-_size / 2);
-	float sigma = 1.0f;
-	float stp = 1.0f;
-	while (stp > 0.01f) 
-	{
-		KernelGaussian1d(_size, sigma, tmp);
-		float w = tmp[0];
-		if (w > _epsilon) 
-		{
-			sigma -= stp;
-			stp *= 0.5f;
-		}
-		sigma += stp;
-	}
-	FRM_DELETE_ARRAY(tmp);
-	return sigma;
-}
-
-float KernelBinomial1d(int _size, float* weights_, bool _normalize = true)
-{
-	_size = _size | 1; // force _size to be odd
-
- // generate (Pascal's triangle)
-	weights_[0] = 1.0f;
-	float sum = 1.0f;
-	for (int i = 1; i < _size; ++i) 
-	{
-		weights_[i] = weights_[i - 1] * (float)(_size - i) / (float)i;
-		sum += weights_[i];
-	}
-
- // normalize
-	if (_normalize) 
-	{
-		for (int i = 0; i < _size; ++i) 
-		{
-			weights_[i] /= sum;
-		}
-	}
-	return sum;
-}
-
-float KernelBinomial2d(int _size, float* weights_, bool _normalize = true)
-{
-	_size = _size | 1; // force _size to be odd
+#include <ConvolutionLib/Kernel.h>
 
- // generate first row
-	float sum = KernelBinomial1d(_size, weights_, false); // not normalized because we overwrite the first row later
-	sum *= sum;	
-
- // derive subsequent rows from the first
-	for (int i = 1; i < _size; ++i) 
-	{
-		for (int j = 0; j < _size; ++j) 
-		{
-			int k = i * _size + j;
-			weights_[k] = (weights_[i] * weights_[j]) / (_normalize ? sum : 1.0f);
-		}
-	}
-
- // copy the first row from the last
-	for (int i = 0; i < _size; ++i) 
-	{
-		weights_[i] = weights_[(_size - 1) * _size + i];
-	}
-	return sum;
-}
-
-// Outputs are arrays of _size / 2 + 1.
-void KernelOptimizeBilinear1d(int _size, const float* _weightsIn, float* weightsOut_, float* offsetsOut_)
-{
-	const int halfSize = _size / 2;
-	int j = 0;
-	for (int i = 0; i != _size - 1; i += 2, ++j) 
-	{
-		float w1 = _weightsIn[i];
-		float w2 = _weightsIn[i + 1];
-		float w3 = w1 + w2;
-		float o1 = (float)(i - halfSize);
-		float o2 = (float)(i - halfSize + 1);
-		float o3 = (o1 * w1 + o2 * w2) / w3;
-		weightsOut_[j] = w3;
-		offsetsOut_[j] = o3;
-	}
-	weightsOut_[j] = _weightsIn[_size - 1];
-	offsetsOut_[j] = (float)(_size - 1 - halfSize);
-}
-
-// Outputs are arrays of (_size / 2 + 1) ^ 2.
-void KernelOptimizeBilinear2d(int _size, const float* _weightsIn, float* weightsOut_, vec2* offsetsOut_)
-{
-	const int outSize = _size / 2 + 1;
-	const int halfSize = _size / 2;
-	int row, col;
-	for (row = 0; row < _size - 1; row += 2) 
-	{
-		for (col = 0; col < _size - 1; col += 2) 
-		{
-			float w1 = _weightsIn[(row * _size) + col];
-			float w2 = _weightsIn[(row * _size) + col + 1];
-			float w3 = _weightsIn[((row + 1) * _size) + col];
-			float w4 = _weightsIn[((row + 1) * _size) + col + 1];
-			float w5 = w1 + w2 + w3 + w4;
-			float x1 = (float)(col - halfSize);
-			float x2 = (float)(col - halfSize + 1);
-			float x3 = (x1 * w1 + x2 * w2) / (w1 + w2);
-			float y1 = (float)(row - halfSize);
-			float y2 = (float)(row - halfSize + 1);
-			float y3 = (y1 * w1 + y2 * w3) / (w1 + w3);
-
-			const int k = (row / 2) * outSize + (col / 2);
-			weightsOut_[k] = w5;
-			offsetsOut_[k] = vec2(x3, y3);
-		}
+#include <cstring>
 
-		float w1 = _weightsIn[(row * _size) + col];
-		float w2 = _weightsIn[((row + 1) * _size) + col];
-		float w3 = w1 + w2;
-		float y1 = (float)(row - halfSize);
-		float y2 = (float)(row - halfSize + 1);
-		float y3 = (y1 * w1 + y2 * w2) / w3;
-	
-		const int k = (row / 2) * outSize + (col / 2);
-		weightsOut_[k] = w3;
-		offsetsOut_[k] = vec2((float)(col - halfSize), y3);
-	}
-
-	for (col = 0; col < _size - 1; col += 2) 
-	{
-		float w1 = _weightsIn[(row * _size) + col];
-		float w2 = _weightsIn[(row * _size) + col + 1];
-		float w3 = w1 + w2;
-		float x1 = (float)(col - halfSize);
-		float x2 = (float)(col - halfSize + 1);
-		float x3 = (x1 * w1 + x2 * w2) / w3;
-
-		const int k = (row / 2) * outSize + (col / 2);
-		weightsOut_[k] = w3;
-		offsetsOut_[k] = vec2(x3, (float)(row - halfSize));
-	}
-
-	const int k = (row / 2) * outSize + (col / 2);
-	weightsOut_[k] = _weightsIn[(row * _size) + col];
-	offsetsOut_[k] = vec2(_size / 2.0f);	
-}
-
-} // namespace
+using namespace frm;
 
 static Convolution s_inst;
 
@@ -259,11 +29,25 @@ Convolution::Convolution()
 		Properties::Add("m_kernelType",            m_kernelType,               0,            Type_Count     &m_kernelType);
 		Properties::Add("m_kernelMode",            m_kernelMode,               0,            Mode_Count     &m_kernelMode);
 		Properties::Add("m_kernelWidth",           m_kernelWidth,              1,            21,            &m_kernelWidth);
-		Properties::Add("m_gaussianSigma",         m_gaussianSigma,            0.0f,         4.0f,          &m_gaussianSigma);
-		Properties::Add("m_prefilterLodBias",      m_prefilterLodBias,         0.0f,         2.0f,          &m_prefilterLodBias);
-		Properties::Add("m_prefilterSampleCount",  m_prefilterSampleCount,     2,            64,            &m_prefilterSampleCount);
+		Properties::Add("m_gaussianSigma",         m_gaussianSigma,            0.0f,         64.0f,         &m_gaussianSigma);
+		Properties::Add("m_prefilterLodBias",      m_prefilterLodBias,         -1.0f,        2.0f,          &m_prefilterLodBias);
+		Properties::Add("m_prefilterSampleCount",  m_prefilterSampleCount,     1,            conv::SamplePatternSet::kMaxSampleCount, &m_prefilterSampleCount);
 		Properties::Add("m_prefilterBlurWidth",    m_prefilterBlurWidth,       0,            64,            &m_prefilterBlurWidth);
+		Properties::Add("m_prefilterAuto",         m_prefilterAuto,                                         &m_prefilterAuto);
+		Properties::Add("m_prefilterSampleTables", m_prefilterSampleTables,                                 &m_prefilterSampleTables);
+		Properties::Add("m_prefilterTemporal",     m_prefilterTemporal,                                     &m_prefilterTemporal);
+		Properties::Add("m_prefilterFrameSampleCount", m_prefilterFrameSampleCount, 1,            64,            &m_prefilterFrameSampleCount);
+		Properties::Add("m_prefilterMinAlpha",     m_prefilterMinAlpha,        0.0f,         1.0f,          &m_prefilterMinAlpha);
+		Properties::Add("m_boxWidth",              m_boxWidth,                 1,            1023,          &m_boxWidth);
+		Properties::Add("m_boxPassCount",          m_boxPassCount,             3,            5,             &m_boxPassCount);
+		Properties::Add("m_pyramidLevelCount",     m_pyramidLevelCount,        1,            8,             &m_pyramidLevelCount);
+		Properties::Add("m_largeWidth",            m_largeWidth,               3,            127,           &m_largeWidth);
+		Properties::Add("m_largeShape",            m_largeShape,               0,            2,             &m_largeShape);
+		Properties::Add("m_largeTolerance",        m_largeTolerance,           1e-5f,        1e-1f,         &m_largeTolerance);
 		Properties::Add("m_cached",                m_cached,                                                &m_cached);
+		Properties::Add("m_cpu",                   m_cpu,                                                   &m_cpu);
+		Properties::Add("m_cpuFixedPoint",         m_cpuFixedPoint,                                         &m_cpuFixedPoint);
+		Properties::Add("m_skipUnchanged",         m_skipUnchanged,                                         &m_skipUnchanged);
 		Properties::Add("m_showKernel",            m_showKernel,                                            &m_showKernel);
 	Properties::PopGroup();
 }
@@ -283,6 +67,18 @@ bool Convolution::init(const ArgList& _args)
 	m_txSrc = Texture::Create("textures/baboon.png");
 	m_txSrc->setWrap(GL_CLAMP_TO_EDGE);
 	m_txSrc->generateMipmap(); // alloc mip chain for Mode_Prefilter
+
+ // CPU copy of the source for the CPU path
+	m_cpuSrc.init(m_txSrc->getWidth(), m_txSrc->getHeight(), conv::Format_RGBA8);
+	glAssert(glGetTextureImage(m_txSrc->getHandle(), 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)m_cpuSrc.getSize(), m_cpuSrc.getData()));
+	++m_srcVersion;
+	m_cpuDst[0].init(m_cpuSrc.getWidth(), m_cpuSrc.getHeight(), conv::Format_RGBA8);
+	m_cpuDst[1].init(m_cpuSrc.getWidth(), m_cpuSrc.getHeight(), conv::Format_RGBA8);
+	m_cpuThreadPool = new conv::ThreadPool();
+
+ // Mode_Prefilter auto tuning table, relative to bin/ as per the shader search paths below
+	m_prefilterTableCount = conv::ReadPrefilterTable("Convolution/PrefilterTable.json", m_prefilterTable, FRM_ARRAY_COUNT(m_prefilterTable));
+	m_prefilterAuto &= m_prefilterTableCount > 0;
 	
 	for (uint i = 0; i < FRM_ARRAY_COUNT(m_txDst); ++i) 
 	{
@@ -293,7 +89,55 @@ bool Convolution::init(const ArgList& _args)
 	m_txDstView = TextureView(m_txDst[0]);
 
 	m_shPrefilter = Shader::CreateCs("shaders/Prefilter_cs.glsl", 8, 8);
-	m_shConvolutionPrefiltered = Shader::CreateCs("shaders/ConvolutionPrefiltered_cs.glsl", 8, 8);
+	for (int i = 0; i < 2; ++i)
+	{
+		for (int j = 0; j < 2; ++j)
+		{
+			ShaderDesc shDesc;
+			shDesc.setPath(GL_COMPUTE_SHADER, "shaders/ConvolutionPrefiltered_cs.glsl");
+			shDesc.setLocalSize(8, 8);
+			shDesc.addDefine(GL_COMPUTE_SHADER, "SAMPLE_TABLES", i);
+			shDesc.addDefine(GL_COMPUTE_SHADER, "TEMPORAL", j);
+			m_shConvolutionPrefiltered[i][j] = Shader::Create(shDesc);
+		}
+	}
+	for (int i = 0; i < 2; ++i)
+	{
+		ShaderDesc shDesc;
+		shDesc.setPath(GL_COMPUTE_SHADER, "shaders/DualFilter_cs.glsl");
+		shDesc.setLocalSize(8, 8);
+		shDesc.addDefine(GL_COMPUTE_SHADER, "UPSAMPLE", i);
+		m_shDualFilter[i] = Shader::Create(shDesc);
+	}
+
+ // Mode_Prefilter sample tables take ~1s to generate, build them on a worker and upload them once ready (see update())
+	m_samplePatternsThread = std::thread([this]()
+		{
+			m_samplePatterns.init();
+			m_samplePatternsReady = true;
+		});
+	for (int i = 0; i < 2; ++i)
+	{
+		m_txPrefilterHistory[i] = Texture::Create2d(m_txSrc->getWidth(), m_txSrc->getHeight(), GL_RGBA16F);
+		m_txPrefilterHistory[i]->setNamef("txPrefilterHistory[%d]", i);
+	}
+
+ // kernel shader permutations, search paths as per the frm file system roots (relative to bin/)
+	m_shaderPreprocessor.addSearchPath("Convolution");
+	m_shaderPreprocessor.addSearchPath("sample_common");
+	m_shaderPreprocessor.addSearchPath("common");
+	m_shaderCache.init(&m_shaderPreprocessor, "ShaderCache");
+
+ // kernels are built on a worker, wait for the first build
+	m_kernelBuilder.init(&Convolution::BuildKernel);
+	requestKernel();
+	m_kernelBuilder.wait();
+	m_kernelBuilder.acquire();
+
+ // all kernels are generated up front and uploaded as a single buffer, initKernel() only selects a range
+	const conv::KernelBank& kernelBank = m_kernelBuilder.getFront().m_kernelBank;
+	m_bfKernelBank = Buffer::Create(GL_SHADER_STORAGE_BUFFER, (GLint)kernelBank.getArenaSize(), GL_DYNAMIC_STORAGE_BIT, kernelBank.getArena());
+	m_bfKernelBank->setName("bfKernelBank");
 
 	initKernel();
 
@@ -302,14 +146,45 @@ bool Convolution::init(const ArgList& _args)
 
 void Convolution::shutdown()
 {
-	shutdownKernel();
+	m_kernelBuilder.shutdown();
+	if (m_samplePatternsThread.joinable())
+	{
+		m_samplePatternsThread.join();
+	}
+	for (auto& it : m_shaderPermutations)
+	{
+		Shader::Release(it.second);
+	}
+	m_shaderPermutations.clear();
+	m_shaderCache.shutdown();
+
+	Buffer::Destroy(m_bfKernelBank);
+	if (m_bfSamplePatterns)
+	{
+		Buffer::Destroy(m_bfSamplePatterns);
+		Texture::Release(m_txRotation);
+	}
 
 	Shader::Release(m_shPrefilter);
+	for (int i = 0; i < 2; ++i)
+	{
+		Shader::Release(m_shConvolutionPrefiltered[i][0]);
+		Shader::Release(m_shConvolutionPrefiltered[i][1]);
+		Texture::Release(m_txPrefilterHistory[i]);
+	}
+	Shader::Release(m_shDualFilter[0]);
+	Shader::Release(m_shDualFilter[1]);
 
 	Texture::Release(m_txDst[0]);
 	Texture::Release(m_txDst[1]);
 	Texture::Release(m_txSrc);
 
+	m_cpuSrc.shutdown();
+	m_cpuDst[0].shutdown();
+	m_cpuDst[1].shutdown();
+	delete m_cpuThreadPool;
+	m_cpuThreadPool = nullptr;
+
 	AppBase::shutdown();
 }
 
@@ -320,6 +195,32 @@ bool Convolution::update()
 		return false;
 	}
 
+ // swap in the latest kernel build, if any
+	if (m_kernelBuilder.acquire())
+	{
+		if (m_kernelBuilder.getFrontParams().m_measureCostModel)
+		{
+			m_largeCostModel        = m_kernelBuilder.getFront().m_largeCostModel;
+			m_largeCostModelPending = false;
+		}
+		initKernel();
+	}
+ // upload the sample tables once the worker is done, 'Sample Tables' falls back to Hammersley + IGN until then
+	if (!m_bfSamplePatterns && m_samplePatternsReady)
+	{
+		m_samplePatternsThread.join();
+		m_bfSamplePatterns = Buffer::Create(GL_SHADER_STORAGE_BUFFER, (GLint)m_samplePatterns.getDataSize(), 0, m_samplePatterns.getData());
+		m_bfSamplePatterns->setName("bfSamplePatterns");
+		const conv::Image& rotation = m_samplePatterns.getRotationTexture();
+		m_txRotation = Texture::Create2d(rotation.getWidth(), rotation.getHeight(), GL_RGBA8);
+		m_txRotation->setName("txRotation");
+		glAssert(glTextureSubImage2D(m_txRotation->getHandle(), 0, 0, 0, rotation.getWidth(), rotation.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, rotation.getData()));
+	}
+
+ // the graph/stats describe the front kernel, the UI state may be ahead of it
+	const KernelParams& params = m_kernelBuilder.getFrontParams();
+	KernelState&        kernel = m_kernelBuilder.getFront();
+
 	bool reinitKernel = false;
 
 	const vec2 borderSize   = vec2(32.0f);
@@ -350,14 +251,125 @@ bool Convolution::update()
 			"Seperable\0"
 			"Seperable Bilinear\0"
 			"Prefilter\0"
+			"Box (Running Sum)\0"
+			"Gaussian (Recursive)\0"
+			"Gaussian (Iterated Box)\0"
+			"Pyramid\0"
+			"2d Large (Direct/Separable/FFT)\0"
 			);
+		ImGui::Checkbox("Skip Unchanged", &m_skipUnchanged);
+		ImGui::SameLine();
+		ImGui::Text("Recomputes/s: %.0f, Reuses/s: %.0f", m_convolutionDirty.getRecomputeRate(), m_convolutionDirty.getReuseRate());
 		
-		if (m_kernelMode == Mode_Prefilter)
+		if (m_kernelMode == Mode_BoxRunningSum)
+		{
+			ImGui::SliderInt("Box Width", &m_boxWidth, 1, 1023);
+			m_boxWidth |= 1;
+		}
+		else if (m_kernelMode == Mode_RecursiveGaussian || m_kernelMode == Mode_IteratedBox)
+		{
+			reinitKernel |= ImGui::SliderFloat("Sigma", &m_gaussianSigma, 0.5f, 64.0f);
+			if (m_kernelMode == Mode_IteratedBox)
+			{
+				reinitKernel |= ImGui::SliderInt("Passes", &m_boxPassCount, 3, 5);
+				ImGui::Text("Box Widths: %d %d %d %d %d", kernel.m_boxPassWidths[0], kernel.m_boxPassWidths[1], kernel.m_boxPassWidths[2], kernel.m_boxPassWidths[3], kernel.m_boxPassWidths[4]);
+				ImGui::Text("Max Error: %f", kernel.m_boxPassMaxError);
+			}
+		}
+		else if (m_kernelMode == Mode_Pyramid)
+		{
+			ImGui::SliderInt("Levels", &m_pyramidLevelCount, 1, 8);
+			ImGui::Checkbox("CPU", &m_cpu);
+		}
+		else if (m_kernelMode == Mode_2dLarge)
+		{
+			bool reinitLarge = false;
+			reinitLarge |= ImGui::Combo("Type", &m_kernelType,
+				"Box\0"
+				"Gaussian\0"
+				"Binomial\0"
+				);
+			reinitLarge |= ImGui::Combo("Shape", &m_largeShape,
+				"Type\0"
+				"Disc\0"
+				"File\0"
+				);
+			if (m_largeShape == 2)
+			{
+				reinitLarge |= ImGui::InputText("Path", m_largePath, sizeof(m_largePath), ImGuiInputTextFlags_EnterReturnsTrue);
+				if (kernel.m_largeLoadFailed)
+				{
+					ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "Load failed, expected an odd square number of weights");
+				}
+			}
+			else
+			{
+				reinitLarge |= ImGui::SliderInt("Size", &m_largeWidth, 3, 127);
+			}
+			if (m_kernelType == Type_Gaussian && m_largeShape == 0)
+			{
+				reinitLarge |= ImGui::SliderFloat("Sigma", &m_gaussianSigma, 0.5f, 64.0f);
+			}
+			reinitLarge |= ImGui::SliderFloat("Tolerance", &m_largeTolerance, 1e-5f, 1e-1f, "%.5f", 4.0f);
+			reinitLarge |= ImGui::Combo("Method", &m_largeMethod,
+				"Direct\0"
+				"Separable\0"
+				"FFT\0"
+				"Auto\0"
+				);
+			if (m_largeCostModelPending)
+			{
+				ImGui::Text("Measuring Cost Model...");
+			}
+			else if (ImGui::Button("Measure Cost Model"))
+			{
+				m_largeCostModelPending = true;
+				reinitLarge = true;
+			}
+			if (reinitLarge)
+			{
+				requestKernel();
+			}
+			for (int method = 0; method < conv::Convolve2dMethod_Count; ++method)
+			{
+				const double cost = kernel.m_cpuConvolver2d.getCost(method);
+				ImGui::Text("%s %-10s %8.2fms (est.)", method == kernel.m_cpuConvolver2d.getMethod() ? ">" : " ", conv::GetConvolve2dMethodName(method), cost < 0.0 ? 0.0 : cost / 1e6);
+			}
+			ImGui::Text("Rank: %d (error %f)", kernel.m_cpuConvolver2d.getLowRankKernel().getRank(), kernel.m_cpuConvolver2d.getLowRankKernel().getError());
+		}
+		else if (m_kernelMode == Mode_Prefilter)
 		{
 			
 			ImGui::SliderInt("Blur Width", &m_prefilterBlurWidth, 0, 64);
-			ImGui::SliderFloat("LOD Bias", &m_prefilterLodBias, 0.0f, 2.0f);
-			ImGui::SliderInt("Sample Count", &m_prefilterSampleCount, 1, 16);
+			if (m_prefilterTableCount > 0)
+			{
+				ImGui::Checkbox("Auto", &m_prefilterAuto);
+			}
+			const conv::PrefilterSetting* setting = m_prefilterAuto ? conv::FindPrefilterSetting(m_prefilterTable, m_prefilterTableCount, m_prefilterBlurWidth) : nullptr;
+			if (setting)
+			{
+				m_prefilterLodBias     = setting->m_lodBias;
+				m_prefilterSampleCount = setting->m_sampleCount;
+				ImGui::Text("LOD Bias: %.2f, Sample Count: %d (%.1fdB at width %d)", m_prefilterLodBias, m_prefilterSampleCount, setting->m_psnr, setting->m_blurWidth);
+			}
+			else
+			{
+				ImGui::SliderFloat("LOD Bias", &m_prefilterLodBias, -1.0f, 2.0f);
+				ImGui::SliderInt("Sample Count", &m_prefilterSampleCount, 1, conv::SamplePatternSet::kMaxSampleCount);
+			}
+			ImGui::Checkbox("Sample Tables", &m_prefilterSampleTables);
+			if (m_prefilterSampleTables && !m_bfSamplePatterns)
+			{
+				ImGui::SameLine();
+				ImGui::Text("(generating...)");
+			}
+			ImGui::Checkbox("Temporal", &m_prefilterTemporal);
+			if (m_prefilterTemporal)
+			{
+				ImGui::SliderInt("Samples/Frame", &m_prefilterFrameSampleCount, 1, m_prefilterSampleCount);
+				ImGui::SliderFloat("Min Alpha", &m_prefilterMinAlpha, 0.0f, 1.0f);
+				ImGui::Text("Frame: %d", m_prefilterFrame);
+			}
 		}
 		else
 		{
@@ -368,16 +380,33 @@ bool Convolution::update()
 				"Binomial\0"
 				);
 
-			if (m_kernelMode == Mode_Separable)
+			if (m_kernelMode == Mode_2d || m_kernelMode == Mode_Separable || m_kernelMode == Mode_SeparableBilinear)
+			{
+				reinitKernel |= ImGui::Checkbox("CPU", &m_cpu);
+			}
+			if ((m_kernelMode == Mode_Separable || m_kernelMode == Mode_SeparableBilinear) && m_cpu)
+			{
+				ImGui::Checkbox("Fixed Point", &m_cpuFixedPoint);
+			}
+			if (m_kernelMode == Mode_2d && m_cpu)
+			{
+				ImGui::Text("Method: %s (rank %d)", conv::GetConvolve2dMethodName(kernel.m_cpuConvolver2d.getMethod()), kernel.m_cpuConvolver2d.getLowRankKernel().getRank());
+			}
+			if (m_kernelMode == Mode_2dBilinear)
+			{
+				reinitKernel |= ImGui::SliderFloat("Max Error", &m_bilinearMaxError, 0.0f, 0.05f, "%.4f");
+				ImGui::Text("Taps: %d/%d (error %.2e)", kernel.m_kernelSize, params.m_width * params.m_width, kernel.m_bilinearError);
+			}
+			if (m_kernelMode == Mode_Separable && !m_cpu)
 			{
 				ImGui::Checkbox("Cache Texture Reads", &m_cached);
 				if (m_cached)
 				{
-					auto localSize = m_shConvolutionCached[0]->getLocalSize();
-					if (ImGui::InputInt2("Shader Local Size", &localSize.x))
+					if (ImGui::InputInt2("Shader Local Size", m_cachedLocalSize))
 					{
-						m_shConvolutionCached[0]->setLocalSize(localSize.x, localSize.y, localSize.z);
-						m_shConvolutionCached[1]->setLocalSize(localSize.x, localSize.y, localSize.z);
+						m_cachedLocalSize[0] = Max(m_cachedLocalSize[0], 1);
+						m_cachedLocalSize[1] = Max(m_cachedLocalSize[1], 1);
+						reinitKernel = true;
 					}
 				}
 			}
@@ -385,16 +414,16 @@ bool Convolution::update()
 			if (m_kernelType == Type_Gaussian) 
 			{
 				reinitKernel |= ImGui::SliderFloat("Sigma", &m_gaussianSigma, 1.0f, 8.0f);
-				ImGui::Text("Optimal Sigma: %f", m_gaussianSigmaOptimal);
+				ImGui::Text("Optimal Sigma: %f", kernel.m_gaussianSigmaOptimal);
 			}
 		}
 
 		if (reinitKernel) 
 		{
-			initKernel();
+			requestKernel();
 		}
 
-		if (m_kernelMode != Mode_Prefilter)
+		if (params.m_mode < Mode_Prefilter)
 		{
 			ImDrawList* drawList = ImGui::GetWindowDrawList();
 			vec2 graphBeg = vec2(ImGui::GetCursorPos()) + vec2(ImGui::GetWindowPos());
@@ -405,23 +434,23 @@ bool Convolution::update()
 			ImGui::PushClipRect(graphBeg, graphEnd, true);
 			
 			float weightsScale = 0.0f;
-			for (int i = 0; i < m_kernelWidth; ++i) 
+			for (int i = 0; i < params.m_width; ++i) 
 			{
-				weightsScale = FRM_MAX(weightsScale, m_displayWeights[i]);
+				weightsScale = FRM_MAX(weightsScale, kernel.m_displayWeights[i]);
 			}
 			weightsScale = weightsScale * 1.1f;
 
 		 // sample weights
-			for (int i = 0; i < m_kernelWidth; ++i)
+			for (int i = 0; i < params.m_width; ++i)
 			{
-				float x0 = floor(graphBeg.x + (float)i / (float)m_kernelWidth * grapkernelHalfWidth.x);
-				float x1 = floor(graphBeg.x + (float)(i + 1) / (float)m_kernelWidth * grapkernelHalfWidth.x);
-				float y = (1.0f - m_displayWeights[i] / weightsScale) * grapkernelHalfWidth.y;
+				float x0 = floor(graphBeg.x + (float)i / (float)params.m_width * grapkernelHalfWidth.x);
+				float x1 = floor(graphBeg.x + (float)(i + 1) / (float)params.m_width * grapkernelHalfWidth.x);
+				float y = (1.0f - kernel.m_displayWeights[i] / weightsScale) * grapkernelHalfWidth.y;
 				drawList->AddRectFilled(vec2(x0, graphEnd.y), vec2(x1, graphBeg.y + y), IM_COLOR_ALPHA(IM_COL32_WHITE, 0.2f));
 			}
 
 		 // gaussian function
-			if (m_kernelType == Type_Gaussian) 
+			if (params.m_type == Type_Gaussian) 
 			{
 
 				const int directSampleCount = (int)grapkernelHalfWidth.x / 4;
@@ -430,8 +459,8 @@ bool Convolution::update()
 				{
 					vec2 p;
 					p.x = (float)i / (float)directSampleCount;
-					float d = p.x * (float)m_kernelWidth - (float)m_kernelWidth * 0.5f;
-					p.y = GaussianDistribution(d, m_gaussianSigma, m_gaussianSigma * m_gaussianSigma) / m_kernelSum / weightsScale;
+					float d = p.x * (float)params.m_width - (float)params.m_width * 0.5f;
+					p.y = conv::GaussianDistribution(d, params.m_gaussianSigma, params.m_gaussianSigma * params.m_gaussianSigma) / kernel.m_kernelSum / weightsScale;
 					p.x = graphBeg.x + p.x * grapkernelHalfWidth.x;
 					p.y = graphEnd.y - p.y * grapkernelHalfWidth.y;
 					drawList->AddLine(q, p, IM_COL32(255, 200, 11, 255), 3.0f);
@@ -440,9 +469,9 @@ bool Convolution::update()
 			}
 
 		 // texel boundaries
-			for (int i = 1; i < m_kernelWidth; ++i) 
+			for (int i = 1; i < params.m_width; ++i) 
 			{
-				float x = floor(graphBeg.x + (float)i / (float)m_kernelWidth * grapkernelHalfWidth.x);
+				float x = floor(graphBeg.x + (float)i / (float)params.m_width * grapkernelHalfWidth.x);
 				drawList->AddLine(vec2(x, graphBeg.y), vec2(x, graphEnd.y), ImColor(0.5f, 0.5f, 0.5f));
 			}
 			drawList->AddRect(graphBeg, graphEnd, ImColor(0.5f, 0.5f, 0.5f));
@@ -471,21 +500,139 @@ bool Convolution::update()
 void Convolution::draw()
 {
 	GlContext* ctx = GlContext::GetCurrent();
-
-	bool is2d = m_kernelMode == Mode_2d || m_kernelMode == Mode_2dBilinear;
+	const KernelParams& params = m_kernelBuilder.getFrontParams(); // the front kernel's, the UI state may be ahead
+	KernelState&        kernel = m_kernelBuilder.getFront();
+
+	bool is2d = params.m_mode == Mode_2d || params.m_mode == Mode_2dBilinear;
+
+ // skip the convolution if none of its inputs changed since the last frame, m_txDst[0] still holds the result (the
+ // kernel version covers everything in KernelParams, temporal accumulation changes the result every frame)
+	m_convolutionDirty.add(m_srcVersion);
+	m_convolutionDirty.add(m_kernelVersion);
+	m_convolutionDirty.add(m_cpu);
+	m_convolutionDirty.add(m_cpuFixedPoint);
+	m_convolutionDirty.add(m_cached);
+	m_convolutionDirty.add(m_boxWidth);
+	m_convolutionDirty.add(m_pyramidLevelCount);
+	m_convolutionDirty.add(m_prefilterBlurWidth);
+	m_convolutionDirty.add(m_prefilterLodBias);
+	m_convolutionDirty.add(m_prefilterSampleCount);
+	m_convolutionDirty.add(m_prefilterSampleTables && m_bfSamplePatterns);
+	m_convolutionDirty.add(m_prefilterTemporal);
+	const bool temporal = params.m_mode == Mode_Prefilter && m_prefilterTemporal;
+	if (!temporal)
+	{
+	 // the history is only valid while consecutive frames accumulate, e.g. switching to another mode and back restarts
+		m_prefilterFrame = 0;
+	}
+	if (!m_convolutionDirty.update(temporal || !m_skipUnchanged))
+	{
+		AppBase::draw();
+		return;
+	}
 	
 	{	PROFILER_MARKER("Convolution");
 
-		if (m_kernelMode == Mode_Separable && m_cached)
+		if (m_cpu && (params.m_mode == Mode_Separable || params.m_mode == Mode_SeparableBilinear))
+		{
+			{	PROFILER_MARKER_CPU("CPU");
+				if (m_cpuFixedPoint)
+				{
+					conv::ConvolveSeparableFixed(*m_cpuThreadPool, m_cpuSrc, m_cpuDst[0], m_cpuDst[1], kernel.m_cpuKernelFixed);
+				}
+				else
+				{
+					conv::ConvolveSeparable(*m_cpuThreadPool, m_cpuSrc, m_cpuDst[0], m_cpuDst[1], kernel.m_cpuKernel);
+				}
+			}
+			uploadCpuDst();
+		}
+		else if (params.m_mode == Mode_BoxRunningSum)
+		{
+			{	PROFILER_MARKER_CPU("CPU");
+				conv::BoxFilter(*m_cpuThreadPool, m_cpuSrc, m_cpuDst[0], m_cpuDst[1], m_boxWidth);
+			}
+			uploadCpuDst();
+		}
+		else if (params.m_mode == Mode_RecursiveGaussian)
+		{
+			{	PROFILER_MARKER_CPU("CPU");
+				conv::RecursiveGaussian(*m_cpuThreadPool, m_cpuSrc, m_cpuDst[0], m_cpuDst[1], kernel.m_cpuRecursiveKernel);
+			}
+			uploadCpuDst();
+		}
+		else if (params.m_mode == Mode_IteratedBox)
+		{
+			{	PROFILER_MARKER_CPU("CPU");
+				conv::BoxFilter(*m_cpuThreadPool, m_cpuSrc, m_cpuDst[0], m_cpuDst[1], kernel.m_boxPassWidths, params.m_boxPassCount);
+			}
+			uploadCpuDst();
+		}
+		else if (params.m_mode == Mode_2dLarge || (params.m_mode == Mode_2d && m_cpu))
+		{
+			{	PROFILER_MARKER_CPU("CPU");
+				kernel.m_cpuConvolver2d.convolve(*m_cpuThreadPool, m_cpuSrc, m_cpuDst[0], m_cpuDst[1]);
+			}
+			uploadCpuDst();
+		}
+		else if (params.m_mode == Mode_Pyramid && m_cpu)
+		{
+			{	PROFILER_MARKER_CPU("CPU");
+				m_cpuPyramid.blur(*m_cpuThreadPool, m_cpuSrc, m_cpuDst[0], m_pyramidLevelCount);
+			}
+			uploadCpuDst();
+		}
+		else if (params.m_mode == Mode_Pyramid)
+		{
+		 // downsample m_txSrc into levels [1, N] of m_txDst[1], upsample back up through the levels of m_txDst[0]
+			const int levelCount = Clamp(m_pyramidLevelCount, 1, (int)m_txDst[0]->getMipCount() - 1);
+			m_txDst[0]->setMinFilter(GL_LINEAR_MIPMAP_NEAREST); // no filtering between mips
+			m_txDst[1]->setMinFilter(GL_LINEAR_MIPMAP_NEAREST);
+			m_txDst[1]->setMipRange(0, levelCount);
+			auto dispatch = [&](Shader* _sh, Texture* _txSrc, int _srcLevel, Texture* _txDst, int _dstLevel)
+				{
+					ivec2 localSize = _sh->getLocalSize().xy();
+					ctx->setShader  (_sh);
+					ctx->clearTextureBindings();
+					ctx->clearImageBindings();
+					ctx->setUniform ("uSrcLevel", _srcLevel);
+					ctx->bindTexture("txSrc", _txSrc);
+					ctx->bindImage  ("txDst", _txDst, GL_WRITE_ONLY, _dstLevel);
+					int w = Max((int)_txDst->getWidth()  >> _dstLevel, 1);
+					int h = Max((int)_txDst->getHeight() >> _dstLevel, 1);
+					ctx->dispatch(
+						Max((w + localSize.x - 1) / localSize.x, 1),
+						Max((h + localSize.y - 1) / localSize.y, 1)
+						);
+					glAssert(glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT));
+				};
+			{	PROFILER_MARKER("Downsample");
+				for (int level = 1; level <= levelCount; ++level)
+				{
+					dispatch(m_shDualFilter[0], level == 1 ? m_txSrc : m_txDst[1], level == 1 ? 0 : level - 1, m_txDst[1], level);
+				}
+			}
+			{	PROFILER_MARKER("Upsample");
+				for (int level = levelCount - 1; level >= 0; --level)
+				{
+					dispatch(m_shDualFilter[1], level == levelCount - 1 ? m_txDst[1] : m_txDst[0], level + 1, m_txDst[0], level);
+				}
+			}
+			m_txDst[0]->setMinFilter(GL_LINEAR_MIPMAP_LINEAR);
+			m_txDst[1]->setMinFilter(GL_LINEAR_MIPMAP_LINEAR);
+		}
+		else if (params.m_mode == Mode_Separable && m_cached)
 		{
 			ctx->setShader  (m_shConvolutionCached[0]);
-			ctx->bindBuffer (m_bfWeights);
+			ctx->bindBuffer (m_bfKernelBank);
+			ctx->setUniform ("uWeightsBase", (int)kernel.m_kernel->m_weights.m_offset);
 			ctx->bindTexture("txSrc", m_txSrc);
 			ctx->bindImage  ("txDst", m_txDst[1], GL_WRITE_ONLY);
 			ctx->dispatch   (m_txDst[1]);
 			glAssert(glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT));
 			ctx->setShader  (m_shConvolutionCached[1]);
-			ctx->bindBuffer (m_bfWeights);
+			ctx->bindBuffer (m_bfKernelBank);
+			ctx->setUniform ("uWeightsBase", (int)kernel.m_kernel->m_weights.m_offset);
 			ctx->bindTexture("txSrc", m_txDst[1]);
 			ctx->bindImage  ("txDst", m_txDst[0], GL_WRITE_ONLY);
 
@@ -498,12 +645,10 @@ void Convolution::draw()
 				FRM_MAX((txSize.y + localSize.y - 1) / localSize.y, 1)
 				);
 		}
-		else if (m_kernelMode == Mode_Prefilter)
+		else if (params.m_mode == Mode_Prefilter)
 		{
 			float radius = m_prefilterBlurWidth * 0.5f;
-			float area   = kPi * (radius * radius);
-				  area   = area / (float)m_prefilterSampleCount; // area per sample
-			float lod    = log2(sqrt(area)) + m_prefilterLodBias; // select mip level with similar area to the sample
+			float lod    = conv::GetPrefilterLod(radius, m_prefilterSampleCount, m_prefilterLodBias); // select mip level with similar area to the sample
 			int   maxLod = Clamp((int)ceil(lod) + 1, 0, (int)m_txDst[0]->getMipCount() - 1);
 		 // \todo can't downsample directly on m_txSrc?
 			{	PROFILER_MARKER("Prefilter");
@@ -533,10 +678,44 @@ void Convolution::draw()
 			}
 			{	PROFILER_MARKER("Blur");
 
-				ctx->setShader  (m_shConvolutionPrefiltered);
+			 // temporal: reset the history if any of the inputs changed (m_prefilterFrame is also reset by frames which don't
+ // accumulate, see above)
+				const int frameSampleCount = m_prefilterTemporal ? Clamp(m_prefilterFrameSampleCount, 1, m_prefilterSampleCount) : m_prefilterSampleCount;
+				const bool  sampleTables = m_prefilterSampleTables && m_bfSamplePatterns; // see update()
+				const float historyKey[] = { radius, lod, (float)m_prefilterSampleCount, (float)frameSampleCount, sampleTables ? 1.0f : 0.0f };
+				static_assert(sizeof(historyKey) == sizeof(m_prefilterHistoryKey), "m_prefilterHistoryKey size mismatch");
+				if (!m_prefilterTemporal || memcmp(historyKey, m_prefilterHistoryKey, sizeof(historyKey)) != 0)
+				{
+					memcpy(m_prefilterHistoryKey, historyKey, sizeof(historyKey));
+					m_prefilterFrame = 0;
+				}
+				int   sampleBegin = 0;
+				vec2  frameRotation = vec2(1.0f, 0.0f);
+				if (m_prefilterTemporal)
+				{
+					conv::GetPrefilterFrame(m_prefilterFrame, m_prefilterSampleCount, frameSampleCount, &sampleBegin, &frameRotation.x);
+				}
+
+				ctx->setShader  (m_shConvolutionPrefiltered[sampleTables ? 1 : 0][m_prefilterTemporal ? 1 : 0]);
 				ctx->setUniform ("uRadius", radius);
 				ctx->setUniform ("uLod", lod);
 				ctx->setUniform ("uSampleCount", m_prefilterSampleCount);
+				ctx->setUniform ("uSampleBegin", sampleBegin);
+				ctx->setUniform ("uFrameSampleCount", frameSampleCount);
+				ctx->setUniform ("uFrameRotation", frameRotation);
+				if (sampleTables)
+				{
+					ctx->bindBuffer (m_bfSamplePatterns);
+					ctx->bindTexture("txRotation", m_txRotation);
+				}
+				if (m_prefilterTemporal)
+				{
+				 // as conv::PrefilterAccumulator, the first frame after a reset overwrites the history
+					++m_prefilterFrame;
+					ctx->setUniform ("uHistoryAlpha", Max(1.0f / (float)m_prefilterFrame, m_prefilterMinAlpha));
+					ctx->bindTexture("txHistory", m_txPrefilterHistory[m_prefilterFrame & 1]);
+					ctx->bindImage  ("txHistoryOut", m_txPrefilterHistory[(m_prefilterFrame + 1) & 1], GL_WRITE_ONLY);
+				}
 				ctx->bindTexture("txSrc", m_txDst[1]);
 				ctx->bindImage  ("txDst", m_txDst[0], GL_WRITE_ONLY);
 				ctx->dispatch   (m_txDst[0]);
@@ -545,8 +724,9 @@ void Convolution::draw()
 		else
 		{
 			ctx->setShader (m_shConvolutionBasic);
-			ctx->bindBuffer(m_bfOffsets);
-			ctx->bindBuffer(m_bfWeights);
+			ctx->bindBuffer(m_bfKernelBank);
+			ctx->setUniform("uWeightsBase", (int)kernel.m_kernel->m_weights.m_offset);
+			ctx->setUniform("uOffsetsBase", (int)kernel.m_kernel->m_offsets.m_offset);
 
 			if (is2d) 
 			{
@@ -576,164 +756,209 @@ void Convolution::draw()
 	AppBase::draw();
 }
 
-void Convolution::initKernel()
+void Convolution::requestKernel()
 {
-	shutdownKernel();
+	m_kernelWidth  = Clamp(m_kernelWidth | 1, conv::KernelBank::kMinWidth, conv::KernelBank::kMaxWidth);
+	m_boxPassCount = Clamp(m_boxPassCount, 3, 5);
+	m_largeWidth   = Clamp(m_largeWidth | 1, 3, 127);
+
+	KernelParams params;
+	params.m_type             = m_kernelType;
+	params.m_mode             = m_kernelMode;
+	params.m_width            = m_kernelWidth;
+	params.m_gaussianSigma    = m_gaussianSigma;
+	params.m_bilinearMaxError = m_bilinearMaxError;
+	params.m_boxPassCount     = m_boxPassCount;
+	params.m_largeWidth       = m_largeWidth;
+	params.m_largeMethod      = m_largeMethod;
+	params.m_largeShape       = m_largeShape;
+	params.m_largeTolerance   = m_largeTolerance;
+	params.m_largeCostModel   = m_largeCostModel;
+	params.m_measureCostModel = m_largeCostModelPending;
+	params.m_srcWidth         = m_cpuSrc.getWidth();
+	params.m_srcHeight        = m_cpuSrc.getHeight();
+	strncpy(params.m_largePath, m_largePath, sizeof(params.m_largePath) - 1);
+	m_kernelBuilder.request(params);
+}
 
-	initOffsets();
-	initWeights();
+void Convolution::BuildKernel(const KernelParams& _params, KernelState& kernel_)
+{
+	static_assert((int)Type_Count == (int)conv::KernelType_Count && (int)Mode_Prefilter == (int)conv::KernelMode_Count, "Type/Mode must match conv::KernelType/KernelMode");
 
- // buffers
-	const bool is2d = m_kernelMode == Mode_2d || m_kernelMode == Mode_2dBilinear;
-	m_bfWeights = Buffer::Create(GL_SHADER_STORAGE_BUFFER, sizeof(float) * m_kernelSize, 0, m_weights);
-	m_bfWeights->setName("bfWeights");
-	m_bfOffsets = Buffer::Create(GL_SHADER_STORAGE_BUFFER, sizeof(float) * m_kernelSize * (is2d ? 2 : 1), 0, m_offsets); // offsets are vec2 for a 2d kernel
-	m_bfOffsets->setName("bfOffsets");
-	
- // shaders
-	ShaderDesc shDesc;
-	shDesc.setPath(GL_COMPUTE_SHADER, "shaders/ConvolutionBasic_cs.glsl");
-	shDesc.setLocalSize(8, 8);
-	shDesc.addDefine(GL_COMPUTE_SHADER, "TYPE", m_kernelType);
-	shDesc.addDefine(GL_COMPUTE_SHADER, "MODE", m_kernelMode);
-	shDesc.addDefine(GL_COMPUTE_SHADER, "KERNEL_SIZE", m_kernelSize);
-	m_shConvolutionBasic = Shader::Create(shDesc);
-
-	shDesc.setPath(GL_COMPUTE_SHADER, "shaders/ConvolutionCached_cs.glsl");
-	shDesc.setLocalSize(64, 1); // local X must be *at least* the kernel radius to have enough threads to fill the cache 
-	shDesc.addDefine(GL_COMPUTE_SHADER, "MODE", (int)Mode_Separable);
-	shDesc.addDefine(GL_COMPUTE_SHADER, "DIMENSION", 0);
-	m_shConvolutionCached[0] = Shader::Create(shDesc);
-	shDesc.addDefine(GL_COMPUTE_SHADER, "DIMENSION", 1);
-	m_shConvolutionCached[1] = Shader::Create(shDesc);
+ // each KernelState has its own bank (initialized by its first build), the GPU copy is updated by initKernel()
+	if (!kernel_.m_kernelBank.getArena())
+	{
+		kernel_.m_kernelBank.init(_params.m_gaussianSigma);
+	}
+
+ // select the kernel from the bank (Mode_Prefilter and the CPU only modes use the separable kernel)
+	const conv::KernelMode mode = _params.m_mode >= Mode_Prefilter ? conv::KernelMode_Separable : (conv::KernelMode)_params.m_mode;
+	conv::KernelBank& bank = kernel_.m_kernelBank;
+	bank.setBilinearMaxError(_params.m_bilinearMaxError);
+	kernel_.m_kernel               = &bank.getKernel(_params.m_type, mode, _params.m_width, _params.m_gaussianSigma);
+	kernel_.m_kernelSize           = kernel_.m_kernel->m_tapCount;
+	kernel_.m_kernelSum            = kernel_.m_kernel->m_sum;
+	kernel_.m_weights              = bank.get(kernel_.m_kernel->m_weights);
+	kernel_.m_offsets              = bank.get(kernel_.m_kernel->m_offsets);
+	kernel_.m_displayWeights       = bank.get(kernel_.m_kernel->m_display);
+	kernel_.m_gaussianSigmaOptimal = bank.getOptimalSigma(_params.m_width);
+	if (mode == conv::KernelMode_2dBilinear)
+	{
+		const conv::KernelBank::Kernel& kernel2d = bank.getKernel(_params.m_type, conv::KernelMode_2d, _params.m_width, _params.m_gaussianSigma);
+		kernel_.m_bilinearError = conv::KernelBilinearError2d(_params.m_width, _params.m_width, bank.get(kernel2d.m_weights), kernel_.m_weights, kernel_.m_offsets, kernel_.m_kernelSize);
+	}
+	bank.clearDirtyRange();
+
+	if (!conv::IsKernelMode2d(mode))
+	{
+		kernel_.m_cpuKernel.init(kernel_.m_weights, kernel_.m_offsets, kernel_.m_kernelSize);
+		kernel_.m_cpuKernelFixed.init(kernel_.m_cpuKernel);
+	}
+	kernel_.m_cpuRecursiveKernel.init(_params.m_gaussianSigma);
+
+	for (int& width : kernel_.m_boxPassWidths)
+	{
+		width = 0;
+	}
+	conv::GaussianFindBoxWidths(_params.m_gaussianSigma, _params.m_boxPassCount, kernel_.m_boxPassWidths);
+	kernel_.m_boxPassMaxError = conv::GaussianBoxMaxError(_params.m_gaussianSigma, kernel_.m_boxPassWidths, _params.m_boxPassCount);
+
+ // Mode_2d on the CPU goes via Convolver2d, the bank's Gaussian/Binomial 2d kernels are rank 1 hence run as separable
+ // (the other modes don't use m_cpuConvolver2d, skip the large kernel/SVD/FFT spectrum)
+	kernel_.m_largeCostModel = _params.m_measureCostModel ? conv::Convolve2dCostModel::Measure() : _params.m_largeCostModel;
+	kernel_.m_cpuConvolver2d.setCostModel(kernel_.m_largeCostModel);
+	if (mode == conv::KernelMode_2d)
+	{
+		kernel_.m_cpuConvolver2d.setTolerance(_params.m_largeTolerance);
+		kernel_.m_cpuConvolver2d.init(kernel_.m_weights, _params.m_width, _params.m_srcWidth, _params.m_srcHeight);
+	}
+	else if (_params.m_mode == Mode_2dLarge)
+	{
+		BuildLargeKernel(_params, kernel_);
+	}
 }
 
-void Convolution::shutdownKernel()
+void Convolution::initKernel()
 {
-	FRM_DELETE_ARRAY(m_weights);
-	FRM_DELETE_ARRAY(m_displayWeights);
-	FRM_DELETE_ARRAY(m_offsets);
-
-	Shader::Release(m_shConvolutionCached[0]);
-	Shader::Release(m_shConvolutionCached[1]);
-	Shader::Release(m_shConvolutionBasic);
-	Buffer::Destroy(m_bfWeights);
-	Buffer::Destroy(m_bfOffsets);
+	const KernelParams& params = m_kernelBuilder.getFrontParams();
+	const KernelState&  kernel = m_kernelBuilder.getFront();
+	++m_kernelVersion;
+
+ // the GPU only reads the current kernel's ranges, upload them from the front bank (other builds may have regenerated
+ // Gaussian kernels with a different sigma in place)
+	const conv::KernelBank::Range ranges[] = { kernel.m_kernel->m_weights, kernel.m_kernel->m_offsets };
+	for (const conv::KernelBank::Range& range : ranges)
+	{
+		glAssert(glNamedBufferSubData(m_bfKernelBank->getHandle(), sizeof(float) * range.m_offset, sizeof(float) * range.m_count, kernel.m_kernelBank.get(range)));
+	}
+
+ // shaders, revisiting a permutation (e.g. sweeping a slider) reuses the shader
+	conv::ShaderDefines defines;
+	defines.add("TYPE", params.m_type);
+	defines.add("MODE", params.m_mode);
+	defines.add("KERNEL_SIZE", kernel.m_kernelSize);
+	m_shConvolutionBasic = createShader("shaders/ConvolutionBasic_cs.glsl", defines, 8, 8);
+
+	defines.add("MODE", (int)Mode_Separable);
+	defines.add("DIMENSION", 0);
+	m_shConvolutionCached[0] = createShader("shaders/ConvolutionCached_cs.glsl", defines, m_cachedLocalSize[0], m_cachedLocalSize[1]);
+	defines.add("DIMENSION", 1);
+	m_shConvolutionCached[1] = createShader("shaders/ConvolutionCached_cs.glsl", defines, m_cachedLocalSize[0], m_cachedLocalSize[1]);
 }
 
-void Convolution::initOffsets()
+Shader* Convolution::createShader(const char* _path, const conv::ShaderDefines& _defines, int _localSizeX, int _localSizeY)
 {
-	m_kernelWidth = m_kernelWidth | 1; // force size to be odd
-	const bool is2d = m_kernelMode == Mode_2d || m_kernelMode == Mode_2dBilinear;
-	const int kernelHalfWidth = m_kernelWidth / 2;
-	m_kernelSize = m_kernelWidth * (is2d ? m_kernelWidth : 1);
+ // if the preprocessor can't resolve the includes let frm load the file, keyed by the path and the defines instead
+	const conv::ShaderPermutation* permutation = m_shaderCache.get(_path, _defines);
+	const uint64_t definesHash = _defines.getHash();
+	const int localSize[] = { _localSizeX, _localSizeY };
+	uint64_t key = permutation ? permutation->m_key : conv::HashFnv1a64(_path, strlen(_path), definesHash);
+	key = conv::HashFnv1a64(localSize, sizeof(localSize), key);
+	auto it = m_shaderPermutations.find(key);
+	if (it != m_shaderPermutations.end())
+	{
+		return it->second;
+	}
 
-	m_offsets = FRM_NEW_ARRAY(float, m_kernelSize * (is2d ? 2 : 1)); // offsets are vec2 for a 2d kernel
-	if (is2d) 
+	ShaderDesc shDesc;
+	shDesc.setLocalSize(_localSizeX, _localSizeY);
+	if (permutation)
 	{
-		for (int i = 0; i < m_kernelWidth; ++i) 
-		{
-			float y = (float)(i - kernelHalfWidth);
-			for (int j = 0; j < m_kernelWidth; ++j) 
-			{
-				float x = (float)(j - kernelHalfWidth);
-				int k = (i * m_kernelWidth + j);
-				m_offsets[k * 2] = x;
-				m_offsets[k * 2 + 1] = y;
-			}
-		}
-	} 
-	else 
+		shDesc.setSource(GL_COMPUTE_SHADER, permutation->m_source.c_str());
+	}
+	else
 	{
-		for (int i = 0; i < m_kernelWidth; ++i) 
+		FRM_LOG_ERR("Convolution: %s", m_shaderPreprocessor.getError());
+		shDesc.setPath(GL_COMPUTE_SHADER, _path);
+		for (auto& define : _defines.getDefines())
 		{
-			m_offsets[i] = (float)(i - kernelHalfWidth);
+			shDesc.addDefine(GL_COMPUTE_SHADER, define.first.c_str(), define.second.c_str());
 		}
 	}
+	Shader* ret = Shader::Create(shDesc);
+	m_shaderPermutations[key] = ret;
+	return ret;
 }
 
-void Convolution::initWeights()
+void Convolution::BuildLargeKernel(const KernelParams& _params, KernelState& kernel_)
 {
-	const bool is2d = m_kernelMode == Mode_2d || m_kernelMode == Mode_2dBilinear;
-
-	m_weights = FRM_NEW_ARRAY(float, m_kernelSize);
-	switch (m_kernelType) 
+	int n = _params.m_largeWidth;
+	float* weights = _params.m_largeShape == 2 ? conv::LoadKernel2d(_params.m_largePath, &n) : nullptr;
+	kernel_.m_largeLoadFailed = _params.m_largeShape == 2 && !weights;
+	if (weights)
 	{
-		case Type_Box:
-			for (int i = 0; i < m_kernelSize; ++i) 
-			{
-				m_weights[i] = 1.0f / (float)m_kernelSize;
-			}
-			m_kernelSum = 1.0f;
-			break;
-		case Type_Gaussian:
-			if (is2d) 
-			{
-				m_kernelSum = KernelGaussian2d(m_kernelWidth, m_gaussianSigma, m_weights);
-			} 
-			else 
-			{
-				m_kernelSum = KernelGaussian1d(m_kernelWidth, m_gaussianSigma, m_weights);
-			}
-			m_gaussianSigmaOptimal = GaussianFindSigma(m_kernelWidth, 1.0f / 255.0f);
-			break;
-		case Type_Binomial:
-			if (is2d) 
-			{
-				m_kernelSum = KernelBinomial2d(m_kernelWidth, m_weights);
-			} 
-			else 
-			{
-				m_kernelSum = KernelBinomial1d(m_kernelWidth, m_weights);
-			}
-			break;
-		default:
-			FRM_ASSERT(false);
-			break;
-	};
-	m_displayWeights = FRM_NEW_ARRAY(float, m_kernelWidth);
-	memcpy(m_displayWeights, m_weights, sizeof(float) * m_kernelWidth);
-
- // optimize for bilinear modes
-	switch (m_kernelMode) 
+	 // loaded from _params.m_largePath
+	}
+	else if (_params.m_largeShape == 1)
 	{
-		case Mode_2dBilinear: 
+		weights = new float[n * n];
+		conv::KernelDisc2d(n, weights);
+	}
+	else
+	{
+		weights = new float[n * n];
+	 // outer product of the normalized 1d kernel, the 2d generators overflow for large binomial kernels
+		float* weights1d = new float[n];
+		switch (_params.m_type)
 		{
-			m_kernelSize = m_kernelWidth / 2 + 1;
-			m_kernelSize = m_kernelSize * m_kernelSize;
-			float* weightsOpt = FRM_NEW_ARRAY(float, m_kernelSize);
-			float* offsetsOpt = FRM_NEW_ARRAY(float, m_kernelSize * 2);
-			KernelOptimizeBilinear2d(m_kernelWidth, m_weights, weightsOpt, (vec2*)offsetsOpt);
-			FRM_DELETE_ARRAY(m_weights);
-			FRM_DELETE_ARRAY(m_offsets);
-			m_weights = weightsOpt;
-			m_offsets = offsetsOpt;
-			break;
-		}
-		case Mode_SeparableBilinear: 
+			default:
+			case Type_Box:      conv::KernelBox1d(n, weights1d); break;
+			case Type_Gaussian: conv::KernelGaussian1d(n, _params.m_gaussianSigma, weights1d); break;
+			case Type_Binomial: conv::KernelBinomial1d(n, weights1d); break;
+		};
+		for (int i = 0; i < n; ++i)
 		{
-			m_kernelSize = m_kernelWidth / 2 + 1;
-			float* weightsOpt = FRM_NEW_ARRAY(float, m_kernelSize);
-			float* offsetsOpt = FRM_NEW_ARRAY(float, m_kernelSize);
-			KernelOptimizeBilinear1d(m_kernelWidth, m_weights, weightsOpt, offsetsOpt);
-			FRM_DELETE_ARRAY(m_weights);
-			FRM_DELETE_ARRAY(m_offsets);
-			m_weights = weightsOpt;
-			m_offsets = offsetsOpt;
-			break;
+			for (int j = 0; j < n; ++j)
+			{
+				weights[i * n + j] = weights1d[i] * weights1d[j];
+			}
 		}
-		default:
-			break;
+		delete[] weights1d;
 	}
+	kernel_.m_cpuConvolver2d.setTolerance(_params.m_largeTolerance);
+	kernel_.m_cpuConvolver2d.init(weights, n, _params.m_srcWidth, _params.m_srcHeight, _params.m_largeMethod);
+	delete[] weights;
+}
+
+void Convolution::uploadCpuDst()
+{
+	glAssert(glTextureSubImage2D(m_txDst[0]->getHandle(), 0, 0, 0, m_cpuDst[0].getWidth(), m_cpuDst[0].getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, m_cpuDst[0].getData()));
 }
 
 void Convolution::copyWeightsToClipboard()
 {
-	bool is2d = m_kernelMode == Mode_2d || m_kernelMode == Mode_2dBilinear;
-	bool isBilinear = m_kernelMode == Mode_2dBilinear || m_kernelMode == Mode_SeparableBilinear;
+	const KernelParams& params = m_kernelBuilder.getFrontParams();
+	const KernelState&  kernel = m_kernelBuilder.getFront();
+	bool is2d = params.m_mode == Mode_2d || params.m_mode == Mode_2dBilinear;
+	bool isBilinear = params.m_mode == Mode_2dBilinear || params.m_mode == Mode_SeparableBilinear;
 
-	int cols = isBilinear ? m_kernelWidth / 2 + 1 : m_kernelWidth;
+	int cols = isBilinear ? params.m_width / 2 + 1 : params.m_width;
 	int rows = is2d ? cols : 1;
+	if (rows * cols != kernel.m_kernelSize) // greedy bilinear merge, see m_bilinearMaxError
+	{
+		cols = kernel.m_kernelSize;
+		rows = 1;
+	}
 
 	String<128> clipboardStr;
 	for (int i = 0; i < rows; ++i) 
@@ -741,7 +966,7 @@ void Convolution::copyWeightsToClipboard()
 		for (int j = 0; j < cols; ++j) 
 		{
 			int k = i * cols + j;
-			clipboardStr.appendf("%f, ", m_weights[k]);
+			clipboardStr.appendf("%f, ", kernel.m_weights[k]);
 		}
 		clipboardStr.appendf("\n");
 	}
@@ -750,11 +975,18 @@ void Convolution::copyWeightsToClipboard()
 
 void Convolution::copyOffsetstoClipboard()
 {
-	bool is2d = m_kernelMode == Mode_2d || m_kernelMode == Mode_2dBilinear;
-	bool isBilinear = m_kernelMode == Mode_2dBilinear || m_kernelMode == Mode_SeparableBilinear;
+	const KernelParams& params = m_kernelBuilder.getFrontParams();
+	const KernelState&  kernel = m_kernelBuilder.getFront();
+	bool is2d = params.m_mode == Mode_2d || params.m_mode == Mode_2dBilinear;
+	bool isBilinear = params.m_mode == Mode_2dBilinear || params.m_mode == Mode_SeparableBilinear;
 
-	int cols = isBilinear ? m_kernelWidth / 2 + 1 : m_kernelWidth;
+	int cols = isBilinear ? params.m_width / 2 + 1 : params.m_width;
 	int rows = is2d ? cols : 1;
+	if (rows * cols != kernel.m_kernelSize) // greedy bilinear merge, see m_bilinearMaxError
+	{
+		cols = kernel.m_kernelSize;
+		rows = 1;
+	}
 
 	String<128> clipboardStr;
 	for (int i = 0; i < rows; ++i) 
@@ -764,11 +996,11 @@ void Convolution::copyOffsetstoClipboard()
 			int k = i * cols + j;
 			if (is2d) 
 			{
-				clipboardStr.appendf("vec2(%f, %f), ", m_offsets[k * 2], m_offsets[k * 2 + 1]);
+				clipboardStr.appendf("vec2(%f, %f), ", kernel.m_offsets[k * 2], kernel.m_offsets[k * 2 + 1]);
 			} 
 			else 
 			{
-				clipboardStr.appendf("%f, ", m_offsets[k]);
+				clipboardStr.appendf("%f, ", kernel.m_offsets[k]);
 			}
 		}
 		clipboardStr.appendf("\n");
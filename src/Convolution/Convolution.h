@@ -3,6 +3,24 @@
 #include <frm/core/AppSample.h>
 #include <frm/core/Texture.h>
 
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include <ConvolutionLib/AsyncBuilder.h>
+#include <ConvolutionLib/BoxFilter.h>
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/ConvolveFixed.h>
+#include <ConvolutionLib/Convolver2d.h>
+#include <ConvolutionLib/DirtyTracker.h>
+#include <ConvolutionLib/KernelBank.h>
+#include <ConvolutionLib/Prefilter.h>
+#include <ConvolutionLib/Pyramid.h>
+#include <ConvolutionLib/RecursiveGaussian.h>
+#include <ConvolutionLib/SamplePattern.h>
+#include <ConvolutionLib/ShaderCache.h>
+#include <ConvolutionLib/ThreadPool.h>
+
 typedef frm::AppSample AppBase;
 
 class Convolution: public frm::AppSample
@@ -35,6 +53,11 @@ protected:
 		Mode_Separable,
 		Mode_SeparableBilinear,
 		Mode_Prefilter,
+		Mode_BoxRunningSum,       // CPU only
+		Mode_RecursiveGaussian,   // CPU only
+		Mode_IteratedBox,         // CPU only, Gaussian approximated by m_boxPassCount box passes
+		Mode_Pyramid,             // dual filter downsample/upsample
+		Mode_2dLarge,             // CPU only, any size/shape, direct/separable/FFT chosen by conv::Convolver2d
 
 		Mode_Count
 	};
@@ -43,24 +66,93 @@ protected:
 	Type   m_kernelType              = Type_Box;
 	Mode   m_kernelMode              = Mode_Separable;
 	int    m_kernelWidth             = 7;
-	int    m_kernelSize              = m_kernelWidth * m_kernelWidth;
 	float  m_gaussianSigma           = 1.0f;
-	float  m_gaussianSigmaOptimal    = 1.0f;
-	float  m_kernelSum               = 0.0f;
+	float  m_bilinearMaxError        = 0.0f;    // Mode_2dBilinear, 0 = fixed 2x2 merge
 	float  m_prefilterLodBias        = 1.0f;
 	int    m_prefilterSampleCount    = 8;
 	int    m_prefilterBlurWidth      = 21;
-	float* m_weights                 = nullptr;
-	float* m_offsets                 = nullptr;
-	float* m_displayWeights          = nullptr;
+	bool   m_prefilterAuto           = false;   // set the bias/sample count from m_prefilterTable
+	conv::PrefilterSetting m_prefilterTable[32]; // from data/Convolution/PrefilterTable.json, see ConvolutionBench prefilter --json
+	int    m_prefilterTableCount     = 0;
+	bool   m_prefilterSampleTables   = false;   // optimized point sets + blue noise rotation, see conv::SamplePatternSet
+	bool   m_prefilterTemporal       = false;   // accumulate m_prefilterFrameSampleCount samples/frame, see conv::PrefilterAccumulator
+	int    m_prefilterFrameSampleCount = 2;
+	float  m_prefilterMinAlpha       = 0.05f;   // EMA weight of the current frame once converged
+	int    m_prefilterFrame          = 0;       // frames accumulated since the history was reset
+	float  m_prefilterHistoryKey[5]  = {};      // inputs of the history, reset m_prefilterFrame if any differ
+	int    m_boxWidth                = 63;      // Mode_BoxRunningSum, not limited by the kernel bank
+	int    m_boxPassCount            = 3;       // Mode_IteratedBox
+	int    m_pyramidLevelCount       = 4;       // Mode_Pyramid
+	int    m_largeWidth              = 31;      // Mode_2dLarge, not limited by the kernel bank
+	int    m_largeMethod             = conv::Convolve2dMethod_Auto;
+	int    m_largeShape              = 0;       // 0 = m_kernelType, 1 = disc, 2 = loaded from m_largePath
+	char   m_largePath[256]          = "kernel.txt";
+	float  m_largeTolerance          = 1e-3f;   // low rank separable decomposition
+	conv::Convolve2dCostModel m_largeCostModel = conv::Convolve2dCostModel::GetDefault();
+	bool   m_largeCostModelPending   = false;   // m_largeCostModel is being measured by the kernel builder
 	bool   m_showKernel              = false;
 	bool   m_cached                  = false;
+	int    m_cachedLocalSize[2]      = { 64, 1 }; // local X must be *at least* the kernel radius to have enough threads to fill the cache
+	bool   m_cpu                     = false; // use the CPU path for Mode_2d/Mode_Separable/Mode_SeparableBilinear/Mode_Pyramid
+	bool   m_cpuFixedPoint           = false; // Mode_Separable/Mode_SeparableBilinear CPU path, see ConvolveFixed.h
+	bool   m_skipUnchanged           = true;  // reuse m_txDst[0] if none of the inputs of the convolution changed, see draw()
+
+	// Kernel parameters (copied from the UI state by requestKernel()) and everything derived from them. Kernels are built
+	// on a worker by m_kernelBuilder, update() swaps the latest build to the front at frame start; the previous kernel is
+	// used until then.
+	struct KernelParams
+	{
+		Type   m_type                    = Type_Box;
+		Mode   m_mode                    = Mode_Separable;
+		int    m_width                   = 7;
+		float  m_gaussianSigma           = 1.0f;
+		float  m_bilinearMaxError        = 0.0f;
+		int    m_boxPassCount            = 3;
+		int    m_largeWidth              = 31;
+		int    m_largeMethod             = conv::Convolve2dMethod_Auto;
+		int    m_largeShape              = 0;
+		char   m_largePath[256]          = "";
+		float  m_largeTolerance          = 1e-3f;
+		conv::Convolve2dCostModel m_largeCostModel = conv::Convolve2dCostModel::GetDefault();
+		bool   m_measureCostModel        = false;   // measure the cost model (~0.5s) instead of m_largeCostModel
+		int    m_srcWidth                = 0;
+		int    m_srcHeight               = 0;
+	};
+	struct KernelState
+	{
+		conv::KernelBank                m_kernelBank;
+		const conv::KernelBank::Kernel* m_kernel               = nullptr;
+		const float*                    m_weights              = nullptr; // current kernel in m_kernelBank
+		const float*                    m_offsets              = nullptr;
+		const float*                    m_displayWeights       = nullptr;
+		int                             m_kernelSize           = 0;
+		float                           m_kernelSum            = 0.0f;
+		float                           m_gaussianSigmaOptimal = 1.0f;
+		float                           m_bilinearError        = 0.0f;    // of the merged kernel vs. Mode_2d
+		int                             m_boxPassWidths[5]     = {};      // from m_gaussianSigma
+		float                           m_boxPassMaxError      = 0.0f;    // vs. KernelGaussian1d
+		bool                            m_largeLoadFailed      = false;   // m_largeShape falls back to m_kernelType
+		conv::Convolve2dCostModel       m_largeCostModel       = conv::Convolve2dCostModel::GetDefault(); // used by m_cpuConvolver2d, measured if m_measureCostModel
+		conv::SeparableKernel           m_cpuKernel;
+		conv::SeparableKernelFixed      m_cpuKernelFixed;
+		conv::RecursiveGaussianKernel   m_cpuRecursiveKernel;
+		conv::Convolver2d               m_cpuConvolver2d;
+	};
+	conv::AsyncBuilder<KernelParams, KernelState> m_kernelBuilder;
+	int                                           m_kernelVersion = 0; // incremented by initKernel()
+	int                                           m_srcVersion    = 0; // incremented whenever m_txSrc/m_cpuSrc are (re)loaded or written
+	conv::DirtyTracker                            m_convolutionDirty;
+
+	static void BuildKernel(const KernelParams& _params, KernelState& kernel_);      // worker
+	static void BuildLargeKernel(const KernelParams& _params, KernelState& kernel_); // Mode_2dLarge, worker
+
+	void requestKernel();   // queue a build with the current parameters
+	void initKernel();      // upload the front kernel and select the shaders, after a build is swapped to the front
 
-	void initKernel();
-	void shutdownKernel();
+	// Find or create the permutation of _path with _defines, the shader is owned by m_shaderPermutations.
+	frm::Shader* createShader(const char* _path, const conv::ShaderDefines& _defines, int _localSizeX, int _localSizeY);
 
-	void initOffsets();
-	void initWeights();
+	void uploadCpuDst();    // copy m_cpuDst[0] to m_txDst[0]
 
 	void copyWeightsToClipboard();
 	void copyOffsetstoClipboard();
@@ -71,7 +163,23 @@ protected:
 	frm::Shader*     m_shConvolutionBasic        = nullptr;
 	frm::Shader*     m_shConvolutionCached[2]    = { nullptr };
 	frm::Shader*     m_shPrefilter               = nullptr;
-	frm::Shader*     m_shConvolutionPrefiltered  = nullptr;
-	frm::Buffer*     m_bfWeights                 = nullptr;
-	frm::Buffer*     m_bfOffsets                 = nullptr;
+	frm::Shader*     m_shConvolutionPrefiltered[2][2] = {}; // [SAMPLE_TABLES][TEMPORAL]
+	frm::Shader*     m_shDualFilter[2]           = { nullptr }; // downsample, upsample
+	frm::Buffer*     m_bfKernelBank              = nullptr;
+	frm::Buffer*     m_bfSamplePatterns          = nullptr; // m_samplePatterns point sets
+	frm::Texture*    m_txRotation                = nullptr; // m_samplePatterns rotation texture
+	frm::Texture*    m_txPrefilterHistory[2]     = { nullptr }; // ping-pong, RGBA16F
+
+	conv::Image                   m_cpuSrc;    // copy of m_txSrc
+	conv::Image                   m_cpuDst[2]; // as m_txDst, [0] is uploaded to m_txDst[0] after the convolution
+	conv::PyramidBlur             m_cpuPyramid;
+	conv::ThreadPool*             m_cpuThreadPool = nullptr;
+
+	conv::SamplePatternSet        m_samplePatterns;       // generated by m_samplePatternsThread, uploaded by update()
+	std::thread                   m_samplePatternsThread;
+	std::atomic<bool>             m_samplePatternsReady   = { false };
+
+	conv::ShaderPreprocessor           m_shaderPreprocessor;
+	conv::ShaderPermutationCache       m_shaderCache;
+	std::map<uint64_t, frm::Shader*>   m_shaderPermutations; // permutation key + local size, released in shutdown()
 };
@@ -0,0 +1,94 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Line.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+
+volatile unsigned g_sink = 0;
+int         g_maxImageSize = 16384;
+int         g_maxThreads   = 0;
+const char* g_jsonPath     = nullptr;
+
+void InitTestImage(conv::Image& img_, int _width, int _height, conv::Format _format)
+{
+	img_.init(_width, _height, _format);
+	uint32_t rng = 0x9e3779b9u;
+	for (int y = 0; y < _height; ++y)
+	{
+		for (int x = 0; x < _width; ++x)
+		{
+			float rgba[4];
+			for (int i = 0; i < 4; ++i)
+			{
+			 // xorshift32
+				rng ^= rng << 13;
+				rng ^= rng >> 17;
+				rng ^= rng << 5;
+				rgba[i] = (float)(rng >> 8) / (float)(1 << 24);
+			}
+			img_.writeTexel(x, y, rgba);
+		}
+	}
+}
+
+void InitTestPattern(conv::Image& img_, int _width, int _height, conv::Format _format)
+{
+	img_.init(_width, _height, _format);
+	const float k = 3.14159265f / (float)(_width > _height ? _width : _height); // frequency reaches Nyquist at the edges
+	for (int y = 0; y < _height; ++y)
+	{
+		for (int x = 0; x < _width; ++x)
+		{
+			const float fx = (float)x - (float)_width * 0.5f;
+			const float fy = (float)y - (float)_height * 0.5f;
+			const float zonePlate = 0.5f + 0.5f * cosf(k * (fx * fx + fy * fy) * 0.5f);
+			const float squares   = ((x / 32 + y / 32) & 1) ? 1.0f : 0.0f;
+			const float gradient  = (float)x / (float)_width;
+			const float rgba[4]   = { zonePlate, squares, gradient, 1.0f };
+			img_.writeTexel(x, y, rgba);
+		}
+	}
+}
+
+double GetPsnr(const conv::Image& _a, const conv::Image& _b)
+{
+	std::vector<float> a(_a.getWidth() * 4), b(_b.getWidth() * 4);
+	double sumSquaredError = 0.0;
+	for (int y = 0; y < _a.getHeight(); ++y)
+	{
+		conv::ReadLine(_a, conv::Direction_Horizontal, y, 0, _a.getWidth(), a.data());
+		conv::ReadLine(_b, conv::Direction_Horizontal, y, 0, _b.getWidth(), b.data());
+		for (int x = 0; x < _a.getWidth(); ++x)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const double err = (double)a[x * 4 + c] - (double)b[x * 4 + c];
+				sumSquaredError += err * err;
+			}
+		}
+	}
+	const double mse = sumSquaredError / ((double)_a.getWidth() * (double)_a.getHeight() * 3.0);
+	return mse > 0.0 ? 10.0 * log10(1.0 / mse) : 99.0;
+}
+
+float GetMaxError(const conv::Image& _a, const conv::Image& _b)
+{
+	std::vector<float> a(_a.getWidth() * 4), b(_b.getWidth() * 4);
+	float ret = 0.0f;
+	for (int y = 0; y < _a.getHeight(); ++y)
+	{
+		conv::ReadLine(_a, conv::Direction_Horizontal, y, 0, _a.getWidth(), a.data());
+		conv::ReadLine(_b, conv::Direction_Horizontal, y, 0, _b.getWidth(), b.data());
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			ret = fmaxf(ret, fabsf(a[i] - b[i]));
+		}
+	}
+	return ret;
+}
+
+} // namespace bench
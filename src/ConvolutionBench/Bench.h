@@ -0,0 +1,75 @@
+#pragma once
+
+// Shared helpers for the ConvolutionBench benchmarks/reports.
+
+#include <ConvolutionLib/Image.h>
+
+#include <chrono>
+#include <cstdio>
+
+namespace bench {
+
+class Timer
+{
+public:
+	Timer()                       { reset(); }
+	void   reset()                { m_start = std::chrono::high_resolution_clock::now(); }
+	double getElapsedMs() const   { return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_start).count(); }
+
+private:
+	std::chrono::high_resolution_clock::time_point m_start;
+};
+
+extern volatile unsigned g_sink;
+
+// Command line options (--max-size, --threads, --json).
+extern int         g_maxImageSize; // largest image size for the benchmarks which sweep image size
+extern int         g_maxThreads;   // largest thread count for the benchmarks which sweep thread count (0 = hardware concurrency)
+extern const char* g_jsonPath;     // JSON file to which tuning benchmarks write their results (nullptr = don't write)
+
+// Prevent the compiler from optimizing away the computation of _value.
+template <typename tType>
+inline void DoNotOptimize(const tType& _value)
+{
+	g_sink = g_sink + (unsigned)*(const volatile unsigned char*)&_value;
+}
+
+// Call _fn repeatedly for at least _minMs (and at least once), return the average time per call in ms.
+template <typename tFunc>
+double Measure(tFunc&& _fn, double _minMs = 100.0)
+{
+	_fn(); // warm up
+
+	int count = 0;
+	Timer timer;
+	double elapsed = 0.0;
+	do
+	{
+		_fn();
+		++count;
+		elapsed = timer.getElapsedMs();
+	}
+	while (elapsed < _minMs);
+	return elapsed / (double)count;
+}
+
+// Fill img_ with uniform random noise (deterministic).
+void InitTestImage(conv::Image& img_, int _width, int _height, conv::Format _format);
+
+// Fill img_ with a structured test pattern (zone plate, squares, gradient in RGB) for quality comparisons; filtering
+// noise is a poor test of quality since any large blur of noise is close to flat.
+void InitTestPattern(conv::Image& img_, int _width, int _height, conv::Format _format);
+
+// Peak signal to noise ratio (dB) of the RGB channels of _b relative to _a, 99 if the images are identical.
+double GetPsnr(const conv::Image& _a, const conv::Image& _b);
+
+// Max absolute difference between 2 images of the same size, as RGBA float.
+float GetMaxError(const conv::Image& _a, const conv::Image& _b);
+
+// Throughput in megapixels per second.
+inline double GetMPixPerSec(int _width, int _height, double _ms)
+{
+	return ((double)_width * (double)_height / 1e6) / (_ms / 1e3);
+}
+
+} // namespace bench
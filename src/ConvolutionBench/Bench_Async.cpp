@@ -0,0 +1,95 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/AsyncBuilder.h>
+#include <ConvolutionLib/Convolver2d.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+const int kImageSize  = 1024;
+const int kKernelSize = 63;
+
+struct Params
+{
+	float m_radius = 0.0f;
+};
+
+// A non-separable (disc) kernel, as per Convolution::BuildLargeKernel(): the build includes the low rank decomposition
+// and the FFT spectrum.
+void BuildDisc(const Params& _params, Convolver2d& result_)
+{
+	std::vector<float> weights(kKernelSize * kKernelSize);
+	const float center = (float)(kKernelSize / 2);
+	float sum = 0.0f;
+	for (int y = 0; y < kKernelSize; ++y)
+	{
+		for (int x = 0; x < kKernelSize; ++x)
+		{
+			const float d = sqrtf(((float)x - center) * ((float)x - center) + ((float)y - center) * ((float)y - center));
+			const float w = d <= _params.m_radius ? 1.0f : 0.0f;
+			weights[y * kKernelSize + x] = w;
+			sum += w;
+		}
+	}
+	for (float& w : weights)
+	{
+		w /= sum;
+	}
+	result_.init(weights.data(), kKernelSize, kImageSize, kImageSize);
+}
+
+} // namespace
+
+// Asynchronous kernel rebuild: a slider drag (the kernel changes every frame) with the build on the main thread vs. on a
+// worker via AsyncBuilder, main thread time per frame and how many builds were coalesced.
+void Bench_Async()
+{
+	const int    kFrames  = 60;
+	const double kFrameMs = 8.0; // simulated render time per frame, the worker builds meanwhile
+
+	Params params;
+	double syncMaxMs = 0.0, syncTotalMs = 0.0;
+	for (int frame = 0; frame < kFrames; ++frame)
+	{
+		Convolver2d convolver;
+		params.m_radius = 8.0f + (float)(frame % 24);
+		bench::Timer timer;
+		BuildDisc(params, convolver);
+		const double ms = timer.getElapsedMs();
+		syncMaxMs    = ms > syncMaxMs ? ms : syncMaxMs;
+		syncTotalMs += ms;
+	}
+
+	AsyncBuilder<Params, Convolver2d> builder;
+	builder.init(&BuildDisc);
+	double asyncMaxMs = 0.0, asyncTotalMs = 0.0;
+	int swapCount = 0;
+	for (int frame = 0; frame < kFrames; ++frame)
+	{
+		params.m_radius = 8.0f + (float)(frame % 24);
+		bench::Timer timer;
+		builder.request(params);
+		swapCount += builder.acquire() ? 1 : 0;
+		const double ms = timer.getElapsedMs();
+		asyncMaxMs    = ms > asyncMaxMs ? ms : asyncMaxMs;
+		asyncTotalMs += ms;
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(kFrameMs));
+	}
+	builder.wait();
+	builder.acquire();
+	const bool latest = builder.getFrontParams().m_radius == params.m_radius;
+
+	printf("%dx%d kernel, %dx%d image, kernel changes every frame for %d frames (%.0fms/frame render)\n", kKernelSize, kKernelSize, kImageSize, kImageSize, kFrames, kFrameMs);
+	printf("%-8s %12s %12s %10s %10s\n", "", "avg ms", "max ms", "requests", "builds");
+	printf("%-8s %12.3f %12.3f %10d %10d\n", "sync", syncTotalMs / kFrames, syncMaxMs, kFrames, kFrames);
+	printf("%-8s %12.3f %12.3f %10d %10d   (%d swaps)\n", "async", asyncTotalMs / kFrames, asyncMaxMs, builder.getRequestCount(), builder.getBuildCount(), swapCount);
+	printf("Final front is the latest request: %s\n\n", latest ? "yes" : "NO");
+	builder.shutdown();
+}
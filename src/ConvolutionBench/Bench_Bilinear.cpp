@@ -0,0 +1,76 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/ThreadPool.h>
+
+#include <cstdio>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+const float kMaxErrors[] = { 1e-3f, 1e-2f, 3e-2f };
+
+} // namespace
+
+// Fixed 2x2 bilinear merging (KernelOptimizeBilinear2d) vs. the greedy error bounded merge: fetch count, kernel error
+// (8 bit sampler fractions) and the max error of the convolved image vs. the unmerged kernel.
+void Bench_Bilinear()
+{
+	struct TestKernel
+	{
+		const char*        m_name;
+		int                m_size;
+		std::vector<float> m_weights;
+	};
+	std::vector<TestKernel> kernels;
+	kernels.push_back({ "box",      21, std::vector<float>(21 * 21) });
+	KernelBox2d(21, kernels.back().m_weights.data());
+	kernels.push_back({ "gaussian", 21, std::vector<float>(21 * 21) });
+	KernelGaussian2d(21, 4.0f, kernels.back().m_weights.data());
+	kernels.push_back({ "binomial", 21, std::vector<float>(21 * 21) });
+	KernelBinomial2d(21, kernels.back().m_weights.data());
+	kernels.push_back({ "disc",     21, std::vector<float>(21 * 21) });
+	KernelDisc2d(21, kernels.back().m_weights.data());
+	kernels.push_back({ "disc",     41, std::vector<float>(41 * 41) });
+	KernelDisc2d(41, kernels.back().m_weights.data());
+
+	const int kSize = bench::g_maxImageSize < 256 ? bench::g_maxImageSize : 256;
+	ThreadPool pool(bench::g_maxThreads);
+	Image src, dstRef, dst;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA32F);
+	dstRef.init(kSize, kSize, Format_RGBA32F);
+	dst.init(kSize, kSize, Format_RGBA32F);
+
+	printf("Fetches / kernel max error / image max error, RGBA32F %dx%d\n", kSize, kSize);
+	printf("%-10s %-5s %6s %28s", "kernel", "size", "taps", "fixed 2x2");
+	for (float maxError : kMaxErrors)
+	{
+		printf("         greedy <= %-9.0e", maxError);
+	}
+	printf("\n");
+	for (const TestKernel& kernel : kernels)
+	{
+		const int n = kernel.m_size;
+		std::vector<float> tapWeights(n * n), tapOffsets(n * n * 2), reconstructed(n * n);
+		auto evaluate = [&](int _tapCount)
+			{
+				const float kernelError = KernelBilinearError2d(n, n, kernel.m_weights.data(), tapWeights.data(), tapOffsets.data(), _tapCount);
+				KernelBilinearReconstruct2d(n, n, tapWeights.data(), tapOffsets.data(), _tapCount, reconstructed.data());
+				Convolve2d(pool, src, dst, reconstructed.data(), n);
+				printf(" %5d %8.1e %8.1e  ", _tapCount, kernelError, bench::GetMaxError(dstRef, dst));
+			};
+
+		Convolve2d(pool, src, dstRef, kernel.m_weights.data(), n);
+		printf("%-10s %-5d %6d   ", kernel.m_name, n, n * n);
+		KernelOptimizeBilinear2d(n, kernel.m_weights.data(), tapWeights.data(), tapOffsets.data());
+		evaluate((n / 2 + 1) * (n / 2 + 1));
+		for (float maxError : kMaxErrors)
+		{
+			evaluate(KernelOptimizeBilinearGreedy2d(n, n, kernel.m_weights.data(), maxError, tapWeights.data(), tapOffsets.data()));
+		}
+		printf("\n");
+	}
+}
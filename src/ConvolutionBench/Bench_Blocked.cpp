@@ -0,0 +1,71 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Simd.h>
+
+#include <cmath>
+#include <cstdio>
+
+using namespace conv;
+
+// Horizontal pass throughput (ns per texel per tap) per instruction set and kernel width, for the line functions
+// specialized on the tap count (register blocked). Widths > 32 use the generic blocked variant. The max difference
+// vs. the scalar line function should be at the level of float rounding.
+void Bench_Blocked()
+{
+	const int kWidth = 1024, kHeight = 64;
+	const Isa bestIsa = GetIsa();
+
+	Image src, dst, ref;
+	bench::InitTestImage(src, kWidth, kHeight, Format_RGBA32F);
+	dst.init(kWidth, kHeight, Format_RGBA32F);
+	ref.init(kWidth, kHeight, Format_RGBA32F);
+
+	printf("RGBA32F %dx%d horizontal pass, 1 thread (ns per texel-tap)\n", kWidth, kHeight);
+	printf("%-6s", "taps");
+	for (Isa isa = Isa_Scalar; isa <= bestIsa; ++isa)
+	{
+		printf(" %8s", GetIsaName(isa));
+	}
+	printf(" %10s\n", "max diff");
+
+	const int kWidths[] = { 3, 5, 7, 9, 13, 17, 21, 25, 31, 41, 63 };
+	for (int width : kWidths)
+	{
+		float weights[63], offsets[63];
+		KernelGaussian1d(width, (float)width / 6.0f, weights);
+		for (int i = 0; i < width; ++i)
+		{
+			offsets[i] = (float)(i - width / 2);
+		}
+		SeparableKernel kernel;
+		kernel.init(weights, offsets, width);
+
+		printf("%-6d", width);
+		float maxDiff = 0.0f;
+		for (Isa isa = Isa_Scalar; isa <= bestIsa; ++isa)
+		{
+			SetIsa(isa);
+		 // best of several short runs, the average is too noisy to compare block sizes
+			double ms = 1e30;
+			for (int run = 0; run < 5; ++run)
+			{
+				const double t = bench::Measure([&]{ ConvolvePass(src, dst, kernel, Direction_Horizontal); }, 20.0);
+				ms = t < ms ? t : ms;
+			}
+			printf(" %8.3f", ms * 1e6 / ((double)kWidth * (double)kHeight * (double)width));
+			if (isa == Isa_Scalar)
+			{
+				ConvolvePass(src, ref, kernel, Direction_Horizontal);
+			}
+			else
+			{
+				maxDiff = fmaxf(maxDiff, bench::GetMaxError(ref, dst));
+			}
+		}
+		SetIsa(bestIsa);
+		printf(" %10.1e\n", maxDiff);
+	}
+	printf("\n");
+}
@@ -0,0 +1,53 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/BoxFilter.h>
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Kernel.h>
+
+#include <cstdio>
+#include <vector>
+
+using namespace conv;
+
+// Running sum box filter vs. the tap loop (ConvolveSeparable() with box weights), both single-threaded at the best ISA.
+void Bench_Box()
+{
+	const int kSize = bench::g_maxImageSize < 1024 ? bench::g_maxImageSize : 1024;
+	const int kWidths[] = { 3, 9, 21, 63, 127, 255, 511 };
+
+	for (Format format = 0; format < Format_Count; ++format)
+	{
+		Image src, dstTaps, dstSum, tmp;
+		bench::InitTestImage(src, kSize, kSize, format);
+		dstTaps.init(kSize, kSize, format);
+		dstSum.init(kSize, kSize, format);
+
+		printf("%s %dx%d (MPix/s)\n", GetFormatName(format), kSize, kSize);
+		printf("%-6s %10s %12s %8s %10s\n", "width", "tap loop", "running sum", "speedup", "max error");
+		for (int width : kWidths)
+		{
+			std::vector<float> weights(width), offsets(width);
+			KernelBox1d(width, weights.data());
+			for (int i = 0; i < width; ++i)
+			{
+				offsets[i] = (float)(i - width / 2);
+			}
+			SeparableKernel kernel;
+			kernel.init(weights.data(), offsets.data(), width);
+
+			double msTaps = bench::Measure([&]{ ConvolveSeparable(src, dstTaps, tmp, kernel); }, 200.0);
+			double msSum  = bench::Measure([&]{ BoxFilter(src, dstSum, tmp, width); }, 200.0);
+			float  error  = bench::GetMaxError(dstTaps, dstSum);
+			printf("%-6d %10.1f %12.1f %7.1fx", width, bench::GetMPixPerSec(kSize, kSize, msTaps), bench::GetMPixPerSec(kSize, kSize, msSum), msTaps / msSum);
+			if (format == Format_RGBA8)
+			{
+				printf(" %6.0f LSB\n", error * 255.0f);
+			}
+			else
+			{
+				printf(" %10.2e\n", error);
+			}
+		}
+		printf("\n");
+	}
+}
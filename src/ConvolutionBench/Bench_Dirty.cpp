@@ -0,0 +1,103 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/DirtyTracker.h>
+#include <ConvolutionLib/Kernel.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace conv;
+
+namespace {
+
+void InitGaussian(int _width, SeparableKernel& kernel_)
+{
+	float weights[64], offsets[64];
+	KernelGaussian1d(_width, (float)_width / 6.0f, weights);
+	for (int i = 0; i < _width; ++i)
+	{
+		offsets[i] = (float)(i - _width / 2);
+	}
+	kernel_.init(weights, offsets, _width);
+}
+
+} // namespace
+
+// Dirty tracking: a session of mostly idle frames with occasional slider drags, convolving every frame vs. only when the
+// inputs (kernel width, source version) changed. The reused result must match a fresh convolution.
+void Bench_Dirty()
+{
+	const int kSize   = bench::g_maxImageSize < 512 ? bench::g_maxImageSize : 512;
+	const int kFrames = 300;
+
+ // kernel width per frame: idle at 9, a drag 9 -> 21 -> 9 starting at frame 100, a single click at frame 250
+	int widths[kFrames];
+	for (int frame = 0; frame < kFrames; ++frame)
+	{
+		int width = 9;
+		if (frame >= 100 && frame < 124)
+		{
+			const int t = frame - 100;
+			width = 9 + 2 * (t < 12 ? t / 2 : (23 - t) / 2);
+		}
+		else if (frame >= 250)
+		{
+			width = 15;
+		}
+		widths[frame] = width;
+	}
+
+	Image src, dst, tmp;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+	dst.init(kSize, kSize, Format_RGBA8);
+	tmp.init(kSize, kSize, Format_RGBA8);
+	SeparableKernel kernel;
+	const int srcVersion = 1;
+
+	bench::Timer timer;
+	for (int frame = 0; frame < kFrames; ++frame)
+	{
+		InitGaussian(widths[frame], kernel);
+		ConvolveSeparable(src, dst, tmp, kernel);
+	}
+	const double msAlways = timer.getElapsedMs();
+
+	DirtyTracker dirty;
+	timer.reset();
+	for (int frame = 0; frame < kFrames; ++frame)
+	{
+		dirty.add(srcVersion);
+		dirty.add(widths[frame]);
+		if (dirty.update())
+		{
+			InitGaussian(widths[frame], kernel);
+			ConvolveSeparable(src, dst, tmp, kernel);
+		}
+	}
+	const double msSkip = timer.getElapsedMs();
+	const int recomputeCount = dirty.getRecomputeCount();
+	const int reuseCount     = dirty.getReuseCount();
+
+	Image ref;
+	ref.init(kSize, kSize, Format_RGBA8);
+	InitGaussian(widths[kFrames - 1], kernel);
+	ConvolveSeparable(src, ref, tmp, kernel);
+	const bool match = memcmp(ref.getData(), dst.getData(), ref.getSize()) == 0;
+
+	const double msUpdate = bench::Measure([&]
+		{
+			for (int i = 0; i < 1000; ++i)
+			{
+				dirty.add(srcVersion);
+				dirty.add(widths[0]);
+				dirty.update();
+			}
+		}) / 1000.0;
+
+	printf("RGBA8 %dx%d, %d frames (idle, a width drag, a single change)\n", kSize, kSize, kFrames);
+	printf("%-8s %10s %12s %10s\n", "", "ms", "ms/frame", "recomputes");
+	printf("%-8s %10.2f %12.3f %10d\n", "always", msAlways, msAlways / kFrames, kFrames);
+	printf("%-8s %10.2f %12.3f %10d   (%d reuses)\n", "skip", msSkip, msSkip / kFrames, recomputeCount, reuseCount);
+	printf("Tracker overhead %.1fns/frame, reused result %s\n\n", msUpdate * 1e6, match ? "matches" : "DIFFERS");
+}
@@ -0,0 +1,112 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolver2d.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/ThreadPool.h>
+
+#include <cstdio>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+const int kSizes[] = { 3, 5, 7, 9, 11, 15, 21, 31, 45, 63, 95, 127 };
+
+} // namespace
+
+// FFT vs. direct vs. separable 2d convolution: accuracy, measured time per kernel size and the crossover points chosen by
+// Convolver2d's cost model vs. the measured crossovers.
+void Bench_Fft()
+{
+	const Convolve2dCostModel defaultModel  = Convolve2dCostModel::GetDefault();
+	const Convolve2dCostModel measuredModel = Convolve2dCostModel::Measure();
+	printf("Cost model (ns)    %10s %10s\n", "default", "measured");
+	printf("direct/tap         %10.3f %10.3f\n", defaultModel.m_direct,        measuredModel.m_direct);
+	printf("separable/tap      %10.3f %10.3f\n", defaultModel.m_separableTap,  measuredModel.m_separableTap);
+	printf("separable/pass     %10.3f %10.3f\n", defaultModel.m_separablePass, measuredModel.m_separablePass);
+	printf("fft/(T^2 log2 T)   %10.3f %10.3f\n", defaultModel.m_fft,           measuredModel.m_fft);
+	printf("\n");
+
+	ThreadPool pool(bench::g_maxThreads);
+
+	{	const int kSize = bench::g_maxImageSize < 256 ? bench::g_maxImageSize : 256;
+		Image src, dstDirect, dstFft, tmp;
+		bench::InitTestImage(src, kSize, kSize, Format_RGBA32F);
+		dstDirect.init(kSize, kSize, Format_RGBA32F);
+		dstFft.init(kSize, kSize, Format_RGBA32F);
+
+		printf("Disc kernel, FFT vs. direct RGBA32F %dx%d\n", kSize, kSize);
+		printf("%-6s %10s %10s\n", "size", "tile size", "max error");
+		for (int size : { 5, 21, 63 })
+		{
+			std::vector<float> weights(size * size);
+			KernelDisc2d(size, weights.data());
+			Convolver2d convolver;
+			convolver.init(weights.data(), size, kSize, kSize, Convolve2dMethod_Direct);
+			convolver.convolve(pool, src, dstDirect, tmp);
+			convolver.init(weights.data(), size, kSize, kSize, Convolve2dMethod_Fft);
+			convolver.convolve(pool, src, dstFft, tmp);
+			printf("%-6d %10d %10.2e\n", size, FftKernel::FindTileSize(size, kSize, kSize), bench::GetMaxError(dstDirect, dstFft));
+		}
+		printf("\n");
+	}
+
+	const int kSize = bench::g_maxImageSize < 1024 ? bench::g_maxImageSize : 1024;
+	Image src, dst, tmp;
+	bench::InitTestImage(src, kSize, kSize, Format_RGBA8);
+	dst.init(kSize, kSize, Format_RGBA8);
+
+ // the direct method is skipped once it's estimated to take > 2s per call
+	printf("Gaussian kernel RGBA8 %dx%d, %d threads (ms)\n", kSize, kSize, pool.getThreadCount());
+	printf("%-6s %10s %10s %10s %10s %10s\n", "size", "direct", "separable", "fft", "fastest", "chosen");
+	int crossover[2] = { 0, 0 }; // measured, estimated: first size for which FFT beats direct
+	for (int size : kSizes)
+	{
+		std::vector<float> weights(size * size);
+		KernelGaussian2d(size, (float)size / 6.0f, weights.data());
+		Convolver2d convolver;
+		convolver.setCostModel(measuredModel);
+
+		double ms[Convolve2dMethod_Count];
+		for (Convolve2dMethod method = 0; method < Convolve2dMethod_Count; ++method)
+		{
+			convolver.init(weights.data(), size, kSize, kSize, method);
+			ms[method] = -1.0;
+			if (method != Convolve2dMethod_Direct || convolver.getCost(method) / pool.getThreadCount() < 2e9)
+			{
+				ms[method] = bench::Measure([&]{ convolver.convolve(pool, src, dst, tmp); }, 200.0);
+			}
+		}
+		convolver.init(weights.data(), size, kSize, kSize);
+
+		Convolve2dMethod fastest = Convolve2dMethod_Fft;
+		for (Convolve2dMethod method = 0; method < Convolve2dMethod_Count; ++method)
+		{
+			fastest = ms[method] >= 0.0 && ms[method] < ms[fastest] ? method : fastest;
+		}
+		if (crossover[0] == 0 && ms[Convolve2dMethod_Direct] >= 0.0 && ms[Convolve2dMethod_Fft] < ms[Convolve2dMethod_Direct])
+		{
+			crossover[0] = size;
+		}
+		if (crossover[1] == 0 && convolver.getCost(Convolve2dMethod_Fft) < convolver.getCost(Convolve2dMethod_Direct))
+		{
+			crossover[1] = size;
+		}
+
+		printf("%-6d ", size);
+		for (Convolve2dMethod method = 0; method < Convolve2dMethod_Count; ++method)
+		{
+			if (ms[method] >= 0.0)
+			{
+				printf("%10.2f ", ms[method]);
+			}
+			else
+			{
+				printf("%10s ", "-");
+			}
+		}
+		printf("%10s %10s\n", GetConvolve2dMethodName(fastest), GetConvolve2dMethodName(convolver.getMethod()));
+	}
+	printf("\nFFT beats direct from size %d (measured), %d (estimated)\n", crossover[0], crossover[1]);
+}
@@ -0,0 +1,106 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/ConvolveFixed.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Simd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace conv;
+
+namespace {
+
+// Max absolute difference between 2 RGBA8 images in LSBs.
+int GetMaxDeviation(const Image& _a, const Image& _b)
+{
+	const uint8_t* a = (const uint8_t*)_a.getData();
+	const uint8_t* b = (const uint8_t*)_b.getData();
+	int ret = 0;
+	for (size_t i = 0; i < _a.getSize(); ++i)
+	{
+		const int d = abs((int)a[i] - (int)b[i]);
+		ret = d > ret ? d : ret;
+	}
+	return ret;
+}
+
+} // namespace
+
+// Fixed point vs. float separable convolution of RGBA8 images: throughput per instruction set and the max deviation in
+// LSBs vs. the float path and vs. an exact reference (float intermediate, rounded once).
+void Bench_Fixed()
+{
+	const int kSize = bench::g_maxImageSize < 2048 ? bench::g_maxImageSize : 2048;
+	const Isa bestIsa = GetIsa();
+
+	Image src, dstFloat, dstFixed, dstExact, tmp, tmpExact, constant;
+	bench::InitTestImage(src, kSize, kSize, Format_RGBA8);
+	dstFloat.init(kSize, kSize, Format_RGBA8);
+	dstFixed.init(kSize, kSize, Format_RGBA8);
+	dstExact.init(kSize, kSize, Format_RGBA8);
+	tmpExact.init(kSize, kSize, Format_RGBA32F);
+	constant.init(64, 64, Format_RGBA8);
+	memset(constant.getData(), 0xb7, constant.getSize());
+
+	printf("RGBA8 %dx%d, 1 thread (MPix/s float/fixed)\n", kSize, kSize);
+	printf("%-6s %-10s", "width", "mode");
+	for (Isa isa = Isa_Scalar; isa <= bestIsa; ++isa)
+	{
+		printf(" %17s", GetIsaName(isa));
+	}
+	printf(" %10s %10s %10s %10s\n", "vs float", "vs exact", "float vs", "weight err");
+
+	for (int width = 3; width <= 21; width += 6)
+	{
+		float weights[21], offsets[21];
+		float weightsBilinear[11], offsetsBilinear[11];
+		KernelGaussian1d(width, (float)width / 6.0f, weights);
+		for (int i = 0; i < width; ++i)
+		{
+			offsets[i] = (float)(i - width / 2);
+		}
+		KernelOptimizeBilinear1d(width, weights, weightsBilinear, offsetsBilinear);
+
+		for (int bilinear = 0; bilinear < 2; ++bilinear)
+		{
+			SeparableKernel kernel;
+			if (bilinear)
+			{
+				kernel.init(weightsBilinear, offsetsBilinear, width / 2 + 1);
+			}
+			else
+			{
+				kernel.init(weights, offsets, width);
+			}
+			SeparableKernelFixed kernelFixed;
+			kernelFixed.init(kernel);
+
+			printf("%-6d %-10s", width, bilinear ? "bilinear" : "separable");
+			for (Isa isa = Isa_Scalar; isa <= bestIsa; ++isa)
+			{
+				SetIsa(isa);
+				const double msFloat = bench::Measure([&]{ ConvolveSeparable(src, dstFloat, tmp, kernel); }, 200.0);
+				const double msFixed = bench::Measure([&]{ ConvolveSeparableFixed(src, dstFixed, tmp, kernelFixed); }, 200.0);
+				printf(" %8.1f/%8.1f", bench::GetMPixPerSec(kSize, kSize, msFloat), bench::GetMPixPerSec(kSize, kSize, msFixed));
+			}
+			SetIsa(bestIsa);
+
+			ConvolvePass(src, tmpExact, kernel, Direction_Horizontal);
+			ConvolvePass(tmpExact, dstExact, kernel, Direction_Vertical);
+			printf(" %10d %10d %10d %10.1e\n", GetMaxDeviation(dstFloat, dstFixed), GetMaxDeviation(dstExact, dstFixed), GetMaxDeviation(dstExact, dstFloat), kernelFixed.getMaxWeightError());
+
+		 // weights sum to exactly 1, a constant image must be unchanged
+			Image constantDst;
+			constantDst.init(64, 64, Format_RGBA8);
+			ConvolveSeparableFixed(constant, constantDst, tmp, kernelFixed);
+			if (GetMaxDeviation(constant, constantDst) != 0)
+			{
+				printf("  ERROR: constant image changed\n");
+			}
+		}
+	}
+	printf("\n");
+}
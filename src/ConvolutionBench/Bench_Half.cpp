@@ -0,0 +1,147 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Half.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Line.h>
+#include <ConvolutionLib/Pyramid.h>
+#include <ConvolutionLib/Simd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+// Max error of _b relative to _a, as RGBA float. Values below the smallest normal half (2^-14) are compared relative to
+// 2^-14, half denormals have fewer significant bits.
+float GetMaxRelativeError(const Image& _a, const Image& _b)
+{
+	std::vector<float> a(_a.getWidth() * 4), b(_b.getWidth() * 4);
+	float ret = 0.0f;
+	for (int y = 0; y < _a.getHeight(); ++y)
+	{
+		ReadLine(_a, Direction_Horizontal, y, 0, _a.getWidth(), a.data());
+		ReadLine(_b, Direction_Horizontal, y, 0, _b.getWidth(), b.data());
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			ret = fmaxf(ret, fabsf(a[i] - b[i]) / fmaxf(fabsf(a[i]), 6.103515625e-05f));
+		}
+	}
+	return ret;
+}
+
+// HDR test image, the test pattern scaled by a horizontal exponential ramp over [2^-8, 2^8].
+void InitHdrImage(Image& img_, int _size, Format _format)
+{
+	Image pattern;
+	bench::InitTestPattern(pattern, _size, _size, Format_RGBA32F);
+	img_.init(_size, _size, _format);
+	for (int y = 0; y < _size; ++y)
+	{
+		for (int x = 0; x < _size; ++x)
+		{
+			float rgba[4];
+			pattern.readTexel(x, y, rgba);
+			const float scale = exp2f(-8.0f + 16.0f * (float)x / (float)_size);
+			for (float& c : rgba)
+			{
+				c *= scale;
+			}
+			img_.writeTexel(x, y, rgba);
+		}
+	}
+}
+
+} // namespace
+
+// Half float storage: conversion correctness and throughput per instruction set, then RGBA16F vs. RGBA32F images for the
+// separable convolution and the pyramid blur (footprint, time, error vs. RGBA32F).
+void Bench_Half()
+{
+	const Isa bestIsa = GetIsa();
+
+	{	int roundTripErrors = 0, mismatches = 0;
+		for (uint32_t h = 0; h < 0x10000u; ++h)
+		{
+			const bool isNan = (h & 0x7c00u) == 0x7c00u && (h & 0x3ffu) != 0;
+			roundTripErrors += !isNan && FloatToHalf(HalfToFloat((uint16_t)h)) != h ? 1 : 0;
+		}
+	 // scalar vs. F16C over a sweep of float bit patterns (NaN payloads may differ)
+		std::vector<float> f;
+		for (uint64_t u = 0; u < (1ull << 32); u += 997)
+		{
+			float v;
+			const uint32_t u32 = (uint32_t)u;
+			memcpy(&v, &u32, sizeof(v));
+			if (!std::isnan(v))
+			{
+				f.push_back(v);
+			}
+		}
+		std::vector<uint16_t> hScalar(f.size()), hBest(f.size());
+		SetIsa(Isa_Scalar);
+		ConvertFloatToHalf(f.data(), hScalar.data(), f.size());
+		SetIsa(bestIsa);
+		ConvertFloatToHalf(f.data(), hBest.data(), f.size());
+		for (size_t i = 0; i < f.size(); ++i)
+		{
+			mismatches += hScalar[i] != hBest[i] ? 1 : 0;
+		}
+		printf("Half round trip errors: %d, scalar vs. %s mismatches: %d/%d\n\n", roundTripErrors, GetIsaName(bestIsa), mismatches, (int)f.size());
+	}
+
+	{	const size_t kCount = 1 << 22;
+		std::vector<float> f(kCount);
+		std::vector<uint16_t> h(kCount);
+		for (size_t i = 0; i < kCount; ++i)
+		{
+			f[i] = (float)i / (float)kCount;
+		}
+		printf("Conversion (GB/s of f32)\n%-8s %12s %12s\n", "isa", "f32 -> f16", "f16 -> f32");
+		for (Isa isa : { (Isa)Isa_Scalar, bestIsa })
+		{
+			SetIsa(isa);
+			const double msToHalf   = bench::Measure([&]{ ConvertFloatToHalf(f.data(), h.data(), kCount); bench::DoNotOptimize(h[kCount / 2]); });
+			const double msToFloat  = bench::Measure([&]{ ConvertHalfToFloat(h.data(), f.data(), kCount); bench::DoNotOptimize(f[kCount / 2]); });
+			const double gb = (double)(kCount * sizeof(float)) / 1e9;
+			printf("%-8s %12.2f %12.2f\n", GetIsaName(isa), gb / (msToHalf / 1e3), gb / (msToFloat / 1e3));
+		}
+		SetIsa(bestIsa);
+		printf("\n");
+	}
+
+	const int kSize = bench::g_maxImageSize < 2048 ? bench::g_maxImageSize : 2048;
+	float weights[21], offsets[21];
+	KernelGaussian1d(21, 3.5f, weights);
+	for (int i = 0; i < 21; ++i)
+	{
+		offsets[i] = (float)(i - 21 / 2);
+	}
+	SeparableKernel kernel;
+	kernel.init(weights, offsets, 21);
+
+	Image src32, dst32, tmp, src16, dst16;
+	InitHdrImage(src32, kSize, Format_RGBA32F);
+	InitHdrImage(src16, kSize, Format_RGBA16F);
+	dst32.init(kSize, kSize, Format_RGBA32F);
+	dst16.init(kSize, kSize, Format_RGBA16F);
+
+	printf("HDR %dx%d, 1 thread (ms, footprint of src + dst + intermediates in MB)\n", kSize, kSize);
+	printf("%-22s %10s %10s %10s %10s %12s\n", "", "RGBA32F", "MB", "RGBA16F", "MB", "rel error");
+
+	const double msSep32 = bench::Measure([&]{ ConvolveSeparable(src32, dst32, tmp, kernel); }, 200.0);
+	const double msSep16 = bench::Measure([&]{ ConvolveSeparable(src16, dst16, tmp, kernel); }, 200.0);
+	printf("%-22s %10.2f %10.1f %10.2f %10.1f %12.2e\n", "separable 21", msSep32, 3.0 * (double)dst32.getSize() / 1e6, msSep16, 3.0 * (double)dst16.getSize() / 1e6, GetMaxRelativeError(dst32, dst16));
+
+	PyramidBlur pyramid32, pyramid16;
+	pyramid16.setLevelFormat(Format_RGBA16F);
+	const double levelsSize = 1.0 / 3.0; // sum of 1/4^i, i > 0
+	const double msPyr32 = bench::Measure([&]{ pyramid32.blur(src32, dst32, 4); }, 200.0);
+	const double msPyr16 = bench::Measure([&]{ pyramid16.blur(src16, dst16, 4); }, 200.0);
+	printf("%-22s %10.2f %10.1f %10.2f %10.1f %12.2e\n", "pyramid 4 levels", msPyr32, (2.0 + levelsSize) * (double)dst32.getSize() / 1e6, msPyr16, (2.0 + levelsSize) * (double)dst16.getSize() / 1e6, GetMaxRelativeError(dst32, dst16));
+	printf("\n");
+}
@@ -0,0 +1,53 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/BoxFilter.h>
+#include <ConvolutionLib/Kernel.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace conv;
+
+// Iterated box Gaussian approximation: box widths, error vs. KernelGaussian1d() and throughput per pass count.
+void Bench_IteratedBox()
+{
+	const float kSigmas[] = { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f };
+	const int kSize = bench::g_maxImageSize < 1024 ? bench::g_maxImageSize : 1024;
+
+	Image src, dst, tmp;
+	bench::InitTestImage(src, kSize, kSize, Format_RGBA8);
+	dst.init(kSize, kSize, Format_RGBA8);
+
+	printf("RGBA8 %dx%d, error vs. KernelGaussian1d of the same size\n", kSize, kSize);
+	printf("%-6s %-7s %-20s %10s %12s %10s %8s\n", "sigma", "passes", "widths", "eff sigma", "max error", "% of peak", "MPix/s");
+	for (float sigma : kSigmas)
+	{
+		for (int passCount = 3; passCount <= 5; ++passCount)
+		{
+			int widths[5];
+			GaussianFindBoxWidths(sigma, passCount, widths);
+
+			char widthsStr[64] = {};
+			for (int i = 0, n = 0; i < passCount; ++i)
+			{
+				n += snprintf(widthsStr + n, sizeof(widthsStr) - n, i == 0 ? "%d" : ",%d", widths[i]);
+			}
+
+		 // effective sigma from the variance of the kernel, error relative to the Gaussian's peak
+			const int size = KernelIteratedBoxSize(widths, passCount);
+			std::vector<float> kernel(size), gaussian(size);
+			KernelIteratedBox1d(widths, passCount, kernel.data());
+			KernelGaussian1d(size, sigma, gaussian.data());
+			double variance = 0.0;
+			for (int i = 0; i < size; ++i)
+			{
+				variance += (double)kernel[i] * (double)((i - size / 2) * (i - size / 2));
+			}
+			const float maxError = GaussianBoxMaxError(sigma, widths, passCount);
+
+			double ms = bench::Measure([&]{ BoxFilter(src, dst, tmp, widths, passCount); }, 200.0);
+			printf("%-6.0f %-7d %-20s %10.2f %12.2e %9.2f%% %8.1f\n", sigma, passCount, widthsStr, sqrt(variance), maxError, maxError / gaussian[size / 2] * 100.0f, bench::GetMPixPerSec(kSize, kSize, ms));
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Kernel.h>
+
+#include <cstdio>
+
+using namespace conv;
+
+// Cost of generating kernels at runtime (as Convolution::initKernel does) vs. copying a constexpr table.
+void Bench_Kernel()
+{
+	float weights[21 * 21];
+	float weightsOpt[11 * 11];
+	float offsetsOpt[11 * 11 * 2];
+
+	printf("%-6s %14s %14s %14s %14s %14s %14s\n", "size", "gaussian1d", "gaussian2d", "binomial1d", "binomial2d", "bilinear2d", "findSigma");
+	for (int size = 3; size <= 21; size += 2)
+	{
+		double gaussian1d = bench::Measure([&]{ KernelGaussian1d(size, 2.0f, weights); bench::DoNotOptimize(weights[0]); }, 20.0);
+		double gaussian2d = bench::Measure([&]{ KernelGaussian2d(size, 2.0f, weights); bench::DoNotOptimize(weights[0]); }, 20.0);
+		double binomial1d = bench::Measure([&]{ KernelBinomial1d(size, weights); bench::DoNotOptimize(weights[0]); }, 20.0);
+		double binomial2d = bench::Measure([&]{ KernelBinomial2d(size, weights); bench::DoNotOptimize(weights[0]); }, 20.0);
+		double bilinear2d = bench::Measure([&]{ KernelOptimizeBilinear2d(size, weights, weightsOpt, offsetsOpt); bench::DoNotOptimize(weightsOpt[0]); }, 20.0);
+		double findSigma  = bench::Measure([&]{ bench::DoNotOptimize(GaussianFindSigma(size, 1.0f / 255.0f)); }, 20.0);
+		printf("%-6d %12.3fus %12.3fus %12.3fus %12.3fus %12.3fus %12.3fus\n", size,
+			gaussian1d * 1e3, gaussian2d * 1e3, binomial1d * 1e3, binomial2d * 1e3, bilinear2d * 1e3, findSigma * 1e3);
+	}
+
+ // constexpr tables are baked into the binary, 'generating' them is a copy
+	static constexpr auto kGaussian9  = MakeKernelGaussian1d<9>(2.0f);
+	static constexpr auto kGaussian21 = MakeKernelBilinear(MakeKernelGaussian2d<21>(4.0f));
+	static constexpr auto kBinomial5  = MakeKernelBinomial1d<5>();
+	KernelTable1d<9> gaussian9 = {};
+	BilinearKernelTable2d<21> gaussian21 = {};
+	KernelTable1d<5> binomial5 = {};
+	double gaussian9Ms  = bench::Measure([&]{ gaussian9  = kGaussian9;  bench::DoNotOptimize(gaussian9.weights[0]);  }, 20.0);
+	double gaussian21Ms = bench::Measure([&]{ gaussian21 = kGaussian21; bench::DoNotOptimize(gaussian21.weights[0]); }, 20.0);
+	double binomial5Ms  = bench::Measure([&]{ binomial5  = kBinomial5;  bench::DoNotOptimize(binomial5.weights[0]);  }, 20.0);
+	printf("\nconstexpr Gaussian 9 %.3fus, bilinear Gaussian 21x21 %.3fus, binomial 5 %.3fus\n", gaussian9Ms * 1e3, gaussian21Ms * 1e3, binomial5Ms * 1e3);
+
+ // max difference between the compile time and runtime tables (should be 0)
+	float maxError = 0.0f;
+	KernelGaussian1d(9, 2.0f, weights);
+	for (int i = 0; i < 9; ++i)
+	{
+		float err = weights[i] - kGaussian9.weights[i];
+		maxError = err > maxError ? err : (-err > maxError ? -err : maxError);
+	}
+	printf("constexpr vs. runtime Gaussian 9 max error %g\n", maxError);
+}
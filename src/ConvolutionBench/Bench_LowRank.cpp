@@ -0,0 +1,128 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/ConvolveFft.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/LowRank.h>
+#include <ConvolutionLib/ThreadPool.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+const float kTolerances[] = { 1e-2f, 1e-3f, 1e-4f };
+
+struct TestKernel
+{
+	const char*        m_name;
+	int                m_size;
+	std::vector<float> m_weights;
+};
+
+// Gaussian with sigmas _sigmaX, _sigmaY rotated by _angle, not separable unless _angle is a multiple of pi/2.
+void KernelRotatedGaussian2d(int _size, float _sigmaX, float _sigmaY, float _angle, float* weights_)
+{
+	const float c = cosf(_angle), s = sinf(_angle);
+	float sum = 0.0f;
+	for (int y = 0; y < _size; ++y)
+	{
+		for (int x = 0; x < _size; ++x)
+		{
+			const float dx = (float)(x - _size / 2), dy = (float)(y - _size / 2);
+			const float u = (c * dx + s * dy) / _sigmaX;
+			const float v = (c * dy - s * dx) / _sigmaY;
+			weights_[y * _size + x] = expf(-0.5f * (u * u + v * v));
+			sum += weights_[y * _size + x];
+		}
+	}
+	for (int i = 0; i < _size * _size; ++i)
+	{
+		weights_[i] /= sum;
+	}
+}
+
+std::vector<TestKernel> GetTestKernels()
+{
+	std::vector<TestKernel> ret;
+	for (int size : { 15, 31, 63 })
+	{
+		TestKernel kernel = { "disc", size, std::vector<float>(size * size) };
+		KernelDisc2d(size, kernel.m_weights.data());
+		ret.push_back(kernel);
+	}
+	{	TestKernel kernel = { "rotated gauss", 31, std::vector<float>(31 * 31) };
+		KernelRotatedGaussian2d(31, 8.0f, 2.0f, kPi / 6.0f, kernel.m_weights.data());
+		ret.push_back(kernel);
+	}
+	{	TestKernel kernel = { "gaussian", 31, std::vector<float>(31 * 31) };
+		KernelGaussian2d(31, 5.0f, kernel.m_weights.data());
+		ret.push_back(kernel);
+	}
+	{	TestKernel kernel = { "binomial", 31, std::vector<float>(31 * 31) };
+		KernelBinomial2d(31, kernel.m_weights.data());
+		ret.push_back(kernel);
+	}
+	return ret;
+}
+
+} // namespace
+
+// Low rank separable decomposition: rank per tolerance, image error vs. the direct 2d convolution and time vs. the direct
+// and FFT methods.
+void Bench_LowRank()
+{
+	const std::vector<TestKernel> kernels = GetTestKernels();
+	ThreadPool pool(bench::g_maxThreads);
+
+	{	const int kSize = bench::g_maxImageSize < 256 ? bench::g_maxImageSize : 256;
+		Image src, dstDirect, dstLowRank, tmp;
+		bench::InitTestPattern(src, kSize, kSize, Format_RGBA32F);
+		dstDirect.init(kSize, kSize, Format_RGBA32F);
+		dstLowRank.init(kSize, kSize, Format_RGBA32F);
+
+		printf("Rank (weight error relative to max weight, image max error) RGBA32F %dx%d\n", kSize, kSize);
+		printf("%-14s %-5s", "kernel", "size");
+		for (float tolerance : kTolerances)
+		{
+			printf(" %9s %-18.0e", "tol", tolerance);
+		}
+		printf("\n");
+		for (const TestKernel& kernel : kernels)
+		{
+			Convolve2d(pool, src, dstDirect, kernel.m_weights.data(), kernel.m_size);
+			printf("%-14s %-5d", kernel.m_name, kernel.m_size);
+			for (float tolerance : kTolerances)
+			{
+				LowRankKernel lowRank;
+				lowRank.init(kernel.m_weights.data(), kernel.m_size, tolerance);
+				ConvolveLowRank(pool, src, dstLowRank, tmp, lowRank);
+				printf(" %9d %8.1e %8.1e ", lowRank.getRank(), lowRank.getError(), bench::GetMaxError(dstDirect, dstLowRank));
+			}
+			printf("\n");
+		}
+		printf("\n");
+	}
+
+	const int kSize = bench::g_maxImageSize < 1024 ? bench::g_maxImageSize : 1024;
+	Image src, dst, tmp;
+	bench::InitTestImage(src, kSize, kSize, Format_RGBA8);
+	dst.init(kSize, kSize, Format_RGBA8);
+
+	printf("RGBA8 %dx%d, %d threads, tolerance 1e-3 (ms)\n", kSize, kSize, pool.getThreadCount());
+	printf("%-14s %-5s %6s %10s %10s %10s\n", "kernel", "size", "rank", "direct", "low rank", "fft");
+	for (const TestKernel& kernel : kernels)
+	{
+		LowRankKernel lowRank;
+		lowRank.init(kernel.m_weights.data(), kernel.m_size, 1e-3f);
+		FftKernel fft;
+		fft.init(kernel.m_weights.data(), kernel.m_size, kSize, kSize);
+
+		const double msDirect  = bench::Measure([&]{ Convolve2d(pool, src, dst, kernel.m_weights.data(), kernel.m_size); }, 200.0);
+		const double msLowRank = bench::Measure([&]{ ConvolveLowRank(pool, src, dst, tmp, lowRank); }, 200.0);
+		const double msFft     = bench::Measure([&]{ ConvolveFft(pool, src, dst, fft); }, 200.0);
+		printf("%-14s %-5d %6d %10.2f %10.2f %10.2f\n", kernel.m_name, kernel.m_size, lowRank.getRank(), msDirect, msLowRank, msFft);
+	}
+}
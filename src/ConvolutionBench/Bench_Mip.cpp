@@ -0,0 +1,57 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Pyramid.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace conv;
+
+// Single traversal mip chain build vs. the level by level loop, per filter and level format: time, memory traffic
+// (image bytes read + written, ignoring caches) and a check that the levels are identical.
+void Bench_Mip()
+{
+	const int kSize = bench::g_maxImageSize < 4096 ? bench::g_maxImageSize : 4096;
+	const int kLevelCount = 8;
+
+	Image src;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+
+	printf("RGBA8 %dx%d source, %d levels, 1 thread (ms, MB)\n", kSize, kSize, kLevelCount);
+	printf("%-14s %-8s %10s %10s %10s %10s %8s %10s\n", "filter", "levels", "per level", "MB", "single", "MB", "speedup", "result");
+	const Format kLevelFormats[] = { Format_RGBA32F, Format_RGBA16F, Format_RGBA8 };
+	for (MipFilter filter = 0; filter < MipFilter_Count; ++filter)
+	{
+		for (Format format : kLevelFormats)
+		{
+			MipChain perLevel, single;
+			perLevel.setLevelFormat(format);
+			single.setLevelFormat(format);
+
+		 // alternate the builds and keep the best of several runs
+			double msPerLevel = 1e30, msSingle = 1e30;
+			for (int run = 0; run < 3; ++run)
+			{
+				const double a = bench::Measure([&]{ perLevel.buildPerLevel(src, kLevelCount, filter); });
+				const double b = bench::Measure([&]{ single.build(src, kLevelCount, filter); });
+				msPerLevel = a < msPerLevel ? a : msPerLevel;
+				msSingle   = b < msSingle   ? b : msSingle;
+			}
+
+		 // both read the source and write every level once, the level by level loop also reads back all but the last level
+			double mbWritten = 0.0, mbReadBack = 0.0;
+			bool equal = true;
+			for (int i = 1; i <= perLevel.getLevelCount(); ++i)
+			{
+				const Image& a = perLevel.getLevel(i);
+				const Image& b = single.getLevel(i);
+				mbWritten  += (double)a.getSize() / 1e6;
+				mbReadBack += i < perLevel.getLevelCount() ? (double)a.getSize() / 1e6 : 0.0;
+				equal &= a.getSize() == b.getSize() && memcmp(a.getData(), b.getData(), a.getSize()) == 0;
+			}
+			const double mbSrc = (double)src.getSize() / 1e6;
+			printf("%-14s %-8s %10.2f %10.1f %10.2f %10.1f %7.2fx %10s\n", GetMipFilterName(filter), GetFormatName(format), msPerLevel, mbSrc + mbWritten + mbReadBack, msSingle, mbSrc + mbWritten, msPerLevel / msSingle, equal ? "equal" : "DIFFERENT");
+		}
+	}
+	printf("\n");
+}
@@ -0,0 +1,134 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Prefilter.h>
+#include <ConvolutionLib/SamplePattern.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+// Mean power of the (mean removed) _size x _size texture _values for frequencies in (0, _size / 8] cycles, normalized
+// such that white noise is ~1. Blue noise is low, i.e. neighbouring texels are dissimilar.
+float GetLowFrequencyPower(const float* _values, int _size)
+{
+	const int count = _size * _size;
+	double mean = 0.0, variance = 0.0;
+	for (int i = 0; i < count; ++i)
+	{
+		mean += _values[i];
+	}
+	mean /= (double)count;
+	for (int i = 0; i < count; ++i)
+	{
+		variance += ((double)_values[i] - mean) * ((double)_values[i] - mean);
+	}
+	variance /= (double)count;
+
+	const int maxFrequency = _size / 8;
+	double power = 0.0;
+	int frequencyCount = 0;
+	for (int fy = -maxFrequency; fy <= maxFrequency; ++fy)
+	{
+		for (int fx = -maxFrequency; fx <= maxFrequency; ++fx)
+		{
+			const int f2 = fx * fx + fy * fy;
+			if (f2 == 0 || f2 > maxFrequency * maxFrequency)
+			{
+				continue;
+			}
+			double re = 0.0, im = 0.0;
+			for (int y = 0; y < _size; ++y)
+			{
+				for (int x = 0; x < _size; ++x)
+				{
+					const double phase = -2.0 * (double)kPi * (double)(fx * x + fy * y) / (double)_size;
+					const double v = (double)_values[y * _size + x] - mean;
+					re += v * cos(phase);
+					im += v * sin(phase);
+				}
+			}
+			power += (re * re + im * im) / ((double)count * variance);
+			++frequencyCount;
+		}
+	}
+	return (float)(power / (double)frequencyCount);
+}
+
+} // namespace
+
+// Optimized sample patterns vs. Hammersley + interleaved gradient noise (ConvolutionPrefiltered_cs.glsl): quality
+// metrics of the point sets and the rotation texture, then the sample count needed to reach the target PSNR in the
+// Mode_Prefilter CPU reference (see 'prefilter').
+void Bench_Patterns()
+{
+	SamplePatternSet patterns;
+	const double msInit = bench::Measure([&]{ patterns.init(); }, 0.0);
+	printf("SamplePatternSet::init() %.0fms (%d point sets, %dx%d rotation texture)\n\n", msInit, SamplePatternSet::kMaxSampleCount, SamplePatternSet::kRotationSize, SamplePatternSet::kRotationSize);
+
+	printf("Point sets (L2 star discrepancy, min distance vs. hexagonal packing, low frequency power vs. white noise)\n");
+	printf("%-8s %26s %26s\n", "", "Hammersley", "optimized");
+	printf("%-8s %8s %8s %8s %8s %8s %8s\n", "samples", "discr", "min dist", "low f", "discr", "min dist", "low f");
+	const int kCounts[] = { 2, 4, 8, 12, 16, 24, 32, 48, 64 };
+	for (int count : kCounts)
+	{
+		std::vector<float> hammersley(count * 2);
+		GenerateHammersley2d(count, hammersley.data());
+		const SamplePatternQuality a = GetSamplePatternQuality(hammersley.data(), count);
+		const SamplePatternQuality b = GetSamplePatternQuality(patterns.getPattern(count), count);
+		printf("%-8d %8.4f %8.3f %8.3f %8.4f %8.3f %8.3f\n", count, a.m_discrepancy, a.m_minDistance, a.m_lowFrequencyPower, b.m_discrepancy, b.m_minDistance, b.m_lowFrequencyPower);
+	}
+	printf("\n");
+
+	{	const int size = SamplePatternSet::kRotationSize;
+		std::vector<float> ign(size * size), blue(size * size), white(size * size);
+		uint32_t rng = 12345u;
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				const float f = ((float)x + 0.5f) * 0.06711056f + ((float)y + 0.5f) * 0.00583715f;
+				const float g = 52.9829189f * (f - floorf(f));
+				ign[y * size + x] = g - floorf(g);
+				rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+				white[y * size + x] = (float)(rng >> 8) / 16777216.0f;
+			}
+		}
+		GenerateBlueNoise(size, 1, blue.data());
+		printf("Rotation low frequency power (%dx%d, white noise ~1): interleaved gradient %.3f, blue noise %.3f, white %.3f\n\n", size, size, GetLowFrequencyPower(ign.data(), size), GetLowFrequencyPower(blue.data(), size), GetLowFrequencyPower(white.data(), size));
+	}
+
+	const int   kSize       = bench::g_maxImageSize < 256 ? bench::g_maxImageSize : 256;
+	Image src;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+	PrefilterBlur prefilter;
+	prefilter.init(src);
+	printf("Mode_Prefilter RGBA8 %dx%d test pattern, PSNR at the best LOD bias, Hammersley + IGN/optimized tables\n", kSize, kSize);
+	const int kSampleCounts[] = { 2, 4, 8, 16, 32 };
+	printf("%-6s", "width");
+	for (int sampleCount : kSampleCounts)
+	{
+		printf(" %16d", sampleCount);
+	}
+	printf("\n");
+	const int kBlurWidths[] = { 3, 9, 15, 21, 31, 45 };
+	for (int blurWidth : kBlurWidths)
+	{
+		printf("%-6d", blurWidth);
+		for (int sampleCount : kSampleCounts)
+		{
+		 // min = max sample count, an unreachable target returns the best bias at that count
+			prefilter.setSamplePatterns(nullptr);
+			const PrefilterSetting a = TunePrefilter(prefilter, blurWidth, 99.0f, sampleCount, sampleCount);
+			prefilter.setSamplePatterns(&patterns);
+			const PrefilterSetting b = TunePrefilter(prefilter, blurWidth, 99.0f, sampleCount, sampleCount);
+			printf("    %5.2f/%5.2fdB", a.m_psnr, b.m_psnr);
+		}
+		printf("\n");
+	}
+	printf("\n");
+}
@@ -0,0 +1,53 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Prefilter.h>
+#include <ConvolutionLib/SamplePattern.h>
+
+#include <cstdio>
+
+using namespace conv;
+
+// Mode_Prefilter auto tuning: per blur width the cheapest sample count and LOD bias which meet the target PSNR vs. the
+// reference Gaussian, and the PSNR of the sample's defaults for comparison. With --json the table is written to the
+// file at the given path, the sample reads it from data/Convolution/PrefilterTable.json (see Convolution::m_prefilterAuto).
+void Bench_Prefilter()
+{
+	const int   kSize       = bench::g_maxImageSize < 256 ? bench::g_maxImageSize : 256;
+	const float kTargetPsnr = 30.0f;
+	const int   kBlurWidths[] = { 2, 3, 5, 9, 15, 21, 31, 45, 64 };
+	const int   kDefaultSampleCount = 8;    // Convolution::m_prefilterSampleCount
+	const float kDefaultLodBias     = 1.0f; // Convolution::m_prefilterLodBias
+
+	Image src;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+	PrefilterBlur prefilter;
+	prefilter.init(src);
+
+	printf("RGBA8 %dx%d test pattern, target PSNR %.1fdB vs. Gaussian sigma = radius / sqrt(3)\n", kSize, kSize, kTargetPsnr);
+	printf("%-6s %14s %8s %8s %9s %10s\n", "width", "default PSNR", "samples", "bias", "PSNR", "tune ms");
+	PrefilterSetting settings[sizeof(kBlurWidths) / sizeof(kBlurWidths[0])];
+	int count = 0;
+	for (int blurWidth : kBlurWidths)
+	{
+		const float psnrDefault = GetPrefilterPsnr(prefilter, blurWidth, kDefaultSampleCount, kDefaultLodBias);
+		bench::Timer timer;
+		const PrefilterSetting setting = TunePrefilter(prefilter, blurWidth, kTargetPsnr, SamplePatternSet::kMaxSampleCount);
+		const double ms = timer.getElapsedMs();
+		settings[count++] = setting;
+		printf("%-6d %12.2fdB %8d %8.3f %8.2fdB%s %10.0f\n", blurWidth, psnrDefault, setting.m_sampleCount, setting.m_lodBias, setting.m_psnr, setting.m_psnr < kTargetPsnr ? "*" : " ", ms);
+	}
+	printf("* target not met at the max sample count\n");
+
+	if (bench::g_jsonPath)
+	{
+		if (WritePrefilterTable(bench::g_jsonPath, settings, count, kTargetPsnr))
+		{
+			printf("Wrote the table to '%s'\n", bench::g_jsonPath);
+		}
+		else
+		{
+			printf("ERROR: failed to write '%s'\n", bench::g_jsonPath);
+		}
+	}
+	printf("\n");
+}
@@ -0,0 +1,87 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Pyramid.h>
+#include <ConvolutionLib/RecursiveGaussian.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+// FIR separable Gaussian truncated at +-3 sigma.
+void GaussianFir(const Image& _src, Image& dst_, Image& tmp_, float _sigma)
+{
+	const int width = (int)ceilf(_sigma * 3.0f) * 2 + 1;
+	std::vector<float> weights(width), offsets(width);
+	KernelGaussian1d(width, _sigma, weights.data());
+	for (int i = 0; i < width; ++i)
+	{
+		offsets[i] = (float)(i - width / 2);
+	}
+	SeparableKernel kernel;
+	kernel.init(weights.data(), offsets.data(), width);
+	ConvolveSeparable(_src, dst_, tmp_, kernel);
+}
+
+} // namespace
+
+// Pyramid (dual filter) blur vs. the separable Gaussian which it best matches: PSNR and time per level count.
+void Bench_Pyramid()
+{
+	const int kSize = bench::g_maxImageSize < 1024 ? bench::g_maxImageSize : 1024;
+	Image src, dst, ref, tmp;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+	dst.init(kSize, kSize, Format_RGBA8);
+	ref.init(kSize, kSize, Format_RGBA8);
+
+	printf("RGBA8 %dx%d test pattern. Sigma is the separable Gaussian with the best PSNR vs. the pyramid.\n", kSize, kSize);
+	printf("%-7s %8s %9s %12s %14s %14s\n", "levels", "sigma", "PSNR", "pyramid ms", "separable ms", "recursive ms");
+	PyramidBlur pyramid;
+	for (int levelCount = 1; levelCount <= 6; ++levelCount)
+	{
+		pyramid.blur(src, dst, levelCount);
+
+	 // golden section search for the sigma which maximizes the PSNR
+		auto getPsnr = [&](float _sigma)
+			{
+				GaussianFir(src, ref, tmp, _sigma);
+				return bench::GetPsnr(ref, dst);
+			};
+		float lo = 0.25f * (float)(1 << levelCount);
+		float hi = 1.5f * (float)(1 << levelCount);
+		const float kInvPhi = 0.618034f;
+		float a = hi - (hi - lo) * kInvPhi;
+		float b = lo + (hi - lo) * kInvPhi;
+		double psnrA = getPsnr(a);
+		double psnrB = getPsnr(b);
+		while (hi - lo > 0.02f * (float)(1 << levelCount))
+		{
+			if (psnrA > psnrB)
+			{
+				hi = b; b = a; psnrB = psnrA;
+				a = hi - (hi - lo) * kInvPhi;
+				psnrA = getPsnr(a);
+			}
+			else
+			{
+				lo = a; a = b; psnrA = psnrB;
+				b = lo + (hi - lo) * kInvPhi;
+				psnrB = getPsnr(b);
+			}
+		}
+		const float  sigma = (lo + hi) * 0.5f;
+		const double psnr  = getPsnr(sigma);
+
+		RecursiveGaussianKernel recursiveKernel;
+		recursiveKernel.init(sigma);
+		double msPyramid   = bench::Measure([&]{ pyramid.blur(src, dst, levelCount); }, 200.0);
+		double msSeparable = bench::Measure([&]{ GaussianFir(src, ref, tmp, sigma); }, 200.0);
+		double msRecursive = bench::Measure([&]{ RecursiveGaussian(src, ref, tmp, recursiveKernel); }, 200.0);
+		printf("%-7d %8.2f %7.2fdB %12.2f %14.2f %14.2f\n", levelCount, sigma, psnr, msPyramid, msSeparable, msRecursive);
+	}
+}
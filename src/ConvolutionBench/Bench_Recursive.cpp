@@ -0,0 +1,86 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/RecursiveGaussian.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+const float kSigmas[] = { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f };
+
+// Width of the FIR kernel with the same support as the reference (+-3 sigma, as GaussianFindSigma()'s epsilon implies).
+int GetFirWidth(float _sigma)
+{
+	return (int)ceilf(_sigma * 3.0f) * 2 + 1;
+}
+
+} // namespace
+
+// Recursive Gaussian accuracy (impulse response vs. KernelGaussian1d()) and throughput vs. the tap loop.
+void Bench_Recursive()
+{
+	printf("Impulse response vs. KernelGaussian1d (+-6 sigma)\n");
+	printf("%-6s %12s %12s %12s\n", "sigma", "max error", "% of peak", "L1 error");
+	for (float sigma : kSigmas)
+	{
+		const int radius = (int)ceilf(sigma * 6.0f);
+		const int width  = radius * 2 + 1;
+		std::vector<float> reference(width);
+		KernelGaussian1d(width, sigma, reference.data());
+
+	 // filter an impulse in the middle of a line long enough for the edges to be irrelevant
+		const int lineLength = width * 4;
+		std::vector<float> line(lineLength * 4, 0.0f);
+		line[(lineLength / 2) * 4] = 1.0f;
+		Image src, dst;
+		src.initView(lineLength, 1, Format_RGBA32F, line.data(), lineLength * 4 * sizeof(float));
+		dst.init(lineLength, 1, Format_RGBA32F);
+		RecursiveGaussianKernel kernel;
+		kernel.init(sigma);
+		RecursiveGaussianPass(src, dst, kernel, Direction_Horizontal);
+
+		const float* response = (const float*)dst.getData();
+		float maxError = 0.0f, l1Error = 0.0f;
+		for (int x = 0; x < lineLength; ++x)
+		{
+			const int i = x - (lineLength / 2 - radius);
+			const float err = fabsf(response[x * 4] - (i >= 0 && i < width ? reference[i] : 0.0f));
+			maxError = fmaxf(maxError, err);
+			l1Error += err;
+		}
+		printf("%-6.0f %12.2e %11.2f%% %12.2e\n", sigma, maxError, maxError / reference[radius] * 100.0f, l1Error);
+	}
+	printf("\n");
+
+	const int kSize = bench::g_maxImageSize < 1024 ? bench::g_maxImageSize : 1024;
+	Image src, dst, tmp;
+	bench::InitTestImage(src, kSize, kSize, Format_RGBA8);
+	dst.init(kSize, kSize, Format_RGBA8);
+
+	printf("RGBA8 %dx%d (MPix/s)\n", kSize, kSize);
+	printf("%-6s %10s %10s %10s\n", "sigma", "fir width", "tap loop", "recursive");
+	for (float sigma : kSigmas)
+	{
+		const int width = GetFirWidth(sigma);
+		std::vector<float> weights(width), offsets(width);
+		KernelGaussian1d(width, sigma, weights.data());
+		for (int i = 0; i < width; ++i)
+		{
+			offsets[i] = (float)(i - width / 2);
+		}
+		SeparableKernel firKernel;
+		firKernel.init(weights.data(), offsets.data(), width);
+		RecursiveGaussianKernel iirKernel;
+		iirKernel.init(sigma);
+
+		double msFir = bench::Measure([&]{ ConvolveSeparable(src, dst, tmp, firKernel); }, 200.0);
+		double msIir = bench::Measure([&]{ RecursiveGaussian(src, dst, tmp, iirKernel); }, 200.0);
+		printf("%-6.0f %10d %10.1f %10.1f\n", sigma, width, bench::GetMPixPerSec(kSize, kSize, msFir), bench::GetMPixPerSec(kSize, kSize, msIir));
+	}
+}
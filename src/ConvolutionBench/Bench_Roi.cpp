@@ -0,0 +1,133 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Region.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+// Invert the texels of _rect (a visible edit).
+void Edit(Image& img_, const Rect& _rect)
+{
+	for (int y = _rect.m_y0; y < _rect.m_y1; ++y)
+	{
+		for (int x = _rect.m_x0; x < _rect.m_x1; ++x)
+		{
+			float rgba[4];
+			img_.readTexel(x, y, rgba);
+			rgba[0] = 1.0f - rgba[0];
+			rgba[1] = 1.0f - rgba[1];
+			rgba[2] = 1.0f - rgba[2];
+			img_.writeTexel(x, y, rgba);
+		}
+	}
+}
+
+// Compare the texels of _rect.
+bool Equal(const Image& _a, const Image& _b, const Rect& _rect)
+{
+	for (int y = _rect.m_y0; y < _rect.m_y1; ++y)
+	{
+		const char* a = (const char*)_a.getRow(y) + _a.getTexelSize() * _rect.m_x0;
+		const char* b = (const char*)_b.getRow(y) + _b.getTexelSize() * _rect.m_x0;
+		if (memcmp(a, b, _a.getTexelSize() * _rect.getWidth()) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+// Dirty rectangle/region of interest convolution: small edits on a large image recomputed via ConvolveSeparableDirty()
+// vs. the whole image, and a viewport via ConvolveSeparableRect(). Results are compared with a full convolution.
+void Bench_Roi()
+{
+	const int kSize        = bench::g_maxImageSize < 2048 ? bench::g_maxImageSize : 2048;
+	const int kKernelWidth = 21;
+
+	float weights[kKernelWidth], offsets[kKernelWidth];
+	KernelGaussian1d(kKernelWidth, (float)kKernelWidth / 6.0f, weights);
+	for (int i = 0; i < kKernelWidth; ++i)
+	{
+		offsets[i] = (float)(i - kKernelWidth / 2);
+	}
+	SeparableKernel kernel;
+	kernel.init(weights, offsets, kKernelWidth);
+
+	Image src, dst, tmp, ref, refTmp;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+	dst.init(kSize, kSize, Format_RGBA8);
+	ref.init(kSize, kSize, Format_RGBA8);
+	ConvolveSeparable(src, dst, tmp, kernel);
+	const double msFull = bench::Measure([&]{ ConvolveSeparable(src, ref, refTmp, kernel); });
+
+	struct Workload
+	{
+		const char*       m_name;
+		std::vector<Rect> m_rects;
+	};
+	Workload workloads[3];
+	workloads[0].m_name = "brush";     // a single 16x16 dab
+	workloads[0].m_rects.push_back(Rect(kSize / 3, kSize / 3, kSize / 3 + 16, kSize / 3 + 16));
+	workloads[1].m_name = "stroke";    // 64 overlapping 8x8 dabs along a diagonal
+	for (int i = 0; i < 64; ++i)
+	{
+		const int x = kSize / 4 + i * 4;
+		const int y = kSize / 2 + i * 2;
+		workloads[1].m_rects.push_back(Rect(x, y, x + 8, y + 8));
+	}
+	workloads[2].m_name = "scattered"; // 16 32x32 edits spread over the image, including the edges
+	for (int i = 0; i < 16; ++i)
+	{
+		const int x = (i % 4) * (kSize - 32) / 3;
+		const int y = (i / 4) * (kSize - 32) / 3;
+		workloads[2].m_rects.push_back(Rect(x, y, x + 32, y + 32));
+	}
+
+	printf("RGBA8 %dx%d, separable width %d, full image %.2fms\n", kSize, kSize, kKernelWidth, msFull);
+	printf("%-10s %8s %10s %12s %10s %8s %8s\n", "", "rects", "dirty", "recomputed", "ms", "speedup", "result");
+	for (Workload& workload : workloads)
+	{
+		for (const Rect& rect : workload.m_rects)
+		{
+			Edit(src, rect);
+		}
+		std::vector<Rect> updated;
+		ConvolveSeparableDirty(src, dst, tmp, kernel, workload.m_rects.data(), (int)workload.m_rects.size(), &updated);
+		ConvolveSeparable(src, ref, refTmp, kernel);
+		const bool match = memcmp(dst.getData(), ref.getData(), dst.getSize()) == 0;
+
+		const double ms = bench::Measure([&]{ ConvolveSeparableDirty(src, dst, tmp, kernel, workload.m_rects.data(), (int)workload.m_rects.size()); });
+		std::vector<Rect> dirty = workload.m_rects;
+		MergeRects(dirty);
+		printf("%-10s %8d %9.3f%% %11.3f%% %10.3f %7.1fx %8s\n", workload.m_name, (int)workload.m_rects.size(),
+			100.0 * (double)GetArea(dirty) / ((double)kSize * kSize),
+			100.0 * (double)GetArea(updated) / ((double)kSize * kSize),
+			ms, msFull / ms, match ? "match" : "DIFFERS"
+			);
+	}
+
+	printf("\n%-10s %12s %10s %8s %8s\n", "viewport", "size", "ms", "speedup", "result");
+	const int kViewportSizes[] = { 256, 512, 1024 };
+	for (int viewportSize : kViewportSizes)
+	{
+		if (viewportSize > kSize)
+		{
+			break;
+		}
+		const Rect viewport(kSize - viewportSize, (kSize - viewportSize) / 2, kSize, (kSize - viewportSize) / 2 + viewportSize);
+		Image roiDst, roiTmp;
+		roiDst.init(kSize, kSize, Format_RGBA8);
+		const double ms = bench::Measure([&]{ ConvolveSeparableRect(src, roiDst, roiTmp, kernel, viewport); });
+		printf("%-10s %5dx%-6d %10.3f %7.1fx %8s\n", "", viewportSize, viewportSize, ms, msFull / ms, Equal(roiDst, ref, viewport) ? "match" : "DIFFERS");
+	}
+	printf("\n");
+}
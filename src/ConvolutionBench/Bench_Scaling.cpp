@@ -0,0 +1,56 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/ThreadPool.h>
+
+#include <cstdio>
+#include <thread>
+
+using namespace conv;
+
+// Multi-threaded separable Gaussian (9 taps, RGBA8) for 1..N threads and 512^2..16k^2 images. The single threaded
+// ConvolveSeparable() is the baseline.
+void Bench_Scaling()
+{
+	int maxThreads = bench::g_maxThreads > 0 ? bench::g_maxThreads : (int)std::thread::hardware_concurrency();
+	maxThreads = maxThreads < 1 ? 1 : maxThreads;
+
+	float weights[9], offsets[9];
+	KernelGaussian1d(9, 1.5f, weights);
+	for (int i = 0; i < 9; ++i)
+	{
+		offsets[i] = (float)(i - 4);
+	}
+	SeparableKernel kernel;
+	kernel.init(weights, offsets, 9);
+
+	printf("MPix/s, 9 tap Gaussian, RGBA8\n");
+	printf("%-8s %10s", "size", "baseline");
+	for (int threads = 1; threads <= maxThreads; ++threads)
+	{
+		printf(" %7d thr", threads);
+	}
+	printf("\n");
+
+	for (int size = 512; size <= bench::g_maxImageSize; size *= 2)
+	{
+		Image src, dst, tmp;
+		bench::InitTestImage(src, size, size, Format_RGBA8);
+		dst.init(size, size, Format_RGBA8);
+
+		const double minMs = 500.0;
+		double ms = bench::Measure([&]{ ConvolveSeparable(src, dst, tmp, kernel); }, minMs);
+		printf("%-8d %10.1f", size, bench::GetMPixPerSec(size, size, ms));
+		fflush(stdout);
+
+		for (int threads = 1; threads <= maxThreads; ++threads)
+		{
+			ThreadPool pool(threads);
+			ms = bench::Measure([&]{ ConvolveSeparable(pool, src, dst, tmp, kernel); }, minMs);
+			printf(" %11.1f", bench::GetMPixPerSec(size, size, ms));
+			fflush(stdout);
+		}
+		printf("\n");
+	}
+}
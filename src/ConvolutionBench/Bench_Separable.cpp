@@ -0,0 +1,67 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Simd.h>
+
+#include <cstdio>
+
+using namespace conv;
+
+// Separable Gaussian (Mode_Separable and Mode_SeparableBilinear weights) per instruction set and format.
+void Bench_Separable()
+{
+	const int kSize = 2048;
+	const Isa bestIsa = GetIsa();
+
+	for (Format format = 0; format < Format_Count; ++format)
+	{
+		Image src, dst, tmp;
+		bench::InitTestImage(src, kSize, kSize, format);
+		dst.init(kSize, kSize, format);
+
+		printf("%s %dx%d (MPix/s)\n", GetFormatName(format), kSize, kSize);
+		printf("%-6s %-10s", "width", "mode");
+		for (Isa isa = Isa_Scalar; isa <= bestIsa; ++isa)
+		{
+			printf(" %10s", GetIsaName(isa));
+		}
+		printf("\n");
+
+		for (int width = 3; width <= 21; width += 6)
+		{
+			float weights[21], offsets[21];
+			float weightsBilinear[11], offsetsBilinear[11];
+			KernelGaussian1d(width, (float)width / 6.0f, weights);
+			for (int i = 0; i < width; ++i)
+			{
+				offsets[i] = (float)(i - width / 2);
+			}
+			KernelOptimizeBilinear1d(width, weights, weightsBilinear, offsetsBilinear);
+
+			for (int bilinear = 0; bilinear < 2; ++bilinear)
+			{
+				SeparableKernel kernel;
+				if (bilinear)
+				{
+					kernel.init(weightsBilinear, offsetsBilinear, width / 2 + 1);
+				}
+				else
+				{
+					kernel.init(weights, offsets, width);
+				}
+
+				printf("%-6d %-10s", width, bilinear ? "bilinear" : "separable");
+				for (Isa isa = Isa_Scalar; isa <= bestIsa; ++isa)
+				{
+					SetIsa(isa);
+					double ms = bench::Measure([&]{ ConvolveSeparable(src, dst, tmp, kernel); }, 200.0);
+					printf(" %10.1f", bench::GetMPixPerSec(kSize, kSize, ms));
+				}
+				printf("\n");
+			}
+		}
+		printf("\n");
+	}
+	SetIsa(bestIsa);
+}
@@ -0,0 +1,156 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/ShaderCache.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+const char* kDataPath  = "data/Convolution"; // relative to the repository root
+const char* kCacheDir  = "ConvolutionBench_ShaderCache";
+const char* kShaders[] = { "shaders/ConvolutionBasic_cs.glsl", "shaders/ConvolutionCached_cs.glsl" };
+
+// frm's common shaders (shaders/def.glsl) aren't part of this repository.
+void InitPreprocessor(ShaderPreprocessor& preprocessor_)
+{
+	preprocessor_.addSearchPath(kDataPath);
+	preprocessor_.addFile("shaders/def.glsl", "#define k2Pi 6.28318530717958647692\n");
+}
+
+// The defines for one Convolution::initKernel() call, as per the sample.
+void GetDefines(int _type, int _mode, int _kernelSize, ShaderDefines* defines_)
+{
+	defines_[0].add("TYPE", _type);
+	defines_[0].add("MODE", _mode);
+	defines_[0].add("KERNEL_SIZE", _kernelSize);
+	for (int dimension = 0; dimension < 2; ++dimension)
+	{
+		defines_[1 + dimension] = defines_[0];
+		defines_[1 + dimension].add("MODE", 2); // Mode_Separable
+		defines_[1 + dimension].add("DIMENSION", dimension);
+	}
+}
+
+} // namespace
+
+// GLSL preprocessor + permutation cache: a kernel width slider sweep (3 shaders per Convolution::initKernel() call) with
+// and without the cache, then the permutations reloaded from disk with the same and a different binary tag.
+void Bench_ShaderCache()
+{
+	{	ShaderPreprocessor preprocessor;
+		InitPreprocessor(preprocessor);
+		if (!preprocessor.preprocess(kShaders[0]))
+		{
+			printf("Skipped: %s (run from the repository root)\n\n", preprocessor.getError());
+			return;
+		}
+	}
+
+ // sweep the width up and down several times, as dragging a slider would
+	std::vector<int> sweep;
+	for (int pass = 0; pass < 4; ++pass)
+	{
+		for (int width = 1; width <= 21; width += 2)
+		{
+			sweep.push_back(pass & 1 ? 22 - width : width);
+		}
+	}
+	const int kType = 1; // Type_Gaussian
+	const int kMode = 2; // Mode_Separable
+
+	size_t sourceSize = 0;
+	int fileReads = 0;
+	const double msUncached = bench::Measure([&]
+		{
+			fileReads = 0;
+			for (int width : sweep)
+			{
+				ShaderDefines defines[3];
+				GetDefines(kType, kMode, width, defines);
+				for (int i = 0; i < 3; ++i)
+				{
+					ShaderPreprocessor preprocessor; // no reuse, re-read and re-resolve every time
+					InitPreprocessor(preprocessor);
+					ShaderPermutationCache cache;
+					cache.init(&preprocessor);
+					sourceSize += cache.get(kShaders[i == 0 ? 0 : 1], defines[i])->m_source.size();
+					fileReads += preprocessor.getFileReadCount();
+				}
+			}
+		});
+
+	ShaderPreprocessor preprocessor;
+	ShaderPermutationCache cache;
+	const double msCached = bench::Measure([&]
+		{
+			preprocessor = ShaderPreprocessor();
+			InitPreprocessor(preprocessor);
+			cache.init(&preprocessor);
+			for (int width : sweep)
+			{
+				ShaderDefines defines[3];
+				GetDefines(kType, kMode, width, defines);
+				for (int i = 0; i < 3; ++i)
+				{
+					sourceSize += cache.get(kShaders[i == 0 ? 0 : 1], defines[i])->m_source.size();
+				}
+			}
+		});
+	bench::DoNotOptimize(sourceSize);
+
+	printf("Width sweep, %d initKernel() calls (%d shaders)\n", (int)sweep.size(), (int)sweep.size() * 3);
+	printf("%-10s %10s %12s %12s %10s\n", "", "ms", "file reads", "resolves", "compiles");
+	printf("%-10s %10.3f %12d %12d %10d\n", "uncached", msUncached, fileReads, (int)sweep.size() * 3, (int)sweep.size() * 3);
+	printf("%-10s %10.3f %12d %12d %10d   (%d hits)\n\n", "cached", msCached, preprocessor.getFileReadCount(), preprocessor.getResolveCount(), cache.getMissCount(), cache.getHitCount());
+
+ // disk: store a (fake) binary per permutation, reload with the same tag then with a different tag
+	const char* kTags[] = { "vendor/renderer/version A", "vendor/renderer/version A", "vendor/renderer/version B" };
+	std::vector<std::string> files;
+	bool binariesMatch = true;
+	printf("%-10s %12s %10s\n", "disk", "permutations", "binaries");
+	for (int run = 0; run < 3; ++run)
+	{
+		ShaderPreprocessor runPreprocessor;
+		InitPreprocessor(runPreprocessor);
+		ShaderPermutationCache runCache;
+		runCache.init(&runPreprocessor, kCacheDir, kTags[run]);
+		for (int width = 1; width <= 21; width += 2)
+		{
+			ShaderDefines defines[3];
+			GetDefines(kType, kMode, width, defines);
+			for (int i = 0; i < 3; ++i)
+			{
+				const ShaderPermutation* permutation = runCache.get(kShaders[i == 0 ? 0 : 1], defines[i]);
+				const uint64_t binary = HashFnv1a64(permutation->m_source.data(), permutation->m_source.size());
+				if (permutation->m_binary.empty())
+				{
+					runCache.setBinary(permutation, 1, &binary, sizeof(binary));
+				}
+				else
+				{
+					binariesMatch &= permutation->m_binary.size() == sizeof(binary) && memcmp(permutation->m_binary.data(), &binary, sizeof(binary)) == 0;
+				}
+				if (run == 0)
+				{
+					char key[32];
+					snprintf(key, sizeof(key), "%016llx", (unsigned long long)permutation->m_key);
+					files.push_back(std::string(kCacheDir) + "/" + key + ".glsl");
+					files.push_back(std::string(kCacheDir) + "/" + key + ".bin");
+				}
+			}
+		}
+		printf("%-10s %12d %10d\n", run == 0 ? "first run" : (run == 1 ? "same tag" : "new tag"), runCache.getCount(), runCache.getBinaryLoadCount());
+	}
+	printf("Reloaded binaries %s\n\n", binariesMatch ? "match" : "DIFFERENT");
+
+	for (const std::string& file : files)
+	{
+		remove(file.c_str());
+	}
+	remove(kCacheDir);
+}
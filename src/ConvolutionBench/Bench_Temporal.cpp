@@ -0,0 +1,91 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Prefilter.h>
+#include <ConvolutionLib/SamplePattern.h>
+
+#include <cstdio>
+
+using namespace conv;
+
+// Mode_Prefilter temporal accumulation: PSNR per frame of the accumulated 2 sample/frame blur vs. the reference Gaussian
+// and vs. the converged 16 sample blur (the same pattern in a single frame), and the single frame blurs for comparison.
+void Bench_Temporal()
+{
+	const int   kSize             = bench::g_maxImageSize < 256 ? bench::g_maxImageSize : 256;
+	const int   kBlurWidth        = 21;     // Convolution::m_prefilterBlurWidth
+	const float kLodBias          = 1.0f;   // Convolution::m_prefilterLodBias
+	const int   kSampleCount      = 16;
+	const int   kFrameSampleCount = 2;
+	const float kMinAlpha         = 0.1f;
+	const int   kFrames[]         = { 1, 2, 4, 8, 16, 32, 64 };
+	const float radius = (float)kBlurWidth * 0.5f;
+	const float lod    = GetPrefilterLod(radius, kSampleCount, kLodBias);
+
+	Image src, reference;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+	InitPrefilterReference(src, radius, reference);
+	SamplePatternSet patterns;
+	patterns.init();
+
+	printf("RGBA8 %dx%d test pattern, width %d, %d of %d samples/frame at lod %.2f, PSNR vs. Gaussian (vs. %d samples)\n", kSize, kSize, kBlurWidth, kFrameSampleCount, kSampleCount, lod, kSampleCount);
+	printf("%-8s %24s %24s\n", "", "Hammersley", "sample tables");
+	printf("%-8s %11s %12s %11s %12s\n", "frames", "Gaussian", "converged", "Gaussian", "converged");
+	PrefilterBlur prefilter[2];
+	Image converged[2];
+	PrefilterAccumulator accumulator[2], accumulatorEma[2];
+	for (int i = 0; i < 2; ++i)
+	{
+		prefilter[i].init(src);
+		prefilter[i].setSamplePatterns(i ? &patterns : nullptr);
+		converged[i].init(kSize, kSize, Format_RGBA32F);
+		prefilter[i].blur(converged[i], radius, lod, kSampleCount);
+	}
+	int frame = 0;
+	for (int frameCount : kFrames)
+	{
+		for (; frame < frameCount; ++frame)
+		{
+			for (int i = 0; i < 2; ++i)
+			{
+				accumulator[i].accumulate(prefilter[i], radius, lod, kSampleCount, kFrameSampleCount);
+				accumulatorEma[i].accumulate(prefilter[i], radius, lod, kSampleCount, kFrameSampleCount, kMinAlpha);
+			}
+		}
+		printf("%-8d", frameCount);
+		for (int i = 0; i < 2; ++i)
+		{
+			printf(" %9.2fdB %10.2fdB", bench::GetPsnr(reference, accumulator[i].getHistory()), bench::GetPsnr(converged[i], accumulator[i].getHistory()));
+		}
+		printf("\n");
+	}
+	printf("%-8s", "EMA");
+	for (int i = 0; i < 2; ++i)
+	{
+		printf(" %9.2fdB %10.2fdB", bench::GetPsnr(reference, accumulatorEma[i].getHistory()), bench::GetPsnr(converged[i], accumulatorEma[i].getHistory()));
+	}
+	printf("   (min alpha %.2f, %d frames)\n\n", kMinAlpha, frame);
+
+	printf("Single frame, PSNR vs. Gaussian (ms)\n");
+	printf("%-8s %21s %21s\n", "samples", "Hammersley", "sample tables");
+	const int kSingleCounts[] = { 2, 8, 16 };
+	for (int sampleCount : kSingleCounts)
+	{
+		printf("%-8d", sampleCount);
+		for (int i = 0; i < 2; ++i)
+		{
+			Image dst;
+			dst.init(kSize, kSize, Format_RGBA32F);
+			const float lodSingle = GetPrefilterLod(radius, sampleCount, kLodBias);
+			const double ms = bench::Measure([&]{ prefilter[i].blur(dst, radius, lodSingle, sampleCount); });
+			printf(" %9.2fdB %8.2fms", bench::GetPsnr(reference, dst), ms);
+		}
+		printf("\n");
+	}
+	printf("%-8s", "temporal");
+	for (int i = 0; i < 2; ++i)
+	{
+		const double ms = bench::Measure([&]{ accumulatorEma[i].accumulate(prefilter[i], radius, lod, kSampleCount, kFrameSampleCount, kMinAlpha); });
+		printf(" %11s %8.2fms", "", ms);
+	}
+	printf("   (%d samples + blend)\n\n", kFrameSampleCount);
+}
@@ -0,0 +1,80 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/OutOfCore.h>
+#include <ConvolutionLib/ThreadPool.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace conv;
+
+// Out-of-core tiled convolution: memory mapped raw source/destination files convolved per tile size vs. the in-memory
+// multi-threaded ConvolveSeparable(), with the peak scratch memory (bounded by the tile size x the thread count).
+void Bench_Tiled()
+{
+	const int   kSize        = bench::g_maxImageSize < 4096 ? bench::g_maxImageSize : 4096;
+	const int   kKernelWidth = 21;
+	const char* kSrcPath     = "ConvolutionBench_Tiled_src.raw";
+	const char* kDstPath     = "ConvolutionBench_Tiled_dst.raw";
+
+	float weights[kKernelWidth], offsets[kKernelWidth];
+	KernelGaussian1d(kKernelWidth, (float)kKernelWidth / 6.0f, weights);
+	for (int i = 0; i < kKernelWidth; ++i)
+	{
+		offsets[i] = (float)(i - kKernelWidth / 2);
+	}
+	SeparableKernel kernel;
+	kernel.init(weights, offsets, kKernelWidth);
+	ThreadPool pool(bench::g_maxThreads);
+
+	Image src, ref, tmp;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+	ref.init(kSize, kSize, Format_RGBA8);
+	const double msInMemory = bench::Measure([&]{ ConvolveSeparable(pool, src, ref, tmp, kernel); });
+
+	{	MappedImage srcFile;
+		if (!srcFile.open(kSrcPath, kSize, kSize, Format_RGBA8, true))
+		{
+			printf("Skipped: couldn't create '%s'\n\n", kSrcPath);
+			return;
+		}
+		memcpy(srcFile.getImage().getData(), src.getData(), src.getSize());
+	}
+	const double imageMb = (double)src.getSize() / (1024.0 * 1024.0);
+
+	printf("RGBA8 %dx%d (%.0fMB), separable width %d, %d threads, in memory %.2fms\n", kSize, kSize, imageMb, kKernelWidth, pool.getThreadCount(), msInMemory);
+	printf("%-6s %8s %10s %10s %14s %16s %8s\n", "tile", "tiles", "ms", "MB/s", "scratch/tile", "peak scratch", "result");
+	const int kTileSizes[] = { 128, 256, 512, 1024 };
+	for (int tileSize : kTileSizes)
+	{
+		if (tileSize > kSize)
+		{
+			break;
+		}
+		MappedImage srcFile, dstFile;
+		if (!srcFile.open(kSrcPath, kSize, kSize, Format_RGBA8, false) || !dstFile.open(kDstPath, kSize, kSize, Format_RGBA8, true))
+		{
+			printf("Skipped: couldn't map '%s'/'%s'\n", kSrcPath, kDstPath);
+			break;
+		}
+		TiledConvolveStats stats;
+		double ms = 0.0;
+		const int kRepeat = 3;
+		for (int i = 0; i < kRepeat; ++i)
+		{
+			ConvolveSeparableTiled(pool, srcFile, dstFile, kernel, tileSize, &stats);
+			ms += stats.m_ms;
+		}
+		ms /= kRepeat;
+		const bool match = memcmp(dstFile.getImage().getData(), ref.getData(), ref.getSize()) == 0;
+		printf("%-6d %8d %10.2f %10.0f %12.2fMB %14.2fMB %8s\n", tileSize, stats.m_tileCount, ms, imageMb * 2.0 / (ms / 1000.0),
+			(double)stats.m_tileScratchBytes / (1024.0 * 1024.0), (double)stats.m_peakScratchBytes / (1024.0 * 1024.0), match ? "match" : "DIFFERS"
+			);
+	}
+	printf("\n");
+
+	remove(kSrcPath);
+	remove(kDstPath);
+}
@@ -0,0 +1,103 @@
+#include "Bench.h"
+
+#include <ConvolutionLib/BoxFilter.h>
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/ConvolveFixed.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/Line.h>
+#include <ConvolutionLib/RecursiveGaussian.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+void Transpose(const Image& _src, Image& dst_)
+{
+	dst_.init(_src.getHeight(), _src.getWidth(), _src.getFormat());
+	std::vector<float> line(_src.getWidth() * 4);
+	for (int y = 0; y < _src.getHeight(); ++y)
+	{
+		ReadLine(_src, Direction_Horizontal, y, 0, _src.getWidth(), line.data());
+		WriteLine(dst_, Direction_Vertical, y, 0, _src.getWidth(), line.data());
+	}
+}
+
+bool IsEqual(const Image& _a, const Image& _b)
+{
+	return _a.getSize() == _b.getSize() && memcmp(_a.getData(), _b.getData(), _a.getSize()) == 0;
+}
+
+} // namespace
+
+// Horizontal vs. vertical pass time on a large image for the direct, fixed point, box (3 passes) and recursive filters,
+// and a check that the vertical pass is the same as transpose + horizontal pass + transpose.
+void Bench_Vertical()
+{
+	const int kSize = bench::g_maxImageSize < 4096 ? bench::g_maxImageSize : 4096;
+	const int kWidth = 21;
+	float weights[kWidth], offsets[kWidth];
+	KernelGaussian1d(kWidth, (float)kWidth / 6.0f, weights);
+	for (int i = 0; i < kWidth; ++i)
+	{
+		offsets[i] = (float)(i - kWidth / 2);
+	}
+	SeparableKernel kernel;
+	kernel.init(weights, offsets, kWidth);
+	SeparableKernelFixed kernelFixed;
+	kernelFixed.init(kernel);
+	RecursiveGaussianKernel kernelRecursive;
+	kernelRecursive.init((float)kWidth / 6.0f);
+	const int boxWidths[3] = { 7, 9, 9 };
+	const char* kModeNames[] = { "", " fix", " box", " rec" };
+
+	printf("%dx%d, Gaussian %d, 1 thread (ms)\n", kSize, kSize, kWidth);
+	printf("%-12s %12s %12s %8s %12s\n", "format", "horizontal", "vertical", "ratio", "transposed");
+	for (int mode = 0; mode < 4; ++mode)
+	{
+		for (Format format = 0; format < Format_Count; ++format)
+		{
+			if (mode == 1 && format != Format_RGBA8)
+			{
+				continue;
+			}
+			Image src, dst;
+			bench::InitTestImage(src, kSize, kSize, format);
+			dst.init(kSize, kSize, format);
+			auto pass = [&](const Image& _src, Image& _dst, Direction _direction)
+				{
+					switch (mode)
+					{
+						case 0:  ConvolvePass(_src, _dst, kernel, _direction); break;
+						case 1:  ConvolvePassFixed(_src, _dst, kernelFixed, _direction); break;
+						case 2:  BoxFilterPass(_src, _dst, boxWidths, 3, _direction); break;
+						default: RecursiveGaussianPass(_src, _dst, kernelRecursive, _direction); break;
+					};
+				};
+		 // alternate the passes and keep the best of several runs to reduce the noise in the ratio
+			double msH = 1e30, msV = 1e30;
+			for (int run = 0; run < 5; ++run)
+			{
+				const double h = bench::Measure([&]{ pass(src, dst, Direction_Horizontal); });
+				const double v = bench::Measure([&]{ pass(src, dst, Direction_Vertical); });
+				msH = h < msH ? h : msH;
+				msV = v < msV ? v : msV;
+			}
+
+		 // vertical pass == transpose, horizontal pass, transpose
+			Image srcT, dstT, ref;
+			Transpose(src, srcT);
+			dstT.init(kSize, kSize, format);
+			pass(srcT, dstT, Direction_Horizontal);
+			Transpose(dstT, ref);
+			char name[32];
+			snprintf(name, sizeof(name), "%s%s", GetFormatName(format), kModeNames[mode]);
+			printf("%-12s %12.2f %12.2f %7.2fx %12s\n", name, msH, msV, msV / msH, IsEqual(dst, ref) ? "equal" : "DIFFERENT");
+		}
+	}
+	printf("\n");
+}
@@ -0,0 +1,135 @@
+// ConvolutionBench: command line benchmarks and reports for ConvolutionLib.
+//
+//   ConvolutionBench [options] [name ...]   Run the named benchmarks, or all of them if no names are given.
+//   ConvolutionBench --list                 List the benchmarks.
+//
+// Options:
+//   --max-size N    Largest image size for benchmarks which sweep the image size (default 16384).
+//   --threads N     Largest thread count for benchmarks which sweep the thread count (default hardware concurrency).
+//   --json PATH     Write the results of the tuning benchmarks (prefilter) into the JSON file at PATH, for the sample
+//                   data/Convolution/PrefilterTable.json.
+
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+void Bench_Kernel();
+void Bench_Separable();
+void Bench_Scaling();
+void Bench_Box();
+void Bench_Recursive();
+void Bench_IteratedBox();
+void Bench_Pyramid();
+void Bench_Fft();
+void Bench_LowRank();
+void Bench_Bilinear();
+void Bench_Fixed();
+void Bench_Half();
+void Bench_Vertical();
+void Bench_Blocked();
+void Bench_Mip();
+void Bench_Prefilter();
+void Bench_Patterns();
+void Bench_Temporal();
+void Bench_ShaderCache();
+void Bench_Async();
+void Bench_Dirty();
+void Bench_Roi();
+void Bench_Tiled();
+
+namespace {
+
+struct Benchmark
+{
+	const char* m_name;
+	const char* m_description;
+	void      (*m_func)();
+};
+
+const Benchmark kBenchmarks[] =
+{
+	{ "kernel",     "Kernel generation vs. constexpr tables.",                Bench_Kernel },
+	{ "separable",  "CPU separable convolution per instruction set.",         Bench_Separable },
+	{ "scaling",    "CPU separable convolution thread/image size scaling.",   Bench_Scaling },
+	{ "box",        "Running sum box filter vs. the tap loop.",               Bench_Box },
+	{ "recursive",  "Recursive Gaussian accuracy and throughput.",            Bench_Recursive },
+	{ "iteratedbox", "Iterated box Gaussian approximation error/throughput.", Bench_IteratedBox },
+	{ "pyramid",    "Pyramid (dual filter) blur PSNR/time vs. separable.",    Bench_Pyramid },
+	{ "fft",        "FFT vs. direct vs. separable 2d convolution crossover.", Bench_Fft },
+	{ "lowrank",    "Low rank separable decomposition rank/error/time.",      Bench_LowRank },
+	{ "bilinear",   "Fixed vs. greedy error bounded bilinear tap merging.",   Bench_Bilinear },
+	{ "fixed",      "Fixed point vs. float RGBA8 separable convolution.",     Bench_Fixed },
+	{ "half",       "Half float (RGBA16F) conversion and storage vs. RGBA32F.", Bench_Half },
+	{ "vertical",   "Vertical vs. horizontal pass on a large image.",         Bench_Vertical },
+	{ "blocked",    "Register blocked line functions per tap count.",        Bench_Blocked },
+	{ "mip",        "Single traversal vs. level by level mip chain build.",  Bench_Mip },
+	{ "prefilter",  "Mode_Prefilter sample count/LOD bias auto tuning.",     Bench_Prefilter },
+	{ "patterns",   "Optimized sample pattern tables vs. Hammersley + IGN.",  Bench_Patterns },
+	{ "temporal",   "Mode_Prefilter temporal accumulation convergence.",      Bench_Temporal },
+	{ "shadercache", "GLSL preprocessor and shader permutation cache.",      Bench_ShaderCache },
+	{ "async",      "Asynchronous kernel rebuild vs. on the main thread.",   Bench_Async },
+	{ "dirty",      "Dirty tracking: skip the convolution if nothing changed.", Bench_Dirty },
+	{ "roi",        "Dirty rectangle/viewport vs. full image convolution.",  Bench_Roi },
+	{ "tiled",      "Out-of-core tiled convolution of memory mapped files.", Bench_Tiled },
+};
+
+} // namespace
+
+int main(int _argc, char** _argv)
+{
+	if (_argc > 1 && strcmp(_argv[1], "--list") == 0)
+	{
+		for (const Benchmark& benchmark : kBenchmarks)
+		{
+			printf("%-16s %s\n", benchmark.m_name, benchmark.m_description);
+		}
+		return 0;
+	}
+
+	const char* names[32];
+	int nameCount = 0;
+	for (int i = 1; i < _argc; ++i)
+	{
+		if (strcmp(_argv[i], "--max-size") == 0 && i + 1 < _argc)
+		{
+			bench::g_maxImageSize = atoi(_argv[++i]);
+		}
+		else if (strcmp(_argv[i], "--threads") == 0 && i + 1 < _argc)
+		{
+			bench::g_maxThreads = atoi(_argv[++i]);
+		}
+		else if (strcmp(_argv[i], "--json") == 0 && i + 1 < _argc)
+		{
+			bench::g_jsonPath = _argv[++i];
+		}
+		else if (nameCount < 32)
+		{
+			names[nameCount++] = _argv[i];
+		}
+	}
+
+	int runCount = 0;
+	for (const Benchmark& benchmark : kBenchmarks)
+	{
+		bool run = nameCount == 0;
+		for (int i = 0; i < nameCount && !run; ++i)
+		{
+			run = strcmp(names[i], benchmark.m_name) == 0;
+		}
+		if (run)
+		{
+			printf("=== %s: %s\n\n", benchmark.m_name, benchmark.m_description);
+			benchmark.m_func();
+			printf("\n");
+			++runCount;
+		}
+	}
+	if (runCount == 0)
+	{
+		fprintf(stderr, "No benchmarks matched, use --list to see the available benchmarks.\n");
+		return 1;
+	}
+	return 0;
+}
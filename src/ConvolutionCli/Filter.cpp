@@ -0,0 +1,102 @@
+#include "Filter.h"
+
+#include <ConvolutionLib/Kernel.h>
+
+#include <cassert>
+
+using namespace conv;
+
+const char* GetModeName(Mode _mode)
+{
+	static const char* kNames[] = { "2d", "separable", "separable-bilinear", "box", "recursive", "iterated-box", "pyramid" };
+	static_assert(sizeof(kNames) / sizeof(kNames[0]) == Mode_Count, "kNames size mismatch");
+	return kNames[_mode];
+}
+
+const char* GetTypeName(KernelType _type)
+{
+	static const char* kNames[] = { "box", "gaussian", "binomial" };
+	static_assert(sizeof(kNames) / sizeof(kNames[0]) == KernelType_Count, "kNames size mismatch");
+	return kNames[_type];
+}
+
+void Filter::init(const FilterDesc& _desc)
+{
+	m_desc = _desc;
+	if (m_desc.m_mode == Mode_BoxRunningSum)
+	{
+		m_desc.m_width = m_desc.m_width < 1 ? 1 : m_desc.m_width;
+	}
+	else
+	{
+		m_desc.m_width = (m_desc.m_width | 1) < KernelBank::kMinWidth ? KernelBank::kMinWidth : ((m_desc.m_width | 1) > KernelBank::kMaxWidth ? KernelBank::kMaxWidth : (m_desc.m_width | 1));
+	}
+	m_desc.m_boxPassCount = m_desc.m_boxPassCount < 3 ? 3 : (m_desc.m_boxPassCount > 5 ? 5 : m_desc.m_boxPassCount);
+	m_desc.m_levelCount   = m_desc.m_levelCount < 1 ? 1 : (m_desc.m_levelCount > PyramidBlur::kMaxLevelCount ? PyramidBlur::kMaxLevelCount : m_desc.m_levelCount);
+
+	m_kernelBank.init();
+	if (!(m_desc.m_gaussianSigma > 0.0f))
+	{
+		m_desc.m_gaussianSigma = m_kernelBank.getOptimalSigma(m_desc.m_width);
+	}
+
+	const KernelMode mode = m_desc.m_mode == Mode_2d ? KernelMode_2d : (m_desc.m_mode == Mode_SeparableBilinear ? KernelMode_SeparableBilinear : KernelMode_Separable);
+	m_kernel = &m_kernelBank.getKernel(m_desc.m_type, mode, m_desc.m_width, m_desc.m_gaussianSigma);
+	if (mode != KernelMode_2d)
+	{
+		m_kernelSeparable.init(m_kernelBank.get(m_kernel->m_weights), m_kernelBank.get(m_kernel->m_offsets), m_kernel->m_tapCount);
+		m_kernelFixed.init(m_kernelSeparable);
+	}
+	m_kernelRecursive.init(m_desc.m_gaussianSigma);
+	GaussianFindBoxWidths(m_desc.m_gaussianSigma, m_desc.m_boxPassCount, m_boxPassWidths);
+	m_convolver2dWidth = m_convolver2dHeight = 0;
+}
+
+void Filter::apply(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_)
+{
+	dst_.init(_src.getWidth(), _src.getHeight(), _src.getFormat());
+	switch (m_desc.m_mode)
+	{
+		case Mode_2d:
+			if (m_convolver2dWidth != _src.getWidth() || m_convolver2dHeight != _src.getHeight())
+			{
+				m_convolver2dWidth  = _src.getWidth();
+				m_convolver2dHeight = _src.getHeight();
+				m_convolver2d.init(m_kernelBank.get(m_kernel->m_weights), m_desc.m_width, m_convolver2dWidth, m_convolver2dHeight);
+			}
+			m_convolver2d.convolve(_pool, _src, dst_, tmp_);
+			break;
+
+		case Mode_Separable:
+		case Mode_SeparableBilinear:
+			if (m_desc.m_fixedPoint && _src.getFormat() == Format_RGBA8)
+			{
+				ConvolveSeparableFixed(_pool, _src, dst_, tmp_, m_kernelFixed);
+			}
+			else
+			{
+				ConvolveSeparable(_pool, _src, dst_, tmp_, m_kernelSeparable);
+			}
+			break;
+
+		case Mode_BoxRunningSum:
+			BoxFilter(_pool, _src, dst_, tmp_, m_desc.m_width | 1);
+			break;
+
+		case Mode_RecursiveGaussian:
+			RecursiveGaussian(_pool, _src, dst_, tmp_, m_kernelRecursive);
+			break;
+
+		case Mode_IteratedBox:
+			BoxFilter(_pool, _src, dst_, tmp_, m_boxPassWidths, m_desc.m_boxPassCount);
+			break;
+
+		case Mode_Pyramid:
+			m_pyramid.blur(_pool, _src, dst_, m_desc.m_levelCount);
+			break;
+
+		default:
+			assert(false);
+			break;
+	};
+}
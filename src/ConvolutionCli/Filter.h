@@ -0,0 +1,65 @@
+#pragma once
+
+// The CPU convolution modes of the Convolution sample, with kernels built as per Convolution::BuildKernel() (from a
+// conv::KernelBank).
+
+#include <ConvolutionLib/BoxFilter.h>
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/ConvolveFixed.h>
+#include <ConvolutionLib/Convolver2d.h>
+#include <ConvolutionLib/KernelBank.h>
+#include <ConvolutionLib/Pyramid.h>
+#include <ConvolutionLib/RecursiveGaussian.h>
+
+enum Mode_
+{
+	Mode_2d,                   // conv::Convolver2d (direct/separable/FFT)
+	Mode_Separable,
+	Mode_SeparableBilinear,
+	Mode_BoxRunningSum,        // m_width is the box width, not limited by the kernel bank
+	Mode_RecursiveGaussian,
+	Mode_IteratedBox,          // Gaussian approximated by m_boxPassCount box passes
+	Mode_Pyramid,              // dual filter, m_levelCount levels
+
+	Mode_Count
+};
+typedef int Mode;
+
+const char* GetModeName(Mode _mode);
+const char* GetTypeName(conv::KernelType _type);
+
+struct FilterDesc
+{
+	conv::KernelType m_type          = conv::KernelType_Gaussian;
+	Mode             m_mode          = Mode_Separable;
+	int              m_width         = 9;
+	float            m_gaussianSigma = 0.0f;   // 0 = the kernel bank's optimal sigma for m_width
+	int              m_boxPassCount  = 3;
+	int              m_levelCount    = 4;
+	bool             m_fixedPoint    = false;  // Mode_Separable/Mode_SeparableBilinear with RGBA8 images
+};
+
+class Filter
+{
+public:
+	// Build the kernels for _desc, the width is clamped to the bank's range (except for Mode_BoxRunningSum).
+	void init(const FilterDesc& _desc);
+
+	// Convolve _src into dst_ (which is initialized to the size and format of _src). Not thread safe, call from one thread.
+	void apply(conv::ThreadPool& _pool, const conv::Image& _src, conv::Image& dst_, conv::Image& tmp_);
+
+	const FilterDesc& getDesc() const                { return m_desc; }
+
+private:
+	FilterDesc                    m_desc;
+	conv::KernelBank              m_kernelBank;
+	const conv::KernelBank::Kernel* m_kernel = nullptr;
+	conv::SeparableKernel         m_kernelSeparable;
+	conv::SeparableKernelFixed    m_kernelFixed;
+	conv::RecursiveGaussianKernel m_kernelRecursive;
+	int                           m_boxPassWidths[5] = {};
+	conv::Convolver2d             m_convolver2d;     // initialized per image size
+	int                           m_convolver2dWidth  = 0;
+	int                           m_convolver2dHeight = 0;
+	conv::PyramidBlur             m_pyramid;
+};
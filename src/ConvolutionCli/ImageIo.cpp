@@ -0,0 +1,325 @@
+#include "ImageIo.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+// Next whitespace delimited token of a PNM header, skipping comments. The single whitespace character which ends the
+// token is consumed (for the last header token this is the separator before the binary data).
+bool ReadToken(FILE* _file, std::string& token_)
+{
+	token_.clear();
+	int c = fgetc(_file);
+	for (;;)
+	{
+		while (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+		{
+			c = fgetc(_file);
+		}
+		if (c != '#')
+		{
+			break;
+		}
+		while (c != '\n' && c != EOF)
+		{
+			c = fgetc(_file);
+		}
+	}
+	while (c != EOF && c != ' ' && c != '\t' && c != '\r' && c != '\n')
+	{
+		token_ += (char)c;
+		c = fgetc(_file);
+	}
+	return !token_.empty();
+}
+
+bool ReadInt(FILE* _file, int& value_)
+{
+	std::string token;
+	if (!ReadToken(_file, token))
+	{
+		return false;
+	}
+	char* end;
+	value_ = (int)strtol(token.c_str(), &end, 10);
+	return *end == '\0';
+}
+
+bool ReadRgba8(FILE* _file, int _channelCount, Image& img_)
+{
+	std::vector<uint8_t> row((size_t)img_.getWidth() * _channelCount);
+	for (int y = 0; y < img_.getHeight(); ++y)
+	{
+		if (fread(row.data(), 1, row.size(), _file) != row.size())
+		{
+			return false;
+		}
+		uint8_t* dst = (uint8_t*)img_.getRow(y);
+		for (int x = 0; x < img_.getWidth(); ++x)
+		{
+			dst[x * 4 + 0] = row[x * _channelCount + 0];
+			dst[x * 4 + 1] = row[x * _channelCount + 1];
+			dst[x * 4 + 2] = row[x * _channelCount + 2];
+			dst[x * 4 + 3] = _channelCount == 4 ? row[x * _channelCount + 3] : 255;
+		}
+	}
+	return true;
+}
+
+bool WriteRgba8(FILE* _file, int _channelCount, const Image& _img)
+{
+	std::vector<uint8_t> row((size_t)_img.getWidth() * _channelCount);
+	for (int y = 0; y < _img.getHeight(); ++y)
+	{
+		const uint8_t* src = (const uint8_t*)_img.getRow(y);
+		for (int x = 0; x < _img.getWidth(); ++x)
+		{
+			for (int i = 0; i < _channelCount; ++i)
+			{
+				row[x * _channelCount + i] = src[x * 4 + i];
+			}
+		}
+		if (fwrite(row.data(), 1, row.size(), _file) != row.size())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+ReadResult ReadPam(FILE* _file, Image& img_, std::string* error_)
+{
+	int width = 0, height = 0, depth = 0, maxVal = 0;
+	std::string key;
+	while (ReadToken(_file, key) && key != "ENDHDR")
+	{
+		int* value = key == "WIDTH" ? &width : key == "HEIGHT" ? &height : key == "DEPTH" ? &depth : key == "MAXVAL" ? &maxVal : nullptr;
+		if (value)
+		{
+			if (!ReadInt(_file, *value))
+			{
+				break;
+			}
+		}
+		else
+		{
+			std::string ignored; // TUPLTYPE
+			ReadToken(_file, ignored);
+		}
+	}
+	if (key != "ENDHDR" || width <= 0 || height <= 0 || (depth != 3 && depth != 4) || maxVal != 255)
+	{
+		*error_ = "unsupported PAM (expected 8 bit RGB or RGB_ALPHA)";
+		return ReadResult_Error;
+	}
+	img_.init(width, height, Format_RGBA8);
+	if (!ReadRgba8(_file, depth, img_))
+	{
+		*error_ = "truncated PAM";
+		return ReadResult_Error;
+	}
+	return ReadResult_Ok;
+}
+
+ReadResult ReadPpm(FILE* _file, Image& img_, std::string* error_)
+{
+	int width = 0, height = 0, maxVal = 0;
+	if (!ReadInt(_file, width) || !ReadInt(_file, height) || !ReadInt(_file, maxVal) || width <= 0 || height <= 0 || maxVal != 255)
+	{
+		*error_ = "unsupported PPM (expected 8 bit RGB)";
+		return ReadResult_Error;
+	}
+	img_.init(width, height, Format_RGBA8);
+	if (!ReadRgba8(_file, 3, img_))
+	{
+		*error_ = "truncated PPM";
+		return ReadResult_Error;
+	}
+	return ReadResult_Ok;
+}
+
+ReadResult ReadPfm(FILE* _file, int _channelCount, Image& img_, std::string* error_)
+{
+	int width = 0, height = 0;
+	std::string scaleToken;
+	if (!ReadInt(_file, width) || !ReadInt(_file, height) || !ReadToken(_file, scaleToken) || width <= 0 || height <= 0)
+	{
+		*error_ = "invalid PFM header";
+		return ReadResult_Error;
+	}
+	const bool swapBytes = atof(scaleToken.c_str()) > 0.0; // positive scale = big endian
+	img_.init(width, height, Format_RGBA32F);
+	std::vector<float> row((size_t)width * _channelCount);
+	for (int y = height - 1; y >= 0; --y) // rows are bottom to top
+	{
+		if (fread(row.data(), sizeof(float), row.size(), _file) != row.size())
+		{
+			*error_ = "truncated PFM";
+			return ReadResult_Error;
+		}
+		if (swapBytes)
+		{
+			for (float& f : row)
+			{
+				uint8_t* b = (uint8_t*)&f;
+				uint8_t tmp[4] = { b[3], b[2], b[1], b[0] };
+				memcpy(b, tmp, 4);
+			}
+		}
+		float* dst = (float*)img_.getRow(y);
+		for (int x = 0; x < width; ++x)
+		{
+			dst[x * 4 + 0] = row[x * _channelCount + 0];
+			dst[x * 4 + 1] = row[x * _channelCount + (_channelCount == 3 ? 1 : 0)];
+			dst[x * 4 + 2] = row[x * _channelCount + (_channelCount == 3 ? 2 : 0)];
+			dst[x * 4 + 3] = 1.0f;
+		}
+	}
+	return ReadResult_Ok;
+}
+
+} // namespace
+
+const char* GetFileFormatExtension(FileFormat _format)
+{
+	static const char* kExtensions[] = { "ppm", "pam", "pfm", "raw" };
+	static_assert(sizeof(kExtensions) / sizeof(kExtensions[0]) == FileFormat_Count, "kExtensions size mismatch");
+	return kExtensions[_format];
+}
+
+FileFormat GetFileFormatFromPath(const char* _path)
+{
+	const char* ext = strrchr(_path, '.');
+	if (ext)
+	{
+		for (int i = 0; i < FileFormat_Count; ++i)
+		{
+			if (strcmp(ext + 1, GetFileFormatExtension(i)) == 0)
+			{
+				return i;
+			}
+		}
+	}
+	return FileFormat_Auto;
+}
+
+ReadResult ReadImage(FILE* _file, FileFormat _format, const RawDesc& _raw, Image& img_, FileFormat* format_, std::string* error_)
+{
+	int c = fgetc(_file);
+	if (_format == FileFormat_Raw)
+	{
+		if (c == EOF)
+		{
+			return ReadResult_End;
+		}
+		ungetc(c, _file);
+		img_.init(_raw.m_width, _raw.m_height, _raw.m_format);
+		for (int y = 0; y < img_.getHeight(); ++y)
+		{
+			const size_t rowSize = (size_t)img_.getWidth() * img_.getTexelSize();
+			if (fread(img_.getRow(y), 1, rowSize, _file) != rowSize)
+			{
+				*error_ = "truncated raw image";
+				return ReadResult_Error;
+			}
+		}
+		*format_ = FileFormat_Raw;
+		return ReadResult_Ok;
+	}
+
+	while (c == ' ' || c == '\t' || c == '\r' || c == '\n') // between images in a stream
+	{
+		c = fgetc(_file);
+	}
+	if (c == EOF)
+	{
+		return ReadResult_End;
+	}
+
+	const int c1 = fgetc(_file);
+	if (c == 'P' && c1 == '7')
+	{
+		*format_ = FileFormat_Pam;
+		return ReadPam(_file, img_, error_);
+	}
+	if (c == 'P' && c1 == '6')
+	{
+		*format_ = FileFormat_Ppm;
+		return ReadPpm(_file, img_, error_);
+	}
+	if (c == 'P' && (c1 == 'F' || c1 == 'f'))
+	{
+		*format_ = FileFormat_Pfm;
+		return ReadPfm(_file, c1 == 'F' ? 3 : 1, img_, error_);
+	}
+	*error_ = "unknown format (expected PPM, PAM or PFM, use --raw for raw data)";
+	return ReadResult_Error;
+}
+
+bool WriteImage(FILE* _file, FileFormat _format, const Image& _img)
+{
+	const int width  = _img.getWidth();
+	const int height = _img.getHeight();
+	switch (_format)
+	{
+		case FileFormat_Ppm:
+			if (_img.getFormat() != Format_RGBA8)
+			{
+				return false;
+			}
+			fprintf(_file, "P6\n%d %d\n255\n", width, height);
+			return WriteRgba8(_file, 3, _img);
+
+		case FileFormat_Pam:
+			if (_img.getFormat() != Format_RGBA8)
+			{
+				return false;
+			}
+			fprintf(_file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width, height);
+			return WriteRgba8(_file, 4, _img);
+
+		case FileFormat_Pfm:
+		{
+			if (_img.getFormat() != Format_RGBA32F)
+			{
+				return false;
+			}
+			fprintf(_file, "PF\n%d %d\n-1.0\n", width, height); // little endian
+			std::vector<float> row((size_t)width * 3);
+			for (int y = height - 1; y >= 0; --y)
+			{
+				const float* src = (const float*)_img.getRow(y);
+				for (int x = 0; x < width; ++x)
+				{
+					row[x * 3 + 0] = src[x * 4 + 0];
+					row[x * 3 + 1] = src[x * 4 + 1];
+					row[x * 3 + 2] = src[x * 4 + 2];
+				}
+				if (fwrite(row.data(), sizeof(float), row.size(), _file) != row.size())
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		case FileFormat_Raw:
+			for (int y = 0; y < height; ++y)
+			{
+				const size_t rowSize = (size_t)width * _img.getTexelSize();
+				if (fwrite(_img.getRow(y), 1, rowSize, _file) != rowSize)
+				{
+					return false;
+				}
+			}
+			return true;
+
+		default:
+			return false;
+	};
+}
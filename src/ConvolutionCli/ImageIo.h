@@ -0,0 +1,54 @@
+#pragma once
+
+// Image file/stream I/O for ConvolutionCli. Formats are the ones which can be read and written without a third party
+// decoder and which tools like ffmpeg/ImageMagick pipe natively:
+//
+//  - PPM (P6, 8 bit RGB) and PAM (P7, 8 bit RGB/RGB_ALPHA) -> Format_RGBA8
+//  - PFM (PF/Pf, float RGB/grey) -> Format_RGBA32F
+//  - Raw, tightly packed rows of a size and format given on the command line (e.g. ffmpeg -f rawvideo -pix_fmt rgba)
+//
+// Several images may be concatenated in a stream (e.g. stdin), ReadImage() reads one at a time.
+
+#include <ConvolutionLib/Image.h>
+
+#include <cstdio>
+#include <string>
+
+enum FileFormat_
+{
+	FileFormat_Ppm,
+	FileFormat_Pam,
+	FileFormat_Pfm,
+	FileFormat_Raw,
+
+	FileFormat_Count,
+	FileFormat_Auto = FileFormat_Count // detect PPM/PAM/PFM from the header
+};
+typedef int FileFormat;
+
+const char* GetFileFormatExtension(FileFormat _format);
+
+// FileFormat_Auto if _path's extension isn't one of the above.
+FileFormat  GetFileFormatFromPath(const char* _path);
+
+struct RawDesc
+{
+	int          m_width  = 0;
+	int          m_height = 0;
+	conv::Format m_format = conv::Format_RGBA8;
+};
+
+enum ReadResult
+{
+	ReadResult_Ok,
+	ReadResult_End,   // no more images in the stream
+	ReadResult_Error,
+};
+
+// Read the next image from _file into img_. If _format is FileFormat_Raw _raw gives the size/format, else the format is
+// detected from the header. format_ receives the format which was read.
+ReadResult ReadImage(FILE* _file, FileFormat _format, const RawDesc& _raw, conv::Image& img_, FileFormat* format_, std::string* error_);
+
+// Write _img to _file. PPM/PFM drop alpha, PPM/PAM require Format_RGBA8, PFM requires Format_RGBA32F, raw writes the
+// rows as is.
+bool WriteImage(FILE* _file, FileFormat _format, const conv::Image& _img);
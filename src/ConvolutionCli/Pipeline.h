@@ -0,0 +1,66 @@
+#pragma once
+
+// Bounded queue between the stages of the ConvolutionCli pipeline (decode -> convolve -> encode). push() blocks while
+// the queue is full, hence a slow stage stalls the stages before it and the number of frames in flight (and their
+// memory) is bounded by the queue capacities.
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+template <typename tType>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(int _capacity): m_capacity(_capacity < 1 ? 1 : _capacity) {}
+
+	BoundedQueue(const BoundedQueue&)            = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	// Block until there's space, return false if the queue was closed (_item is dropped).
+	bool push(tType&& _item)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_notFull.wait(lock, [this]{ return (int)m_items.size() < m_capacity || m_closed; });
+		if (m_closed)
+		{
+			return false;
+		}
+		m_items.push_back(std::move(_item));
+		m_notEmpty.notify_one();
+		return true;
+	}
+
+	// Block until there's an item, return false if the queue is closed and empty.
+	bool pop(tType& item_)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_notEmpty.wait(lock, [this]{ return !m_items.empty() || m_closed; });
+		if (m_items.empty())
+		{
+			return false;
+		}
+		item_ = std::move(m_items.front());
+		m_items.pop_front();
+		m_notFull.notify_one();
+		return true;
+	}
+
+	// No more items will be pushed, pop() returns the remaining items then false.
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+		m_notFull.notify_all();
+		m_notEmpty.notify_all();
+	}
+
+private:
+	int                     m_capacity;
+	bool                    m_closed = false;
+	std::deque<tType>       m_items;
+	std::mutex              m_mutex;
+	std::condition_variable m_notFull;
+	std::condition_variable m_notEmpty;
+};
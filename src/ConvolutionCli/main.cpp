@@ -0,0 +1,548 @@
+// ConvolutionCli: headless batch/stream convolution with the Convolution sample's CPU modes.
+//
+//   ConvolutionCli [options] INPUT OUTPUT
+//
+// INPUT is an image file, a directory (every .ppm/.pam/.pfm/.raw file, in name order) or '-' for a stream of images on
+// stdin. OUTPUT is a directory (created if required) or '-' for a stream on stdout; if INPUT is a file OUTPUT may also
+// be a file. See ImageIo.h for the formats, e.g. to blur a video via ffmpeg:
+//
+//   ffmpeg -i in.mp4 -f rawvideo -pix_fmt rgba - | ConvolutionCli --raw 1920x1080 rgba8 - - | ffmpeg -f rawvideo -pix_fmt rgba -s 1920x1080 -i - out.mp4
+//
+// Options:
+//   --type T         box, gaussian (default), binomial.
+//   --mode M         2d, separable (default), separable-bilinear, box, recursive, iterated-box, pyramid.
+//   --width N        Kernel width (default 9, clamped to the kernel bank's range), or the box width for --mode box (1-16383).
+//   --sigma S        Gaussian sigma (default 0 = the optimal sigma for the width, 0-1024).
+//   --passes N       Box passes for --mode iterated-box (default 3, 3-5).
+//   --levels N       Levels for --mode pyramid (default 4, 1-12).
+//   --fixed          Fixed point separable convolution for RGBA8 images.
+//   --raw WxH F      INPUT is raw WxH images in format F (rgba8, rgba16f, rgba32f).
+//   --format F       Output format: ppm, pam, pfm, raw (default the input's format).
+//   --threads N      Convolution threads (default 0 = hardware concurrency, 0-256).
+//   --queue N        Images in flight between stages (default 4, 1-1024).
+//
+// Decode, convolve and encode run on their own threads connected by bounded queues (see Pipeline.h), the convolution
+// itself runs on a ThreadPool. Throughput and per stage latency percentiles are reported on stderr.
+
+#include "Filter.h"
+#include "ImageIo.h"
+#include "Pipeline.h"
+
+#include <ConvolutionLib/Line.h>
+#include <ConvolutionLib/ThreadPool.h>
+
+#include <algorithm>
+#include <cctype>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+	#include <direct.h>
+	#include <fcntl.h>
+	#include <io.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+using namespace conv;
+
+namespace {
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Option limits, see the usage above.
+const int   kMaxWidth       = 16383;
+const float kMaxSigma       = 1024.0f;
+const int   kMaxThreadCount = 256;
+const int   kMaxQueueSize   = 1024;
+
+struct Options
+{
+	FilterDesc  m_filter;
+	FileFormat  m_inputFormat  = FileFormat_Auto;
+	FileFormat  m_outputFormat = FileFormat_Auto; // = the input's
+	RawDesc     m_raw;
+	int         m_threadCount  = 0;
+	int         m_queueSize    = 4;
+	const char* m_input        = nullptr;
+	const char* m_output       = nullptr;
+};
+
+struct Frame
+{
+	int               m_index      = 0;
+	std::string       m_name;                 // output file name, without the extension
+	FileFormat        m_format     = FileFormat_Auto;
+	Image             m_src;
+	Image             m_dst;
+	Clock::time_point m_start;
+	double            m_decodeMs   = 0.0;
+	double            m_convolveMs = 0.0;
+};
+typedef std::unique_ptr<Frame> FramePtr;
+
+double GetMs(Clock::time_point _begin, Clock::time_point _end)
+{
+	return std::chrono::duration<double, std::milli>(_end - _begin).count();
+}
+
+bool IsDirectory(const char* _path)
+{
+	#ifdef _MSC_VER
+		const DWORD attributes = GetFileAttributesA(_path);
+		return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+	#else
+		struct stat st;
+		return stat(_path, &st) == 0 && S_ISDIR(st.st_mode);
+	#endif
+}
+
+void MakeDirectory(const char* _path)
+{
+	#ifdef _MSC_VER
+		_mkdir(_path);
+	#else
+		mkdir(_path, 0755);
+	#endif
+}
+
+// Files in _dir with a supported extension, sorted by name.
+void ListImages(const char* _dir, std::vector<std::string>& paths_)
+{
+	std::vector<std::string> names;
+	#ifdef _MSC_VER
+		WIN32_FIND_DATAA findData;
+		HANDLE find = FindFirstFileA((std::string(_dir) + "\\*").c_str(), &findData);
+		if (find != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				names.push_back(findData.cFileName);
+			}
+			while (FindNextFileA(find, &findData));
+			FindClose(find);
+		}
+	#else
+		DIR* dir = opendir(_dir);
+		if (dir)
+		{
+			while (dirent* entry = readdir(dir))
+			{
+				names.push_back(entry->d_name);
+			}
+			closedir(dir);
+		}
+	#endif
+	std::sort(names.begin(), names.end());
+	for (const std::string& name : names)
+	{
+		if (GetFileFormatFromPath(name.c_str()) != FileFormat_Auto)
+		{
+			paths_.push_back(std::string(_dir) + "/" + name);
+		}
+	}
+}
+
+// File name without the directory and extension.
+std::string GetBaseName(const std::string& _path)
+{
+	const size_t slash = _path.find_last_of("/\\");
+	std::string ret = slash == std::string::npos ? _path : _path.substr(slash + 1);
+	const size_t dot = ret.find_last_of('.');
+	return dot == std::string::npos ? ret : ret.substr(0, dot);
+}
+
+bool ParseFormat(const char* _name, Format& format_)
+{
+	for (int i = 0; i < Format_Count; ++i)
+	{
+		std::string name = GetFormatName(i);
+		std::transform(name.begin(), name.end(), name.begin(), [](char _c) { return (char)tolower(_c); });
+		if (name == _name)
+		{
+			format_ = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Parse _str as a number in [_min, _max], else print an error for _option.
+bool ParseInt(const char* _option, const char* _str, int _min, int _max, int& value_)
+{
+	char* end;
+	const long value = strtol(_str, &end, 10);
+	if (end == _str || *end != '\0' || value < _min || value > _max)
+	{
+		fprintf(stderr, "Invalid %s '%s', expected an integer in [%d, %d]\n", _option, _str, _min, _max);
+		return false;
+	}
+	value_ = (int)value;
+	return true;
+}
+
+bool ParseFloat(const char* _option, const char* _str, float _min, float _max, float& value_)
+{
+	char* end;
+	const double value = strtod(_str, &end);
+	if (end == _str || *end != '\0' || !(value >= _min && value <= _max))
+	{
+		fprintf(stderr, "Invalid %s '%s', expected a number in [%g, %g]\n", _option, _str, _min, _max);
+		return false;
+	}
+	value_ = (float)value;
+	return true;
+}
+
+bool ParseArgs(int _argc, char** _argv, Options& options_)
+{
+	for (int i = 1; i < _argc; ++i)
+	{
+		const char* arg  = _argv[i];
+		const bool  next = i + 1 < _argc;
+		if (strcmp(arg, "--type") == 0 && next)
+		{
+			const char* name = _argv[++i];
+			options_.m_filter.m_type = -1;
+			for (int type = 0; type < KernelType_Count; ++type)
+			{
+				options_.m_filter.m_type = strcmp(name, GetTypeName(type)) == 0 ? type : options_.m_filter.m_type;
+			}
+			if (options_.m_filter.m_type < 0)
+			{
+				fprintf(stderr, "Unknown type '%s'\n", name);
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--mode") == 0 && next)
+		{
+			const char* name = _argv[++i];
+			options_.m_filter.m_mode = -1;
+			for (int mode = 0; mode < Mode_Count; ++mode)
+			{
+				options_.m_filter.m_mode = strcmp(name, GetModeName(mode)) == 0 ? mode : options_.m_filter.m_mode;
+			}
+			if (options_.m_filter.m_mode < 0)
+			{
+				fprintf(stderr, "Unknown mode '%s'\n", name);
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--width") == 0 && next)
+		{
+			if (!ParseInt(arg, _argv[++i], 1, kMaxWidth, options_.m_filter.m_width))
+			{
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--sigma") == 0 && next)
+		{
+			if (!ParseFloat(arg, _argv[++i], 0.0f, kMaxSigma, options_.m_filter.m_gaussianSigma))
+			{
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--passes") == 0 && next)
+		{
+			if (!ParseInt(arg, _argv[++i], 3, 5, options_.m_filter.m_boxPassCount))
+			{
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--levels") == 0 && next)
+		{
+			if (!ParseInt(arg, _argv[++i], 1, PyramidBlur::kMaxLevelCount, options_.m_filter.m_levelCount))
+			{
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--fixed") == 0)
+		{
+			options_.m_filter.m_fixedPoint = true;
+		}
+		else if (strcmp(arg, "--raw") == 0 && i + 2 < _argc)
+		{
+			options_.m_inputFormat = FileFormat_Raw;
+			if (sscanf(_argv[++i], "%dx%d", &options_.m_raw.m_width, &options_.m_raw.m_height) != 2 || options_.m_raw.m_width <= 0 || options_.m_raw.m_height <= 0)
+			{
+				fprintf(stderr, "Invalid raw size '%s', expected WxH\n", _argv[i]);
+				return false;
+			}
+			if (!ParseFormat(_argv[++i], options_.m_raw.m_format))
+			{
+				fprintf(stderr, "Unknown raw format '%s'\n", _argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--format") == 0 && next)
+		{
+			options_.m_outputFormat = GetFileFormatFromPath((std::string(".") + _argv[++i]).c_str());
+			if (options_.m_outputFormat == FileFormat_Auto)
+			{
+				fprintf(stderr, "Unknown output format '%s'\n", _argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--threads") == 0 && next)
+		{
+			if (!ParseInt(arg, _argv[++i], 0, kMaxThreadCount, options_.m_threadCount))
+			{
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--queue") == 0 && next)
+		{
+			if (!ParseInt(arg, _argv[++i], 1, kMaxQueueSize, options_.m_queueSize))
+			{
+				return false;
+			}
+		}
+		else if (arg[0] == '-' && arg[1] != '\0')
+		{
+			fprintf(stderr, "Unknown option '%s'\n", arg);
+			return false;
+		}
+		else if (!options_.m_input)
+		{
+			options_.m_input = arg;
+		}
+		else if (!options_.m_output)
+		{
+			options_.m_output = arg;
+		}
+		else
+		{
+			fprintf(stderr, "Unexpected argument '%s'\n", arg);
+			return false;
+		}
+	}
+	if (!options_.m_input || !options_.m_output)
+	{
+		fprintf(stderr, "Usage: ConvolutionCli [options] INPUT OUTPUT (see main.cpp for the options)\n");
+		return false;
+	}
+	return true;
+}
+
+// Convert _src to a format which _fileFormat can store (PPM/PAM need RGBA8, PFM RGBA32F).
+const Image& ConvertForFile(const Image& _src, FileFormat _fileFormat, Image& tmp_)
+{
+	const Format format = _fileFormat == FileFormat_Pfm ? Format_RGBA32F : (_fileFormat == FileFormat_Raw ? _src.getFormat() : Format_RGBA8);
+	if (format == _src.getFormat())
+	{
+		return _src;
+	}
+	tmp_.init(_src.getWidth(), _src.getHeight(), format);
+	std::vector<float> line((size_t)_src.getWidth() * 4);
+	for (int y = 0; y < _src.getHeight(); ++y)
+	{
+		ReadLine(_src, Direction_Horizontal, y, 0, _src.getWidth(), line.data());
+		WriteLine(tmp_, Direction_Horizontal, y, 0, _src.getWidth(), line.data());
+	}
+	return tmp_;
+}
+
+struct Percentiles
+{
+	double m_p50, m_p90, m_p99, m_max;
+};
+
+Percentiles GetPercentiles(std::vector<double> _values)
+{
+	Percentiles ret = {};
+	if (_values.empty())
+	{
+		return ret;
+	}
+	std::sort(_values.begin(), _values.end());
+	auto at = [&](double _p) { return _values[std::min(_values.size() - 1, (size_t)(_p * (double)_values.size()))]; };
+	ret.m_p50 = at(0.5);
+	ret.m_p90 = at(0.9);
+	ret.m_p99 = at(0.99);
+	ret.m_max = _values.back();
+	return ret;
+}
+
+} // namespace
+
+int main(int _argc, char** _argv)
+{
+	Options options;
+	if (!ParseArgs(_argc, _argv, options))
+	{
+		return 1;
+	}
+	const bool inputStream  = strcmp(options.m_input, "-") == 0;
+	const bool outputStream = strcmp(options.m_output, "-") == 0;
+	#ifdef _MSC_VER
+		_setmode(_fileno(stdin),  _O_BINARY);
+		_setmode(_fileno(stdout), _O_BINARY);
+	#endif
+
+	std::vector<std::string> inputPaths;
+	if (!inputStream)
+	{
+		if (IsDirectory(options.m_input))
+		{
+			ListImages(options.m_input, inputPaths);
+		}
+		else
+		{
+			inputPaths.push_back(options.m_input);
+		}
+		if (inputPaths.empty())
+		{
+			fprintf(stderr, "No images in '%s'\n", options.m_input);
+			return 1;
+		}
+	}
+	const bool outputFile = !outputStream && !inputStream && inputPaths.size() == 1 && !IsDirectory(options.m_input) && GetFileFormatFromPath(options.m_output) != FileFormat_Auto;
+	if (outputFile && options.m_outputFormat == FileFormat_Auto)
+	{
+		options.m_outputFormat = GetFileFormatFromPath(options.m_output);
+	}
+	if (!outputStream && !outputFile)
+	{
+		MakeDirectory(options.m_output);
+	}
+
+	Filter filter;
+	filter.init(options.m_filter);
+	ThreadPool pool(options.m_threadCount);
+	const FilterDesc& desc = filter.getDesc();
+	fprintf(stderr, "%s %s width %d sigma %.3f, %d threads\n", GetModeName(desc.m_mode), GetTypeName(desc.m_type), desc.m_width, desc.m_gaussianSigma, pool.getThreadCount());
+
+	BoundedQueue<FramePtr> decoded(options.m_queueSize);
+	BoundedQueue<FramePtr> convolved(options.m_queueSize);
+	std::atomic<bool> failed = { false };
+	const Clock::time_point start = Clock::now();
+
+ // decode
+	std::thread reader([&]()
+		{
+			for (int index = 0; inputStream || index < (int)inputPaths.size(); ++index)
+			{
+				FramePtr frame(new Frame);
+				frame->m_index = index;
+				frame->m_start = Clock::now();
+				FILE* file = inputStream ? stdin : fopen(inputPaths[index].c_str(), "rb");
+				if (!file)
+				{
+					fprintf(stderr, "Failed to open '%s'\n", inputPaths[index].c_str());
+					failed = true;
+					break;
+				}
+				const FileFormat format = inputStream ? options.m_inputFormat : (options.m_inputFormat == FileFormat_Raw ? FileFormat_Raw : FileFormat_Auto);
+				std::string error;
+				const ReadResult result = ReadImage(file, format, options.m_raw, frame->m_src, &frame->m_format, &error);
+				if (!inputStream)
+				{
+					fclose(file);
+				}
+				if (result == ReadResult_End && inputStream)
+				{
+					break;
+				}
+				if (result != ReadResult_Ok)
+				{
+					fprintf(stderr, "Failed to read %s #%d: %s\n", inputStream ? "stdin" : inputPaths[index].c_str(), index, result == ReadResult_End ? "empty file" : error.c_str());
+					failed = true;
+					break;
+				}
+				if (inputStream)
+				{
+					char name[32];
+					snprintf(name, sizeof(name), "frame_%06d", index);
+					frame->m_name = name;
+				}
+				else
+				{
+					frame->m_name = GetBaseName(inputPaths[index]);
+				}
+				frame->m_decodeMs = GetMs(frame->m_start, Clock::now());
+				if (!decoded.push(std::move(frame)))
+				{
+					break;
+				}
+			}
+			decoded.close();
+		});
+
+ // encode
+	std::vector<double> decodeMs, convolveMs, encodeMs, latencyMs;
+	long long pixelCount = 0;
+	std::thread writer([&]()
+		{
+			FramePtr frame;
+			Image converted;
+			while (convolved.pop(frame))
+			{
+				const Clock::time_point encodeStart = Clock::now();
+				const FileFormat format = options.m_outputFormat == FileFormat_Auto ? frame->m_format : options.m_outputFormat;
+				const Image& img = ConvertForFile(frame->m_dst, format, converted);
+				std::string path = outputFile ? std::string(options.m_output) : std::string(options.m_output) + "/" + frame->m_name + "." + GetFileFormatExtension(format);
+				FILE* file = outputStream ? stdout : fopen(path.c_str(), "wb");
+				bool ok = file && WriteImage(file, format, img);
+				if (outputStream)
+				{
+					ok &= fflush(stdout) == 0;
+				}
+				else if (file)
+				{
+					ok &= fclose(file) == 0;
+				}
+				if (!ok)
+				{
+					fprintf(stderr, "Failed to write '%s'\n", outputStream ? "stdout" : path.c_str());
+					failed = true;
+				}
+				const Clock::time_point end = Clock::now();
+				decodeMs.push_back(frame->m_decodeMs);
+				convolveMs.push_back(frame->m_convolveMs);
+				encodeMs.push_back(GetMs(encodeStart, end));
+				latencyMs.push_back(GetMs(frame->m_start, end));
+				pixelCount += (long long)img.getWidth() * img.getHeight();
+			}
+		});
+
+ // convolve
+	{
+		FramePtr frame;
+		Image tmp;
+		while (decoded.pop(frame))
+		{
+			const Clock::time_point convolveStart = Clock::now();
+			filter.apply(pool, frame->m_src, frame->m_dst, tmp);
+			frame->m_src.shutdown();
+			frame->m_convolveMs = GetMs(convolveStart, Clock::now());
+			convolved.push(std::move(frame));
+		}
+		convolved.close();
+	}
+	reader.join();
+	writer.join();
+
+	const double seconds = GetMs(start, Clock::now()) / 1000.0;
+	const int imageCount = (int)latencyMs.size();
+	fprintf(stderr, "%d images, %.1f MPix in %.3fs: %.2f images/s, %.2f MPix/s\n", imageCount, (double)pixelCount / 1e6, seconds, (double)imageCount / seconds, (double)pixelCount / 1e6 / seconds);
+	fprintf(stderr, "%-10s %10s %10s %10s %10s\n", "ms", "p50", "p90", "p99", "max");
+	const std::vector<double>* stages[] = { &decodeMs, &convolveMs, &encodeMs, &latencyMs };
+	const char* stageNames[] = { "decode", "convolve", "encode", "latency" };
+	for (int i = 0; i < 4; ++i)
+	{
+		const Percentiles percentiles = GetPercentiles(*stages[i]);
+		fprintf(stderr, "%-10s %10.3f %10.3f %10.3f %10.3f\n", stageNames[i], percentiles.m_p50, percentiles.m_p90, percentiles.m_p99, percentiles.m_max);
+	}
+	return failed ? 1 : 0;
+}
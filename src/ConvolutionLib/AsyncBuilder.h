@@ -0,0 +1,172 @@
+#pragma once
+
+// Build a result (e.g. a kernel and everything derived from it) from parameters on a worker thread, such that the
+// thread which uses the result never waits for a build:
+//
+//  - request() replaces any pending parameters, hence requests made while the worker is busy are coalesced and only the
+//    latest parameters are built.
+//  - Results are triple buffered: the worker builds into the back buffer, a completed build waits in the ready buffer
+//    and acquire() swaps the ready buffer to the front (e.g. at frame start). The front is only modified by acquire(),
+//    the caller keeps using the previous result until then.
+//
+// Each buffer is reused by later builds (the build function receives the buffer's previous result, which is 2 builds
+// old), so results which are expensive to allocate can be updated in place.
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace conv {
+
+template <typename tParams, typename tResult>
+class AsyncBuilder
+{
+public:
+	// Build _params into result_, result_ is a previous result (or default constructed).
+	typedef std::function<void(const tParams& _params, tResult& result_)> BuildFunc;
+
+	AsyncBuilder() = default;
+	~AsyncBuilder()                                  { shutdown(); }
+
+	AsyncBuilder(const AsyncBuilder&)            = delete;
+	AsyncBuilder& operator=(const AsyncBuilder&) = delete;
+
+	// Start the worker. If _async is false request() builds on the calling thread and the result is immediately ready.
+	void init(BuildFunc&& _build, bool _async = true)
+	{
+		shutdown();
+		m_build = std::move(_build);
+		m_quit  = false;
+		if (_async)
+		{
+			m_worker = std::thread([this]{ workerMain(); });
+		}
+	}
+
+	// Stop the worker, a build in progress completes first and pending requests are dropped.
+	void shutdown()
+	{
+		if (m_worker.joinable())
+		{
+			{	std::lock_guard<std::mutex> lock(m_mutex);
+				m_quit = true;
+			}
+			m_requestCv.notify_one();
+			m_worker.join();
+		}
+		m_hasRequest = m_hasReady = m_building = false;
+	}
+
+	// Queue a build of _params, replacing any pending request.
+	void request(const tParams& _params)
+	{
+		if (!m_worker.joinable())
+		{
+			++m_requestCount;
+			build(_params);
+			return;
+		}
+		{	std::lock_guard<std::mutex> lock(m_mutex);
+			m_request    = _params;
+			m_hasRequest = true;
+			++m_requestCount;
+		}
+		m_requestCv.notify_one();
+	}
+
+	// If a build completed since the last call, swap it to the front and return true.
+	bool acquire()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_hasReady)
+		{
+			return false;
+		}
+		std::swap(m_front, m_ready);
+		m_hasReady = false;
+		return true;
+	}
+
+	// Block until there are no pending requests or builds in progress (then acquire() returns the latest result).
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idleCv.wait(lock, [this]{ return !m_hasRequest && !m_building; });
+	}
+
+	bool           isBusy() const                    { std::lock_guard<std::mutex> lock(m_mutex); return m_hasRequest || m_building; }
+
+	// Front result and the parameters from which it was built, invalid until the first acquire().
+	tResult&       getFront()                        { return m_front->m_result; }
+	const tResult& getFront() const                  { return m_front->m_result; }
+	const tParams& getFrontParams() const            { return m_front->m_params; }
+
+	int            getRequestCount() const           { return m_requestCount; }
+	int            getBuildCount() const             { return m_buildCount; } // <= getRequestCount(), the difference were coalesced
+
+private:
+	struct Buffer
+	{
+		tParams m_params;
+		tResult m_result;
+	};
+
+	Buffer                  m_buffers[3];
+	Buffer*                 m_front      = &m_buffers[0];
+	Buffer*                 m_ready      = &m_buffers[1];
+	Buffer*                 m_back       = &m_buffers[2]; // only accessed by the worker
+	BuildFunc               m_build;
+	tParams                 m_request;
+	bool                    m_hasRequest = false;
+	bool                    m_hasReady   = false;
+	bool                    m_building   = false;
+	bool                    m_quit       = false;
+	std::atomic<int>        m_requestCount = { 0 };
+	std::atomic<int>        m_buildCount   = { 0 };
+	std::thread             m_worker;
+	mutable std::mutex      m_mutex;
+	std::condition_variable m_requestCv;
+	std::condition_variable m_idleCv;
+
+	// Build into the back buffer then swap it with the ready buffer.
+	void build(const tParams& _params)
+	{
+		m_back->m_params = _params;
+		m_build(_params, m_back->m_result);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::swap(m_back, m_ready);
+		m_hasReady = true;
+		++m_buildCount;
+	}
+
+	void workerMain()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			m_requestCv.wait(lock, [this]{ return m_hasRequest || m_quit; });
+			if (m_quit)
+			{
+				break;
+			}
+			const tParams params = m_request;
+			m_hasRequest = false;
+			m_building   = true;
+			lock.unlock();
+
+			build(params);
+
+			lock.lock();
+			m_building = false;
+			if (!m_hasRequest)
+			{
+				m_idleCv.notify_all();
+			}
+		}
+	}
+};
+
+} // namespace conv
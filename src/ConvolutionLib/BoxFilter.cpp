@@ -0,0 +1,376 @@
+#include "BoxFilter.h"
+
+#include "Schedule.h"
+#include "Simd.h"
+
+#include <cassert>
+#include <cstring>
+#include <immintrin.h>
+
+namespace conv {
+
+namespace {
+
+// Box filter _count texels of _line into out_. _line points at texel 0, _radius texels before/after [0, _count) are read.
+typedef void (BoxFilterLineFunc)(const float* _line, float* out_, int _count, int _radius);
+
+void BoxFilterLine_Scalar(const float* _line, float* out_, int _count, int _radius)
+{
+	const double scale = 1.0 / (double)(_radius * 2 + 1);
+	double sum[4] = {};
+	for (int i = -_radius; i <= _radius; ++i)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			sum[c] += (double)_line[i * 4 + c];
+		}
+	}
+	for (int x = 0; x < _count; ++x)
+	{
+		const float* add = _line + (x + _radius + 1) * 4;
+		const float* sub = _line + (x - _radius) * 4;
+		for (int c = 0; c < 4; ++c)
+		{
+			out_[x * 4 + c] = (float)(sum[c] * scale);
+			sum[c] += (double)add[c] - (double)sub[c];
+		}
+	}
+}
+
+CONV_TARGET_SSE4 void BoxFilterLine_Sse4(const float* _line, float* out_, int _count, int _radius)
+{
+ // RGBA sum split across 2 registers (RG, BA)
+	const __m128d scale = _mm_set1_pd(1.0 / (double)(_radius * 2 + 1));
+	__m128d sumRG = _mm_setzero_pd();
+	__m128d sumBA = _mm_setzero_pd();
+	for (int i = -_radius; i <= _radius; ++i)
+	{
+		const __m128 t = _mm_loadu_ps(_line + i * 4);
+		sumRG = _mm_add_pd(sumRG, _mm_cvtps_pd(t));
+		sumBA = _mm_add_pd(sumBA, _mm_cvtps_pd(_mm_movehl_ps(t, t)));
+	}
+	for (int x = 0; x < _count; ++x)
+	{
+		const __m128 rg = _mm_cvtpd_ps(_mm_mul_pd(sumRG, scale));
+		const __m128 ba = _mm_cvtpd_ps(_mm_mul_pd(sumBA, scale));
+		_mm_storeu_ps(out_ + x * 4, _mm_movelh_ps(rg, ba));
+
+		const __m128 add = _mm_loadu_ps(_line + (x + _radius + 1) * 4);
+		const __m128 sub = _mm_loadu_ps(_line + (x - _radius) * 4);
+		sumRG = _mm_add_pd(sumRG, _mm_sub_pd(_mm_cvtps_pd(add), _mm_cvtps_pd(sub)));
+		sumBA = _mm_add_pd(sumBA, _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(add, add)), _mm_cvtps_pd(_mm_movehl_ps(sub, sub))));
+	}
+}
+
+CONV_TARGET_AVX2 void BoxFilterLine_Avx2(const float* _line, float* out_, int _count, int _radius)
+{
+ // RGBA sum in a single register
+	const __m256d scale = _mm256_set1_pd(1.0 / (double)(_radius * 2 + 1));
+	__m256d sum = _mm256_setzero_pd();
+	for (int i = -_radius; i <= _radius; ++i)
+	{
+		sum = _mm256_add_pd(sum, _mm256_cvtps_pd(_mm_loadu_ps(_line + i * 4)));
+	}
+	for (int x = 0; x < _count; ++x)
+	{
+		_mm_storeu_ps(out_ + x * 4, _mm256_cvtpd_ps(_mm256_mul_pd(sum, scale)));
+
+		const __m256d add = _mm256_cvtps_pd(_mm_loadu_ps(_line + (x + _radius + 1) * 4));
+		const __m256d sub = _mm256_cvtps_pd(_mm_loadu_ps(_line + (x - _radius) * 4));
+		sum = _mm256_add_pd(sum, _mm256_sub_pd(add, sub));
+	}
+}
+
+BoxFilterLineFunc* GetBoxFilterLineFunc()
+{
+	switch (GetIsa())
+	{
+		case Isa_Avx2: return BoxFilterLine_Avx2;
+		case Isa_Sse4: return BoxFilterLine_Sse4;
+		default:       return BoxFilterLine_Scalar;
+	};
+}
+
+// As BoxFilterLineFunc but along the columns of _count rows of _width texels. _rows points at row 0, _radius rows
+// before/after [0, _count) are read. The running sums are the same double operations in the same order as the line
+// functions, hence the result is identical to filtering each column as a line.
+typedef void (BoxFilterRowsFunc)(const float* _rows, float* out_, int _count, int _radius, int _width);
+
+void BoxFilterRows_Scalar(const float* _rows, float* out_, int _count, int _radius, int _width)
+{
+	const double scale = 1.0 / (double)(_radius * 2 + 1);
+	const int n = _width * 4;
+	for (int x = 0; x < _width; ++x)
+	{
+		const float* rows = _rows + x * 4;
+		float*       out  = out_ + x * 4;
+		double sum[4] = {};
+		for (int i = -_radius; i <= _radius; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				sum[c] += (double)rows[i * n + c];
+			}
+		}
+		for (int y = 0; y < _count; ++y)
+		{
+			const float* add = rows + (y + _radius + 1) * n;
+			const float* sub = rows + (y - _radius) * n;
+			for (int c = 0; c < 4; ++c)
+			{
+				out[y * n + c] = (float)(sum[c] * scale);
+				sum[c] += (double)add[c] - (double)sub[c];
+			}
+		}
+	}
+}
+
+CONV_TARGET_SSE4 void BoxFilterRows_Sse4(const float* _rows, float* out_, int _count, int _radius, int _width)
+{
+	const __m128d scale = _mm_set1_pd(1.0 / (double)(_radius * 2 + 1));
+	const int n = _width * 4;
+	for (int x = 0; x < _width; ++x)
+	{
+		const float* rows = _rows + x * 4;
+		float*       out  = out_ + x * 4;
+		__m128d sumRG = _mm_setzero_pd();
+		__m128d sumBA = _mm_setzero_pd();
+		for (int i = -_radius; i <= _radius; ++i)
+		{
+			const __m128 t = _mm_loadu_ps(rows + i * n);
+			sumRG = _mm_add_pd(sumRG, _mm_cvtps_pd(t));
+			sumBA = _mm_add_pd(sumBA, _mm_cvtps_pd(_mm_movehl_ps(t, t)));
+		}
+		for (int y = 0; y < _count; ++y)
+		{
+			const __m128 rg = _mm_cvtpd_ps(_mm_mul_pd(sumRG, scale));
+			const __m128 ba = _mm_cvtpd_ps(_mm_mul_pd(sumBA, scale));
+			_mm_storeu_ps(out + y * n, _mm_movelh_ps(rg, ba));
+
+			const __m128 add = _mm_loadu_ps(rows + (y + _radius + 1) * n);
+			const __m128 sub = _mm_loadu_ps(rows + (y - _radius) * n);
+			sumRG = _mm_add_pd(sumRG, _mm_sub_pd(_mm_cvtps_pd(add), _mm_cvtps_pd(sub)));
+			sumBA = _mm_add_pd(sumBA, _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(add, add)), _mm_cvtps_pd(_mm_movehl_ps(sub, sub))));
+		}
+	}
+}
+
+CONV_TARGET_AVX2 void BoxFilterRows_Avx2(const float* _rows, float* out_, int _count, int _radius, int _width)
+{
+ // 4 columns at a time, each column sum in a register as BoxFilterLine_Avx2
+	const __m256d scale = _mm256_set1_pd(1.0 / (double)(_radius * 2 + 1));
+	const int n = _width * 4;
+	int x = 0;
+	for (; x + 4 <= _width; x += 4)
+	{
+		const float* rows = _rows + x * 4;
+		float*       out  = out_ + x * 4;
+		__m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+		for (int i = -_radius; i <= _radius; ++i)
+		{
+			const float* row = rows + i * n;
+			s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm_loadu_ps(row +  0)));
+			s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm_loadu_ps(row +  4)));
+			s2 = _mm256_add_pd(s2, _mm256_cvtps_pd(_mm_loadu_ps(row +  8)));
+			s3 = _mm256_add_pd(s3, _mm256_cvtps_pd(_mm_loadu_ps(row + 12)));
+		}
+		for (int y = 0; y < _count; ++y)
+		{
+			float* o = out + y * n;
+			_mm_storeu_ps(o +  0, _mm256_cvtpd_ps(_mm256_mul_pd(s0, scale)));
+			_mm_storeu_ps(o +  4, _mm256_cvtpd_ps(_mm256_mul_pd(s1, scale)));
+			_mm_storeu_ps(o +  8, _mm256_cvtpd_ps(_mm256_mul_pd(s2, scale)));
+			_mm_storeu_ps(o + 12, _mm256_cvtpd_ps(_mm256_mul_pd(s3, scale)));
+			const float* add = rows + (y + _radius + 1) * n;
+			const float* sub = rows + (y - _radius) * n;
+			s0 = _mm256_add_pd(s0, _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(add +  0)), _mm256_cvtps_pd(_mm_loadu_ps(sub +  0))));
+			s1 = _mm256_add_pd(s1, _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(add +  4)), _mm256_cvtps_pd(_mm_loadu_ps(sub +  4))));
+			s2 = _mm256_add_pd(s2, _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(add +  8)), _mm256_cvtps_pd(_mm_loadu_ps(sub +  8))));
+			s3 = _mm256_add_pd(s3, _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(add + 12)), _mm256_cvtps_pd(_mm_loadu_ps(sub + 12))));
+		}
+	}
+	for (; x < _width; ++x)
+	{
+		const float* rows = _rows + x * 4;
+		float*       out  = out_ + x * 4;
+		__m256d sum = _mm256_setzero_pd();
+		for (int i = -_radius; i <= _radius; ++i)
+		{
+			sum = _mm256_add_pd(sum, _mm256_cvtps_pd(_mm_loadu_ps(rows + i * n)));
+		}
+		for (int y = 0; y < _count; ++y)
+		{
+			_mm_storeu_ps(out + y * n, _mm256_cvtpd_ps(_mm256_mul_pd(sum, scale)));
+			sum = _mm256_add_pd(sum, _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(rows + (y + _radius + 1) * n)), _mm256_cvtps_pd(_mm_loadu_ps(rows + (y - _radius) * n))));
+		}
+	}
+}
+
+BoxFilterRowsFunc* GetBoxFilterRowsFunc()
+{
+	switch (GetIsa())
+	{
+		case Isa_Avx2: return BoxFilterRows_Avx2;
+		case Isa_Sse4: return BoxFilterRows_Sse4;
+		default:       return BoxFilterRows_Scalar;
+	};
+}
+
+// The vertical pass filters tiles of kTileWidth columns by kBandHeight rows (+ padding), small enough for the buffers to
+// stay in L2.
+constexpr int kTileWidth  = 128;
+constexpr int kBandHeight = 256;
+
+} // namespace
+
+void BoxFilterPass(const Image& _src, Image& dst_, int _width, Direction _direction, int _rowBegin, int _rowEnd)
+{
+	assert(_width >= 1);
+	BoxFilterPass(_src, dst_, &_width, 1, _direction, _rowBegin, _rowEnd);
+}
+
+void BoxFilterPass(const Image& _src, Image& dst_, const int* _widths, int _passCount, Direction _direction, int _rowBegin, int _rowEnd)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	_rowEnd = _rowEnd < 0 ? dst_.getHeight() : _rowEnd;
+	if (_rowEnd <= _rowBegin || _passCount < 1)
+	{
+		return;
+	}
+
+	if (_direction == Direction_Vertical && _rowEnd - _rowBegin > kBandHeight)
+	{
+	 // bands are padded as per the threaded BoxFilter(), hence the result doesn't depend on the band height
+		for (int y = _rowBegin; y < _rowEnd; y += kBandHeight)
+		{
+			BoxFilterPass(_src, dst_, _widths, _passCount, _direction, y, y + kBandHeight < _rowEnd ? y + kBandHeight : _rowEnd);
+		}
+		return;
+	}
+
+	BoxFilterLineFunc* boxFilterLine = GetBoxFilterLineFunc();
+	BoxFilterRowsFunc* boxFilterRows = GetBoxFilterRowsFunc();
+
+ // as ConvolvePass(), padded by the total radius (+1 per pass since the running sum reads 1 texel beyond the last output)
+	const int lineBegin  = _direction == Direction_Horizontal ? _rowBegin : 0;
+	const int lineEnd    = _direction == Direction_Horizontal ? _rowEnd : dst_.getWidth();
+	const int texelBegin = _direction == Direction_Horizontal ? 0 : _rowBegin;
+	const int texelCount = _direction == Direction_Horizontal ? dst_.getWidth() : _rowEnd - _rowBegin;
+	const int lineLength = GetLineLength(dst_, _direction);
+	int pad = 0;
+	for (int i = 0; i < _passCount; ++i)
+	{
+		assert(_widths[i] >= 1);
+		pad += (_widths[i] | 1) / 2 + 1;
+	}
+	const int bufferBegin = texelBegin - pad; // line position of buffer texel 0
+	const int bufferCount = pad + texelCount + pad;
+
+ // The vertical pass filters tiles of kTileWidth columns at once, a buffer texel is then a row of the tile. Reading
+ // and writing whole rows of the tile avoids walking the image a column at a time.
+	const int tileWidth = _direction == Direction_Horizontal ? 1 : kTileWidth;
+
+ // Each pass filters the whole buffer except its own radius at either end, the valid region shrinks towards the output
+ // range by the radius per pass. Between passes, buffer texels outside the line are clamped to the edge of the
+ // intermediate result, hence the result is the same as _passCount separate passes over the whole image.
+	float* buffers[2];
+	buffers[0] = (float*)AlignedAlloc(sizeof(float) * 4 * bufferCount * tileWidth);
+	buffers[1] = (float*)AlignedAlloc(sizeof(float) * 4 * bufferCount * tileWidth);
+	for (int line = lineBegin; line < lineEnd; line += tileWidth)
+	{
+		const int width  = lineEnd - line < tileWidth ? lineEnd - line : tileWidth;
+		const int stride = width * 4; // floats per buffer texel
+		if (_direction == Direction_Horizontal)
+		{
+			ReadLine(_src, _direction, line, bufferBegin, bufferCount, buffers[0]);
+		}
+		else
+		{
+			for (int j = 0; j < bufferCount; ++j)
+			{
+				int y = bufferBegin + j;
+				y = y < 0 ? 0 : (y >= lineLength ? lineLength - 1 : y);
+				ReadLine(_src, Direction_Horizontal, y, line, width, buffers[0] + j * stride);
+			}
+		}
+
+		for (int i = 0; i < _passCount; ++i)
+		{
+			const float* in  = buffers[i & 1];
+			float*       out = buffers[(i + 1) & 1];
+			const int radius = (_widths[i] | 1) / 2;
+			const int count  = bufferCount - radius * 2 - 1;
+			if (_direction == Direction_Horizontal)
+			{
+				boxFilterLine(in + radius * 4, out + radius * 4, count, radius);
+			}
+			else
+			{
+				boxFilterRows(in + radius * stride, out + radius * stride, count, radius, width);
+			}
+
+		 // texels which weren't written must still be finite, they enter the running sum of the next pass
+			memcpy(out, in, sizeof(float) * stride * radius);
+			memcpy(out + (radius + count) * stride, in + (radius + count) * stride, sizeof(float) * stride * (radius + 1));
+
+			const int clampBefore = -bufferBegin;                           // buffer texels before line texel 0
+			const int clampAfter  = bufferBegin + bufferCount - lineLength; // buffer texels after the last line texel
+			for (int j = 0; j < clampBefore; ++j)
+			{
+				memcpy(out + j * stride, out + clampBefore * stride, sizeof(float) * stride);
+			}
+			for (int j = bufferCount - clampAfter; j < bufferCount; ++j)
+			{
+				memcpy(out + j * stride, out + (bufferCount - clampAfter - 1) * stride, sizeof(float) * stride);
+			}
+		}
+
+		const float* result = buffers[_passCount & 1] + pad * stride;
+		if (_direction == Direction_Horizontal)
+		{
+			WriteLine(dst_, _direction, line, texelBegin, texelCount, result);
+		}
+		else
+		{
+			for (int j = 0; j < texelCount; ++j)
+			{
+				WriteLine(dst_, Direction_Horizontal, texelBegin + j, line, width, result + j * stride);
+			}
+		}
+	}
+	AlignedFree(buffers[0]);
+	AlignedFree(buffers[1]);
+}
+
+void BoxFilter(const Image& _src, Image& dst_, Image& tmp_, int _width)
+{
+	BoxFilter(_src, dst_, tmp_, &_width, 1);
+}
+
+void BoxFilter(const Image& _src, Image& dst_, Image& tmp_, const int* _widths, int _passCount)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), dst_.getFormat());
+	BoxFilterPass(_src, tmp_, _widths, _passCount, Direction_Horizontal);
+	BoxFilterPass(tmp_, dst_, _widths, _passCount, Direction_Vertical);
+}
+
+void BoxFilter(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, int _width, int _bandHeight)
+{
+	BoxFilter(_pool, _src, dst_, tmp_, &_width, 1, _bandHeight);
+}
+
+void BoxFilter(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const int* _widths, int _passCount, int _bandHeight)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), dst_.getFormat());
+	int radius = 0;
+	for (int i = 0; i < _passCount; ++i)
+	{
+		radius += (_widths[i] | 1) / 2;
+	}
+	RunSeparablePasses(_pool, dst_.getHeight(), -radius, radius, _bandHeight,
+		[&](int _rowBegin, int _rowEnd) { BoxFilterPass(_src, tmp_, _widths, _passCount, Direction_Horizontal, _rowBegin, _rowEnd); },
+		[&](int _rowBegin, int _rowEnd) { BoxFilterPass(tmp_, dst_, _widths, _passCount, Direction_Vertical, _rowBegin, _rowEnd); }
+		);
+}
+
+} // namespace conv
@@ -0,0 +1,32 @@
+#pragma once
+
+// Running sum box filter. The cost per texel is constant (1 add, 1 subtract, 1 multiply) regardless of the width, hence
+// widths far beyond KernelBank::kMaxWidth are practical. The result is the same as ConvolveSeparable() with the weights
+// from KernelBox1d() to within float rounding (the sums are accumulated in double precision so there is no drift along
+// the line). Edges are clamped (GL_CLAMP_TO_EDGE).
+//
+// The multi-pass overloads apply several box filters per line in a single read/write of the line, e.g. 3-5 passes with
+// the widths from GaussianFindBoxWidths() approximate a Gaussian (the kernel is KernelIteratedBox1d()). Intermediate
+// results are kept as float, otherwise the result is the same as separate passes.
+
+#include "Image.h"
+#include "Line.h"
+
+namespace conv {
+
+class ThreadPool;
+
+// Box filter rows [_rowBegin, _rowEnd) of dst_ along _direction (_rowEnd < 0 means the image height). _width must be >= 1
+// and is forced to be odd, as per KernelBox1d(). _src and dst_ must be the same size but the formats may differ.
+void BoxFilterPass(const Image& _src, Image& dst_, int _width, Direction _direction, int _rowBegin = 0, int _rowEnd = -1);
+void BoxFilterPass(const Image& _src, Image& dst_, const int* _widths, int _passCount, Direction _direction, int _rowBegin = 0, int _rowEnd = -1);
+
+// Horizontal then vertical pass, see ConvolveSeparable(). tmp_ is (re)initialized if required.
+void BoxFilter(const Image& _src, Image& dst_, Image& tmp_, int _width);
+void BoxFilter(const Image& _src, Image& dst_, Image& tmp_, const int* _widths, int _passCount);
+
+// Multi-threaded BoxFilter(), see ConvolveSeparable(ThreadPool&, ...).
+void BoxFilter(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, int _width, int _bandHeight = 0);
+void BoxFilter(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const int* _widths, int _passCount, int _bandHeight = 0);
+
+} // namespace conv
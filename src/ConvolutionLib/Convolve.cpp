@@ -0,0 +1,704 @@
+#include "Convolve.h"
+
+#include "Schedule.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#include <utility>
+
+namespace conv {
+
+namespace {
+
+// Convolve _count texels of _line into out_. _line points at texel 0, taps may read before/after [0, _count).
+typedef void (ConvolveLineFunc)(const float* _line, float* out_, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount);
+
+void ConvolveLine_Scalar(const float* _line, float* out_, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount)
+{
+	for (int x = 0; x < _count; ++x)
+	{
+		float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+		for (int i = 0; i < _tapCount; ++i)
+		{
+			const float* texel = _line + (x + _tapOffsets[i]) * 4;
+			const float  w     = _tapWeights[i];
+			r += texel[0] * w;
+			g += texel[1] * w;
+			b += texel[2] * w;
+			a += texel[3] * w;
+		}
+		out_[x * 4 + 0] = r;
+		out_[x * 4 + 1] = g;
+		out_[x * 4 + 2] = b;
+		out_[x * 4 + 3] = a;
+	}
+}
+
+CONV_TARGET_SSE4 void ConvolveLine_Sse4(const float* _line, float* out_, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount)
+{
+ // 1 RGBA texel per register
+	for (int x = 0; x < _count; ++x)
+	{
+		__m128 acc = _mm_setzero_ps();
+		const float* line = _line + x * 4;
+		for (int i = 0; i < _tapCount; ++i)
+		{
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(line + _tapOffsets[i] * 4), _mm_set1_ps(_tapWeights[i])));
+		}
+		_mm_storeu_ps(out_ + x * 4, acc);
+	}
+}
+
+CONV_TARGET_AVX2 void ConvolveLine_Avx2(const float* _line, float* out_, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount)
+{
+ // 2 adjacent RGBA texels per register
+	int x = 0;
+	for (; x + 2 <= _count; x += 2)
+	{
+		__m256 acc = _mm256_setzero_ps();
+		const float* line = _line + x * 4;
+		for (int i = 0; i < _tapCount; ++i)
+		{
+			acc = _mm256_fmadd_ps(_mm256_loadu_ps(line + _tapOffsets[i] * 4), _mm256_set1_ps(_tapWeights[i]), acc);
+		}
+		_mm256_storeu_ps(out_ + x * 4, acc);
+	}
+	for (; x < _count; ++x)
+	{
+		__m128 acc = _mm_setzero_ps();
+		const float* line = _line + x * 4;
+		for (int i = 0; i < _tapCount; ++i)
+		{
+			acc = _mm_fmadd_ps(_mm_loadu_ps(line + _tapOffsets[i] * 4), _mm_set1_ps(_tapWeights[i]), acc);
+		}
+		_mm_storeu_ps(out_ + x * 4, acc);
+	}
+}
+
+// Register blocked variants: kBlock adjacent texels per iteration in independent accumulators, such that each weight is
+// broadcast once per block rather than once per texel and the FMA latency is hidden. kTapCount > 0 is the tap count
+// known at compile time (the loop over taps is unrolled), 0 means use _tapCount. The remainder of the line is handled
+// by the unblocked variants above. The accumulators are expanded via integer_sequence rather than loops, so that they
+// stay in registers without relying on the optimizer unrolling the loops.
+template <int... kRegs>
+CONV_TARGET_SSE4 inline void ConvolveBlock_Sse4(const float* _line, float* out_, const int* _tapOffsets, const float* _tapWeights, int _tapCount, std::integer_sequence<int, kRegs...>)
+{
+	__m128 acc[sizeof...(kRegs)] = {};
+	for (int i = 0; i < _tapCount; ++i)
+	{
+		const __m128 w = _mm_set1_ps(_tapWeights[i]);
+		const float* tap = _line + _tapOffsets[i] * 4;
+		const int expand[] = { (acc[kRegs] = _mm_add_ps(acc[kRegs], _mm_mul_ps(_mm_loadu_ps(tap + kRegs * 4), w)), 0)... };
+		(void)expand;
+	}
+	const int expand[] = { (_mm_storeu_ps(out_ + kRegs * 4, acc[kRegs]), 0)... };
+	(void)expand;
+}
+
+template <int... kRegs>
+CONV_TARGET_AVX2 inline void ConvolveBlock_Avx2(const float* _line, float* out_, const int* _tapOffsets, const float* _tapWeights, int _tapCount, std::integer_sequence<int, kRegs...>)
+{
+	__m256 acc[sizeof...(kRegs)] = {};
+	for (int i = 0; i < _tapCount; ++i)
+	{
+		const __m256 w = _mm256_broadcast_ss(_tapWeights + i);
+		const float* tap = _line + _tapOffsets[i] * 4;
+		const int expand[] = { (acc[kRegs] = _mm256_fmadd_ps(_mm256_loadu_ps(tap + kRegs * 8), w, acc[kRegs]), 0)... };
+		(void)expand;
+	}
+	const int expand[] = { (_mm256_storeu_ps(out_ + kRegs * 8, acc[kRegs]), 0)... };
+	(void)expand;
+}
+
+template <int kBlock, int kTapCount>
+CONV_TARGET_SSE4 void ConvolveLineBlocked_Sse4(const float* _line, float* out_, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount)
+{
+	const int tapCount = kTapCount > 0 ? kTapCount : _tapCount;
+	int x = 0;
+	for (; x + kBlock <= _count; x += kBlock)
+	{
+		ConvolveBlock_Sse4(_line + x * 4, out_ + x * 4, _tapOffsets, _tapWeights, tapCount, std::make_integer_sequence<int, kBlock>()); // 1 texel per register
+	}
+	ConvolveLine_Sse4(_line + x * 4, out_ + x * 4, _count - x, _tapOffsets, _tapWeights, tapCount);
+}
+
+template <int kBlock, int kTapCount>
+CONV_TARGET_AVX2 void ConvolveLineBlocked_Avx2(const float* _line, float* out_, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount)
+{
+	const int tapCount = kTapCount > 0 ? kTapCount : _tapCount;
+	int x = 0;
+	for (; x + kBlock <= _count; x += kBlock)
+	{
+		ConvolveBlock_Avx2(_line + x * 4, out_ + x * 4, _tapOffsets, _tapWeights, tapCount, std::make_integer_sequence<int, kBlock / 2>()); // 2 texels per register
+	}
+	ConvolveLine_Avx2(_line + x * 4, out_ + x * 4, _count - x, _tapOffsets, _tapWeights, tapCount);
+}
+
+// Texels per iteration (AVX2, SSE4 uses half) for a tap count, 0 = unknown. Short kernels use larger blocks to amortize
+// the per-block overhead (tap offset loads, stores), otherwise 8 texels (4 ymm accumulators) hides the FMA latency
+// without the extra registers and tail texels of larger blocks. See ConvolutionBench blocked.
+constexpr int GetBlockSize(int _tapCount)
+{
+	return (_tapCount > 0 && _tapCount <= 6) ? 16 : 8;
+}
+
+// Line functions specialized for tap counts [0, kMaxSpecializedTapCount], indexed by tap count.
+constexpr int kMaxSpecializedTapCount = 32;
+
+template <int... kTapCounts>
+ConvolveLineFunc* GetConvolveLineFunc_Sse4(int _tapCount, std::integer_sequence<int, kTapCounts...>)
+{
+	static ConvolveLineFunc* const s_funcs[] = { ConvolveLineBlocked_Sse4<GetBlockSize(kTapCounts) / 2, kTapCounts>... };
+	return s_funcs[_tapCount <= kMaxSpecializedTapCount ? _tapCount : 0];
+}
+
+template <int... kTapCounts>
+ConvolveLineFunc* GetConvolveLineFunc_Avx2(int _tapCount, std::integer_sequence<int, kTapCounts...>)
+{
+	static ConvolveLineFunc* const s_funcs[] = { ConvolveLineBlocked_Avx2<GetBlockSize(kTapCounts), kTapCounts>... };
+	return s_funcs[_tapCount <= kMaxSpecializedTapCount ? _tapCount : 0];
+}
+
+ConvolveLineFunc* GetConvolveLineFunc(int _tapCount)
+{
+	switch (GetIsa())
+	{
+		case Isa_Avx2: return GetConvolveLineFunc_Avx2(_tapCount, std::make_integer_sequence<int, kMaxSpecializedTapCount + 1>());
+		case Isa_Sse4: return GetConvolveLineFunc_Sse4(_tapCount, std::make_integer_sequence<int, kMaxSpecializedTapCount + 1>());
+		default:       return ConvolveLine_Scalar;
+	};
+}
+
+// Vertical variants of the line functions: convolve _count texels of kRows consecutive output rows, row r is written to
+// out_ + r * _outPitch (in floats). Tap i of output row r reads _rows + _tapOffsets[i] + r * _rowPitch, hence a block of
+// texels of each source row is loaded once per kRows output rows and reused from L1 by the taps of the other rows,
+// rather than loaded once per output row. Each output texel accumulates the taps in order with the same instructions
+// as the line function of the same instruction set, so the result is identical to a horizontal pass on the transposed
+// image.
+typedef void (ConvolveRowsFunc)(const float* _rows, int _rowPitch, float* out_, int _outPitch, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount);
+
+template <int kRows>
+void ConvolveRows_Scalar(const float* _rows, int _rowPitch, float* out_, int _outPitch, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount)
+{
+	for (int r = 0; r < kRows; ++r)
+	{
+		for (int x = 0; x < _count; ++x)
+		{
+			float red = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+			for (int i = 0; i < _tapCount; ++i)
+			{
+				const float* texel = _rows + _tapOffsets[i] + r * _rowPitch + x * 4;
+				const float  w     = _tapWeights[i];
+				red += texel[0] * w;
+				g   += texel[1] * w;
+				b   += texel[2] * w;
+				a   += texel[3] * w;
+			}
+			float* out = out_ + r * _outPitch + x * 4;
+			out[0] = red;
+			out[1] = g;
+			out[2] = b;
+			out[3] = a;
+		}
+	}
+}
+
+// kRegs enumerates the accumulators, 2 per row (adjacent texels), as per ConvolveBlock_Sse4().
+template <int... kRegs>
+CONV_TARGET_SSE4 inline void ConvolveRowsBlock_Sse4(const float* _rows, int _rowPitch, float* out_, int _outPitch, const int* _tapOffsets, const float* _tapWeights, int _tapCount, std::integer_sequence<int, kRegs...>)
+{
+	__m128 acc[sizeof...(kRegs)] = {};
+	for (int i = 0; i < _tapCount; ++i)
+	{
+		const __m128 w = _mm_set1_ps(_tapWeights[i]);
+		const float* tap = _rows + _tapOffsets[i];
+		const int expand[] = { (acc[kRegs] = _mm_add_ps(acc[kRegs], _mm_mul_ps(_mm_loadu_ps(tap + (kRegs / 2) * _rowPitch + (kRegs % 2) * 4), w)), 0)... };
+		(void)expand;
+	}
+	const int expand[] = { (_mm_storeu_ps(out_ + (kRegs / 2) * _outPitch + (kRegs % 2) * 4, acc[kRegs]), 0)... };
+	(void)expand;
+}
+
+template <int kRows>
+CONV_TARGET_SSE4 void ConvolveRows_Sse4(const float* _rows, int _rowPitch, float* out_, int _outPitch, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount)
+{
+	int x = 0;
+	for (; x + 2 <= _count; x += 2)
+	{
+		ConvolveRowsBlock_Sse4(_rows + x * 4, _rowPitch, out_ + x * 4, _outPitch, _tapOffsets, _tapWeights, _tapCount, std::make_integer_sequence<int, kRows * 2>());
+	}
+	for (; x < _count; ++x)
+	{
+		for (int r = 0; r < kRows; ++r)
+		{
+			__m128 acc = _mm_setzero_ps();
+			for (int i = 0; i < _tapCount; ++i)
+			{
+				acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(_rows + _tapOffsets[i] + r * _rowPitch + x * 4), _mm_set1_ps(_tapWeights[i])));
+			}
+			_mm_storeu_ps(out_ + r * _outPitch + x * 4, acc);
+		}
+	}
+}
+
+// As ConvolveRowsBlock_Sse4(), 2 registers of 2 texels per row.
+template <int... kRegs>
+CONV_TARGET_AVX2 inline void ConvolveRowsBlock_Avx2(const float* _rows, int _rowPitch, float* out_, int _outPitch, const int* _tapOffsets, const float* _tapWeights, int _tapCount, std::integer_sequence<int, kRegs...>)
+{
+	__m256 acc[sizeof...(kRegs)] = {};
+	for (int i = 0; i < _tapCount; ++i)
+	{
+		const __m256 w = _mm256_broadcast_ss(_tapWeights + i);
+		const float* tap = _rows + _tapOffsets[i];
+		const int expand[] = { (acc[kRegs] = _mm256_fmadd_ps(_mm256_loadu_ps(tap + (kRegs / 2) * _rowPitch + (kRegs % 2) * 8), w, acc[kRegs]), 0)... };
+		(void)expand;
+	}
+	const int expand[] = { (_mm256_storeu_ps(out_ + (kRegs / 2) * _outPitch + (kRegs % 2) * 8, acc[kRegs]), 0)... };
+	(void)expand;
+}
+
+template <int kRows>
+CONV_TARGET_AVX2 void ConvolveRows_Avx2(const float* _rows, int _rowPitch, float* out_, int _outPitch, int _count, const int* _tapOffsets, const float* _tapWeights, int _tapCount)
+{
+	int x = 0;
+	for (; x + 4 <= _count; x += 4)
+	{
+		ConvolveRowsBlock_Avx2(_rows + x * 4, _rowPitch, out_ + x * 4, _outPitch, _tapOffsets, _tapWeights, _tapCount, std::make_integer_sequence<int, kRows * 2>());
+	}
+	for (; x < _count; ++x)
+	{
+		for (int r = 0; r < kRows; ++r)
+		{
+			__m128 acc = _mm_setzero_ps();
+			for (int i = 0; i < _tapCount; ++i)
+			{
+				acc = _mm_fmadd_ps(_mm_loadu_ps(_rows + _tapOffsets[i] + r * _rowPitch + x * 4), _mm_set1_ps(_tapWeights[i]), acc);
+			}
+			_mm_storeu_ps(out_ + r * _outPitch + x * 4, acc);
+		}
+	}
+}
+
+// Output rows per call of the vertical functions (8 accumulators with 4 rows, enough to hide the FMA latency).
+constexpr int kRowBlock = 4;
+
+// _rows is kRowBlock or 1 (the remainder).
+ConvolveRowsFunc* GetConvolveRowsFunc(int _rows)
+{
+	switch (GetIsa())
+	{
+		case Isa_Avx2: return _rows == kRowBlock ? ConvolveRows_Avx2<kRowBlock> : ConvolveRows_Avx2<1>;
+		case Isa_Sse4: return _rows == kRowBlock ? ConvolveRows_Sse4<kRowBlock> : ConvolveRows_Sse4<1>;
+		default:       return _rows == kRowBlock ? ConvolveRows_Scalar<kRowBlock> : ConvolveRows_Scalar<1>;
+	};
+}
+
+// Vertical passes run over strips of up to kStripWidth columns rather than walking columns. Source rows are converted
+// once, into a ring buffer of the rows read by the kernel for the current block of output rows, and all reads/writes
+// are contiguous row segments. Each row is written to the ring twice, at ring rows k and k + the ring size, so that the
+// rows of any block are contiguous (a tap is then a single offset for all rows of the block). Ring rows are skewed by a
+// cache line (kRingSkew texels) such that the same texel of different rows doesn't map to the same L1 set. Strips are
+// narrowed for large kernels such that the ring doesn't exceed kMaxRingTexels.
+constexpr int kStripWidth    = 1024;
+constexpr int kMinStripWidth = 64;
+constexpr int kRingSkew      = 4;
+constexpr int kMaxRingTexels = 64 * 1024;
+
+// Vertical pass of rows [_rowBegin, _rowEnd) x columns [_colBegin, _colEnd) of dst_, the sum of _srcs[i] convolved
+// with _kernels[i].
+void ConvolveVertical(const Image* _srcs, Image& dst_, const SeparableKernel* _kernels, int _count, int _rowBegin, int _rowEnd, int _colBegin, int _colEnd)
+{
+	int padBefore = 0, padAfter = 0, maxTapCount = 0;
+	for (int i = 0; i < _count; ++i)
+	{
+		assert(_srcs[i].getWidth() == dst_.getWidth() && _srcs[i].getHeight() == dst_.getHeight());
+		padBefore   = -_kernels[i].getMinOffset() > padBefore ? -_kernels[i].getMinOffset() : padBefore;
+		padAfter    =  _kernels[i].getMaxOffset() > padAfter  ?  _kernels[i].getMaxOffset() : padAfter;
+		maxTapCount =  _kernels[i].getTapCount() > maxTapCount ? _kernels[i].getTapCount() : maxTapCount;
+	}
+
+	const int    height     = dst_.getHeight();
+	const int    ringSize   = padBefore + padAfter + kRowBlock; // source row y is ring row (y + padBefore) % ringSize
+	const int    maxWidth   = kMaxRingTexels / ringSize > kStripWidth ? kStripWidth : (kMaxRingTexels / ringSize < kMinStripWidth ? kMinStripWidth : kMaxRingTexels / ringSize);
+	const int    ringPitch  = (maxWidth + kRingSkew) * 4; // in floats
+	const size_t ringFloats = (size_t)ringPitch * ringSize * 2;
+	int*   tapOffsets = new int[maxTapCount * _count];
+	float* rings      = (float*)AlignedAlloc(sizeof(float) * ringFloats * _count); // ring per source
+	float* rowTmp     = (float*)AlignedAlloc(sizeof(float) * 4 * maxWidth * kRowBlock);
+	float* rowOut     = (float*)AlignedAlloc(sizeof(float) * 4 * maxWidth * kRowBlock);
+	for (int i = 0; i < _count; ++i)
+	{
+		for (int j = 0; j < _kernels[i].getTapCount(); ++j)
+		{
+			tapOffsets[i * maxTapCount + j] = (_kernels[i].getTapOffsets()[j] + padBefore) * ringPitch; // relative to row y - padBefore
+		}
+	}
+	for (int x0 = _colBegin; x0 < _colEnd; x0 += maxWidth)
+	{
+		const int stripWidth = _colEnd - x0 < maxWidth ? _colEnd - x0 : maxWidth;
+		auto readRow = [&](int _i, int _y)
+			{
+				const int srcY = _y < 0 ? 0 : (_y >= height ? height - 1 : _y);
+				float* row = rings + ringFloats * _i + (size_t)((_y + padBefore) % ringSize) * ringPitch;
+				ReadLine(_srcs[_i], Direction_Horizontal, srcY, x0, stripWidth, row);
+				memcpy(row + (size_t)ringSize * ringPitch, row, sizeof(float) * 4 * stripWidth);
+			};
+
+	 // prime the rings with the rows before the first output row, then read 1 row per output row
+		for (int i = 0; i < _count; ++i)
+		{
+			for (int y = _rowBegin - padBefore; y < _rowBegin + padAfter; ++y)
+			{
+				readRow(i, y);
+			}
+		}
+		for (int y0 = _rowBegin; y0 < _rowEnd; y0 += kRowBlock)
+		{
+			const int rowCount = _rowEnd - y0 < kRowBlock ? _rowEnd - y0 : kRowBlock;
+			for (int i = 0; i < _count; ++i)
+			{
+				const SeparableKernel& kernel = _kernels[i];
+				for (int y = y0 + padAfter; y < y0 + rowCount + padAfter; ++y)
+				{
+					readRow(i, y);
+				}
+				const float* rows = rings + ringFloats * i + (size_t)(y0 % ringSize) * ringPitch; // row y0 - padBefore
+				float*       out  = i == 0 ? rowOut : rowTmp;
+				if (rowCount == kRowBlock)
+				{
+					GetConvolveRowsFunc(kRowBlock)(rows, ringPitch, out, stripWidth * 4, stripWidth, tapOffsets + i * maxTapCount, kernel.getTapWeights(), kernel.getTapCount());
+				}
+				else
+				{
+					for (int r = 0; r < rowCount; ++r)
+					{
+						GetConvolveRowsFunc(1)(rows + r * ringPitch, ringPitch, out + r * stripWidth * 4, stripWidth * 4, stripWidth, tapOffsets + i * maxTapCount, kernel.getTapWeights(), kernel.getTapCount());
+					}
+				}
+				if (i > 0)
+				{
+					for (int j = 0; j < stripWidth * rowCount * 4; ++j)
+					{
+						rowOut[j] += rowTmp[j];
+					}
+				}
+			}
+			for (int r = 0; r < rowCount; ++r)
+			{
+				WriteLine(dst_, Direction_Horizontal, y0 + r, x0, stripWidth, rowOut + r * stripWidth * 4);
+			}
+		}
+	}
+	AlignedFree(rings);
+	AlignedFree(rowTmp);
+	AlignedFree(rowOut);
+	delete[] tapOffsets;
+}
+
+} // namespace
+
+void SeparableKernel::init(const float* _weights, const float* _offsets, int _count)
+{
+ // each tap is at most 2 texel fetches, only reallocate if the capacity is insufficient
+	if (_count * 2 > m_tapCapacity)
+	{
+		shutdown();
+		m_tapCapacity = _count * 2;
+		m_tapOffsets  = new int[m_tapCapacity];
+		m_tapWeights  = new float[m_tapCapacity];
+	}
+	m_tapCount  = 0;
+	m_minOffset = 0;
+	m_maxOffset = 0;
+	for (int i = 0; i < _count; ++i)
+	{
+		const float o = _offsets[i];
+		const float w = _weights[i];
+		const int   o0 = (int)floorf(o);
+		const float f = o - (float)o0;
+
+		m_tapOffsets[m_tapCount] = o0;
+		m_tapWeights[m_tapCount] = w * (1.0f - f);
+		++m_tapCount;
+		if (f > 0.0f)
+		{
+			m_tapOffsets[m_tapCount] = o0 + 1;
+			m_tapWeights[m_tapCount] = w * f;
+			++m_tapCount;
+		}
+	}
+	for (int i = 0; i < m_tapCount; ++i)
+	{
+		m_minOffset = m_tapOffsets[i] < m_minOffset ? m_tapOffsets[i] : m_minOffset;
+		m_maxOffset = m_tapOffsets[i] > m_maxOffset ? m_tapOffsets[i] : m_maxOffset;
+	}
+}
+
+void SeparableKernel::shutdown()
+{
+	delete[] m_tapOffsets;
+	delete[] m_tapWeights;
+	m_tapOffsets  = nullptr;
+	m_tapWeights  = nullptr;
+	m_tapCount    = 0;
+	m_tapCapacity = 0;
+}
+
+void ConvolvePass(const Image& _src, Image& dst_, const SeparableKernel& _kernel, Direction _direction, int _rowBegin, int _rowEnd)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	_rowEnd = _rowEnd < 0 ? dst_.getHeight() : _rowEnd;
+	if (_rowEnd <= _rowBegin)
+	{
+		return;
+	}
+	if (_direction == Direction_Vertical)
+	{
+		ConvolveVertical(&_src, dst_, &_kernel, 1, _rowBegin, _rowEnd, 0, dst_.getWidth());
+		return;
+	}
+
+	ConvolveLineFunc* convolveLine = GetConvolveLineFunc(_kernel.getTapCount());
+	const int padBefore = -_kernel.getMinOffset();
+	const int padAfter  = _kernel.getMaxOffset();
+	const int texelCount = dst_.getWidth();
+
+	float* lineIn  = (float*)AlignedAlloc(sizeof(float) * 4 * (padBefore + texelCount + padAfter));
+	float* lineOut = (float*)AlignedAlloc(sizeof(float) * 4 * texelCount);
+	for (int line = _rowBegin; line < _rowEnd; ++line)
+	{
+		ReadLine(_src, Direction_Horizontal, line, -padBefore, padBefore + texelCount + padAfter, lineIn);
+		convolveLine(lineIn + padBefore * 4, lineOut, texelCount, _kernel.getTapOffsets(), _kernel.getTapWeights(), _kernel.getTapCount());
+		WriteLine(dst_, Direction_Horizontal, line, 0, texelCount, lineOut);
+	}
+	AlignedFree(lineIn);
+	AlignedFree(lineOut);
+}
+
+void ConvolvePassSum(const Image* _srcs, Image& dst_, const SeparableKernel* _kernels, int _count, Direction _direction, int _rowBegin, int _rowEnd)
+{
+	_rowEnd = _rowEnd < 0 ? dst_.getHeight() : _rowEnd;
+	if (_rowEnd <= _rowBegin || _count < 1)
+	{
+		return;
+	}
+	if (_direction == Direction_Vertical)
+	{
+		ConvolveVertical(_srcs, dst_, _kernels, _count, _rowBegin, _rowEnd, 0, dst_.getWidth());
+		return;
+	}
+
+	int padBefore = 0, padAfter = 0;
+	for (int i = 0; i < _count; ++i)
+	{
+		assert(_srcs[i].getWidth() == dst_.getWidth() && _srcs[i].getHeight() == dst_.getHeight());
+		padBefore = -_kernels[i].getMinOffset() > padBefore ? -_kernels[i].getMinOffset() : padBefore;
+		padAfter  =  _kernels[i].getMaxOffset() > padAfter  ?  _kernels[i].getMaxOffset() : padAfter;
+	}
+
+	const int texelCount = dst_.getWidth();
+	float* lineIn  = (float*)AlignedAlloc(sizeof(float) * 4 * (padBefore + texelCount + padAfter));
+	float* lineTmp = (float*)AlignedAlloc(sizeof(float) * 4 * texelCount);
+	float* lineOut = (float*)AlignedAlloc(sizeof(float) * 4 * texelCount);
+	for (int line = _rowBegin; line < _rowEnd; ++line)
+	{
+		for (int i = 0; i < _count; ++i)
+		{
+			const SeparableKernel& kernel = _kernels[i];
+			ReadLine(_srcs[i], Direction_Horizontal, line, -padBefore, padBefore + texelCount + padAfter, lineIn);
+			GetConvolveLineFunc(kernel.getTapCount())(lineIn + padBefore * 4, i == 0 ? lineOut : lineTmp, texelCount, kernel.getTapOffsets(), kernel.getTapWeights(), kernel.getTapCount());
+			if (i > 0)
+			{
+				for (int j = 0; j < texelCount * 4; ++j)
+				{
+					lineOut[j] += lineTmp[j];
+				}
+			}
+		}
+		WriteLine(dst_, Direction_Horizontal, line, 0, texelCount, lineOut);
+	}
+	AlignedFree(lineIn);
+	AlignedFree(lineTmp);
+	AlignedFree(lineOut);
+}
+
+void ConvolveSeparable(const Image& _src, Image& dst_, Image& tmp_, const SeparableKernel& _kernel)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), dst_.getFormat());
+	ConvolvePass(_src, tmp_, _kernel, Direction_Horizontal);
+	ConvolvePass(tmp_, dst_, _kernel, Direction_Vertical);
+}
+
+void ConvolveSeparable(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const SeparableKernel& _kernel, int _bandHeight)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), dst_.getFormat());
+	RunSeparablePasses(_pool, dst_.getHeight(), _kernel.getMinOffset(), _kernel.getMaxOffset(), _bandHeight,
+		[&](int _rowBegin, int _rowEnd) { ConvolvePass(_src, tmp_, _kernel, Direction_Horizontal, _rowBegin, _rowEnd); },
+		[&](int _rowBegin, int _rowEnd) { ConvolvePass(tmp_, dst_, _kernel, Direction_Vertical, _rowBegin, _rowEnd); }
+		);
+}
+
+void ConvolvePassRect(const Image& _src, Image& dst_, const SeparableKernel& _kernel, Direction _direction, const Rect& _rect)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	assert(_rect.m_x0 >= 0 && _rect.m_y0 >= 0 && _rect.m_x1 <= dst_.getWidth() && _rect.m_y1 <= dst_.getHeight());
+	if (_rect.isEmpty())
+	{
+		return;
+	}
+	if (_direction == Direction_Vertical)
+	{
+		ConvolveVertical(&_src, dst_, &_kernel, 1, _rect.m_y0, _rect.m_y1, _rect.m_x0, _rect.m_x1);
+		return;
+	}
+
+	ConvolveLineFunc* convolveLine = GetConvolveLineFunc(_kernel.getTapCount());
+	const int padBefore = -_kernel.getMinOffset();
+	const int padAfter  = _kernel.getMaxOffset();
+	const int texelCount = _rect.getWidth();
+
+	float* lineIn  = (float*)AlignedAlloc(sizeof(float) * 4 * (padBefore + texelCount + padAfter));
+	float* lineOut = (float*)AlignedAlloc(sizeof(float) * 4 * texelCount);
+	for (int line = _rect.m_y0; line < _rect.m_y1; ++line)
+	{
+		ReadLine(_src, Direction_Horizontal, line, _rect.m_x0 - padBefore, padBefore + texelCount + padAfter, lineIn);
+		convolveLine(lineIn + padBefore * 4, lineOut, texelCount, _kernel.getTapOffsets(), _kernel.getTapWeights(), _kernel.getTapCount());
+		WriteLine(dst_, Direction_Horizontal, line, _rect.m_x0, texelCount, lineOut);
+	}
+	AlignedFree(lineIn);
+	AlignedFree(lineOut);
+}
+
+void ConvolveSeparableRect(const Image& _src, Image& dst_, Image& tmp_, const SeparableKernel& _kernel, const Rect& _rect)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), dst_.getFormat());
+	const Rect image(0, 0, dst_.getWidth(), dst_.getHeight());
+	const Rect rect = Intersect(_rect, image);
+
+ // vertical texel y reads horizontal rows y + [min offset, max offset] (clamped, hence always inside the image)
+	const Rect rectH = Intersect(Rect(rect.m_x0, rect.m_y0 + _kernel.getMinOffset(), rect.m_x1, rect.m_y1 + _kernel.getMaxOffset()), image);
+	ConvolvePassRect(_src, tmp_, _kernel, Direction_Horizontal, rectH);
+	ConvolvePassRect(tmp_, dst_, _kernel, Direction_Vertical, rect);
+}
+
+void ConvolveSeparableDirty(const Image& _src, Image& dst_, Image& tmp_, const SeparableKernel& _kernel, const Rect* _dirtyRects, int _dirtyCount, std::vector<Rect>* updated_)
+{
+	const Rect image(0, 0, dst_.getWidth(), dst_.getHeight());
+	if (tmp_.getWidth() != dst_.getWidth() || tmp_.getHeight() != dst_.getHeight() || tmp_.getFormat() != dst_.getFormat())
+	{
+		ConvolveSeparable(_src, dst_, tmp_, _kernel);
+		if (updated_)
+		{
+			updated_->assign(1, image);
+		}
+		return;
+	}
+
+ // output texel x reads x + [min offset, max offset] hence a change at x affects [x - max offset, x - min offset] (also
+ // at the edges, where reads are clamped)
+	std::vector<Rect> rects;
+	for (int i = 0; i < _dirtyCount; ++i)
+	{
+		const Rect& dirty = _dirtyRects[i];
+		rects.push_back(Intersect(Rect(dirty.m_x0 - _kernel.getMaxOffset(), dirty.m_y0, dirty.m_x1 - _kernel.getMinOffset(), dirty.m_y1), image));
+	}
+	MergeRects(rects);
+	for (const Rect& rect : rects)
+	{
+		ConvolvePassRect(_src, tmp_, _kernel, Direction_Horizontal, rect);
+	}
+
+	for (Rect& rect : rects)
+	{
+		rect = Intersect(Rect(rect.m_x0, rect.m_y0 - _kernel.getMaxOffset(), rect.m_x1, rect.m_y1 - _kernel.getMinOffset()), image);
+	}
+	MergeRects(rects);
+	for (const Rect& rect : rects)
+	{
+		ConvolvePassRect(tmp_, dst_, _kernel, Direction_Vertical, rect);
+	}
+
+	if (updated_)
+	{
+		*updated_ = std::move(rects);
+	}
+}
+
+void Convolve2d(const Image& _src, Image& dst_, const float* _weights, int _size, int _rowBegin, int _rowEnd)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	_rowEnd = _rowEnd < 0 ? dst_.getHeight() : _rowEnd;
+	if (_rowEnd <= _rowBegin)
+	{
+		return;
+	}
+
+	ConvolveLineFunc* convolveLine = GetConvolveLineFunc(_size);
+	const int width  = dst_.getWidth();
+	const int height = dst_.getHeight();
+	const int radius = _size / 2;
+	int* offsets = new int[_size];
+	for (int i = 0; i < _size; ++i)
+	{
+		offsets[i] = i - radius;
+	}
+
+ // ring buffer of the _size source rows (padded) under the kernel, each row is read once per call
+	const int paddedWidth = radius + width + radius;
+	float* rows = (float*)AlignedAlloc(sizeof(float) * 4 * paddedWidth * _size);
+	float* lineTmp = (float*)AlignedAlloc(sizeof(float) * 4 * width);
+	float* lineOut = (float*)AlignedAlloc(sizeof(float) * 4 * width);
+	auto getRow = [&](int _y) { return rows + ((_y % _size) + _size) % _size * paddedWidth * 4; };
+	auto readRow = [&](int _y)
+		{
+			const int y = _y < 0 ? 0 : (_y >= height ? height - 1 : _y);
+			ReadLine(_src, Direction_Horizontal, y, -radius, paddedWidth, getRow(_y));
+		};
+	for (int y = _rowBegin - radius; y < _rowBegin + radius; ++y)
+	{
+		readRow(y);
+	}
+	for (int y = _rowBegin; y < _rowEnd; ++y)
+	{
+		readRow(y + radius);
+		for (int j = 0; j < _size; ++j)
+		{
+			float* out = j == 0 ? lineOut : lineTmp;
+			convolveLine(getRow(y + j - radius) + radius * 4, out, width, offsets, _weights + j * _size, _size);
+			if (j > 0)
+			{
+				for (int i = 0; i < width * 4; ++i)
+				{
+					lineOut[i] += lineTmp[i];
+				}
+			}
+		}
+		WriteLine(dst_, Direction_Horizontal, y, 0, width, lineOut);
+	}
+	AlignedFree(rows);
+	AlignedFree(lineTmp);
+	AlignedFree(lineOut);
+	delete[] offsets;
+}
+
+void Convolve2d(ThreadPool& _pool, const Image& _src, Image& dst_, const float* _weights, int _size)
+{
+ // ~4 chunks per thread for load balancing, each chunk reads _size - 1 extra rows
+	const int height = dst_.getHeight();
+	int chunkSize = (height + _pool.getThreadCount() * 4 - 1) / (_pool.getThreadCount() * 4);
+	chunkSize = chunkSize < _size * 2 ? _size * 2 : chunkSize;
+
+	ThreadPool::TaskGroup group;
+	for (int rowBegin = 0; rowBegin < height; rowBegin += chunkSize)
+	{
+		const int rowEnd = rowBegin + chunkSize < height ? rowBegin + chunkSize : height;
+		_pool.run(group, [&, rowBegin, rowEnd]() { Convolve2d(_src, dst_, _weights, _size, rowBegin, rowEnd); });
+	}
+	_pool.wait(group);
+}
+
+} // namespace conv
@@ -0,0 +1,88 @@
+#pragma once
+
+// CPU convolution engine. ConvolveSeparable() gives the same result as ConvolutionBasic_cs.glsl dispatched with
+// uDirection (1,0) then (0,1) (Mode_Separable and Mode_SeparableBilinear), using the same weights/offsets buffers.
+// Edges are clamped (GL_CLAMP_TO_EDGE). The inner loops are selected at runtime per GetIsa() (AVX2, SSE4 or scalar).
+
+#include "Image.h"
+#include "Line.h"
+#include "Region.h"
+
+namespace conv {
+
+class ThreadPool;
+
+// 1d kernel for the separable passes. Initialize from the weights/offsets generated for Mode_Separable (integer offsets)
+// or Mode_SeparableBilinear (fractional offsets). Bilinear taps are split into the 2 texel fetches + lerp weights which
+// the texture unit would use, so the result matches GL_LINEAR sampling (to within the sampler's weight precision).
+class SeparableKernel
+{
+public:
+	SeparableKernel() = default;
+	~SeparableKernel()                         { shutdown(); }
+
+	SeparableKernel(const SeparableKernel&)            = delete;
+	SeparableKernel& operator=(const SeparableKernel&) = delete;
+
+	// Only reallocates if _count exceeds the count of any previous call.
+	void         init(const float* _weights, const float* _offsets, int _count);
+	void         shutdown();
+
+	int          getTapCount() const           { return m_tapCount;   }
+	const int*   getTapOffsets() const         { return m_tapOffsets; }
+	const float* getTapWeights() const         { return m_tapWeights; }
+
+	// Range of texel offsets read by the kernel, inclusive.
+	int          getMinOffset() const          { return m_minOffset;  }
+	int          getMaxOffset() const          { return m_maxOffset;  }
+
+private:
+	int    m_tapCount    = 0;
+	int    m_tapCapacity = 0;
+	int*   m_tapOffsets  = nullptr;
+	float* m_tapWeights  = nullptr;
+	int    m_minOffset   = 0;
+	int    m_maxOffset   = 0;
+};
+
+// Convolve rows [_rowBegin, _rowEnd) of dst_ along _direction (_rowEnd < 0 means the image height). _src and dst_ must
+// be the same size but the formats may differ.
+void ConvolvePass(const Image& _src, Image& dst_, const SeparableKernel& _kernel, Direction _direction, int _rowBegin = 0, int _rowEnd = -1);
+
+// As ConvolvePass() but dst_ is the sum of _count passes, _srcs[i] convolved with _kernels[i] (e.g. the terms of a
+// LowRankKernel). All images must be the same size.
+void ConvolvePassSum(const Image* _srcs, Image& dst_, const SeparableKernel* _kernels, int _count, Direction _direction, int _rowBegin = 0, int _rowEnd = -1);
+
+// Horizontal then vertical pass. tmp_ receives the result of the horizontal pass and should have the same format as
+// dst_ to match the GPU path (the intermediate m_txDst[1] is RGBA8). tmp_ is (re)initialized if required.
+void ConvolveSeparable(const Image& _src, Image& dst_, Image& tmp_, const SeparableKernel& _kernel);
+
+// Multi-threaded ConvolveSeparable(). The image is split into bands of _bandHeight rows (0 = choose automatically).
+// Horizontal bands are independent. The vertical pass for a band is queued as soon as the horizontal bands which it
+// reads (the band dilated by the kernel radius) are complete, so the passes overlap rather than being separated by a
+// full barrier.
+void ConvolveSeparable(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const SeparableKernel& _kernel, int _bandHeight = 0);
+
+// As ConvolvePass() but only texels of dst_ inside _rect (which must be inside the image) are written.
+void ConvolvePassRect(const Image& _src, Image& dst_, const SeparableKernel& _kernel, Direction _direction, const Rect& _rect);
+
+// As ConvolveSeparable() but only texels of dst_ inside _rect are written (e.g. the visible part of the image). The
+// horizontal pass covers _rect dilated vertically by the kernel, the contents of tmp_ are otherwise undefined.
+void ConvolveSeparableRect(const Image& _src, Image& dst_, Image& tmp_, const SeparableKernel& _kernel, const Rect& _rect);
+
+// Update dst_ after the texels of _src inside _dirtyRects changed. dst_ and tmp_ must hold the result of a previous
+// ConvolveSeparable() (or ConvolveSeparableDirty()) with the same _kernel, _src may only differ inside _dirtyRects. The
+// horizontal pass recomputes the dirty rects dilated horizontally by the kernel, the vertical pass those dilated
+// vertically; overlapping rects are merged. If tmp_ doesn't match dst_ the whole image is convolved. updated_ (if not
+// nullptr) receives the rects of dst_ which were written.
+void ConvolveSeparableDirty(const Image& _src, Image& dst_, Image& tmp_, const SeparableKernel& _kernel, const Rect* _dirtyRects, int _dirtyCount, std::vector<Rect>* updated_ = nullptr);
+
+// Direct 2d convolution of rows [_rowBegin, _rowEnd) of dst_ (_rowEnd < 0 means the image height) with a _size x _size
+// kernel (row major, integer offsets centered on the texel as per Mode_2d). The cost is _size^2 taps per texel, see
+// Convolver2d for the faster alternatives.
+void Convolve2d(const Image& _src, Image& dst_, const float* _weights, int _size, int _rowBegin = 0, int _rowEnd = -1);
+
+// Multi-threaded Convolve2d(), rows are distributed across the pool.
+void Convolve2d(ThreadPool& _pool, const Image& _src, Image& dst_, const float* _weights, int _size);
+
+} // namespace conv
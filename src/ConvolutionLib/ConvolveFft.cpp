@@ -0,0 +1,251 @@
+#include "ConvolveFft.h"
+
+#include "Line.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace conv {
+
+namespace {
+
+// Accumulation target for the tiles, RGBA float.
+struct Accumulator
+{
+	float* m_data;
+	int    m_width;
+	int    m_height;
+};
+
+// Convolve the block at (_blockX, _blockY) (in blocks) and add the result to acc_. tile_ is 2 * T * T complex values,
+// tmp_ is T complex values.
+void ConvolveTile(const Image& _src, Accumulator& acc_, const FftKernel& _kernel, int _blockX, int _blockY, float* tile_, float* tmp_, float* line_)
+{
+	const int tileSize  = _kernel.getTileSize();
+	const int blockSize = _kernel.getBlockSize();
+	const int radius    = _kernel.getSize() / 2;
+	const int width     = _src.getWidth();
+	const int height    = _src.getHeight();
+	const Fft& fft      = _kernel.getFft();
+	float* tiles[2]     = { tile_, tile_ + tileSize * tileSize * 2 };
+
+ // The block covers [x0, x0 + B) of the source padded by the radius (i.e. source texel x0 - radius), clamped. The full
+ // convolution of the block covers [x0, x0 + B + size - 1), the output texel x is at padded position x + 2 * radius.
+	const int x0 = _blockX * blockSize;
+	const int y0 = _blockY * blockSize;
+	const int blockWidth  = x0 + blockSize < width  + radius * 2 ? blockSize : width  + radius * 2 - x0;
+	const int blockHeight = y0 + blockSize < height + radius * 2 ? blockSize : height + radius * 2 - y0;
+	memset(tiles[0], 0, sizeof(float) * tileSize * tileSize * 2 * 2);
+	for (int y = 0; y < blockHeight; ++y)
+	{
+		int srcY = y0 + y - radius;
+		srcY = srcY < 0 ? 0 : (srcY >= height ? height - 1 : srcY);
+		ReadLine(_src, Direction_Horizontal, srcY, x0 - radius, blockWidth, line_);
+		float* row0 = tiles[0] + y * tileSize * 2;
+		float* row1 = tiles[1] + y * tileSize * 2;
+		for (int x = 0; x < blockWidth; ++x)
+		{
+			row0[x * 2 + 0] = line_[x * 4 + 0];
+			row0[x * 2 + 1] = line_[x * 4 + 1];
+			row1[x * 2 + 0] = line_[x * 4 + 2];
+			row1[x * 2 + 1] = line_[x * 4 + 3];
+		}
+	}
+
+	const float* spectrum = _kernel.getSpectrum();
+	for (float* tile : tiles)
+	{
+		fft.forward2d(tile, tmp_);
+		for (int i = 0; i < tileSize * tileSize; ++i)
+		{
+			const float ar = tile[i * 2 + 0], ai = tile[i * 2 + 1];
+			const float br = spectrum[i * 2 + 0], bi = spectrum[i * 2 + 1];
+			tile[i * 2 + 0] = ar * br - ai * bi;
+			tile[i * 2 + 1] = ar * bi + ai * br;
+		}
+		fft.inverse2d(tile, tmp_);
+	}
+
+ // add the part of the result which lands in the output
+	const int resultWidth  = blockWidth  + _kernel.getSize() - 1;
+	const int resultHeight = blockHeight + _kernel.getSize() - 1;
+	for (int y = 0; y < resultHeight; ++y)
+	{
+		const int dstY = y0 + y - radius * 2;
+		if (dstY < 0 || dstY >= acc_.m_height)
+		{
+			continue;
+		}
+		const float* row0 = tiles[0] + y * tileSize * 2;
+		const float* row1 = tiles[1] + y * tileSize * 2;
+		float* dst = acc_.m_data + dstY * acc_.m_width * 4;
+		for (int x = 0; x < resultWidth; ++x)
+		{
+			const int dstX = x0 + x - radius * 2;
+			if (dstX < 0 || dstX >= acc_.m_width)
+			{
+				continue;
+			}
+			dst[dstX * 4 + 0] += row0[x * 2 + 0];
+			dst[dstX * 4 + 1] += row0[x * 2 + 1];
+			dst[dstX * 4 + 2] += row1[x * 2 + 0];
+			dst[dstX * 4 + 3] += row1[x * 2 + 1];
+		}
+	}
+}
+
+// Call _func(blockX, blockY) for every block, in phase _phase (0-3, or -1 for all).
+template <typename tFunc>
+void ForEachBlock(const Image& _src, const FftKernel& _kernel, int _phase, tFunc&& _func)
+{
+	const int blockSize   = _kernel.getBlockSize();
+	const int padding     = (_kernel.getSize() / 2) * 2;
+	const int blockCountX = (_src.getWidth()  + padding + blockSize - 1) / blockSize;
+	const int blockCountY = (_src.getHeight() + padding + blockSize - 1) / blockSize;
+	for (int by = 0; by < blockCountY; ++by)
+	{
+		for (int bx = 0; bx < blockCountX; ++bx)
+		{
+			if (_phase < 0 || _phase == ((by & 1) << 1 | (bx & 1)))
+			{
+				_func(bx, by);
+			}
+		}
+	}
+}
+
+void WriteAccumulator(const Accumulator& _acc, Image& dst_)
+{
+	for (int y = 0; y < _acc.m_height; ++y)
+	{
+		WriteLine(dst_, Direction_Horizontal, y, 0, _acc.m_width, _acc.m_data + y * _acc.m_width * 4);
+	}
+}
+
+} // namespace
+
+int FftKernel::FindTileSize(int _size, int _width, int _height)
+{
+ // cost ~ tile count * T^2 log2(T); B = T - size + 1 must be >= size - 1 such that tiles only overlap their immediate
+ // neighbors
+	int    ret = 0;
+	double retCost = 0.0;
+	for (int log2T = 3; log2T <= 11; ++log2T)
+	{
+		const int T = 1 << log2T;
+		const int B = T - _size + 1;
+		if (B < _size - 1 || B < 1)
+		{
+			continue;
+		}
+		const double cost = (double)GetTileCount(T, _size, _width, _height) * (double)T * (double)T * (double)log2T;
+		if (ret == 0 || cost < retCost)
+		{
+			ret = T;
+			retCost = cost;
+		}
+	}
+	return ret == 0 ? 2048 : ret;
+}
+
+int FftKernel::GetTileCount(int _tileSize, int _size, int _width, int _height)
+{
+	const int blockSize = _tileSize - _size + 1;
+	const int padding   = (_size / 2) * 2;
+	return ((_width + padding + blockSize - 1) / blockSize) * ((_height + padding + blockSize - 1) / blockSize);
+}
+
+bool FftKernel::init(const float* _weights, int _size, int _width, int _height)
+{
+	const int tileSize = FindTileSize(_size, _width, _height);
+	if (_size == m_size && tileSize == m_fft.getSize() && memcmp(_weights, m_weights, sizeof(float) * _size * _size) == 0)
+	{
+		return false;
+	}
+	shutdown();
+
+	m_size = _size;
+	m_weights = new float[_size * _size];
+	memcpy(m_weights, _weights, sizeof(float) * _size * _size);
+	m_fft.init(tileSize);
+
+ // the other paths correlate (output = sum of weight[i] * src[x + i - radius]), hence the kernel is flipped
+	m_spectrum = (float*)AlignedAlloc(sizeof(float) * 2 * tileSize * tileSize);
+	memset(m_spectrum, 0, sizeof(float) * 2 * tileSize * tileSize);
+	for (int y = 0; y < _size; ++y)
+	{
+		for (int x = 0; x < _size; ++x)
+		{
+			m_spectrum[(y * tileSize + x) * 2] = _weights[(_size - 1 - y) * _size + (_size - 1 - x)];
+		}
+	}
+	float* tmp = (float*)AlignedAlloc(sizeof(float) * 2 * tileSize);
+	m_fft.forward2d(m_spectrum, tmp);
+	AlignedFree(tmp);
+
+	return true;
+}
+
+void FftKernel::shutdown()
+{
+	delete[] m_weights;
+	AlignedFree(m_spectrum);
+	m_weights  = nullptr;
+	m_spectrum = nullptr;
+	m_size     = 0;
+}
+
+void ConvolveFft(const Image& _src, Image& dst_, const FftKernel& _kernel)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	const int tileSize = _kernel.getTileSize();
+
+	Accumulator acc = { (float*)AlignedAlloc(sizeof(float) * 4 * dst_.getWidth() * dst_.getHeight()), dst_.getWidth(), dst_.getHeight() };
+	memset(acc.m_data, 0, sizeof(float) * 4 * acc.m_width * acc.m_height);
+	float* tile = (float*)AlignedAlloc(sizeof(float) * 2 * tileSize * tileSize * 2);
+	float* tmp  = (float*)AlignedAlloc(sizeof(float) * 2 * tileSize);
+	float* line = (float*)AlignedAlloc(sizeof(float) * 4 * tileSize);
+
+	ForEachBlock(_src, _kernel, -1, [&](int _bx, int _by) { ConvolveTile(_src, acc, _kernel, _bx, _by, tile, tmp, line); });
+	WriteAccumulator(acc, dst_);
+
+	AlignedFree(tile);
+	AlignedFree(tmp);
+	AlignedFree(line);
+	AlignedFree(acc.m_data);
+}
+
+void ConvolveFft(ThreadPool& _pool, const Image& _src, Image& dst_, const FftKernel& _kernel)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	const int tileSize = _kernel.getTileSize();
+
+	Accumulator acc = { (float*)AlignedAlloc(sizeof(float) * 4 * dst_.getWidth() * dst_.getHeight()), dst_.getWidth(), dst_.getHeight() };
+	memset(acc.m_data, 0, sizeof(float) * 4 * acc.m_width * acc.m_height);
+
+	for (int phase = 0; phase < 4; ++phase)
+	{
+		ThreadPool::TaskGroup group;
+		ForEachBlock(_src, _kernel, phase, [&](int _bx, int _by)
+			{
+				_pool.run(group, [&, _bx, _by]()
+					{
+						float* tile = (float*)AlignedAlloc(sizeof(float) * 2 * tileSize * tileSize * 2);
+						float* tmp  = (float*)AlignedAlloc(sizeof(float) * 2 * tileSize);
+						float* line = (float*)AlignedAlloc(sizeof(float) * 4 * tileSize);
+						ConvolveTile(_src, acc, _kernel, _bx, _by, tile, tmp, line);
+						AlignedFree(tile);
+						AlignedFree(tmp);
+						AlignedFree(line);
+					});
+			});
+		_pool.wait(group);
+	}
+	WriteAccumulator(acc, dst_);
+
+	AlignedFree(acc.m_data);
+}
+
+} // namespace conv
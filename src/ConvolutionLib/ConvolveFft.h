@@ -0,0 +1,59 @@
+#pragma once
+
+// FFT convolution for large 2d kernels. The cost per texel is ~O(log T) for a tile size T, independent of the kernel
+// size, vs. _size^2 taps for Convolve2d(). The image is split into B x B blocks (B = T - _size + 1) which are
+// transformed as T x T tiles, multiplied by the kernel spectrum and transformed back, the results are overlap-added.
+//
+// RGBA is transformed as 2 complex signals, (R + iG) and (B + iA): since the kernel is real the real and imaginary
+// parts of the result are the convolutions of each channel, hence each complex transform does the work of a real to
+// complex transform of 2 channels. Results match Convolve2d() (edges clamped) to within float rounding.
+
+#include "Fft.h"
+#include "Image.h"
+
+namespace conv {
+
+class ThreadPool;
+
+class FftKernel
+{
+public:
+	FftKernel() = default;
+	~FftKernel()                                  { shutdown(); }
+
+	FftKernel(const FftKernel&)            = delete;
+	FftKernel& operator=(const FftKernel&) = delete;
+
+	// Set a _size x _size kernel (row major, as per Convolve2d()) for a _width x _height image (the tile size depends on
+	// both). The spectrum is cached, it's only recomputed if the tile size or weights differ from the previous call, hence
+	// call every frame. Return true if the spectrum was recomputed.
+	bool         init(const float* _weights, int _size, int _width, int _height);
+	void         shutdown();
+
+	int          getSize() const                  { return m_size; }
+	int          getTileSize() const              { return m_fft.getSize(); }
+	int          getBlockSize() const             { return m_fft.getSize() - m_size + 1; }
+	const Fft&   getFft() const                   { return m_fft; }
+
+	// T x T complex values.
+	const float* getSpectrum() const              { return m_spectrum; }
+
+	// Tile size which minimizes the total cost for a _size kernel and a _width x _height image (power of 2).
+	static int   FindTileSize(int _size, int _width, int _height);
+	// Number of tiles for a _tileSize, _size kernel and _width x _height image.
+	static int   GetTileCount(int _tileSize, int _size, int _width, int _height);
+
+private:
+	int    m_size     = 0;
+	float* m_weights  = nullptr; // copy of the weights, to detect changes
+	float* m_spectrum = nullptr;
+	Fft    m_fft;
+};
+
+void ConvolveFft(const Image& _src, Image& dst_, const FftKernel& _kernel);
+
+// Multi-threaded ConvolveFft(). Each tile adds into its neighbors' blocks, hence tiles are processed in 4 phases by
+// (x, y) parity such that concurrent tiles never overlap.
+void ConvolveFft(ThreadPool& _pool, const Image& _src, Image& dst_, const FftKernel& _kernel);
+
+} // namespace conv
@@ -0,0 +1,284 @@
+#include "ConvolveFixed.h"
+
+#include "Convolve.h"
+#include "Schedule.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace conv {
+
+namespace {
+
+constexpr int kFixedPointBits  = SeparableKernelFixed::kFixedPointBits;
+constexpr int kFixedPointRound = 1 << (kFixedPointBits - 1);
+
+// Vertical pass strips, see ConvolveVertical() in Convolve.cpp.
+constexpr int kStripWidth    = 1024;
+constexpr int kMinStripWidth = 64;
+constexpr int kRingSkew      = 16; // texels, a cache line
+constexpr int kMaxRingTexels = 128 * 1024;
+
+// Convolve _count RGBA8 texels of _line into out_, as ConvolveLineFunc in Convolve.cpp. _tapCount is a multiple of 2.
+typedef void (ConvolveLineFixedFunc)(const uint8_t* _line, uint8_t* out_, int _count, const int* _tapOffsets, const int16_t* _tapWeights, int _tapCount);
+
+void ConvolveLineFixed_Scalar(const uint8_t* _line, uint8_t* out_, int _count, const int* _tapOffsets, const int16_t* _tapWeights, int _tapCount)
+{
+	for (int x = 0; x < _count; ++x)
+	{
+		int32_t r = kFixedPointRound, g = kFixedPointRound, b = kFixedPointRound, a = kFixedPointRound;
+		for (int i = 0; i < _tapCount; ++i)
+		{
+			const uint8_t* texel = _line + (x + _tapOffsets[i]) * 4;
+			const int32_t  w     = _tapWeights[i];
+			r += texel[0] * w;
+			g += texel[1] * w;
+			b += texel[2] * w;
+			a += texel[3] * w;
+		}
+		auto toUnorm8 = [](int32_t _v) { _v >>= kFixedPointBits; return (uint8_t)(_v < 0 ? 0 : (_v > 255 ? 255 : _v)); };
+		out_[x * 4 + 0] = toUnorm8(r);
+		out_[x * 4 + 1] = toUnorm8(g);
+		out_[x * 4 + 2] = toUnorm8(b);
+		out_[x * 4 + 3] = toUnorm8(a);
+	}
+}
+
+// Weights for a pair of taps (i, i + 1) as the low/high 16 bits of each 32 bit lane, for _mm_madd_epi16.
+inline int32_t LoadWeightPair(const int16_t* _tapWeights)
+{
+	int32_t ret;
+	memcpy(&ret, _tapWeights, sizeof(ret));
+	return ret;
+}
+
+CONV_TARGET_SSE4 void ConvolveLineFixed_Sse4(const uint8_t* _line, uint8_t* out_, int _count, const int* _tapOffsets, const int16_t* _tapWeights, int _tapCount)
+{
+ // 2 adjacent texels per iteration; interleaving the 16 bit channels of tap i and i + 1 gives 1 texel per register
+ // with the pairs summed by pmaddwd
+	const __m128i round = _mm_set1_epi32(kFixedPointRound);
+	int x = 0;
+	for (; x + 2 <= _count; x += 2)
+	{
+		__m128i acc0 = round, acc1 = round;
+		const uint8_t* line = _line + x * 4;
+		for (int i = 0; i < _tapCount; i += 2)
+		{
+			const __m128i t0 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(line + _tapOffsets[i] * 4)));
+			const __m128i t1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(line + _tapOffsets[i + 1] * 4)));
+			const __m128i w  = _mm_set1_epi32(LoadWeightPair(_tapWeights + i));
+			acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(t0, t1), w));
+			acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(t0, t1), w));
+		}
+		const __m128i v = _mm_packs_epi32(_mm_srai_epi32(acc0, kFixedPointBits), _mm_srai_epi32(acc1, kFixedPointBits));
+		_mm_storel_epi64((__m128i*)(out_ + x * 4), _mm_packus_epi16(v, v));
+	}
+	ConvolveLineFixed_Scalar(_line + x * 4, out_ + x * 4, _count - x, _tapOffsets, _tapWeights, _tapCount);
+}
+
+CONV_TARGET_AVX2 void ConvolveLineFixed_Avx2(const uint8_t* _line, uint8_t* out_, int _count, const int* _tapOffsets, const int16_t* _tapWeights, int _tapCount)
+{
+ // 4 adjacent texels per iteration, acc0 holds texels (0, 2) and acc1 (1, 3) as the unpacks are per 128 bit lane
+	const __m256i round = _mm256_set1_epi32(kFixedPointRound);
+	int x = 0;
+	for (; x + 4 <= _count; x += 4)
+	{
+		__m256i acc0 = round, acc1 = round;
+		const uint8_t* line = _line + x * 4;
+		for (int i = 0; i < _tapCount; i += 2)
+		{
+			const __m256i t0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(line + _tapOffsets[i] * 4)));
+			const __m256i t1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(line + _tapOffsets[i + 1] * 4)));
+			const __m256i w  = _mm256_set1_epi32(LoadWeightPair(_tapWeights + i));
+			acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(t0, t1), w));
+			acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(t0, t1), w));
+		}
+		__m256i v = _mm256_packs_epi32(_mm256_srai_epi32(acc0, kFixedPointBits), _mm256_srai_epi32(acc1, kFixedPointBits));
+		v = _mm256_packus_epi16(v, v);
+		v = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i*)(out_ + x * 4), _mm256_castsi256_si128(v));
+	}
+	ConvolveLineFixed_Sse4(_line + x * 4, out_ + x * 4, _count - x, _tapOffsets, _tapWeights, _tapCount);
+}
+
+ConvolveLineFixedFunc* GetConvolveLineFixedFunc()
+{
+	switch (GetIsa())
+	{
+		case Isa_Avx2: return ConvolveLineFixed_Avx2;
+		case Isa_Sse4: return ConvolveLineFixed_Sse4;
+		default:       return ConvolveLineFixed_Scalar;
+	};
+}
+
+} // namespace
+
+void SeparableKernelFixed::init(const SeparableKernel& _kernel)
+{
+	const int count       = _kernel.getTapCount();
+	const int paddedCount = (count + 1) & ~1;
+	if (paddedCount > m_tapCapacity)
+	{
+		shutdown();
+		m_tapCapacity = paddedCount;
+		m_tapOffsets  = new int[m_tapCapacity];
+		m_tapWeights  = new int16_t[m_tapCapacity];
+	}
+	m_tapCount       = paddedCount;
+	m_minOffset      = _kernel.getMinOffset();
+	m_maxOffset      = _kernel.getMaxOffset();
+	m_maxWeightError = 0.0f;
+	if (count == 0)
+	{
+		return;
+	}
+
+	const float* weights = _kernel.getTapWeights();
+	float sum = 0.0f;
+	for (int i = 0; i < count; ++i)
+	{
+		sum += weights[i];
+	}
+	const float scale = (sum != 0.0f ? 1.0f / sum : 1.0f) * (float)(1 << kFixedPointBits);
+
+ // round to nearest, then fix the sum by adjusting the taps whose rounding error was largest in the direction of the
+ // residual (largest remainder), such that the error per tap stays < 1 LSB of the weight
+	float* remainders = new float[count];
+	int isum = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		const float w = weights[i] * scale;
+		const int   q = (int)floorf(w + 0.5f);
+		assert(q >= INT16_MIN && q <= INT16_MAX);
+		remainders[i]   = w - (float)q;
+		m_tapWeights[i] = (int16_t)q;
+		m_tapOffsets[i] = _kernel.getTapOffsets()[i];
+		isum += q;
+	}
+	while (isum != (1 << kFixedPointBits))
+	{
+		const int step = isum < (1 << kFixedPointBits) ? 1 : -1;
+		int best = 0;
+		for (int i = 1; i < count; ++i)
+		{
+			best = remainders[i] * step > remainders[best] * step ? i : best;
+		}
+		m_tapWeights[best] = (int16_t)(m_tapWeights[best] + step);
+		remainders[best] -= (float)step;
+		isum += step;
+	}
+	for (int i = 0; i < count; ++i)
+	{
+		const float err = fabsf(remainders[i]) / (float)(1 << kFixedPointBits);
+		m_maxWeightError = err > m_maxWeightError ? err : m_maxWeightError;
+	}
+	delete[] remainders;
+
+	if (paddedCount > count)
+	{
+		m_tapOffsets[count] = 0; // always within [m_minOffset, m_maxOffset]
+		m_tapWeights[count] = 0;
+	}
+}
+
+void SeparableKernelFixed::shutdown()
+{
+	delete[] m_tapOffsets;
+	delete[] m_tapWeights;
+	m_tapOffsets  = nullptr;
+	m_tapWeights  = nullptr;
+	m_tapCount    = 0;
+	m_tapCapacity = 0;
+}
+
+void ConvolvePassFixed(const Image& _src, Image& dst_, const SeparableKernelFixed& _kernel, Direction _direction, int _rowBegin, int _rowEnd)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	assert(_src.getFormat() == Format_RGBA8 && dst_.getFormat() == Format_RGBA8);
+	_rowEnd = _rowEnd < 0 ? dst_.getHeight() : _rowEnd;
+	if (_rowEnd <= _rowBegin)
+	{
+		return;
+	}
+
+	ConvolveLineFixedFunc* convolveLine = GetConvolveLineFixedFunc();
+	const int padBefore = -_kernel.getMinOffset();
+	const int padAfter  = _kernel.getMaxOffset();
+
+	if (_direction == Direction_Horizontal)
+	{
+		const int texelCount = dst_.getWidth();
+		uint8_t* lineIn  = (uint8_t*)AlignedAlloc(4 * (padBefore + texelCount + padAfter));
+		uint8_t* lineOut = (uint8_t*)AlignedAlloc(4 * texelCount);
+		for (int line = _rowBegin; line < _rowEnd; ++line)
+		{
+			ReadLine8(_src, Direction_Horizontal, line, -padBefore, padBefore + texelCount + padAfter, lineIn);
+			convolveLine(lineIn + padBefore * 4, lineOut, texelCount, _kernel.getTapOffsets(), _kernel.getTapWeights(), _kernel.getTapCount());
+			WriteLine8(dst_, Direction_Horizontal, line, 0, texelCount, lineOut);
+		}
+		AlignedFree(lineIn);
+		AlignedFree(lineOut);
+		return;
+	}
+
+ // vertical passes convert each source row once into a mirrored ring of rows, as per ConvolveVertical() in Convolve.cpp;
+ // the rows read by an output row are contiguous hence the line function applies directly with the taps as row offsets
+	const int    width      = dst_.getWidth();
+	const int    height     = dst_.getHeight();
+	const int    ringSize   = padBefore + padAfter + 1; // source row y is ring row (y + padBefore) % ringSize
+	const int    maxWidth   = kMaxRingTexels / ringSize > kStripWidth ? kStripWidth : (kMaxRingTexels / ringSize < kMinStripWidth ? kMinStripWidth : kMaxRingTexels / ringSize);
+	const int    ringPitch  = maxWidth + kRingSkew; // in texels
+	int*     tapOffsets = new int[_kernel.getTapCount()];
+	uint8_t* ring       = (uint8_t*)AlignedAlloc((size_t)4 * ringPitch * ringSize * 2);
+	uint8_t* lineOut    = (uint8_t*)AlignedAlloc(4 * maxWidth);
+	for (int i = 0; i < _kernel.getTapCount(); ++i)
+	{
+		tapOffsets[i] = (_kernel.getTapOffsets()[i] + padBefore) * ringPitch; // relative to row y - padBefore
+	}
+	for (int x0 = 0; x0 < width; x0 += maxWidth)
+	{
+		const int stripWidth = width - x0 < maxWidth ? width - x0 : maxWidth;
+		auto readRow = [&](int _y)
+			{
+				const int srcY = _y < 0 ? 0 : (_y >= height ? height - 1 : _y);
+				uint8_t* row = ring + (size_t)4 * ((_y + padBefore) % ringSize) * ringPitch;
+				ReadLine8(_src, Direction_Horizontal, srcY, x0, stripWidth, row);
+				memcpy(row + (size_t)4 * ringSize * ringPitch, row, 4 * stripWidth);
+			};
+		for (int y = _rowBegin - padBefore; y < _rowBegin + padAfter; ++y)
+		{
+			readRow(y);
+		}
+		for (int y = _rowBegin; y < _rowEnd; ++y)
+		{
+			readRow(y + padAfter);
+			convolveLine(ring + (size_t)4 * (y % ringSize) * ringPitch, lineOut, stripWidth, tapOffsets, _kernel.getTapWeights(), _kernel.getTapCount());
+			WriteLine8(dst_, Direction_Horizontal, y, x0, stripWidth, lineOut);
+		}
+	}
+	AlignedFree(ring);
+	AlignedFree(lineOut);
+	delete[] tapOffsets;
+}
+
+void ConvolveSeparableFixed(const Image& _src, Image& dst_, Image& tmp_, const SeparableKernelFixed& _kernel)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), Format_RGBA8);
+	ConvolvePassFixed(_src, tmp_, _kernel, Direction_Horizontal);
+	ConvolvePassFixed(tmp_, dst_, _kernel, Direction_Vertical);
+}
+
+void ConvolveSeparableFixed(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const SeparableKernelFixed& _kernel, int _bandHeight)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), Format_RGBA8);
+	RunSeparablePasses(_pool, dst_.getHeight(), _kernel.getMinOffset(), _kernel.getMaxOffset(), _bandHeight,
+		[&](int _rowBegin, int _rowEnd) { ConvolvePassFixed(_src, tmp_, _kernel, Direction_Horizontal, _rowBegin, _rowEnd); },
+		[&](int _rowBegin, int _rowEnd) { ConvolvePassFixed(tmp_, dst_, _kernel, Direction_Vertical, _rowBegin, _rowEnd); }
+		);
+}
+
+} // namespace conv
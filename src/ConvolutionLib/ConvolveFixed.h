@@ -0,0 +1,63 @@
+#pragma once
+
+// Fixed point convolution of RGBA8 images. Weights are quantized to signed 2.14 fixed point such that they sum to
+// exactly 1 << kFixedPointBits (hence a constant image is unchanged), texels stay as 8 bit integers and pairs of taps are
+// accumulated in 32 bit lanes via pmaddwd (_mm_madd_epi16). Each pass rounds to 8 bits, as the float path does when the
+// intermediate image is RGBA8 (see ConvolveSeparable()), so the result differs from the float path only by the weight
+// quantization (typically <= 1 LSB).
+
+#include "Image.h"
+#include "Line.h"
+
+namespace conv {
+
+class SeparableKernel;
+class ThreadPool;
+
+class SeparableKernelFixed
+{
+public:
+	static constexpr int kFixedPointBits = 14;
+
+	SeparableKernelFixed() = default;
+	~SeparableKernelFixed()                      { shutdown(); }
+
+	SeparableKernelFixed(const SeparableKernelFixed&)            = delete;
+	SeparableKernelFixed& operator=(const SeparableKernelFixed&) = delete;
+
+	// Quantize _kernel (bilinear taps are already split into texel fetches). The rounding residual is distributed to the
+	// taps with the largest rounding error (largest remainder) such that the weights sum to 1 << kFixedPointBits; the
+	// float weights are normalized first if their sum isn't 1. Weights must be in [-2, 2).
+	void           init(const SeparableKernel& _kernel);
+	void           shutdown();
+
+	// The tap count is padded to a multiple of 2 with a zero weight.
+	int            getTapCount() const           { return m_tapCount;   }
+	const int*     getTapOffsets() const         { return m_tapOffsets; }
+	const int16_t* getTapWeights() const         { return m_tapWeights; }
+	int            getMinOffset() const          { return m_minOffset;  }
+	int            getMaxOffset() const          { return m_maxOffset;  }
+
+	// Max absolute difference between the quantized and (normalized) float weights.
+	float          getMaxWeightError() const     { return m_maxWeightError; }
+
+private:
+	int      m_tapCount       = 0;
+	int      m_tapCapacity    = 0;
+	int*     m_tapOffsets     = nullptr;
+	int16_t* m_tapWeights     = nullptr;
+	int      m_minOffset      = 0;
+	int      m_maxOffset      = 0;
+	float    m_maxWeightError = 0.0f;
+};
+
+// As ConvolvePass(), _src and dst_ must be Format_RGBA8.
+void ConvolvePassFixed(const Image& _src, Image& dst_, const SeparableKernelFixed& _kernel, Direction _direction, int _rowBegin = 0, int _rowEnd = -1);
+
+// Horizontal then vertical pass, tmp_ is (re)initialized as RGBA8.
+void ConvolveSeparableFixed(const Image& _src, Image& dst_, Image& tmp_, const SeparableKernelFixed& _kernel);
+
+// Multi-threaded ConvolveSeparableFixed(), see ConvolveSeparable(ThreadPool&, ...).
+void ConvolveSeparableFixed(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const SeparableKernelFixed& _kernel, int _bandHeight = 0);
+
+} // namespace conv
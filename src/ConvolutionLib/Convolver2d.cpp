@@ -0,0 +1,205 @@
+#include "Convolver2d.h"
+
+#include "Kernel.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace conv {
+
+namespace {
+
+// Call _fn repeatedly for at least _minMs (and at least once), return the average time per call in ns.
+template <typename tFunc>
+double MeasureNs(tFunc&& _fn, double _minMs = 100.0)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	_fn(); // warm up
+
+	int count = 0;
+	const Clock::time_point start = Clock::now();
+	double elapsed = 0.0;
+	do
+	{
+		_fn();
+		++count;
+		elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	}
+	while (elapsed < _minMs * 1e6);
+	return elapsed / (double)count;
+}
+
+int Log2(int _x)
+{
+	int ret = 0;
+	while ((1 << ret) < _x)
+	{
+		++ret;
+	}
+	return ret;
+}
+
+} // namespace
+
+const char* GetConvolve2dMethodName(Convolve2dMethod _method)
+{
+	switch (_method)
+	{
+		case Convolve2dMethod_Direct:    return "Direct";
+		case Convolve2dMethod_Separable: return "Separable";
+		case Convolve2dMethod_Fft:       return "FFT";
+		case Convolve2dMethod_Auto:      return "Auto";
+		default:                         return "Unknown";
+	};
+}
+
+Convolve2dCostModel Convolve2dCostModel::Measure()
+{
+	Convolve2dCostModel ret;
+	const int kSize = 256;
+	Image src(kSize, kSize, Format_RGBA32F), dst(kSize, kSize, Format_RGBA32F), tmp;
+	for (int y = 0; y < kSize; ++y)
+	{
+		float* row = (float*)src.getRow(y);
+		for (int x = 0; x < kSize * 4; ++x)
+		{
+			row[x] = (float)((x * 7 + y * 13) % 255) / 255.0f;
+		}
+	}
+	const double texelCount = (double)kSize * (double)kSize;
+
+ // direct, 9x9
+	float weights2d[9 * 9];
+	KernelBox2d(9, weights2d);
+	ret.m_direct = MeasureNs([&]{ Convolve2d(src, dst, weights2d, 9); }) / (texelCount * 81.0);
+
+ // separable, fit the cost of 2 passes at 2 widths to taps * m_separableTap + m_separablePass
+	float weights1d[33], offsets1d[33];
+	double costs[2];
+	const int widths[2] = { 3, 33 };
+	for (int i = 0; i < 2; ++i)
+	{
+		KernelBox1d(widths[i], weights1d);
+		for (int j = 0; j < widths[i]; ++j)
+		{
+			offsets1d[j] = (float)(j - widths[i] / 2);
+		}
+		SeparableKernel kernel;
+		kernel.init(weights1d, offsets1d, widths[i]);
+		costs[i] = MeasureNs([&]{ ConvolveSeparable(src, dst, tmp, kernel); }) / (texelCount * 2.0);
+	}
+	ret.m_separableTap  = (costs[1] - costs[0]) / (double)(widths[1] - widths[0]);
+	ret.m_separablePass = costs[0] - ret.m_separableTap * (double)widths[0];
+	ret.m_separablePass = ret.m_separablePass < 0.0 ? 0.0 : ret.m_separablePass;
+
+ // FFT, 15x15 (the kernel size only affects the tile size/count)
+	float weightsFft[15 * 15];
+	KernelBox2d(15, weightsFft);
+	FftKernel fftKernel;
+	fftKernel.init(weightsFft, 15, kSize, kSize);
+	const int tileSize = fftKernel.getTileSize();
+	const double fftUnits = (double)FftKernel::GetTileCount(tileSize, 15, kSize, kSize) * (double)tileSize * (double)tileSize * (double)Log2(tileSize);
+	ret.m_fft = MeasureNs([&]{ ConvolveFft(src, dst, fftKernel); }) / fftUnits;
+
+	return ret;
+}
+
+Convolve2dCostModel Convolve2dCostModel::GetDefault()
+{
+	Convolve2dCostModel ret;
+	ret.m_direct        = 1.0;
+	ret.m_separableTap  = 0.8;
+	ret.m_separablePass = 6.4;
+	ret.m_fft           = 25.0;
+	return ret;
+}
+
+double Convolve2dCostModel::getCostDirect(int _size, int _width, int _height) const
+{
+	return (double)_width * (double)_height * (double)_size * (double)_size * m_direct;
+}
+
+double Convolve2dCostModel::getCostSeparable(int _size, int _width, int _height, int _rank) const
+{
+	return (double)_width * (double)_height * 2.0 * (double)_rank * ((double)_size * m_separableTap + m_separablePass);
+}
+
+double Convolve2dCostModel::getCostFft(int _size, int _width, int _height) const
+{
+	const int tileSize = FftKernel::FindTileSize(_size, _width, _height);
+	return (double)FftKernel::GetTileCount(tileSize, _size, _width, _height) * (double)tileSize * (double)tileSize * (double)Log2(tileSize) * m_fft;
+}
+
+void Convolver2d::init(const float* _weights, int _size, int _width, int _height, Convolve2dMethod _method)
+{
+	assert(_size > 0 && (_size & 1) == 1);
+	if (_size * _size > m_capacity)
+	{
+		delete[] m_weights;
+		m_capacity = _size * _size;
+		m_weights  = new float[m_capacity];
+	}
+	m_size = _size;
+	memcpy(m_weights, _weights, sizeof(float) * _size * _size);
+
+	m_separable = m_lowRankKernel.init(_weights, _size, m_tolerance, _size / 2 > 1 ? _size / 2 : 1);
+
+	m_costs[Convolve2dMethod_Direct]    = m_costModel.getCostDirect(_size, _width, _height);
+	m_costs[Convolve2dMethod_Separable] = m_separable ? m_costModel.getCostSeparable(_size, _width, _height, m_lowRankKernel.getRank()) : -1.0;
+	m_costs[Convolve2dMethod_Fft]       = m_costModel.getCostFft(_size, _width, _height);
+
+	if (_method == Convolve2dMethod_Auto || m_costs[_method] < 0.0)
+	{
+		m_method = Convolve2dMethod_Direct;
+		for (int method = 0; method < Convolve2dMethod_Count; ++method)
+		{
+			if (m_costs[method] >= 0.0 && m_costs[method] < m_costs[m_method])
+			{
+				m_method = method;
+			}
+		}
+	}
+	else
+	{
+		m_method = _method;
+	}
+
+	if (m_method == Convolve2dMethod_Fft)
+	{
+		m_fftKernel.init(_weights, _size, _width, _height);
+	}
+}
+
+void Convolver2d::shutdown()
+{
+	delete[] m_weights;
+	m_weights  = nullptr;
+	m_capacity = 0;
+	m_size     = 0;
+	m_lowRankKernel.shutdown();
+	m_fftKernel.shutdown();
+}
+
+void Convolver2d::convolve(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_) const
+{
+	switch (m_method)
+	{
+		case Convolve2dMethod_Direct:
+			Convolve2d(_pool, _src, dst_, m_weights, m_size);
+			break;
+		case Convolve2dMethod_Separable:
+			ConvolveLowRank(_pool, _src, dst_, tmp_, m_lowRankKernel);
+			break;
+		case Convolve2dMethod_Fft:
+			ConvolveFft(_pool, _src, dst_, m_fftKernel);
+			break;
+		default:
+			assert(false);
+			break;
+	};
+}
+
+} // namespace conv
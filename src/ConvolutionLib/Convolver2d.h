@@ -0,0 +1,92 @@
+#pragma once
+
+// 2d convolution of any size with automatic selection of the method: direct taps (Convolve2d(), _size^2 taps per texel),
+// separable passes (ConvolveLowRank(), 2 * rank * _size taps per texel, rank 1 for exactly separable kernels) or FFT
+// (ConvolveFft(), independent of the kernel size). The method with the lowest estimated cost is chosen; the estimates come from a
+// CostModel which is measured on the current machine.
+
+#include "Convolve.h"
+#include "ConvolveFft.h"
+#include "LowRank.h"
+
+namespace conv {
+
+class ThreadPool;
+
+enum Convolve2dMethod_
+{
+	Convolve2dMethod_Direct,
+	Convolve2dMethod_Separable,
+	Convolve2dMethod_Fft,
+
+	Convolve2dMethod_Count,
+	Convolve2dMethod_Auto = Convolve2dMethod_Count
+};
+typedef int Convolve2dMethod;
+
+const char* GetConvolve2dMethodName(Convolve2dMethod _method);
+
+// Cost per unit of work of each method in ns (single threaded). All methods scale similarly with the thread count
+// hence the relative costs also hold for the multi-threaded versions.
+struct Convolve2dCostModel
+{
+	double m_direct;        // per texel per tap
+	double m_separableTap;  // per texel per tap per pass
+	double m_separablePass; // per texel per pass (line read/write), per term
+	double m_fft;           // per tile texel per log2(tile size) per tile
+
+	// Time each method on a small RGBA32F image, takes ~0.5s.
+	static Convolve2dCostModel Measure();
+	// Typical values for an AVX2 machine (as reported by ConvolutionBench 'fft'), use until Measure() has been called.
+	static Convolve2dCostModel GetDefault();
+
+	double getCostDirect(int _size, int _width, int _height) const;
+	double getCostSeparable(int _size, int _width, int _height, int _rank = 1) const;
+	double getCostFft(int _size, int _width, int _height) const;
+};
+
+class Convolver2d
+{
+public:
+	Convolver2d() = default;
+	~Convolver2d()                                   { shutdown(); }
+
+	Convolver2d(const Convolver2d&)            = delete;
+	Convolver2d& operator=(const Convolver2d&) = delete;
+
+	void         setCostModel(const Convolve2dCostModel& _costModel) { m_costModel = _costModel; }
+	const Convolve2dCostModel& getCostModel() const { return m_costModel; }
+
+	// Max error of the separable decomposition relative to the largest weight, see LowRankKernel::init().
+	void         setTolerance(float _tolerance)      { m_tolerance = _tolerance; }
+
+	// Set a _size x _size kernel (row major, as per Convolve2d()) for a _width x _height image and choose the method
+	// (or use _method if not Convolve2dMethod_Auto). The separable method is only available if the kernel is within the
+	// tolerance at a rank < _size / 2, beyond which it needs more taps than the direct method. The FFT spectrum is
+	// cached, call every frame.
+	void         init(const float* _weights, int _size, int _width, int _height, Convolve2dMethod _method = Convolve2dMethod_Auto);
+	void         shutdown();
+
+	// tmp_ is the intermediate for the separable method, see ConvolveLowRank().
+	void         convolve(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_) const;
+
+	Convolve2dMethod getMethod() const               { return m_method; }
+	bool         isSeparable() const                 { return m_separable; }
+	const LowRankKernel& getLowRankKernel() const    { return m_lowRankKernel; }
+	// Estimated cost (ns, single threaded), < 0 if the method isn't available (i.e. separable for a non-separable kernel).
+	double       getCost(Convolve2dMethod _method) const { return m_costs[_method]; }
+
+private:
+	Convolve2dCostModel m_costModel = Convolve2dCostModel::GetDefault();
+	Convolve2dMethod    m_method    = Convolve2dMethod_Direct;
+	float               m_tolerance = 1e-3f;
+	double              m_costs[Convolve2dMethod_Count] = {};
+	int                 m_size      = 0;
+	int                 m_capacity  = 0;       // of m_weights, only reallocated if the size grows
+	float*              m_weights   = nullptr; // copy for the direct method
+	bool               m_separable = false;
+	LowRankKernel       m_lowRankKernel;
+	FftKernel           m_fftKernel;
+};
+
+} // namespace conv
@@ -0,0 +1,44 @@
+#include "DirtyTracker.h"
+
+#include "Hash.h"
+
+namespace conv {
+
+void DirtyTracker::addData(const void* _data, size_t _size)
+{
+	m_hash = HashFnv1a64(_data, _size, m_hash);
+}
+
+bool DirtyTracker::update(bool _force)
+{
+	const bool ret = _force || m_invalid || m_hash != m_prevHash;
+	m_prevHash = m_hash;
+	m_hash     = kHashSeed;
+	m_invalid  = false;
+
+	if (ret)
+	{
+		++m_recomputeCount;
+		++m_windowRecomputeCount;
+	}
+	else
+	{
+		++m_reuseCount;
+		++m_windowReuseCount;
+	}
+
+	const Clock::time_point now = Clock::now();
+	const double seconds = std::chrono::duration<double>(now - m_windowStart).count();
+	if (seconds >= 1.0)
+	{
+		m_recomputeRate        = (float)(m_windowRecomputeCount / seconds);
+		m_reuseRate            = (float)(m_windowReuseCount / seconds);
+		m_windowRecomputeCount = 0;
+		m_windowReuseCount     = 0;
+		m_windowStart          = now;
+	}
+
+	return ret;
+}
+
+} // namespace conv
@@ -0,0 +1,60 @@
+#pragma once
+
+// Skip recomputing a result whose inputs haven't changed. Each frame the caller add()s every input of the result (values,
+// version counters, resource handles), then update() compares a hash of the inputs with the previous frame's: if they're
+// equal the previous result is still valid and can be reused.
+//
+// Inputs are hashed as raw bytes, hence add() is restricted to trivially copyable types; add structs member by member
+// (padding bytes are undefined) and prefer version counters to large data.
+
+#include "Hash.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace conv {
+
+class DirtyTracker
+{
+public:
+	template <typename tType>
+	void  add(const tType& _value)
+	{
+		static_assert(std::is_trivially_copyable<tType>::value, "DirtyTracker::add(): tType must be trivially copyable");
+		addData(&_value, sizeof(tType));
+	}
+	void  addData(const void* _data, size_t _size);
+
+	// Force the next update() to return true (e.g. after an input which can't be add()ed changed).
+	void  invalidate()                               { m_invalid = true; }
+
+	// Return true if the inputs added since the last call differ from the previous inputs, or _force, or invalidate() was
+	// called, or on the first call. Clears the inputs for the next frame.
+	bool  update(bool _force = false);
+
+	int   getRecomputeCount() const                  { return m_recomputeCount; }
+	int   getReuseCount() const                      { return m_reuseCount; }
+	// Per second, over the last complete 1s window.
+	float getRecomputeRate() const                   { return m_recomputeRate; }
+	float getReuseRate() const                       { return m_reuseRate; }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	static const uint64_t kHashSeed = kFnv1a64Seed;
+
+	uint64_t          m_hash           = kHashSeed;
+	uint64_t          m_prevHash       = 0;
+	bool              m_invalid        = true;
+	int               m_recomputeCount = 0;
+	int               m_reuseCount     = 0;
+	int               m_windowRecomputeCount = 0;
+	int               m_windowReuseCount     = 0;
+	Clock::time_point m_windowStart    = Clock::now();
+	float             m_recomputeRate  = 0.0f;
+	float             m_reuseRate      = 0.0f;
+};
+
+} // namespace conv
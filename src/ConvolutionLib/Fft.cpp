@@ -0,0 +1,150 @@
+#include "Fft.h"
+
+#include "Image.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace conv {
+
+void Fft::init(int _size)
+{
+	assert(_size > 0 && (_size & (_size - 1)) == 0);
+	if (_size == m_size)
+	{
+		return;
+	}
+	shutdown();
+
+	m_size = _size;
+	m_log2Size = 0;
+	while ((1 << m_log2Size) < _size)
+	{
+		++m_log2Size;
+	}
+
+	m_twiddles = (float*)AlignedAlloc(sizeof(float) * 2 * (_size / 2 > 0 ? _size / 2 : 1));
+	for (int k = 0; k < _size / 2; ++k)
+	{
+		const double theta = -2.0 * 3.14159265358979323846 * (double)k / (double)_size;
+		m_twiddles[k * 2 + 0] = (float)cos(theta);
+		m_twiddles[k * 2 + 1] = (float)sin(theta);
+	}
+
+	m_bitReverse = new int[_size];
+	for (int i = 0; i < _size; ++i)
+	{
+		int r = 0;
+		for (int b = 0; b < m_log2Size; ++b)
+		{
+			r |= ((i >> b) & 1) << (m_log2Size - 1 - b);
+		}
+		m_bitReverse[i] = r;
+	}
+}
+
+void Fft::shutdown()
+{
+	AlignedFree(m_twiddles);
+	delete[] m_bitReverse;
+	m_twiddles   = nullptr;
+	m_bitReverse = nullptr;
+	m_size       = 0;
+	m_log2Size   = 0;
+}
+
+void Fft::forward(float* data_, int _stride) const
+{
+	transform(data_, _stride, false);
+}
+
+void Fft::inverse(float* data_, int _stride) const
+{
+	transform(data_, _stride, true);
+}
+
+void Fft::forward2d(float* data_, float* tmp_) const
+{
+	transform2d(data_, tmp_, false);
+}
+
+void Fft::inverse2d(float* data_, float* tmp_) const
+{
+	transform2d(data_, tmp_, true);
+}
+
+void Fft::transform(float* data_, int _stride, bool _inverse) const
+{
+	const int n = m_size;
+	auto re = [=](int _i) -> float& { return data_[_i * _stride * 2 + 0]; };
+	auto im = [=](int _i) -> float& { return data_[_i * _stride * 2 + 1]; };
+
+	for (int i = 0; i < n; ++i)
+	{
+		const int j = m_bitReverse[i];
+		if (j > i)
+		{
+			std::swap(re(i), re(j));
+			std::swap(im(i), im(j));
+		}
+	}
+
+	const float sign = _inverse ? -1.0f : 1.0f; // conjugate twiddles for the inverse
+	for (int len = 2, twiddleStep = n / 2; len <= n; len <<= 1, twiddleStep >>= 1)
+	{
+		const int half = len / 2;
+		for (int i = 0; i < n; i += len)
+		{
+			for (int j = 0; j < half; ++j)
+			{
+				const float wr = m_twiddles[j * twiddleStep * 2 + 0];
+				const float wi = m_twiddles[j * twiddleStep * 2 + 1] * sign;
+				const int a = i + j;
+				const int b = i + j + half;
+				const float vr = re(b) * wr - im(b) * wi;
+				const float vi = re(b) * wi + im(b) * wr;
+				re(b) = re(a) - vr;
+				im(b) = im(a) - vi;
+				re(a) += vr;
+				im(a) += vi;
+			}
+		}
+	}
+
+	if (_inverse)
+	{
+		const float scale = 1.0f / (float)n;
+		for (int i = 0; i < n; ++i)
+		{
+			re(i) *= scale;
+			im(i) *= scale;
+		}
+	}
+}
+
+void Fft::transform2d(float* data_, float* tmp_, bool _inverse) const
+{
+	const int n = m_size;
+	for (int y = 0; y < n; ++y)
+	{
+		transform(data_ + y * n * 2, 1, _inverse);
+	}
+	for (int x = 0; x < n; ++x)
+	{
+		for (int y = 0; y < n; ++y)
+		{
+			tmp_[y * 2 + 0] = data_[(y * n + x) * 2 + 0];
+			tmp_[y * 2 + 1] = data_[(y * n + x) * 2 + 1];
+		}
+		transform(tmp_, 1, _inverse);
+		for (int y = 0; y < n; ++y)
+		{
+			data_[(y * n + x) * 2 + 0] = tmp_[y * 2 + 0];
+			data_[(y * n + x) * 2 + 1] = tmp_[y * 2 + 1];
+		}
+	}
+}
+
+} // namespace conv
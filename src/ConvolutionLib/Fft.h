@@ -0,0 +1,41 @@
+#pragma once
+
+// Complex FFT for the FFT convolution path: radix-2, iterative, in place. Data is interleaved (re, im) float pairs.
+
+namespace conv {
+
+class Fft
+{
+public:
+	Fft() = default;
+	~Fft()                                     { shutdown(); }
+
+	Fft(const Fft&)            = delete;
+	Fft& operator=(const Fft&) = delete;
+
+	// Prepare for transforms of _size complex values (power of 2). Only reallocates if the size changes.
+	void  init(int _size);
+	void  shutdown();
+
+	int   getSize() const                      { return m_size; }
+
+	// Transform getSize() complex values, _stride complex values apart. inverse() includes the 1/N scale.
+	void  forward(float* data_, int _stride = 1) const;
+	void  inverse(float* data_, int _stride = 1) const;
+
+	// 2d transform of getSize() x getSize() complex values (row major). tmp_ is getSize() complex values of scratch for
+	// the columns, which are copied out to avoid a strided transform.
+	void  forward2d(float* data_, float* tmp_) const;
+	void  inverse2d(float* data_, float* tmp_) const;
+
+private:
+	int    m_size        = 0;
+	int    m_log2Size    = 0;
+	float* m_twiddles    = nullptr; // exp(-2 pi i k / N), k = [0, N/2)
+	int*   m_bitReverse  = nullptr;
+
+	void  transform(float* data_, int _stride, bool _inverse) const;
+	void  transform2d(float* data_, float* tmp_, bool _inverse) const;
+};
+
+} // namespace conv
@@ -0,0 +1,147 @@
+#include "Half.h"
+
+#include "Simd.h"
+
+#include <cstring>
+#include <immintrin.h>
+
+namespace conv {
+
+namespace {
+
+inline uint32_t AsUint(float _f)
+{
+	uint32_t ret;
+	memcpy(&ret, &_f, sizeof(ret));
+	return ret;
+}
+
+inline float AsFloat(uint32_t _u)
+{
+	float ret;
+	memcpy(&ret, &_u, sizeof(ret));
+	return ret;
+}
+
+void ConvertFloatToHalf_Scalar(const float* _src, uint16_t* dst_, size_t _count)
+{
+	for (size_t i = 0; i < _count; ++i)
+	{
+		dst_[i] = FloatToHalf(_src[i]);
+	}
+}
+
+void ConvertHalfToFloat_Scalar(const uint16_t* _src, float* dst_, size_t _count)
+{
+	for (size_t i = 0; i < _count; ++i)
+	{
+		dst_[i] = HalfToFloat(_src[i]);
+	}
+}
+
+CONV_TARGET_AVX2 void ConvertFloatToHalf_F16c(const float* _src, uint16_t* dst_, size_t _count)
+{
+	size_t i = 0;
+	for (; i + 8 <= _count; i += 8)
+	{
+		_mm_storeu_si128((__m128i*)(dst_ + i), _mm256_cvtps_ph(_mm256_loadu_ps(_src + i), _MM_FROUND_TO_NEAREST_INT));
+	}
+	for (; i + 4 <= _count; i += 4)
+	{
+		_mm_storel_epi64((__m128i*)(dst_ + i), _mm_cvtps_ph(_mm_loadu_ps(_src + i), _MM_FROUND_TO_NEAREST_INT));
+	}
+	ConvertFloatToHalf_Scalar(_src + i, dst_ + i, _count - i);
+}
+
+CONV_TARGET_AVX2 void ConvertHalfToFloat_F16c(const uint16_t* _src, float* dst_, size_t _count)
+{
+	size_t i = 0;
+	for (; i + 8 <= _count; i += 8)
+	{
+		_mm256_storeu_ps(dst_ + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(_src + i))));
+	}
+	for (; i + 4 <= _count; i += 4)
+	{
+		_mm_storeu_ps(dst_ + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(_src + i))));
+	}
+	ConvertHalfToFloat_Scalar(_src + i, dst_ + i, _count - i);
+}
+
+} // namespace
+
+uint16_t FloatToHalf(float _f)
+{
+ // Giesen, "float->half variants" (float_to_half_fast3_rtne)
+	const uint32_t kInf         = 255u << 23;
+	const uint32_t kHalfMax     = (127u + 16u) << 23; // 65536, >= 65520 rounds to inf
+	const uint32_t kDenormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+	uint32_t f = AsUint(_f);
+	const uint32_t sign = f & 0x80000000u;
+	f ^= sign;
+
+	uint32_t ret;
+	if (f >= kHalfMax)
+	{
+		ret = f > kInf ? 0x7e00u : 0x7c00u; // NaN -> quiet NaN, else inf
+	}
+	else if (f < (113u << 23))
+	{
+	 // denormal or zero, the float addition does the rounding
+		ret = AsUint(AsFloat(f) + AsFloat(kDenormMagic)) - kDenormMagic;
+	}
+	else
+	{
+		const uint32_t mantissaOdd = (f >> 13) & 1u;
+		f += ((uint32_t)(15 - 127) << 23) + 0xfffu;
+		f += mantissaOdd;
+		ret = f >> 13;
+	}
+	return (uint16_t)(ret | (sign >> 16));
+}
+
+float HalfToFloat(uint16_t _h)
+{
+	const uint32_t kShiftedExp = 0x7c00u << 13;
+
+	uint32_t ret = ((uint32_t)_h & 0x7fffu) << 13;
+	const uint32_t exp = ret & kShiftedExp;
+	ret += (uint32_t)(127 - 15) << 23;
+	if (exp == kShiftedExp)
+	{
+		ret += (uint32_t)(128 - 16) << 23; // inf/NaN
+	}
+	else if (exp == 0)
+	{
+	 // denormal or zero, renormalize via a float subtraction
+		ret += 1u << 23;
+		ret = AsUint(AsFloat(ret) - AsFloat(113u << 23));
+	}
+	return AsFloat(ret | (((uint32_t)_h & 0x8000u) << 16));
+}
+
+void ConvertFloatToHalf(const float* _src, uint16_t* dst_, size_t _count)
+{
+	if (GetIsa() == Isa_Avx2)
+	{
+		ConvertFloatToHalf_F16c(_src, dst_, _count);
+	}
+	else
+	{
+		ConvertFloatToHalf_Scalar(_src, dst_, _count);
+	}
+}
+
+void ConvertHalfToFloat(const uint16_t* _src, float* dst_, size_t _count)
+{
+	if (GetIsa() == Isa_Avx2)
+	{
+		ConvertHalfToFloat_F16c(_src, dst_, _count);
+	}
+	else
+	{
+		ConvertHalfToFloat_Scalar(_src, dst_, _count);
+	}
+}
+
+} // namespace conv
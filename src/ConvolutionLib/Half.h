@@ -0,0 +1,18 @@
+#pragma once
+
+// IEEE 754 binary16 conversion for Format_RGBA16F (i.e. GL_RGBA16F). Float to half rounds to nearest even, values beyond
+// the half range become +-inf, as per F16C (vcvtps2ph). The bulk conversions use F16C at Isa_Avx2, see GetIsa().
+
+#include <cstddef>
+#include <cstdint>
+
+namespace conv {
+
+uint16_t FloatToHalf(float _f);
+float    HalfToFloat(uint16_t _h);
+
+// Convert _count values.
+void     ConvertFloatToHalf(const float* _src, uint16_t* dst_, size_t _count);
+void     ConvertHalfToFloat(const uint16_t* _src, float* dst_, size_t _count);
+
+} // namespace conv
@@ -0,0 +1,23 @@
+#pragma once
+
+// Non-cryptographic hashing for change detection and cache keys (see DirtyTracker, ShaderPermutationCache).
+
+#include <cstddef>
+#include <cstdint>
+
+namespace conv {
+
+constexpr uint64_t kFnv1a64Seed = 0xcbf29ce484222325ull;
+
+// 64 bit FNV-1a of _size bytes at _data, continued from _hash.
+inline uint64_t HashFnv1a64(const void* _data, size_t _size, uint64_t _hash = kFnv1a64Seed)
+{
+	const unsigned char* data = (const unsigned char*)_data;
+	for (size_t i = 0; i < _size; ++i)
+	{
+		_hash = (_hash ^ data[i]) * 0x100000001b3ull;
+	}
+	return _hash;
+}
+
+} // namespace conv
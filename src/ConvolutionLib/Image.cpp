@@ -0,0 +1,170 @@
+#include "Image.h"
+
+#include "Half.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+#ifdef _MSC_VER
+	#include <malloc.h>
+#endif
+
+namespace conv {
+
+size_t GetTexelSize(Format _format)
+{
+	switch (_format)
+	{
+		case Format_RGBA8:   return 4;
+		case Format_RGBA16F: return 8;
+		case Format_RGBA32F: return 16;
+		default:             assert(false); return 0;
+	};
+}
+
+const char* GetFormatName(Format _format)
+{
+	switch (_format)
+	{
+		case Format_RGBA8:   return "RGBA8";
+		case Format_RGBA16F: return "RGBA16F";
+		case Format_RGBA32F: return "RGBA32F";
+		default:             return "?";
+	};
+}
+
+void* AlignedAlloc(size_t _size, size_t _align)
+{
+	#ifdef _MSC_VER
+		return _aligned_malloc(_size, _align);
+	#else
+		void* ret = nullptr;
+		if (posix_memalign(&ret, _align, _size) != 0)
+		{
+			return nullptr;
+		}
+		return ret;
+	#endif
+}
+
+void AlignedFree(void* _ptr)
+{
+	#ifdef _MSC_VER
+		_aligned_free(_ptr);
+	#else
+		free(_ptr);
+	#endif
+}
+
+void Image::init(int _width, int _height, Format _format)
+{
+	assert(_width > 0 && _height > 0);
+	if (m_ownsData && _width == m_width && _height == m_height && _format == m_format)
+	{
+		return;
+	}
+	shutdown();
+
+	m_width    = _width;
+	m_height   = _height;
+	m_format   = _format;
+	m_stride   = (size_t)_width * GetTexelSize(_format);
+	m_data     = AlignedAlloc(getSize());
+	m_ownsData = true;
+	assert(m_data);
+}
+
+void Image::initView(int _width, int _height, Format _format, void* _data, size_t _stride)
+{
+	assert(_data && _stride >= (size_t)_width * GetTexelSize(_format));
+	shutdown();
+
+	m_width    = _width;
+	m_height   = _height;
+	m_format   = _format;
+	m_stride   = _stride;
+	m_data     = _data;
+	m_ownsData = false;
+}
+
+void Image::shutdown()
+{
+	if (m_ownsData)
+	{
+		AlignedFree(m_data);
+	}
+	m_width    = m_height = 0;
+	m_stride   = 0;
+	m_data     = nullptr;
+	m_ownsData = false;
+}
+
+void Image::readTexel(int _x, int _y, float* rgba_) const
+{
+	switch (m_format)
+	{
+		case Format_RGBA8:
+		{
+			const uint8_t* texel = (const uint8_t*)getRow(_y) + _x * 4;
+			for (int i = 0; i < 4; ++i)
+			{
+				rgba_[i] = (float)texel[i] / 255.0f;
+			}
+			break;
+		}
+		case Format_RGBA16F:
+		{
+			ConvertHalfToFloat((const uint16_t*)getRow(_y) + _x * 4, rgba_, 4);
+			break;
+		}
+		case Format_RGBA32F:
+		{
+			const float* texel = (const float*)getRow(_y) + _x * 4;
+			for (int i = 0; i < 4; ++i)
+			{
+				rgba_[i] = texel[i];
+			}
+			break;
+		}
+		default:
+			assert(false);
+			break;
+	};
+}
+
+void Image::writeTexel(int _x, int _y, const float* _rgba)
+{
+	switch (m_format)
+	{
+		case Format_RGBA8:
+		{
+			uint8_t* texel = (uint8_t*)getRow(_y) + _x * 4;
+			for (int i = 0; i < 4; ++i)
+			{
+				float v = _rgba[i] < 0.0f ? 0.0f : (_rgba[i] > 1.0f ? 1.0f : _rgba[i]);
+				texel[i] = (uint8_t)lrintf(v * 255.0f);
+			}
+			break;
+		}
+		case Format_RGBA16F:
+		{
+			ConvertFloatToHalf(_rgba, (uint16_t*)getRow(_y) + _x * 4, 4);
+			break;
+		}
+		case Format_RGBA32F:
+		{
+			float* texel = (float*)getRow(_y) + _x * 4;
+			for (int i = 0; i < 4; ++i)
+			{
+				texel[i] = _rgba[i];
+			}
+			break;
+		}
+		default:
+			assert(false);
+			break;
+	};
+}
+
+} // namespace conv
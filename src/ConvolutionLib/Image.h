@@ -0,0 +1,70 @@
+#pragma once
+
+// CPU image, the source/destination of the CPU convolution engine. Rows are tightly packed (stride = width * texel
+// size) so that data can be copied directly to/from a GL texture with the default pack/unpack alignment.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace conv {
+
+enum Format_
+{
+	Format_RGBA8,   // normalized to [0,1] on load, rounded and clamped on store (i.e. GL_RGBA8)
+	Format_RGBA16F, // converted to/from float on load/store, see Half.h (i.e. GL_RGBA16F)
+	Format_RGBA32F,
+
+	Format_Count
+};
+typedef int Format;
+
+// Size in bytes of a texel in _format.
+size_t GetTexelSize(Format _format);
+
+const char* GetFormatName(Format _format);
+
+// Aligned heap allocations, use for any buffers which are accessed via SIMD.
+void* AlignedAlloc(size_t _size, size_t _align = 64);
+void  AlignedFree(void* _ptr);
+
+class Image
+{
+public:
+	Image() = default;
+	Image(int _width, int _height, Format _format)                        { init(_width, _height, _format); }
+	~Image()                                                              { shutdown(); }
+
+	Image(const Image&)            = delete;
+	Image& operator=(const Image&) = delete;
+
+	// Allocate storage; the contents are uninitialized. Reinitializing with the same size/format doesn't reallocate.
+	void        init(int _width, int _height, Format _format);
+	// Wrap externally owned memory, _stride is the size of a row in bytes.
+	void        initView(int _width, int _height, Format _format, void* _data, size_t _stride);
+	void        shutdown();
+
+	int         getWidth() const                                          { return m_width;  }
+	int         getHeight() const                                         { return m_height; }
+	Format      getFormat() const                                         { return m_format; }
+	size_t      getStride() const                                         { return m_stride; }
+	size_t      getTexelSize() const                                      { return GetTexelSize(m_format); }
+	size_t      getSize() const                                           { return m_stride * (size_t)m_height; }
+	void*       getData()                                                 { return m_data; }
+	const void* getData() const                                           { return m_data; }
+	void*       getRow(int _y)                                            { return (char*)m_data + m_stride * (size_t)_y; }
+	const void* getRow(int _y) const                                      { return (const char*)m_data + m_stride * (size_t)_y; }
+
+	// Read/write a single texel as RGBA float. These are slow, use for reference implementations and tools only.
+	void        readTexel(int _x, int _y, float* rgba_) const;
+	void        writeTexel(int _x, int _y, const float* _rgba);
+
+private:
+	int    m_width     = 0;
+	int    m_height    = 0;
+	Format m_format    = Format_RGBA8;
+	size_t m_stride    = 0;
+	void*  m_data      = nullptr;
+	bool   m_ownsData  = false;
+};
+
+} // namespace conv
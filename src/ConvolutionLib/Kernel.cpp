@@ -0,0 +1,507 @@
+#include "Kernel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace conv {
+
+// Sanity checks for the constexpr generators; binomial weights are exact in float.
+static_assert(MakeKernelBinomial1d<5>().sum == 16.0f, "");
+static_assert(MakeKernelBinomial1d<5>().weights[0] == 1.0f / 16.0f, "");
+static_assert(MakeKernelBinomial1d<5>().weights[2] == 6.0f / 16.0f, "");
+static_assert(MakeKernelBinomial2d<3>().weights[4] == 4.0f / 16.0f, "");
+static_assert(MakeKernelBilinear(MakeKernelBinomial1d<5>()).offsets[0] == -1.2f, "");
+static_assert(MakeKernelBilinear(MakeKernelBinomial2d<3>()).offsets[0] == -1.0f / 3.0f, "");
+static_assert(MakeKernelBilinear(MakeKernelBinomial2d<3>()).offsets[1] == -1.0f / 3.0f, "");
+static_assert(MakeKernelBilinear(MakeKernelBinomial2d<3>()).offsets[3 * 2] == 1.0f, "");
+static_assert(MakeKernelBox1d<7>().weights[3] == 1.0f / 7.0f, "");
+static_assert(internal::Exp(0.0) == 1.0, "");
+
+float GaussianFindSigma(int _size, float _epsilon)
+{
+ // no allocation for typical sizes
+	float  tmpStack[64];
+	float* tmp = (_size | 1) <= 64 ? tmpStack : new float[_size | 1];
+	float sigma = 1.0f;
+	float stp = 1.0f;
+	while (stp > 0.01f)
+	{
+		KernelGaussian1d(_size, sigma, tmp);
+		float w = tmp[0];
+		if (w > _epsilon)
+		{
+			sigma -= stp;
+			stp *= 0.5f;
+		}
+		sigma += stp;
+	}
+	if (tmp != tmpStack)
+	{
+		delete[] tmp;
+	}
+	return sigma;
+}
+
+void GaussianFindBoxWidths(float _sigma, int _passCount, int* widths_)
+{
+ // the variance of a box of width w is (w^2 - 1) / 12, the ideal width gives n * (w^2 - 1) / 12 = sigma^2
+	const float sigma2 = _sigma * _sigma;
+	const float n      = (float)_passCount;
+	int wl = (int)floorf(sqrtf(12.0f * sigma2 / n + 1.0f));
+	wl = (wl % 2 == 0) ? wl - 1 : wl;
+	wl = wl < 1 ? 1 : wl;
+	const float fwl = (float)wl;
+	int m = (int)roundf((12.0f * sigma2 - n * fwl * fwl - 4.0f * n * fwl - 3.0f * n) / (-4.0f * fwl - 4.0f));
+	m = m < 0 ? 0 : (m > _passCount ? _passCount : m);
+	for (int i = 0; i < _passCount; ++i)
+	{
+		widths_[i] = i < m ? wl : wl + 2;
+	}
+}
+
+float GaussianBoxMaxError(float _sigma, const int* _widths, int _passCount)
+{
+	const int size = KernelIteratedBoxSize(_widths, _passCount);
+	float* box      = new float[size];
+	float* gaussian = new float[size];
+	KernelIteratedBox1d(_widths, _passCount, box);
+	KernelGaussian1d(size, _sigma, gaussian);
+	float ret = 0.0f;
+	for (int i = 0; i < size; ++i)
+	{
+		ret = fmaxf(ret, fabsf(box[i] - gaussian[i]));
+	}
+	delete[] box;
+	delete[] gaussian;
+	return ret;
+}
+
+namespace {
+
+// Quantize a bilinear fraction to _bits of precision (as the texture unit does), _bits <= 0 means no quantization.
+float QuantizeFraction(float _f, int _bits)
+{
+	if (_bits <= 0)
+	{
+		return _f;
+	}
+	const float scale = (float)(1 << _bits);
+	return floorf(_f * scale + 0.5f) / scale;
+}
+
+// Add the texels sampled by the taps to weights_, a (_width + 2) x (_height + 2) grid (1 texel border, such that taps
+// which land just outside the kernel are captured).
+void ReconstructPadded(int _width, int _height, const float* _tapWeights, const float* _tapOffsets, int _tapCount, float* weights_, int _fractionBits)
+{
+	const int paddedWidth  = _width + 2;
+	const int paddedHeight = _height + 2;
+	for (int i = 0; i < _tapCount; ++i)
+	{
+		const float x  = _tapOffsets[i * 2 + 0] + (float)(_width / 2 + 1);
+		const float y  = _tapOffsets[i * 2 + 1] + (float)(_height / 2 + 1);
+		int   x0 = (int)floorf(x);
+		int   y0 = (int)floorf(y);
+		float fx = QuantizeFraction(x - (float)x0, _fractionBits);
+		float fy = QuantizeFraction(y - (float)y0, _fractionBits);
+		if (fx >= 1.0f)
+		{
+			++x0;
+			fx = 0.0f;
+		}
+		if (fy >= 1.0f)
+		{
+			++y0;
+			fy = 0.0f;
+		}
+		const float w = _tapWeights[i];
+		const float texelWeights[4] = { w * (1.0f - fx) * (1.0f - fy), w * fx * (1.0f - fy), w * (1.0f - fx) * fy, w * fx * fy };
+		for (int j = 0; j < 4; ++j)
+		{
+			const int tx = x0 + (j & 1);
+			const int ty = y0 + (j >> 1);
+			if (tx >= 0 && tx < paddedWidth && ty >= 0 && ty < paddedHeight)
+			{
+				weights_[ty * paddedWidth + tx] += texelWeights[j];
+			}
+		}
+	}
+}
+
+struct BilinearMerge
+{
+	int   m_x, m_y;          // top left texel
+	int   m_sizeX, m_sizeY;  // 2x2, 2x1 or 1x2
+	int   m_count;           // texels with |weight| > max error
+	float m_error;
+	float m_weight;
+	float m_fx, m_fy;
+};
+
+// Fit a single bilinear tap to the block, return false if the weights have mixed signs (not representable).
+bool FitBilinearMerge(int _width, const float* _weights, int _fractionBits, BilinearMerge& merge_)
+{
+	float t[4] = {};
+	for (int j = 0; j < 4; ++j)
+	{
+		const int dx = j & 1, dy = j >> 1;
+		if (dx < merge_.m_sizeX && dy < merge_.m_sizeY)
+		{
+			t[j] = _weights[(merge_.m_y + dy) * _width + merge_.m_x + dx];
+		}
+	}
+	const float w = t[0] + t[1] + t[2] + t[3];
+	if (w == 0.0f)
+	{
+		return false;
+	}
+	for (float ti : t)
+	{
+		if (ti != 0.0f && (ti < 0.0f) != (w < 0.0f))
+		{
+			return false;
+		}
+	}
+
+ // matching the weight and centroid of the block
+	const float fx = QuantizeFraction((t[1] + t[3]) / w, _fractionBits);
+	const float fy = QuantizeFraction((t[2] + t[3]) / w, _fractionBits);
+	const float fit[4] = { w * (1.0f - fx) * (1.0f - fy), w * fx * (1.0f - fy), w * (1.0f - fx) * fy, w * fx * fy };
+	merge_.m_error = 0.0f;
+	for (int j = 0; j < 4; ++j)
+	{
+		merge_.m_error = fabsf(fit[j] - t[j]) > merge_.m_error ? fabsf(fit[j] - t[j]) : merge_.m_error;
+	}
+	merge_.m_weight = w;
+	merge_.m_fx     = fx;
+	merge_.m_fy     = fy;
+	return true;
+}
+
+} // namespace
+
+size_t KernelOptimizeBilinearGreedy2dScratchSize(int _width, int _height)
+{
+ // candidate merges (<= 3 per texel) and as many for sorting them, selected merges for the current/best alignment (<= 1
+ // per texel), assigned flags for the current/best alignment
+	const size_t texelCount = (size_t)_width * (size_t)_height;
+	return sizeof(BilinearMerge) * texelCount * 8 + texelCount * 2;
+}
+
+int KernelOptimizeBilinearGreedy2d(int _width, int _height, const float* _weightsIn, float _maxError, float* weightsOut_, float* offsetsOut_, int _fractionBits, void* scratch_)
+{
+	std::vector<uint8_t> allocatedScratch;
+	if (!scratch_)
+	{
+		allocatedScratch.resize(KernelOptimizeBilinearGreedy2dScratchSize(_width, _height));
+		scratch_ = allocatedScratch.data();
+	}
+	const int texelCount = _width * _height;
+	BilinearMerge* merges       = (BilinearMerge*)scratch_;
+	BilinearMerge* sortTmp      = merges + texelCount * 3;
+	BilinearMerge* selected     = sortTmp + texelCount * 3;
+	BilinearMerge* bestSelected = selected + texelCount;
+	uint8_t*       assigned     = (uint8_t*)(bestSelected + texelCount);
+	uint8_t*       bestAssigned = assigned + texelCount;
+
+	float maxWeight = 0.0f;
+	float sum = 0.0f;
+	for (int i = 0; i < texelCount; ++i)
+	{
+		maxWeight = fabsf(_weightsIn[i]) > maxWeight ? fabsf(_weightsIn[i]) : maxWeight;
+		sum += _weightsIn[i];
+	}
+	_maxError *= maxWeight;
+	auto isSignificant = [&](int _x, int _y) { return fabsf(_weightsIn[_y * _width + _x]) > _maxError; };
+
+ // all candidate merges within the error bound which save at least 1 fetch
+	int mergeCount = 0;
+	const int kShapes[3][2] = { { 2, 2 }, { 2, 1 }, { 1, 2 } };
+	for (const auto& shape : kShapes)
+	{
+		for (int y = 0; y + shape[1] <= _height; ++y)
+		{
+			for (int x = 0; x + shape[0] <= _width; ++x)
+			{
+				BilinearMerge merge = {};
+				merge.m_x     = x;
+				merge.m_y     = y;
+				merge.m_sizeX = shape[0];
+				merge.m_sizeY = shape[1];
+				for (int dy = 0; dy < shape[1]; ++dy)
+				{
+					for (int dx = 0; dx < shape[0]; ++dx)
+					{
+						merge.m_count += isSignificant(x + dx, y + dy) ? 1 : 0;
+					}
+				}
+				if (merge.m_count >= 2 && FitBilinearMerge(_width, _weightsIn, _fractionBits, merge) && merge.m_error <= _maxError)
+				{
+					merges[mergeCount++] = merge;
+				}
+			}
+		}
+	}
+
+ // take merges greedily (most significant texels first), each texel belongs to at most 1 merge. Among merges with the
+ // same count prefer one alignment of the 2x2 grid, else the order of equally good merges leaves gaps; try all 4
+ // alignments and keep the one with the fewest fetches
+	int bestSelectedCount = 0;
+	int bestCount = -1;
+	for (int alignment = 0; alignment < 4; ++alignment)
+	{
+		auto isAligned = [alignment](const BilinearMerge& _merge) { return (_merge.m_x & 1) == (alignment & 1) && (_merge.m_y & 1) == (alignment >> 1); };
+		auto isBefore = [&](const BilinearMerge& _a, const BilinearMerge& _b)
+			{
+				if (_a.m_count != _b.m_count)
+				{
+					return _a.m_count > _b.m_count;
+				}
+				if (isAligned(_a) != isAligned(_b))
+				{
+					return isAligned(_a);
+				}
+				return _a.m_error < _b.m_error;
+			};
+	 // bottom up merge sort via sortTmp, stable as per std::stable_sort (which may allocate)
+		BilinearMerge* sortSrc = merges;
+		BilinearMerge* sortDst = sortTmp;
+		for (int runLength = 1; runLength < mergeCount; runLength *= 2)
+		{
+			for (int i = 0; i < mergeCount; i += runLength * 2)
+			{
+				const int mid = std::min(i + runLength, mergeCount);
+				const int end = std::min(i + runLength * 2, mergeCount);
+				std::merge(sortSrc + i, sortSrc + mid, sortSrc + mid, sortSrc + end, sortDst + i, isBefore);
+			}
+			std::swap(sortSrc, sortDst);
+		}
+		if (sortSrc != merges)
+		{
+			memcpy(merges, sortSrc, sizeof(BilinearMerge) * mergeCount);
+		}
+
+		memset(assigned, 0, texelCount);
+		int selectedCount = 0;
+		for (int i = 0; i < mergeCount; ++i)
+		{
+			const BilinearMerge& merge = merges[i];
+			bool free = true;
+			for (int dy = 0; dy < merge.m_sizeY && free; ++dy)
+			{
+				for (int dx = 0; dx < merge.m_sizeX && free; ++dx)
+				{
+					free = !assigned[(merge.m_y + dy) * _width + merge.m_x + dx];
+				}
+			}
+			if (!free)
+			{
+				continue;
+			}
+			for (int dy = 0; dy < merge.m_sizeY; ++dy)
+			{
+				for (int dx = 0; dx < merge.m_sizeX; ++dx)
+				{
+					assigned[(merge.m_y + dy) * _width + merge.m_x + dx] = 1;
+				}
+			}
+			selected[selectedCount++] = merge;
+		}
+		int count = selectedCount;
+		for (int y = 0; y < _height; ++y)
+		{
+			for (int x = 0; x < _width; ++x)
+			{
+				count += !assigned[y * _width + x] && isSignificant(x, y) ? 1 : 0;
+			}
+		}
+		if (bestCount < 0 || count < bestCount)
+		{
+			bestCount = count;
+			bestSelectedCount = selectedCount;
+			memcpy(bestAssigned, assigned, texelCount);
+			memcpy(bestSelected, selected, sizeof(BilinearMerge) * selectedCount);
+		}
+	}
+
+	int ret = 0;
+	for (int i = 0; i < bestSelectedCount; ++i)
+	{
+		const BilinearMerge& merge = bestSelected[i];
+		weightsOut_[ret]         = merge.m_weight;
+		offsetsOut_[ret * 2]     = (float)(merge.m_x - _width / 2) + merge.m_fx;
+		offsetsOut_[ret * 2 + 1] = (float)(merge.m_y - _height / 2) + merge.m_fy;
+		++ret;
+	}
+
+ // remaining significant texels are single (point) fetches, the rest are dropped
+	for (int y = 0; y < _height; ++y)
+	{
+		for (int x = 0; x < _width; ++x)
+		{
+			if (!bestAssigned[y * _width + x] && isSignificant(x, y))
+			{
+				weightsOut_[ret]         = _weightsIn[y * _width + x];
+				offsetsOut_[ret * 2]     = (float)(x - _width / 2);
+				offsetsOut_[ret * 2 + 1] = (float)(y - _height / 2);
+				++ret;
+			}
+		}
+	}
+
+ // dropped texels bias the sum (i.e. the brightness of the result), rescale towards the original sum as far as the error
+ // bound allows: each texel covered by a tap constrains the scale to keep its fitted weight within _maxError
+	float tapSum = 0.0f;
+	for (int i = 0; i < ret; ++i)
+	{
+		tapSum += weightsOut_[i];
+	}
+	if (tapSum != 0.0f && sum != 0.0f)
+	{
+		float minScale = -FLT_MAX, maxScale = FLT_MAX;
+		auto constrain = [&](float _weight, float _fit)
+			{
+				if (_fit != 0.0f)
+				{
+					const float a = (_weight - _maxError) / _fit;
+					const float b = (_weight + _maxError) / _fit;
+					minScale = std::max(minScale, std::min(a, b));
+					maxScale = std::min(maxScale, std::max(a, b));
+				}
+			};
+		for (int i = 0; i < bestSelectedCount; ++i)
+		{
+			const BilinearMerge& merge = bestSelected[i];
+			for (int dy = 0; dy < merge.m_sizeY; ++dy)
+			{
+				for (int dx = 0; dx < merge.m_sizeX; ++dx)
+				{
+					const float fit = merge.m_weight * (dx ? merge.m_fx : 1.0f - merge.m_fx) * (dy ? merge.m_fy : 1.0f - merge.m_fy);
+					constrain(_weightsIn[(merge.m_y + dy) * _width + merge.m_x + dx], fit);
+				}
+			}
+		}
+		for (int i = bestSelectedCount; i < ret; ++i)
+		{
+			constrain(weightsOut_[i], weightsOut_[i]);
+		}
+		const float scale = minScale <= maxScale ? std::min(std::max(sum / tapSum, minScale), maxScale) : 1.0f;
+		for (int i = 0; i < ret; ++i)
+		{
+			weightsOut_[i] *= scale;
+		}
+	}
+	return ret;
+}
+
+void KernelBilinearReconstruct2d(int _width, int _height, const float* _tapWeights, const float* _tapOffsets, int _tapCount, float* weightsOut_, int _fractionBits)
+{
+	std::vector<float> padded((_width + 2) * (_height + 2), 0.0f);
+	ReconstructPadded(_width, _height, _tapWeights, _tapOffsets, _tapCount, padded.data(), _fractionBits);
+	for (int y = 0; y < _height; ++y)
+	{
+		for (int x = 0; x < _width; ++x)
+		{
+			weightsOut_[y * _width + x] = padded[(y + 1) * (_width + 2) + x + 1];
+		}
+	}
+}
+
+float KernelBilinearError2d(int _width, int _height, const float* _weights, const float* _tapWeights, const float* _tapOffsets, int _tapCount, int _fractionBits)
+{
+	std::vector<float> padded((_width + 2) * (_height + 2), 0.0f);
+	ReconstructPadded(_width, _height, _tapWeights, _tapOffsets, _tapCount, padded.data(), _fractionBits);
+	float ret = 0.0f;
+	for (int y = 0; y < _height + 2; ++y)
+	{
+		for (int x = 0; x < _width + 2; ++x)
+		{
+			const bool  inside = x > 0 && x <= _width && y > 0 && y <= _height;
+			const float err    = fabsf(padded[y * (_width + 2) + x] - (inside ? _weights[(y - 1) * _width + x - 1] : 0.0f));
+			ret = err > ret ? err : ret;
+		}
+	}
+	return ret;
+}
+
+float* LoadKernel2d(const char* _path, int* size_, bool _normalize)
+{
+	FILE* file = fopen(_path, "rb");
+	if (!file)
+	{
+		return nullptr;
+	}
+	fseek(file, 0, SEEK_END);
+	const long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char* text = new char[fileSize + 1];
+	const size_t readSize = fread(text, 1, (size_t)fileSize, file);
+	fclose(file);
+	text[readSize] = '\0';
+
+ // count pass, then parse pass
+	float* ret = nullptr;
+	int count = 0;
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		count = 0;
+		for (char* c = text; *c != '\0';)
+		{
+			if (*c == '#')
+			{
+				while (*c != '\0' && *c != '\n')
+				{
+					++c;
+				}
+				continue;
+			}
+			char* end = c;
+			const float w = strtof(c, &end);
+			if (end == c)
+			{
+				++c; // whitespace, commas or junk
+				continue;
+			}
+			if (ret)
+			{
+				ret[count] = w;
+			}
+			++count;
+			c = end;
+		}
+
+		if (pass == 0)
+		{
+			int size = (int)sqrt((double)count + 0.5);
+			if (count == 0 || size * size != count || (size & 1) == 0)
+			{
+				delete[] text;
+				return nullptr;
+			}
+			*size_ = size;
+			ret = new float[count];
+		}
+	}
+	delete[] text;
+
+	float sum = 0.0f;
+	for (int i = 0; i < count; ++i)
+	{
+		sum += ret[i];
+	}
+	if (_normalize && sum != 0.0f)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			ret[i] /= sum;
+		}
+	}
+	return ret;
+}
+
+} // namespace conv
@@ -0,0 +1,500 @@
+#pragma once
+
+// Convolution kernel generators, shared by the Convolution sample and the command line tools. There are no framework
+// dependencies here, so this builds standalone on any platform.
+//
+// All of the generators are constexpr, hence fixed-size kernels can be baked at compile time via the Make*() templates:
+//
+//   constexpr auto kGaussian9 = conv::MakeKernelGaussian1d<9>(2.0f);
+//   constexpr auto kBinomial5 = conv::MakeKernelBinomial1d<5>();
+//
+// Kernel sizes are always forced to be odd.
+
+#include <cstddef>
+
+#ifndef GAUSSIAN_USE_INTEGRATION
+	#define GAUSSIAN_USE_INTEGRATION 1 // Integrate the Gaussian over the area of each texel, else sample at the texel center.
+#endif
+
+namespace conv {
+
+constexpr float kPi    = 3.14159265359f;
+constexpr float kTwoPi = 6.28318530718f;
+
+namespace internal {
+
+// std::exp() isn't constexpr. Halve _x until |_x| <= 0.5, evaluate the Taylor series then square the result back up.
+constexpr double Exp(double _x)
+{
+	int k = 0;
+	while (_x > 0.5 || _x < -0.5)
+	{
+		_x *= 0.5;
+		++k;
+	}
+	double term = 1.0;
+	double ret  = 1.0;
+	for (int i = 1; i < 12; ++i)
+	{
+		term *= _x / (double)i;
+		ret += term;
+	}
+	while (k-- > 0)
+	{
+		ret *= ret;
+	}
+	return ret;
+}
+
+} // namespace internal
+
+constexpr float GaussianDistribution(float _d, float /*_sigma*/, float _sigma2)
+{
+	float d = (_d * _d) / (2.0f * _sigma2);
+	return 1.0f / (kTwoPi * _sigma2) * (float)internal::Exp(-d);
+}
+
+// Evaluate GaussianDistribution() over the interval [_mind,_maxd] via trapezoidal integration.
+constexpr float GaussianIntegration(float _mind, float _maxd, float _sigma, float _sigma2, int _sampleCount = 64)
+{
+	const float w = 1.0f / (float)(_sampleCount - 1);
+	const float stepd = (_maxd - _mind) * w;
+	float ret = GaussianDistribution(_mind, _sigma, _sigma2);
+	float d = _mind + stepd;
+	for (int i = 1; i < _sampleCount - 1; ++i)
+	{
+		ret += GaussianDistribution(d, _sigma, _sigma2) * 2.0f;
+		d += stepd;
+	}
+	ret += GaussianDistribution(d, _sigma, _sigma2);
+	return ret * stepd / 2.0f;
+}
+
+// weights_ is an array of _size. Box weights are always normalized, return the kernel sum (1).
+constexpr float KernelBox1d(int _size, float* weights_)
+{
+	_size = _size | 1; // force _size to be odd
+
+	for (int i = 0; i < _size; ++i)
+	{
+		weights_[i] = 1.0f / (float)_size;
+	}
+	return 1.0f;
+}
+
+// weights_ is an array of _size * _size.
+constexpr float KernelBox2d(int _size, float* weights_)
+{
+	_size = _size | 1; // force _size to be odd
+
+	return KernelBox1d(_size * _size, weights_);
+}
+
+// weights_ is an array of _size. Return the sum of the unnormalized weights.
+constexpr float KernelGaussian1d(int _size, float _sigma, float* weights_, bool _normalize = true)
+{
+	_size = _size | 1; // force _size to be odd
+
+ // generate
+	const float sigma2 = _sigma * _sigma;
+	const int n = _size / 2;
+	float sum = 0.0f;
+	for (int i = 0; i < _size; ++i)
+	{
+		float d = (float)(i - n);
+		#if GAUSSIAN_USE_INTEGRATION
+			weights_[i] = GaussianIntegration(d - 0.5f, d + 0.5f, _sigma, sigma2);
+		#else
+			weights_[i] = GaussianDistribution(d, _sigma, sigma2);
+		#endif
+		sum += weights_[i];
+	}
+
+ // normalize
+	if (_normalize)
+	{
+		for (int i = 0; i < _size; ++i)
+		{
+			weights_[i] /= sum;
+		}
+	}
+	return sum;
+}
+
+// weights_ is an array of _size * _size. Return the sum of the unnormalized weights.
+constexpr float KernelGaussian2d(int _size, float _sigma, float* weights_, bool _normalize = true)
+{
+	_size = _size | 1; // force _size to be odd
+
+ // generate first row
+	float sum = KernelGaussian1d(_size, _sigma, weights_, false); // not normalized because we overwrite the first row later
+	sum *= sum;
+
+ // derive subsequent rows from the first
+	for (int i = 1; i < _size; ++i)
+	{
+		for (int j = 0; j < _size; ++j)
+		{
+			int k = i * _size + j;
+			weights_[k] = (weights_[i] * weights_[j]) / (_normalize ? sum : 1.0f);
+		}
+	}
+
+ // copy the first row from the last
+	for (int i = 0; i < _size; ++i)
+	{
+		weights_[i] = weights_[(_size - 1) * _size + i];
+	}
+	return sum;
+}
+
+// weights_ is an array of _size. Return the sum of the unnormalized weights.
+constexpr float KernelBinomial1d(int _size, float* weights_, bool _normalize = true)
+{
+	_size = _size | 1; // force _size to be odd
+
+ // generate (Pascal's triangle)
+	weights_[0] = 1.0f;
+	float sum = 1.0f;
+	for (int i = 1; i < _size; ++i)
+	{
+		weights_[i] = weights_[i - 1] * (float)(_size - i) / (float)i;
+		sum += weights_[i];
+	}
+
+ // normalize
+	if (_normalize)
+	{
+		for (int i = 0; i < _size; ++i)
+		{
+			weights_[i] /= sum;
+		}
+	}
+	return sum;
+}
+
+// Disc of diameter _size (i.e. a bokeh kernel), not separable. Each weight is the coverage of the texel estimated with
+// 4x4 samples. weights_ is an array of _size * _size. Return the sum of the unnormalized weights.
+constexpr float KernelDisc2d(int _size, float* weights_, bool _normalize = true)
+{
+	_size = _size | 1; // force _size to be odd
+
+	const float radius = (float)_size * 0.5f;
+	float sum = 0.0f;
+	for (int i = 0; i < _size; ++i)
+	{
+		for (int j = 0; j < _size; ++j)
+		{
+			int covered = 0;
+			for (int k = 0; k < 16; ++k)
+			{
+				const float x = (float)j + ((float)(k % 4) + 0.5f) / 4.0f - radius;
+				const float y = (float)i + ((float)(k / 4) + 0.5f) / 4.0f - radius;
+				covered += (x * x + y * y) <= radius * radius ? 1 : 0;
+			}
+			weights_[i * _size + j] = (float)covered / 16.0f;
+			sum += weights_[i * _size + j];
+		}
+	}
+
+	if (_normalize)
+	{
+		for (int i = 0; i < _size * _size; ++i)
+		{
+			weights_[i] /= sum;
+		}
+	}
+	return sum;
+}
+
+// weights_ is an array of _size * _size. Return the sum of the unnormalized weights.
+constexpr float KernelBinomial2d(int _size, float* weights_, bool _normalize = true)
+{
+	_size = _size | 1; // force _size to be odd
+
+ // generate first row
+	float sum = KernelBinomial1d(_size, weights_, false); // not normalized because we overwrite the first row later
+	sum *= sum;
+
+ // derive subsequent rows from the first
+	for (int i = 1; i < _size; ++i)
+	{
+		for (int j = 0; j < _size; ++j)
+		{
+			int k = i * _size + j;
+			weights_[k] = (weights_[i] * weights_[j]) / (_normalize ? sum : 1.0f);
+		}
+	}
+
+ // copy the first row from the last
+	for (int i = 0; i < _size; ++i)
+	{
+		weights_[i] = weights_[(_size - 1) * _size + i];
+	}
+	return sum;
+}
+
+// Size of the kernel equivalent to _passCount successive box filters of _widths (forced to be odd).
+constexpr int KernelIteratedBoxSize(const int* _widths, int _passCount)
+{
+	int ret = 1;
+	for (int i = 0; i < _passCount; ++i)
+	{
+		ret += (_widths[i] | 1) - 1;
+	}
+	return ret;
+}
+
+// Kernel equivalent to _passCount successive box filters of _widths. weights_ is an array of KernelIteratedBoxSize().
+// Box weights are always normalized, return the kernel sum (1).
+constexpr float KernelIteratedBox1d(const int* _widths, int _passCount, float* weights_)
+{
+	int size = 1;
+	weights_[0] = 1.0f;
+	for (int i = 0; i < _passCount; ++i)
+	{
+	 // convolve in place, output i reads inputs [i - width + 1, i] so iterate backwards
+		const int width = _widths[i] | 1;
+		size += width - 1;
+		for (int j = size - 1; j >= 0; --j)
+		{
+			float w = 0.0f;
+			for (int k = j - width + 1; k <= j; ++k)
+			{
+				w += k >= 0 && k < size - width + 1 ? weights_[k] : 0.0f;
+			}
+			weights_[j] = w / (float)width;
+		}
+	}
+	return 1.0f;
+}
+
+// Outputs are arrays of _size / 2 + 1.
+constexpr void KernelOptimizeBilinear1d(int _size, const float* _weightsIn, float* weightsOut_, float* offsetsOut_)
+{
+	const int halfSize = _size / 2;
+	int j = 0;
+	for (int i = 0; i != _size - 1; i += 2, ++j)
+	{
+		float w1 = _weightsIn[i];
+		float w2 = _weightsIn[i + 1];
+		float w3 = w1 + w2;
+		float o1 = (float)(i - halfSize);
+		float o2 = (float)(i - halfSize + 1);
+		float o3 = (o1 * w1 + o2 * w2) / w3;
+		weightsOut_[j] = w3;
+		offsetsOut_[j] = o3;
+	}
+	weightsOut_[j] = _weightsIn[_size - 1];
+	offsetsOut_[j] = (float)(_size - 1 - halfSize);
+}
+
+// Outputs are arrays of (_size / 2 + 1) ^ 2, offsets are interleaved xy pairs (i.e. vec2). Merges fixed 2x2 blocks, which
+// is only exact if each block is rank 1 (e.g. the separable kernels above); see KernelOptimizeBilinearGreedy2d().
+constexpr void KernelOptimizeBilinear2d(int _size, const float* _weightsIn, float* weightsOut_, float* offsetsOut_)
+{
+	const int outSize = _size / 2 + 1;
+	const int halfSize = _size / 2;
+	int row = 0, col = 0;
+	for (row = 0; row < _size - 1; row += 2)
+	{
+		for (col = 0; col < _size - 1; col += 2)
+		{
+			float w1 = _weightsIn[(row * _size) + col];
+			float w2 = _weightsIn[(row * _size) + col + 1];
+			float w3 = _weightsIn[((row + 1) * _size) + col];
+			float w4 = _weightsIn[((row + 1) * _size) + col + 1];
+			float w5 = w1 + w2 + w3 + w4;
+			float x1 = (float)(col - halfSize);
+			float x2 = (float)(col - halfSize + 1);
+			float x3 = (x1 * (w1 + w3) + x2 * (w2 + w4)) / w5;
+			float y1 = (float)(row - halfSize);
+			float y2 = (float)(row - halfSize + 1);
+			float y3 = (y1 * (w1 + w2) + y2 * (w3 + w4)) / w5; // centroid of the whole block
+
+			const int k = (row / 2) * outSize + (col / 2);
+			weightsOut_[k] = w5;
+			offsetsOut_[k * 2] = x3;
+			offsetsOut_[k * 2 + 1] = y3;
+		}
+
+		float w1 = _weightsIn[(row * _size) + col];
+		float w2 = _weightsIn[((row + 1) * _size) + col];
+		float w3 = w1 + w2;
+		float y1 = (float)(row - halfSize);
+		float y2 = (float)(row - halfSize + 1);
+		float y3 = (y1 * w1 + y2 * w2) / w3;
+
+		const int k = (row / 2) * outSize + (col / 2);
+		weightsOut_[k] = w3;
+		offsetsOut_[k * 2] = (float)(col - halfSize);
+		offsetsOut_[k * 2 + 1] = y3;
+	}
+
+	for (col = 0; col < _size - 1; col += 2)
+	{
+		float w1 = _weightsIn[(row * _size) + col];
+		float w2 = _weightsIn[(row * _size) + col + 1];
+		float w3 = w1 + w2;
+		float x1 = (float)(col - halfSize);
+		float x2 = (float)(col - halfSize + 1);
+		float x3 = (x1 * w1 + x2 * w2) / w3;
+
+		const int k = (row / 2) * outSize + (col / 2);
+		weightsOut_[k] = w3;
+		offsetsOut_[k * 2] = x3;
+		offsetsOut_[k * 2 + 1] = (float)(row - halfSize);
+	}
+
+	const int k = (row / 2) * outSize + (col / 2);
+	weightsOut_[k] = _weightsIn[(row * _size) + col];
+	offsetsOut_[k * 2] = (float)(col - halfSize);
+	offsetsOut_[k * 2 + 1] = (float)(row - halfSize);
+}
+
+// Find sigma such that no weights are < _epsilon. Epsilon should be the smallest representable for the precision of the signal to be convolved e.g. 1/255 for 8-bit.
+float GaussianFindSigma(int _size, float _epsilon);
+
+// Find the box widths for _passCount successive box filters which best approximate a Gaussian of _sigma, as per Kovesi
+// ("Fast almost-Gaussian filtering", 2010). The widths are odd, the first passes use the smaller width such that the
+// variance is as close as possible to _sigma^2. widths_ is an array of _passCount.
+void GaussianFindBoxWidths(float _sigma, int _passCount, int* widths_);
+
+// Max absolute difference between KernelIteratedBox1d(_widths, _passCount) and KernelGaussian1d() of the same size.
+float GaussianBoxMaxError(float _sigma, const int* _widths, int _passCount);
+
+// Merge the taps of a _width x _height kernel (row major, any weights) into bilinear fetches. Candidate merges are 2x2
+// blocks and 2x1/1x2 pairs of texels, fitted by matching the weight and centroid of the block. A merge is accepted if
+// the max absolute error of the fitted weights (with fractions quantized to _fractionBits, the texture unit's subtexel
+// precision) is <= _maxError * the largest absolute weight. Merges are taken greedily, most texels then lowest error
+// first, for each of the 4 block alignments; the alignment with the fewest taps wins. Texels within the error bound
+// which aren't merged are dropped and the taps are rescaled towards the kernel sum, as far as the error bound allows.
+// Outputs are arrays of _width * _height (the worst case), offsets are interleaved xy pairs relative to the center texel
+// (_width / 2, _height / 2). scratch_ is KernelOptimizeBilinearGreedy2dScratchSize() bytes for the temporaries
+// (allocated if nullptr). Return the tap count.
+int KernelOptimizeBilinearGreedy2d(int _width, int _height, const float* _weightsIn, float _maxError, float* weightsOut_, float* offsetsOut_, int _fractionBits = 8, void* scratch_ = nullptr);
+size_t KernelOptimizeBilinearGreedy2dScratchSize(int _width, int _height);
+
+// Weights of the _width x _height texel grid sampled by _tapCount bilinear taps (as output by KernelOptimizeBilinear2d()
+// or KernelOptimizeBilinearGreedy2d()) with fractions quantized to _fractionBits. Taps outside the grid are ignored.
+void KernelBilinearReconstruct2d(int _width, int _height, const float* _tapWeights, const float* _tapOffsets, int _tapCount, float* weightsOut_, int _fractionBits = 8);
+
+// Max absolute difference between _weights and KernelBilinearReconstruct2d() (weight outside the grid counts as error).
+float KernelBilinearError2d(int _width, int _height, const float* _weights, const float* _tapWeights, const float* _tapOffsets, int _tapCount, int _fractionBits = 8);
+
+// Load a user 2d kernel from a text file: _size^2 weights (row major, _size odd) separated by whitespace or commas, '#'
+// comments to the end of the line. Return the weights (allocated with new[]) and write the size to size_, or return
+// nullptr if the file can't be read or the weight count isn't an odd square. Weights are normalized if the sum is != 0.
+float* LoadKernel2d(const char* _path, int* size_, bool _normalize = true);
+
+
+// Fixed-size kernels. These wrap the generators above to return the weights by value, use as constexpr to bake the
+// weights into the binary.
+
+template <int kSize>
+struct KernelTable1d
+{
+	static_assert(kSize > 0 && (kSize & 1) == 1, "Kernel size must be odd");
+	static constexpr int kWidth = kSize;
+	static constexpr int kCount = kSize;
+
+	float weights[kCount];
+	float sum; // sum of the unnormalized weights, as returned by the generator
+};
+
+template <int kSize>
+struct KernelTable2d
+{
+	static_assert(kSize > 0 && (kSize & 1) == 1, "Kernel size must be odd");
+	static constexpr int kWidth = kSize;
+	static constexpr int kCount = kSize * kSize;
+
+	float weights[kCount];
+	float sum;
+};
+
+template <int kSize>
+struct BilinearKernelTable1d
+{
+	static constexpr int kWidth = kSize;
+	static constexpr int kCount = kSize / 2 + 1;
+
+	float weights[kCount];
+	float offsets[kCount];
+};
+
+template <int kSize>
+struct BilinearKernelTable2d
+{
+	static constexpr int kWidth = kSize;
+	static constexpr int kCount = (kSize / 2 + 1) * (kSize / 2 + 1);
+
+	float weights[kCount];
+	float offsets[kCount * 2]; // xy pairs
+};
+
+template <int kSize>
+constexpr KernelTable1d<kSize> MakeKernelBox1d()
+{
+	KernelTable1d<kSize> ret = {};
+	ret.sum = KernelBox1d(kSize, ret.weights);
+	return ret;
+}
+
+template <int kSize>
+constexpr KernelTable2d<kSize> MakeKernelBox2d()
+{
+	KernelTable2d<kSize> ret = {};
+	ret.sum = KernelBox2d(kSize, ret.weights);
+	return ret;
+}
+
+template <int kSize>
+constexpr KernelTable1d<kSize> MakeKernelGaussian1d(float _sigma, bool _normalize = true)
+{
+	KernelTable1d<kSize> ret = {};
+	ret.sum = KernelGaussian1d(kSize, _sigma, ret.weights, _normalize);
+	return ret;
+}
+
+template <int kSize>
+constexpr KernelTable2d<kSize> MakeKernelGaussian2d(float _sigma, bool _normalize = true)
+{
+	KernelTable2d<kSize> ret = {};
+	ret.sum = KernelGaussian2d(kSize, _sigma, ret.weights, _normalize);
+	return ret;
+}
+
+template <int kSize>
+constexpr KernelTable1d<kSize> MakeKernelBinomial1d(bool _normalize = true)
+{
+	KernelTable1d<kSize> ret = {};
+	ret.sum = KernelBinomial1d(kSize, ret.weights, _normalize);
+	return ret;
+}
+
+template <int kSize>
+constexpr KernelTable2d<kSize> MakeKernelBinomial2d(bool _normalize = true)
+{
+	KernelTable2d<kSize> ret = {};
+	ret.sum = KernelBinomial2d(kSize, ret.weights, _normalize);
+	return ret;
+}
+
+template <int kSize>
+constexpr BilinearKernelTable1d<kSize> MakeKernelBilinear(const KernelTable1d<kSize>& _kernel)
+{
+	BilinearKernelTable1d<kSize> ret = {};
+	KernelOptimizeBilinear1d(kSize, _kernel.weights, ret.weights, ret.offsets);
+	return ret;
+}
+
+template <int kSize>
+constexpr BilinearKernelTable2d<kSize> MakeKernelBilinear(const KernelTable2d<kSize>& _kernel)
+{
+	BilinearKernelTable2d<kSize> ret = {};
+	KernelOptimizeBilinear2d(kSize, _kernel.weights, ret.weights, ret.offsets);
+	return ret;
+}
+
+} // namespace conv
@@ -0,0 +1,231 @@
+#include "KernelBank.h"
+
+#include "Image.h"
+#include "Kernel.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace conv {
+
+namespace {
+
+uint32_t AlignRange(uint32_t _offset)
+{
+	return (_offset + KernelBank::kRangeAlign - 1) / KernelBank::kRangeAlign * KernelBank::kRangeAlign;
+}
+
+} // namespace
+
+void KernelBank::init(float _gaussianSigma)
+{
+	shutdown();
+
+ // layout
+	uint32_t offset = 0;
+	for (KernelType type = 0; type < KernelType_Count; ++type)
+	{
+		for (int width = kMinWidth; width <= kMaxWidth; width += 2)
+		{
+			for (KernelMode mode = 0; mode < KernelMode_Count; ++mode)
+			{
+				Kernel& kernel = getEntry(type, mode, width);
+				const int rowCount   = IsKernelModeBilinear(mode) ? width / 2 + 1 : width;
+				kernel.m_type        = type;
+				kernel.m_mode        = mode;
+				kernel.m_width       = width;
+				kernel.m_tapCount    = IsKernelMode2d(mode) ? rowCount * rowCount : rowCount;
+				kernel.m_sum         = 0.0f;
+				kernel.m_sigma       = 0.0f;
+				kernel.m_weights     = { offset, (uint32_t)kernel.m_tapCount };
+				offset = AlignRange(offset + kernel.m_weights.m_count);
+				kernel.m_offsets     = { offset, (uint32_t)(kernel.m_tapCount * (IsKernelMode2d(mode) ? 2 : 1)) };
+				offset = AlignRange(offset + kernel.m_offsets.m_count);
+			}
+
+		 // display weights are the first row of the unoptimized kernel
+			for (KernelMode mode = 0; mode < KernelMode_Count; ++mode)
+			{
+				const Kernel& src = getEntry(type, IsKernelMode2d(mode) ? KernelMode_2d : KernelMode_Separable, width);
+				getEntry(type, mode, width).m_display = { src.m_weights.m_offset, (uint32_t)width };
+			}
+		}
+	}
+	m_arenaCount = offset;
+	m_arena = (float*)AlignedAlloc(sizeof(float) * m_arenaCount);
+	memset(m_arena, 0, sizeof(float) * m_arenaCount);
+
+ // greedy 2d bilinear merge outputs (kMaxWidth^2 weights + xy offsets) then its temporaries, see generateBilinear2d()
+	m_bilinearScratch = (float*)AlignedAlloc(sizeof(float) * kMaxWidth * kMaxWidth * 3 + KernelOptimizeBilinearGreedy2dScratchSize(kMaxWidth, kMaxWidth));
+
+ // generate
+	for (KernelType type = 0; type < KernelType_Count; ++type)
+	{
+		for (int width = kMinWidth; width <= kMaxWidth; width += 2)
+		{
+			generate(type, width, _gaussianSigma);
+		}
+	}
+	for (int width = kMinWidth; width <= kMaxWidth; width += 2)
+	{
+		m_optimalSigma[(width - kMinWidth) / 2] = GaussianFindSigma(width, 1.0f / 255.0f);
+	}
+	m_dirty = { 0, m_arenaCount };
+}
+
+void KernelBank::shutdown()
+{
+	AlignedFree(m_arena);
+	AlignedFree(m_bilinearScratch);
+	m_arena      = nullptr;
+	m_bilinearScratch = nullptr;
+	m_arenaCount = 0;
+	m_dirty      = { 0, 0 };
+}
+
+const KernelBank::Kernel& KernelBank::getKernel(KernelType _type, KernelMode _mode, int _width, float _gaussianSigma)
+{
+	assert(m_arena);
+	assert(_type >= 0 && _type < KernelType_Count);
+	assert(_mode >= 0 && _mode < KernelMode_Count);
+
+	_width = _width | 1;
+	_width = _width < kMinWidth ? kMinWidth : (_width > kMaxWidth ? kMaxWidth : _width);
+	Kernel& kernel = getEntry(_type, _mode, _width);
+	if (_type == KernelType_Gaussian && kernel.m_sigma != _gaussianSigma)
+	{
+		generate(_type, _width, _gaussianSigma);
+	}
+	return kernel;
+}
+
+float KernelBank::getOptimalSigma(int _width) const
+{
+	_width = _width | 1;
+	_width = _width < kMinWidth ? kMinWidth : (_width > kMaxWidth ? kMaxWidth : _width);
+	return m_optimalSigma[(_width - kMinWidth) / 2];
+}
+
+void KernelBank::generate(KernelType _type, int _width, float _gaussianSigma)
+{
+	Kernel& kernel2d                = getEntry(_type, KernelMode_2d,                _width);
+	Kernel& kernel2dBilinear        = getEntry(_type, KernelMode_2dBilinear,        _width);
+	Kernel& kernelSeparable         = getEntry(_type, KernelMode_Separable,         _width);
+	Kernel& kernelSeparableBilinear = getEntry(_type, KernelMode_SeparableBilinear, _width);
+
+ // weights
+	float* weights2d        = m_arena + kernel2d.m_weights.m_offset;
+	float* weightsSeparable = m_arena + kernelSeparable.m_weights.m_offset;
+	float sum2d = 1.0f, sumSeparable = 1.0f;
+	switch (_type)
+	{
+		case KernelType_Box:
+			sum2d        = KernelBox2d(_width, weights2d);
+			sumSeparable = KernelBox1d(_width, weightsSeparable);
+			break;
+		case KernelType_Gaussian:
+			sum2d        = KernelGaussian2d(_width, _gaussianSigma, weights2d);
+			sumSeparable = KernelGaussian1d(_width, _gaussianSigma, weightsSeparable);
+			break;
+		case KernelType_Binomial:
+			sum2d        = KernelBinomial2d(_width, weights2d);
+			sumSeparable = KernelBinomial1d(_width, weightsSeparable);
+			break;
+		default:
+			assert(false);
+			break;
+	};
+
+ // offsets
+	const int halfWidth = _width / 2;
+	float* offsets2d        = m_arena + kernel2d.m_offsets.m_offset;
+	float* offsetsSeparable = m_arena + kernelSeparable.m_offsets.m_offset;
+	for (int i = 0; i < _width; ++i)
+	{
+		offsetsSeparable[i] = (float)(i - halfWidth);
+		for (int j = 0; j < _width; ++j)
+		{
+			int k = i * _width + j;
+			offsets2d[k * 2]     = (float)(j - halfWidth);
+			offsets2d[k * 2 + 1] = (float)(i - halfWidth);
+		}
+	}
+
+ // bilinear
+	generateBilinear2d(kernel2d, kernel2dBilinear);
+	KernelOptimizeBilinear1d(_width, weightsSeparable, m_arena + kernelSeparableBilinear.m_weights.m_offset, m_arena + kernelSeparableBilinear.m_offsets.m_offset);
+
+	kernel2d.m_sum         = kernel2dBilinear.m_sum        = sum2d;
+	kernelSeparable.m_sum  = kernelSeparableBilinear.m_sum = sumSeparable;
+	const float sigma      = _type == KernelType_Gaussian ? _gaussianSigma : 0.0f;
+	kernel2d.m_sigma       = kernel2dBilinear.m_sigma = kernelSeparable.m_sigma = kernelSeparableBilinear.m_sigma = sigma;
+
+ // the 4 kernels are contiguous in the arena
+	uint32_t begin = kernel2d.m_weights.m_offset;
+	uint32_t end   = kernelSeparableBilinear.m_offsets.m_offset + kernelSeparableBilinear.m_offsets.m_count;
+	markDirty({ begin, end - begin });
+}
+
+void KernelBank::setBilinearMaxError(float _maxError)
+{
+	if (_maxError == m_bilinearMaxError)
+	{
+		return;
+	}
+	m_bilinearMaxError = _maxError;
+	if (!m_arena)
+	{
+		return;
+	}
+	for (KernelType type = 0; type < KernelType_Count; ++type)
+	{
+		for (int width = kMinWidth; width <= kMaxWidth; width += 2)
+		{
+			Kernel& kernel2dBilinear = getEntry(type, KernelMode_2dBilinear, width);
+			generateBilinear2d(getEntry(type, KernelMode_2d, width), kernel2dBilinear);
+			markDirty(kernel2dBilinear.m_weights);
+			markDirty(kernel2dBilinear.m_offsets);
+		}
+	}
+}
+
+void KernelBank::generateBilinear2d(const Kernel& _kernel2d, Kernel& kernel2dBilinear_)
+{
+	const int    width      = _kernel2d.m_width;
+	const float* weights2d  = m_arena + _kernel2d.m_weights.m_offset;
+	float*       weightsOut = m_arena + kernel2dBilinear_.m_weights.m_offset;
+	float*       offsetsOut = m_arena + kernel2dBilinear_.m_offsets.m_offset;
+	const int    capacity   = (int)kernel2dBilinear_.m_weights.m_count;
+
+	if (m_bilinearMaxError > 0.0f)
+	{
+	 // the greedy merge writes up to width^2 taps, only use it if it beats the fixed merge
+		float* weights = m_bilinearScratch;
+		float* offsets = weights + width * width;
+		const int tapCount = KernelOptimizeBilinearGreedy2d(width, width, weights2d, m_bilinearMaxError, weights, offsets, 8, offsets + width * width * 2);
+		if (tapCount <= capacity)
+		{
+			memcpy(weightsOut, weights, sizeof(float) * tapCount);
+			memcpy(offsetsOut, offsets, sizeof(float) * tapCount * 2);
+			kernel2dBilinear_.m_tapCount = tapCount;
+			return;
+		}
+	}
+	KernelOptimizeBilinear2d(width, weights2d, weightsOut, offsetsOut);
+	kernel2dBilinear_.m_tapCount = capacity;
+}
+
+void KernelBank::markDirty(const Range& _range)
+{
+	if (m_dirty.m_count == 0)
+	{
+		m_dirty = _range;
+		return;
+	}
+	uint32_t begin = _range.m_offset < m_dirty.m_offset ? _range.m_offset : m_dirty.m_offset;
+	uint32_t end   = _range.m_offset + _range.m_count;
+	end = end > m_dirty.m_offset + m_dirty.m_count ? end : m_dirty.m_offset + m_dirty.m_count;
+	m_dirty = { begin, end - begin };
+}
+
+} // namespace conv
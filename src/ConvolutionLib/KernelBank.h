@@ -0,0 +1,114 @@
+#pragma once
+
+// Pre-built kernels for every type/mode/width combination, packed into a single arena. Selecting a kernel is a lookup
+// of its ranges in the arena; nothing is allocated after init(). The arena can be uploaded as a single buffer, the
+// ranges are then used to index into it (see bfKernelBank in Convolution.glsl).
+//
+// Box and Binomial kernels don't change after init(). Gaussian kernels depend on sigma and are regenerated in place
+// (their size doesn't depend on sigma) by getKernel(); the modified part of the arena is tracked via getDirtyRange().
+
+#include <cstdint>
+
+namespace conv {
+
+// As per the TYPE/MODE defines in Convolution.glsl.
+enum KernelType_
+{
+	KernelType_Box,
+	KernelType_Gaussian,
+	KernelType_Binomial,
+
+	KernelType_Count
+};
+typedef int KernelType;
+
+enum KernelMode_
+{
+	KernelMode_2d,
+	KernelMode_2dBilinear,
+	KernelMode_Separable,
+	KernelMode_SeparableBilinear,
+
+	KernelMode_Count
+};
+typedef int KernelMode;
+
+inline bool IsKernelMode2d(KernelMode _mode)        { return _mode == KernelMode_2d || _mode == KernelMode_2dBilinear; }
+inline bool IsKernelModeBilinear(KernelMode _mode)  { return _mode == KernelMode_2dBilinear || _mode == KernelMode_SeparableBilinear; }
+
+class KernelBank
+{
+public:
+	static constexpr int kMinWidth     = 3;
+	static constexpr int kMaxWidth     = 21;
+	static constexpr int kWidthCount   = (kMaxWidth - kMinWidth) / 2 + 1;
+	static constexpr int kRangeAlign   = 64; // floats, ranges are aligned to 256 bytes (>= GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT)
+
+	// Range of floats in the arena.
+	struct Range
+	{
+		uint32_t m_offset;
+		uint32_t m_count;
+	};
+
+	struct Kernel
+	{
+		KernelType m_type;
+		KernelMode m_mode;
+		int        m_width;
+		int        m_tapCount;   // KERNEL_SIZE, <= the size of m_weights (see setBilinearMaxError())
+		float      m_sum;        // sum of the unnormalized weights
+		float      m_sigma;      // Gaussian only
+		Range      m_weights;    // m_tapCount floats
+		Range      m_offsets;    // m_tapCount floats for separable modes, m_tapCount xy pairs for 2d modes
+		Range      m_display;    // m_width unoptimized weights (the first row for 2d modes)
+	};
+
+	KernelBank() = default;
+	~KernelBank()                                               { shutdown(); }
+
+	KernelBank(const KernelBank&)            = delete;
+	KernelBank& operator=(const KernelBank&) = delete;
+
+	// Allocate the arena and generate all kernels. Gaussian kernels are generated with _gaussianSigma.
+	void          init(float _gaussianSigma = 1.0f);
+	void          shutdown();
+
+	// If _maxError > 0, 2d bilinear kernels are generated with KernelOptimizeBilinearGreedy2d() (their tap count is then
+	// <= the fixed 2x2 merge), else with KernelOptimizeBilinear2d(). Regenerates the 2d bilinear kernels if changed.
+	void          setBilinearMaxError(float _maxError);
+	float         getBilinearMaxError() const                   { return m_bilinearMaxError; }
+
+	// _width is forced to be odd and clamped to [kMinWidth, kMaxWidth]. For Gaussian kernels, if _gaussianSigma differs
+	// from the kernel's sigma the kernel is regenerated (and the dirty range updated).
+	const Kernel& getKernel(KernelType _type, KernelMode _mode, int _width, float _gaussianSigma = 1.0f);
+
+	const float*  get(const Range& _range) const                { return m_arena + _range.m_offset; }
+	const float*  getArena() const                              { return m_arena; }
+	uint32_t      getArenaCount() const                         { return m_arenaCount; }
+	uint32_t      getArenaSize() const                          { return m_arenaCount * (uint32_t)sizeof(float); }
+
+	// Sigma such that no weights are < 1/255 (GaussianFindSigma()), precomputed per width.
+	float         getOptimalSigma(int _width) const;
+
+	// Range of the arena modified since the last call to clearDirtyRange(), m_count is 0 if clean. init() marks the
+	// whole arena dirty.
+	Range         getDirtyRange() const                         { return m_dirty; }
+	void          clearDirtyRange()                             { m_dirty = { 0, 0 }; }
+
+private:
+	Kernel   m_kernels[KernelType_Count][KernelMode_Count][kWidthCount];
+	float    m_optimalSigma[kWidthCount];
+	float*   m_arena      = nullptr;
+	uint32_t m_arenaCount = 0;
+	Range    m_dirty      = { 0, 0 };
+	float    m_bilinearMaxError = 0.0f;
+	float*   m_bilinearScratch  = nullptr; // KernelOptimizeBilinearGreedy2d() outputs and temporaries, allocated by init()
+
+	Kernel&  getEntry(KernelType _type, KernelMode _mode, int _width)  { return m_kernels[_type][_mode][(_width - kMinWidth) / 2]; }
+	void     generate(KernelType _type, int _width, float _gaussianSigma);
+	void     generateBilinear2d(const Kernel& _kernel2d, Kernel& kernel2dBilinear_);
+	void     markDirty(const Range& _range);
+};
+
+} // namespace conv
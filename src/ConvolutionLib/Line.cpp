@@ -0,0 +1,188 @@
+#include "Line.h"
+
+#include "Half.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace conv {
+
+namespace {
+
+inline void ReadTexels(const char* _src, size_t _step, Format _format, int _count, float* dst_)
+{
+	if (_format == Format_RGBA8)
+	{
+		for (int i = 0; i < _count; ++i, _src += _step, dst_ += 4)
+		{
+			const uint8_t* texel = (const uint8_t*)_src;
+			dst_[0] = (float)texel[0] * (1.0f / 255.0f);
+			dst_[1] = (float)texel[1] * (1.0f / 255.0f);
+			dst_[2] = (float)texel[2] * (1.0f / 255.0f);
+			dst_[3] = (float)texel[3] * (1.0f / 255.0f);
+		}
+	}
+	else if (_format == Format_RGBA16F && _step == 8)
+	{
+		ConvertHalfToFloat((const uint16_t*)_src, dst_, (size_t)_count * 4);
+	}
+	else if (_format == Format_RGBA16F)
+	{
+		for (int i = 0; i < _count; ++i, _src += _step, dst_ += 4)
+		{
+			ConvertHalfToFloat((const uint16_t*)_src, dst_, 4);
+		}
+	}
+	else if (_step == 16)
+	{
+		memcpy(dst_, _src, (size_t)_count * 16);
+	}
+	else
+	{
+		for (int i = 0; i < _count; ++i, _src += _step, dst_ += 4)
+		{
+			memcpy(dst_, _src, 16);
+		}
+	}
+}
+
+inline uint8_t ToUnorm8(float _v)
+{
+	_v = _v < 0.0f ? 0.0f : (_v > 1.0f ? 1.0f : _v);
+	return (uint8_t)(_v * 255.0f + 0.5f);
+}
+
+inline void WriteTexels(char* _dst, size_t _step, Format _format, int _count, const float* _src)
+{
+	if (_format == Format_RGBA8)
+	{
+		for (int i = 0; i < _count; ++i, _dst += _step, _src += 4)
+		{
+			uint8_t* texel = (uint8_t*)_dst;
+			texel[0] = ToUnorm8(_src[0]);
+			texel[1] = ToUnorm8(_src[1]);
+			texel[2] = ToUnorm8(_src[2]);
+			texel[3] = ToUnorm8(_src[3]);
+		}
+	}
+	else if (_format == Format_RGBA16F && _step == 8)
+	{
+		ConvertFloatToHalf(_src, (uint16_t*)_dst, (size_t)_count * 4);
+	}
+	else if (_format == Format_RGBA16F)
+	{
+		for (int i = 0; i < _count; ++i, _dst += _step, _src += 4)
+		{
+			ConvertFloatToHalf(_src, (uint16_t*)_dst, 4);
+		}
+	}
+	else if (_step == 16)
+	{
+		memcpy(_dst, _src, (size_t)_count * 16);
+	}
+	else
+	{
+		for (int i = 0; i < _count; ++i, _dst += _step, _src += 4)
+		{
+			memcpy(_dst, _src, 16);
+		}
+	}
+}
+
+} // namespace
+
+void ReadLine(const Image& _img, Direction _direction, int _line, int _begin, int _count, float* texels_)
+{
+	assert(_line >= 0 && _line < GetLineCount(_img, _direction));
+
+	const size_t texelSize = _img.getTexelSize();
+	const size_t step      = _direction == Direction_Horizontal ? texelSize : _img.getStride();
+	const char*  base      = _direction == Direction_Horizontal ? (const char*)_img.getRow(_line) : (const char*)_img.getData() + texelSize * (size_t)_line;
+	const int    length    = GetLineLength(_img, _direction);
+
+ // clamp to edge before/after the image
+	int end = _begin + _count;
+	while (_begin < 0 && _begin < end)
+	{
+		ReadTexels(base, step, _img.getFormat(), 1, texels_);
+		texels_ += 4;
+		++_begin;
+	}
+	int interiorEnd = end < length ? end : length;
+	if (interiorEnd > _begin)
+	{
+		ReadTexels(base + step * (size_t)_begin, step, _img.getFormat(), interiorEnd - _begin, texels_);
+		texels_ += 4 * (interiorEnd - _begin);
+		_begin = interiorEnd;
+	}
+	while (_begin < end)
+	{
+		ReadTexels(base + step * (size_t)(length - 1), step, _img.getFormat(), 1, texels_);
+		texels_ += 4;
+		++_begin;
+	}
+}
+
+void WriteLine(Image& img_, Direction _direction, int _line, int _begin, int _count, const float* _texels)
+{
+	assert(_line >= 0 && _line < GetLineCount(img_, _direction));
+	assert(_begin >= 0 && _begin + _count <= GetLineLength(img_, _direction));
+
+	const size_t texelSize = img_.getTexelSize();
+	const size_t step      = _direction == Direction_Horizontal ? texelSize : img_.getStride();
+	char*        base      = _direction == Direction_Horizontal ? (char*)img_.getRow(_line) : (char*)img_.getData() + texelSize * (size_t)_line;
+	WriteTexels(base + step * (size_t)_begin, step, img_.getFormat(), _count, _texels);
+}
+
+void ReadLine8(const Image& _img, Direction _direction, int _line, int _begin, int _count, uint8_t* texels_)
+{
+	assert(_img.getFormat() == Format_RGBA8);
+	assert(_line >= 0 && _line < GetLineCount(_img, _direction));
+
+	const size_t step   = _direction == Direction_Horizontal ? 4 : _img.getStride();
+	const char*  base   = _direction == Direction_Horizontal ? (const char*)_img.getRow(_line) : (const char*)_img.getData() + 4 * (size_t)_line;
+	const int    length = GetLineLength(_img, _direction);
+
+ // clamp to edge before/after the image, rows are contiguous
+	const int end = _begin + _count;
+	for (; _begin < 0 && _begin < end; ++_begin, texels_ += 4)
+	{
+		memcpy(texels_, base, 4);
+	}
+	const int interiorEnd = end < length ? end : length;
+	if (_direction == Direction_Horizontal && interiorEnd > _begin)
+	{
+		memcpy(texels_, base + 4 * (size_t)_begin, 4 * (size_t)(interiorEnd - _begin));
+		texels_ += 4 * (interiorEnd - _begin);
+		_begin = interiorEnd;
+	}
+	for (; _begin < interiorEnd; ++_begin, texels_ += 4)
+	{
+		memcpy(texels_, base + step * (size_t)_begin, 4);
+	}
+	for (; _begin < end; ++_begin, texels_ += 4)
+	{
+		memcpy(texels_, base + step * (size_t)(length - 1), 4);
+	}
+}
+
+void WriteLine8(Image& img_, Direction _direction, int _line, int _begin, int _count, const uint8_t* _texels)
+{
+	assert(img_.getFormat() == Format_RGBA8);
+	assert(_line >= 0 && _line < GetLineCount(img_, _direction));
+	assert(_begin >= 0 && _begin + _count <= GetLineLength(img_, _direction));
+
+	const size_t step = _direction == Direction_Horizontal ? 4 : img_.getStride();
+	char*        dst  = (_direction == Direction_Horizontal ? (char*)img_.getRow(_line) : (char*)img_.getData() + 4 * (size_t)_line) + step * (size_t)_begin;
+	if (_direction == Direction_Horizontal)
+	{
+		memcpy(dst, _texels, (size_t)_count * 4);
+		return;
+	}
+	for (int i = 0; i < _count; ++i, dst += step, _texels += 4)
+	{
+		memcpy(dst, _texels, 4);
+	}
+}
+
+} // namespace conv
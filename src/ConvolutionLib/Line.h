@@ -0,0 +1,35 @@
+#pragma once
+
+// Line access for the 1d passes. A line is a row (Direction_Horizontal) or a column (Direction_Vertical) of an image,
+// read/written as RGBA float (4 floats per texel).
+
+#include "Image.h"
+
+namespace conv {
+
+enum Direction_
+{
+	Direction_Horizontal,
+	Direction_Vertical,
+
+	Direction_Count
+};
+typedef int Direction;
+
+// Length of lines along _direction (i.e. the width for horizontal lines).
+inline int GetLineLength(const Image& _img, Direction _direction)   { return _direction == Direction_Horizontal ? _img.getWidth() : _img.getHeight(); }
+// Number of lines along _direction (i.e. the height for horizontal lines).
+inline int GetLineCount(const Image& _img, Direction _direction)    { return _direction == Direction_Horizontal ? _img.getHeight() : _img.getWidth(); }
+
+// Read texels [_begin, _begin + _count) of line _line into texels_. Texels outside the image are clamped to the edge.
+void ReadLine(const Image& _img, Direction _direction, int _line, int _begin, int _count, float* texels_);
+
+// Write texels [_begin, _begin + _count) of line _line from _texels. The range must be inside the image.
+void WriteLine(Image& img_, Direction _direction, int _line, int _begin, int _count, const float* _texels);
+
+// As ReadLine()/WriteLine() but texels are raw RGBA8 (4 bytes per texel), _img must be Format_RGBA8. Used by the fixed
+// point passes (see ConvolveFixed.h).
+void ReadLine8(const Image& _img, Direction _direction, int _line, int _begin, int _count, uint8_t* texels_);
+void WriteLine8(Image& img_, Direction _direction, int _line, int _begin, int _count, const uint8_t* _texels);
+
+} // namespace conv
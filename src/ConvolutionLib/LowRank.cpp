@@ -0,0 +1,258 @@
+#include "LowRank.h"
+
+#include "Schedule.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace conv {
+
+namespace {
+
+// SVD of the _n x _n matrix a_ (row major) via one-sided Jacobi (Hestenes): rotate pairs of columns until they're
+// orthogonal, a_ becomes U * S and v_ (row major, _n x _n) accumulates V. Return the number of sweeps.
+int JacobiSvd(double* a_, double* v_, int _n)
+{
+	for (int i = 0; i < _n * _n; ++i)
+	{
+		v_[i] = (i / _n) == (i % _n) ? 1.0 : 0.0;
+	}
+
+	const double kEpsilon = 1e-12;
+	int sweep = 0;
+	for (bool rotated = true; rotated && sweep < 64; ++sweep)
+	{
+		rotated = false;
+		for (int p = 0; p < _n - 1; ++p)
+		{
+			for (int q = p + 1; q < _n; ++q)
+			{
+				double alpha = 0.0, beta = 0.0, gamma = 0.0;
+				for (int i = 0; i < _n; ++i)
+				{
+					const double ap = a_[i * _n + p];
+					const double aq = a_[i * _n + q];
+					alpha += ap * ap;
+					beta  += aq * aq;
+					gamma += ap * aq;
+				}
+				if (fabs(gamma) <= kEpsilon * sqrt(alpha * beta) || gamma == 0.0)
+				{
+					continue;
+				}
+				rotated = true;
+
+				const double zeta = (beta - alpha) / (2.0 * gamma);
+				const double t    = (zeta >= 0.0 ? 1.0 : -1.0) / (fabs(zeta) + sqrt(1.0 + zeta * zeta));
+				const double c    = 1.0 / sqrt(1.0 + t * t);
+				const double s    = c * t;
+				for (int i = 0; i < _n; ++i)
+				{
+					double* ap = a_ + i * _n + p;
+					double* aq = a_ + i * _n + q;
+					const double a0 = *ap;
+					*ap = c * a0 - s * *aq;
+					*aq = s * a0 + c * *aq;
+
+					double* vp = v_ + i * _n + p;
+					double* vq = v_ + i * _n + q;
+					const double v0 = *vp;
+					*vp = c * v0 - s * *vq;
+					*vq = s * v0 + c * *vq;
+				}
+			}
+		}
+	}
+	return sweep;
+}
+
+} // namespace
+
+bool LowRankKernel::init(const float* _weights, int _size, float _tolerance, int _maxRank)
+{
+	assert(_size > 0);
+	shutdown();
+	_maxRank = _maxRank <= 0 || _maxRank > _size ? _size : _maxRank;
+
+	const int n = _size;
+	double* a = new double[n * n * 2];
+	double* v = a + n * n;
+	float maxWeight = 0.0f;
+	for (int i = 0; i < n * n; ++i)
+	{
+		a[i] = (double)_weights[i];
+		maxWeight = fabsf(_weights[i]) > maxWeight ? fabsf(_weights[i]) : maxWeight;
+	}
+	JacobiSvd(a, v, n);
+
+ // singular values are the column norms of a, sort the columns by descending singular value
+	int*    order = new int[n];
+	double* norms = new double[n];
+	for (int j = 0; j < n; ++j)
+	{
+		double norm = 0.0;
+		for (int i = 0; i < n; ++i)
+		{
+			norm += a[i * n + j] * a[i * n + j];
+		}
+		norms[j] = sqrt(norm);
+		order[j] = j;
+	}
+	for (int i = 1; i < n; ++i)
+	{
+		for (int j = i; j > 0 && norms[order[j]] > norms[order[j - 1]]; --j)
+		{
+			const int tmp = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = tmp;
+		}
+	}
+
+	m_size           = n;
+	m_singularValues = new float[n];
+	m_factors        = new float[_maxRank * 2 * n];
+	for (int k = 0; k < n; ++k)
+	{
+		m_singularValues[k] = (float)norms[order[k]];
+	}
+
+ // add terms until the residual is within the tolerance; column j of a is s_j * u_j
+	float* residual = new float[n * n];
+	memcpy(residual, _weights, sizeof(float) * n * n);
+	m_error = maxWeight > 0.0f ? 1.0f : 0.0f;
+	m_rank  = 0;
+	while (m_rank < _maxRank && m_error > _tolerance)
+	{
+		const int j = order[m_rank];
+		const double s = norms[j];
+		if (s == 0.0)
+		{
+			break;
+		}
+		float* row = m_factors + m_rank * 2 * n;
+		float* col = row + n;
+		const double scale = 1.0 / sqrt(s); // (s * u) / sqrt(s) and v * sqrt(s)
+		for (int i = 0; i < n; ++i)
+		{
+			col[i] = (float)(a[i * n + j] * scale);
+			row[i] = (float)(v[i * n + j] * s * scale);
+		}
+		++m_rank;
+
+		float maxError = 0.0f;
+		for (int y = 0; y < n; ++y)
+		{
+			for (int x = 0; x < n; ++x)
+			{
+				residual[y * n + x] -= col[y] * row[x];
+				maxError = fabsf(residual[y * n + x]) > maxError ? fabsf(residual[y * n + x]) : maxError;
+			}
+		}
+		m_error = maxError / maxWeight;
+	}
+	delete[] residual;
+	delete[] order;
+	delete[] norms;
+	delete[] a;
+
+	float* offsets = new float[n];
+	for (int i = 0; i < n; ++i)
+	{
+		offsets[i] = (float)(i - n / 2);
+	}
+	m_rowKernels = new SeparableKernel[m_rank > 0 ? m_rank : 1];
+	m_colKernels = new SeparableKernel[m_rank > 0 ? m_rank : 1];
+	for (int k = 0; k < m_rank; ++k)
+	{
+		m_rowKernels[k].init(m_factors + k * 2 * n, offsets, n);
+		m_colKernels[k].init(m_factors + k * 2 * n + n, offsets, n);
+	}
+	delete[] offsets;
+
+	return m_error <= _tolerance;
+}
+
+void LowRankKernel::shutdown()
+{
+	delete[] m_singularValues;
+	delete[] m_factors;
+	delete[] m_rowKernels;
+	delete[] m_colKernels;
+	m_singularValues = nullptr;
+	m_factors        = nullptr;
+	m_rowKernels     = nullptr;
+	m_colKernels     = nullptr;
+	m_size           = 0;
+	m_rank           = 0;
+	m_error          = 0.0f;
+}
+
+void LowRankKernel::reconstruct(float* weights_) const
+{
+	const int n = m_size;
+	memset(weights_, 0, sizeof(float) * n * n);
+	for (int k = 0; k < m_rank; ++k)
+	{
+		const float* row = m_factors + k * 2 * n;
+		const float* col = row + n;
+		for (int y = 0; y < n; ++y)
+		{
+			for (int x = 0; x < n; ++x)
+			{
+				weights_[y * n + x] += col[y] * row[x];
+			}
+		}
+	}
+}
+
+namespace {
+
+// Per-term views of tmp_, which holds the horizontal pass for each term stacked vertically.
+Image* InitTermViews(const Image& _dst, Image& tmp_, int _rank)
+{
+	const int width  = _dst.getWidth();
+	const int height = _dst.getHeight();
+	tmp_.init(width, height * _rank, Format_RGBA32F);
+	Image* ret = new Image[_rank];
+	for (int k = 0; k < _rank; ++k)
+	{
+		ret[k].initView(width, height, Format_RGBA32F, tmp_.getRow(k * height), tmp_.getStride());
+	}
+	return ret;
+}
+
+} // namespace
+
+void ConvolveLowRank(const Image& _src, Image& dst_, Image& tmp_, const LowRankKernel& _kernel)
+{
+	assert(_kernel.getRank() > 0);
+	Image* terms = InitTermViews(dst_, tmp_, _kernel.getRank());
+	for (int k = 0; k < _kernel.getRank(); ++k)
+	{
+		ConvolvePass(_src, terms[k], _kernel.getRowKernels()[k], Direction_Horizontal);
+	}
+	ConvolvePassSum(terms, dst_, _kernel.getColKernels(), _kernel.getRank(), Direction_Vertical);
+	delete[] terms;
+}
+
+void ConvolveLowRank(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const LowRankKernel& _kernel, int _bandHeight)
+{
+	assert(_kernel.getRank() > 0);
+	Image* terms = InitTermViews(dst_, tmp_, _kernel.getRank());
+	const int radius = _kernel.getSize() / 2;
+	RunSeparablePasses(_pool, dst_.getHeight(), -radius, radius, _bandHeight,
+		[&](int _rowBegin, int _rowEnd)
+		{
+			for (int k = 0; k < _kernel.getRank(); ++k)
+			{
+				ConvolvePass(_src, terms[k], _kernel.getRowKernels()[k], Direction_Horizontal, _rowBegin, _rowEnd);
+			}
+		},
+		[&](int _rowBegin, int _rowEnd) { ConvolvePassSum(terms, dst_, _kernel.getColKernels(), _kernel.getRank(), Direction_Vertical, _rowBegin, _rowEnd); }
+		);
+	delete[] terms;
+}
+
+} // namespace conv
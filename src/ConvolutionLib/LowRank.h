@@ -0,0 +1,59 @@
+#pragma once
+
+// Low rank separable decomposition of arbitrary 2d kernels. The SVD of the kernel, W = sum(s_k * u_k * v_k^T), gives
+// rank 1 terms which are each a separable kernel (horizontal v_k, vertical u_k scaled by sqrt(s_k)). Truncating to the
+// smallest rank which is within an error tolerance gives a sum of separable passes, i.e. 2 * rank * _size taps per
+// texel instead of _size^2. Exactly separable kernels (KernelGaussian2d(), KernelBinomial2d()) are rank 1.
+
+#include "Convolve.h"
+
+namespace conv {
+
+class ThreadPool;
+
+class LowRankKernel
+{
+public:
+	LowRankKernel() = default;
+	~LowRankKernel()                                      { shutdown(); }
+
+	LowRankKernel(const LowRankKernel&)            = delete;
+	LowRankKernel& operator=(const LowRankKernel&) = delete;
+
+	// Decompose a _size x _size kernel (row major, as per Convolve2d()). Find the smallest rank <= _maxRank (0 = _size)
+	// for which the max absolute error of the reconstructed weights is <= _tolerance * the largest absolute weight. Return
+	// false if _maxRank terms aren't sufficient, in which case the kernel is truncated to _maxRank terms.
+	bool         init(const float* _weights, int _size, float _tolerance = 1e-3f, int _maxRank = 0);
+	void         shutdown();
+
+	int          getSize() const                          { return m_size; }
+	int          getRank() const                          { return m_rank; }
+	// Max absolute error of the truncated kernel relative to the largest absolute weight.
+	float        getError() const                         { return m_error; }
+	// getSize() singular values in descending order.
+	const float* getSingularValues() const                { return m_singularValues; }
+
+	const SeparableKernel* getRowKernels() const          { return m_rowKernels; }
+	const SeparableKernel* getColKernels() const          { return m_colKernels; }
+
+	// Write the weights of the truncated kernel to weights_ (_size^2).
+	void         reconstruct(float* weights_) const;
+
+private:
+	int              m_size           = 0;
+	int              m_rank           = 0;
+	float            m_error          = 0.0f;
+	float*           m_singularValues = nullptr;
+	float*           m_factors        = nullptr; // rank x (row, col) x size, scaled by sqrt(s_k)
+	SeparableKernel* m_rowKernels     = nullptr; // horizontal pass per term
+	SeparableKernel* m_colKernels     = nullptr; // vertical pass per term
+};
+
+// Horizontal pass per term into tmp_, then a single vertical pass which sums the terms. tmp_ is (re)initialized as
+// RGBA32F with a height of getRank() * the image height.
+void ConvolveLowRank(const Image& _src, Image& dst_, Image& tmp_, const LowRankKernel& _kernel);
+
+// Multi-threaded ConvolveLowRank(), scheduled as per ConvolveSeparable().
+void ConvolveLowRank(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const LowRankKernel& _kernel, int _bandHeight = 0);
+
+} // namespace conv
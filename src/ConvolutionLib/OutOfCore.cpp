@@ -0,0 +1,257 @@
+#include "OutOfCore.h"
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+#ifdef _MSC_VER
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace conv {
+
+namespace {
+
+// Copy the _width x _height region of _src at _x, _y into img_, texels outside _src are clamped to the edge (as per
+// ReadLine()). img_ must have the same format as _src.
+void ReadRegionClamped(const Image& _src, int _x, int _y, int _width, int _height, Image& img_)
+{
+	const size_t texelSize = _src.getTexelSize();
+	const int    srcWidth  = _src.getWidth();
+	const int    srcHeight = _src.getHeight();
+	const int    x0 = _x < 0 ? 0 : _x;
+	const int    x1 = _x + _width > srcWidth ? srcWidth : _x + _width;
+	for (int y = 0; y < _height; ++y)
+	{
+		const int   srcY   = _y + y < 0 ? 0 : (_y + y >= srcHeight ? srcHeight - 1 : _y + y);
+		const char* srcRow = (const char*)_src.getRow(srcY);
+		char*       dstRow = (char*)img_.getRow(y);
+		memcpy(dstRow + (x0 - _x) * texelSize, srcRow + x0 * texelSize, (x1 - x0) * texelSize);
+		for (int x = _x; x < x0; ++x)
+		{
+			memcpy(dstRow + (x - _x) * texelSize, srcRow, texelSize);
+		}
+		for (int x = x1; x < _x + _width; ++x)
+		{
+			memcpy(dstRow + (x - _x) * texelSize, srcRow + (srcWidth - 1) * texelSize, texelSize);
+		}
+	}
+}
+
+} // namespace
+
+bool MappedImage::open(const char* _path, int _width, int _height, Format _format, bool _write, size_t _offset)
+{
+	close();
+	if (_width <= 0 || _height <= 0)
+	{
+		return false;
+	}
+	const size_t stride   = (size_t)_width * GetTexelSize(_format);
+	const size_t fileSize = _offset + stride * (size_t)_height;
+
+	#ifdef _MSC_VER
+		HANDLE file = CreateFileA(_path, GENERIC_READ | (_write ? GENERIC_WRITE : 0), FILE_SHARE_READ, nullptr, _write ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || (!_write && (size_t)size.QuadPart < fileSize))
+		{
+			CloseHandle(file);
+			return false;
+		}
+	 // a mapping larger than the file extends the file
+		HANDLE fileMap = CreateFileMappingA(file, nullptr, _write ? PAGE_READWRITE : PAGE_READONLY, (DWORD)((uint64_t)fileSize >> 32), (DWORD)fileSize, nullptr);
+		if (!fileMap)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		const size_t mapBegin = _offset / systemInfo.dwAllocationGranularity * systemInfo.dwAllocationGranularity;
+		m_mapping = MapViewOfFile(fileMap, _write ? FILE_MAP_WRITE : FILE_MAP_READ, (DWORD)((uint64_t)mapBegin >> 32), (DWORD)mapBegin, fileSize - mapBegin);
+		if (!m_mapping)
+		{
+			CloseHandle(fileMap);
+			CloseHandle(file);
+			return false;
+		}
+		m_file    = file;
+		m_fileMap = fileMap;
+	#else
+		int file = ::open(_path, _write ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+		if (file < 0)
+		{
+			return false;
+		}
+		struct stat st;
+		if (fstat(file, &st) != 0 || (!_write && (size_t)st.st_size < fileSize) || (_write && (size_t)st.st_size < fileSize && ftruncate(file, (off_t)fileSize) != 0))
+		{
+			::close(file);
+			return false;
+		}
+		const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		const size_t mapBegin = _offset / pageSize * pageSize;
+		void* mapping = mmap(nullptr, fileSize - mapBegin, PROT_READ | (_write ? PROT_WRITE : 0), MAP_SHARED, file, (off_t)mapBegin);
+		if (mapping == MAP_FAILED)
+		{
+			::close(file);
+			return false;
+		}
+		m_mapping = mapping;
+		m_file    = file;
+	#endif
+
+	m_mappingSize = fileSize - mapBegin;
+	m_offset      = _offset - mapBegin;
+	m_write       = _write;
+	m_image.initView(_width, _height, _format, (char*)m_mapping + m_offset, stride);
+	return true;
+}
+
+void MappedImage::close()
+{
+	if (!m_mapping)
+	{
+		return;
+	}
+	m_image.shutdown();
+	#ifdef _MSC_VER
+		UnmapViewOfFile(m_mapping);
+		CloseHandle((HANDLE)m_fileMap);
+		CloseHandle((HANDLE)m_file);
+		m_fileMap = nullptr;
+		m_file    = nullptr;
+	#else
+		munmap(m_mapping, m_mappingSize);
+		::close(m_file);
+		m_file = -1;
+	#endif
+	m_mapping     = nullptr;
+	m_mappingSize = 0;
+}
+
+void MappedImage::release(int _rowBegin, int _rowEnd)
+{
+	if (!m_mapping || _rowEnd <= _rowBegin)
+	{
+		return;
+	}
+
+ // pages shared with neighbouring rows are released too, they're simply read back if accessed
+	#ifdef _MSC_VER
+		const size_t pageSize = 4096;
+	#else
+		const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	#endif
+	size_t begin = m_offset + m_image.getStride() * (size_t)_rowBegin;
+	size_t end   = m_offset + m_image.getStride() * (size_t)_rowEnd;
+	begin = begin / pageSize * pageSize;
+	end   = (end + pageSize - 1) / pageSize * pageSize;
+	end   = end > m_mappingSize ? m_mappingSize : end;
+	char* ptr = (char*)m_mapping + begin;
+
+	#ifdef _MSC_VER
+		if (m_write)
+		{
+			FlushViewOfFile(ptr, end - begin);
+		}
+		VirtualUnlock(ptr, end - begin); // removes unlocked pages from the working set
+	#else
+		if (m_write)
+		{
+			msync(ptr, end - begin, MS_ASYNC);
+		}
+		madvise(ptr, end - begin, MADV_DONTNEED);
+	#endif
+}
+
+void ConvolveSeparableTiled(ThreadPool& _pool, MappedImage& _src, MappedImage& dst_, const SeparableKernel& _kernel, int _tileSize, TiledConvolveStats* stats_)
+{
+	const Image& src = _src.getImage();
+	Image&       dst = dst_.getImage();
+	assert(src.getWidth() == dst.getWidth() && src.getHeight() == dst.getHeight());
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	const int width     = dst.getWidth();
+	const int height    = dst.getHeight();
+	const int tileSize  = _tileSize < 16 ? 16 : _tileSize;
+	const int padBefore = -_kernel.getMinOffset();
+	const int padAfter  = _kernel.getMaxOffset();
+	const int haloSize  = padBefore + tileSize + padAfter;
+	const size_t tileScratchBytes = (size_t)haloSize * haloSize * (src.getTexelSize() + dst.getTexelSize() * 2);
+
+	std::atomic<size_t> scratchBytes = { 0 };
+	std::atomic<size_t> peakScratchBytes = { 0 };
+	int tileCount = 0;
+	int srcReleased = 0;
+	for (int y0 = 0; y0 < height; y0 += tileSize)
+	{
+		const int y1 = y0 + tileSize < height ? y0 + tileSize : height;
+		ThreadPool::TaskGroup group;
+		for (int x0 = 0; x0 < width; x0 += tileSize)
+		{
+			const int x1 = x0 + tileSize < width ? x0 + tileSize : width;
+			++tileCount;
+			_pool.run(group, [&, x0, y0, x1, y1]()
+				{
+					const int tileWidth  = x1 - x0;
+					const int tileHeight = y1 - y0;
+					Image tileSrc(padBefore + tileWidth + padAfter, padBefore + tileHeight + padAfter, src.getFormat());
+					Image tileDst(tileSrc.getWidth(), tileSrc.getHeight(), dst.getFormat());
+					Image tileTmp; // allocated by ConvolveSeparableRect(), the size of tileDst
+
+					const size_t bytes = tileSrc.getSize() + tileDst.getSize() * 2;
+					const size_t current = scratchBytes.fetch_add(bytes) + bytes;
+					size_t peak = peakScratchBytes.load();
+					while (current > peak && !peakScratchBytes.compare_exchange_weak(peak, current));
+
+				 // the halo is clamped at the image edges, hence the tile's clamped reads at the halo edges match the reads
+				 // of the whole image
+					ReadRegionClamped(src, x0 - padBefore, y0 - padBefore, tileSrc.getWidth(), tileSrc.getHeight(), tileSrc);
+					ConvolveSeparableRect(tileSrc, tileDst, tileTmp, _kernel, Rect(padBefore, padBefore, padBefore + tileWidth, padBefore + tileHeight));
+					const size_t texelSize = dst.getTexelSize();
+					for (int y = 0; y < tileHeight; ++y)
+					{
+						memcpy((char*)dst.getRow(y0 + y) + x0 * texelSize, (const char*)tileDst.getRow(padBefore + y) + padBefore * texelSize, tileWidth * texelSize);
+					}
+
+					scratchBytes.fetch_sub(bytes);
+				});
+		}
+		_pool.wait(group);
+
+	 // the next row of tiles reads source rows from y1 - padBefore
+		dst_.release(y0, y1);
+		const int srcReleaseEnd = y1 - padBefore < height ? y1 - padBefore : height;
+		if (srcReleaseEnd > srcReleased)
+		{
+			_src.release(srcReleased, srcReleaseEnd);
+			srcReleased = srcReleaseEnd;
+		}
+	}
+	_src.release(srcReleased, height);
+
+	if (stats_)
+	{
+		stats_->m_tileCount        = tileCount;
+		stats_->m_peakScratchBytes = peakScratchBytes.load();
+		stats_->m_tileScratchBytes = tileScratchBytes;
+		stats_->m_ms               = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+} // namespace conv
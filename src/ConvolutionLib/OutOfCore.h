@@ -0,0 +1,65 @@
+#pragma once
+
+// Out-of-core separable convolution of images which don't fit in memory. Images are raw files (tightly packed rows,
+// see Image) which are memory mapped; ConvolveSeparableTiled() convolves tiles on a ThreadPool, each task copies its
+// tile plus a halo of the kernel radius from the source mapping into a scratch image, convolves it and copies the
+// result to the destination mapping. Heap memory is bounded by the tile size x the thread count. Mapped pages are
+// written back and released after each row of tiles, so the resident part of the files is bounded by a row of tiles.
+
+#include "Convolve.h"
+
+#include <cstddef>
+
+namespace conv {
+
+class ThreadPool;
+
+class MappedImage
+{
+public:
+	MappedImage() = default;
+	~MappedImage()                                   { close(); }
+
+	MappedImage(const MappedImage&)            = delete;
+	MappedImage& operator=(const MappedImage&) = delete;
+
+	// Map _path as a _width x _height image in _format, starting _offset bytes into the file. If _write the file is
+	// created (or resized) as required, else it must exist and be large enough. Return false on failure.
+	bool         open(const char* _path, int _width, int _height, Format _format, bool _write, size_t _offset = 0);
+	void         close();
+
+	// View of the mapping, empty if not open.
+	const Image& getImage() const                    { return m_image; }
+	Image&       getImage()                          { return m_image; }
+
+	// Write back rows [_rowBegin, _rowEnd) (if open for writing) and release them from memory. The rows remain valid,
+	// accessing them reads them back from the file.
+	void         release(int _rowBegin, int _rowEnd);
+
+private:
+	Image  m_image;
+	void*  m_mapping     = nullptr;
+	size_t m_mappingSize = 0;
+	size_t m_offset      = 0;      // of m_image in the mapping (the mapping starts at a page boundary)
+	bool   m_write       = false;
+	#ifdef _MSC_VER
+		void* m_file     = nullptr; // HANDLE
+		void* m_fileMap  = nullptr; // HANDLE
+	#else
+		int   m_file     = -1;
+	#endif
+};
+
+struct TiledConvolveStats
+{
+	int    m_tileCount         = 0;
+	size_t m_peakScratchBytes  = 0;  // max heap memory in use by the tile tasks
+	size_t m_tileScratchBytes  = 0;  // per tile task
+	double m_ms                = 0.0;
+};
+
+// Convolve _src into dst_ (which must be the same size, the formats may differ) in _tileSize x _tileSize tiles. The
+// result is identical to ConvolveSeparable().
+void ConvolveSeparableTiled(ThreadPool& _pool, MappedImage& _src, MappedImage& dst_, const SeparableKernel& _kernel, int _tileSize = 512, TiledConvolveStats* stats_ = nullptr);
+
+} // namespace conv
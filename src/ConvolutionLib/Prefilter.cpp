@@ -0,0 +1,488 @@
+#include "Prefilter.h"
+
+#include "Convolve.h"
+#include "Kernel.h"
+#include "Line.h"
+#include "SamplePattern.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+#include <string>
+#include <vector>
+
+namespace conv {
+
+namespace {
+
+// As Noise_InterleavedGradient() (common/shaders/Noise.glsl).
+inline float InterleavedGradientNoise(float _x, float _y)
+{
+	const float f = _x * 0.06711056f + _y * 0.00583715f;
+	const float g = 52.9829189f * (f - floorf(f));
+	return g - floorf(g);
+}
+
+// Bilinear sample of _level at normalized coordinates (_u, _v), GL_CLAMP_TO_EDGE.
+inline __m128 SampleBilinear(const Image& _level, float _u, float _v)
+{
+	const int width  = _level.getWidth();
+	const int height = _level.getHeight();
+	const float px = _u * (float)width - 0.5f;
+	const float py = _v * (float)height - 0.5f;
+	const float x0f = floorf(px);
+	const float y0f = floorf(py);
+	const __m128 fx = _mm_set1_ps(px - x0f);
+	const __m128 fy = _mm_set1_ps(py - y0f);
+	int x0 = (int)x0f, x1 = x0 + 1;
+	int y0 = (int)y0f, y1 = y0 + 1;
+	x0 = x0 < 0 ? 0 : (x0 >= width  ? width  - 1 : x0);
+	x1 = x1 < 0 ? 0 : (x1 >= width  ? width  - 1 : x1);
+	y0 = y0 < 0 ? 0 : (y0 >= height ? height - 1 : y0);
+	y1 = y1 < 0 ? 0 : (y1 >= height ? height - 1 : y1);
+	const float* row0 = (const float*)_level.getRow(y0);
+	const float* row1 = (const float*)_level.getRow(y1);
+	const __m128 a = _mm_loadu_ps(row0 + x0 * 4);
+	const __m128 b = _mm_loadu_ps(row0 + x1 * 4);
+	const __m128 c = _mm_loadu_ps(row1 + x0 * 4);
+	const __m128 d = _mm_loadu_ps(row1 + x1 * 4);
+	const __m128 r0 = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fx));
+	const __m128 r1 = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), fx));
+	return _mm_add_ps(r0, _mm_mul_ps(_mm_sub_ps(r1, r0), fy));
+}
+
+// RGB PSNR of _b vs. _a, as per the ConvolutionBench PSNR.
+double GetPsnr(const Image& _a, const Image& _b)
+{
+	std::vector<float> a(_a.getWidth() * 4), b(_b.getWidth() * 4);
+	double sumSquaredError = 0.0;
+	for (int y = 0; y < _a.getHeight(); ++y)
+	{
+		ReadLine(_a, Direction_Horizontal, y, 0, _a.getWidth(), a.data());
+		ReadLine(_b, Direction_Horizontal, y, 0, _b.getWidth(), b.data());
+		for (int x = 0; x < _a.getWidth(); ++x)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const double err = (double)a[x * 4 + c] - (double)b[x * 4 + c];
+				sumSquaredError += err * err;
+			}
+		}
+	}
+	const double mse = sumSquaredError / ((double)_a.getWidth() * (double)_a.getHeight() * 3.0);
+	return mse > 0.0 ? 10.0 * log10(1.0 / mse) : 99.0;
+}
+
+// Find the value of "_key" in [_begin, _end), return false if not found.
+bool FindNumber(const char* _begin, const char* _end, const char* _key, float* value_)
+{
+	std::string key = std::string("\"") + _key + "\"";
+	const char* c = strstr(_begin, key.c_str());
+	if (!c || c >= _end)
+	{
+		return false;
+	}
+	c = strchr(c + key.size(), ':');
+	if (!c || c >= _end)
+	{
+		return false;
+	}
+	*value_ = strtof(c + 1, nullptr);
+	return true;
+}
+
+// Extent [begin_, end_) of the value of the "PrefilterTable" member of _json ('{' to the matching '}' inclusive) and
+// the start of the member's name (the opening quote), return false if not found.
+bool FindTable(const char* _json, const char** name_, const char** begin_, const char** end_)
+{
+	const char* name = strstr(_json, "\"PrefilterTable\"");
+	if (!name)
+	{
+		return false;
+	}
+	const char* begin = strchr(name, '{');
+	if (!begin)
+	{
+		return false;
+	}
+	int depth = 0;
+	for (const char* c = begin; *c != '\0'; ++c)
+	{
+		depth += *c == '{' ? 1 : (*c == '}' ? -1 : 0);
+		if (depth == 0)
+		{
+			*name_  = name;
+			*begin_ = begin;
+			*end_   = c + 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string ReadTextFile(const char* _path, bool* exists_)
+{
+	std::string ret;
+	FILE* file = fopen(_path, "rb");
+	*exists_ = file != nullptr;
+	if (file)
+	{
+		char buf[4096];
+		size_t n;
+		while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+		{
+			ret.append(buf, n);
+		}
+		fclose(file);
+	}
+	return ret;
+}
+
+} // namespace
+
+float GetPrefilterLod(float _radius, int _sampleCount, float _lodBias)
+{
+	const float area = kPi * _radius * _radius / (float)(_sampleCount < 1 ? 1 : _sampleCount); // area per sample
+	return log2f(sqrtf(area)) + _lodBias;
+}
+
+float GetPrefilterReferenceSigma(float _radius)
+{
+	return _radius / sqrtf(3.0f);
+}
+
+void InitPrefilterReference(const Image& _src, float _radius, Image& reference_)
+{
+	const float sigma = GetPrefilterReferenceSigma(_radius);
+	const int   size  = (int)ceilf(sigma * 3.0f) * 2 + 1;
+	std::vector<float> weights(size), offsets(size);
+	KernelGaussian1d(size, sigma, weights.data());
+	for (int i = 0; i < size; ++i)
+	{
+		offsets[i] = (float)(i - size / 2);
+	}
+	SeparableKernel kernel;
+	kernel.init(weights.data(), offsets.data(), size);
+	Image tmp;
+	reference_.init(_src.getWidth(), _src.getHeight(), Format_RGBA32F);
+	ConvolveSeparable(_src, reference_, tmp, kernel);
+}
+
+void GetPrefilterFrame(int _frame, int _sampleCount, int _frameSampleCount, int* sampleBegin_, float* cosSin_)
+{
+	const int first = _frame * _frameSampleCount;
+	const int cycle = first / _sampleCount;
+	*sampleBegin_ = first % _sampleCount;
+
+ // golden ratio sequence, each cycle fills the largest gap between the previous rotations
+	const float phi   = (float)cycle * 0.61803398875f;
+	const float theta = (phi - floorf(phi)) * 2.0f * kPi;
+	cosSin_[0] = cosf(theta);
+	cosSin_[1] = sinf(theta);
+}
+
+
+void PrefilterBlur::init(const Image& _src)
+{
+	m_level0.init(_src.getWidth(), _src.getHeight(), Format_RGBA32F);
+	std::vector<float> line(_src.getWidth() * 4);
+	for (int y = 0; y < _src.getHeight(); ++y)
+	{
+		ReadLine(_src, Direction_Horizontal, y, 0, _src.getWidth(), line.data());
+		WriteLine(m_level0, Direction_Horizontal, y, 0, _src.getWidth(), line.data());
+	}
+
+ // full chain, the level count is clamped to MipChain::kMaxLevelCount
+	int levelCount = 0;
+	for (int size = _src.getWidth() > _src.getHeight() ? _src.getWidth() : _src.getHeight(); size > 1; size >>= 1)
+	{
+		++levelCount;
+	}
+	m_mips.setLevelFormat(Format_RGBA32F);
+	m_mips.build(m_level0, levelCount, MipFilter_Prefilter);
+	++m_version;
+}
+
+void PrefilterBlur::blur(Image& dst_, float _radius, float _lod, int _sampleCount, int _frameSampleCount, int _frame) const
+{
+	assert(dst_.getWidth() == m_level0.getWidth() && dst_.getHeight() == m_level0.getHeight());
+
+ // GL_LINEAR_MIPMAP_LINEAR with the mip range clamped to [0, ceil(lod) + 1], as per Convolution::draw
+	const int   maxLevel = getLevelCount() - 1;
+	const float lod      = _lod < 0.0f ? 0.0f : (_lod > (float)maxLevel ? (float)maxLevel : _lod);
+	const int   level0   = (int)lod;
+	const int   level1   = level0 + 1 > maxLevel ? maxLevel : level0 + 1;
+	const __m128 levelFrac = _mm_set1_ps(lod - (float)level0);
+
+	const int   width  = dst_.getWidth();
+	const int   height = dst_.getHeight();
+	std::vector<float> pattern(_sampleCount * 2);
+	if (m_patterns)
+	{
+		assert(_sampleCount <= SamplePatternSet::kMaxSampleCount);
+		memcpy(pattern.data(), m_patterns->getPattern(_sampleCount), sizeof(float) * 2 * _sampleCount);
+	}
+	else
+	{
+		GenerateHammersley2d(_sampleCount, pattern.data());
+	}
+
+ // this frame's slice of the pattern, rotated by the frame rotation
+	const int frameSampleCount = _frameSampleCount > 0 ? _frameSampleCount : _sampleCount;
+	int   sampleBegin = 0;
+	float frameCosSin[2] = { 1.0f, 0.0f };
+	if (_frameSampleCount > 0)
+	{
+		GetPrefilterFrame(_frame, _sampleCount, _frameSampleCount, &sampleBegin, frameCosSin);
+	}
+	const float rn = 1.0f / (float)frameSampleCount;
+	std::vector<float> offsets(frameSampleCount * 2);
+	for (int i = 0; i < frameSampleCount; ++i)
+	{
+		const float* p = &pattern[((sampleBegin + i) % _sampleCount) * 2];
+		offsets[i * 2 + 0] = frameCosSin[0] * p[0] - frameCosSin[1] * p[1];
+		offsets[i * 2 + 1] = frameCosSin[1] * p[0] + frameCosSin[0] * p[1];
+	}
+
+	std::vector<float> rowOut(width * 4);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const float ix = (float)x + 0.5f;
+			const float iy = (float)y + 0.5f;
+			float cosSin[2];
+			if (m_patterns)
+			{
+				m_patterns->getRotation(x, y, cosSin);
+			}
+			else
+			{
+				const float theta = InterleavedGradientNoise(ix, iy) * 2.0f * kPi;
+				cosSin[0] = cosf(theta);
+				cosSin[1] = sinf(theta);
+			}
+			const float cosTheta = cosSin[0];
+			const float sinTheta = cosSin[1];
+			__m128 acc = _mm_setzero_ps();
+			for (int i = 0; i < frameSampleCount; ++i)
+			{
+				const float ox = offsets[i * 2 + 0];
+				const float oy = offsets[i * 2 + 1];
+				const float u  = (ix + (cosTheta * ox - sinTheta * oy) * _radius) / (float)width;
+				const float v  = (iy + (sinTheta * ox + cosTheta * oy) * _radius) / (float)height;
+				const __m128 s0 = SampleBilinear(getLevel(level0), u, v);
+				const __m128 s1 = SampleBilinear(getLevel(level1), u, v);
+				acc = _mm_add_ps(acc, _mm_add_ps(s0, _mm_mul_ps(_mm_sub_ps(s1, s0), levelFrac)));
+			}
+			_mm_storeu_ps(&rowOut[x * 4], _mm_mul_ps(acc, _mm_set1_ps(rn)));
+		}
+		WriteLine(dst_, Direction_Horizontal, y, 0, width, rowOut.data());
+	}
+}
+
+void PrefilterBlur::shutdown()
+{
+	m_level0.shutdown();
+	m_mips.shutdown();
+	++m_version;
+}
+
+void PrefilterAccumulator::accumulate(const PrefilterBlur& _prefilter, float _radius, float _lod, int _sampleCount, int _frameSampleCount, float _minAlpha)
+{
+	const Image& src = _prefilter.getLevel(0);
+	const int width  = src.getWidth();
+	const int height = src.getHeight();
+	if (&_prefilter != m_prefilter || _prefilter.getVersion() != m_prefilterVersion || width != m_history.getWidth() || height != m_history.getHeight() ||
+	    _radius != m_radius || _lod != m_lod || _sampleCount != m_sampleCount || _frameSampleCount != m_frameSampleCount)
+	{
+		m_prefilter        = &_prefilter;
+		m_prefilterVersion = _prefilter.getVersion();
+		m_radius           = _radius;
+		m_lod              = _lod;
+		m_sampleCount      = _sampleCount;
+		m_frameSampleCount = _frameSampleCount;
+		m_history.init(width, height, Format_RGBA32F);
+		m_current.init(width, height, Format_RGBA32F);
+		m_frame = 0;
+	}
+
+	_prefilter.blur(m_current, _radius, _lod, _sampleCount, _frameSampleCount, m_frame);
+	++m_frame;
+
+ // history += (current - history) * alpha, the first frame overwrites the history
+	const float alpha = 1.0f / (float)m_frame > _minAlpha ? 1.0f / (float)m_frame : _minAlpha;
+	const __m128 alpha4 = _mm_set1_ps(alpha);
+	for (int y = 0; y < height; ++y)
+	{
+		float*       history = (float*)m_history.getRow(y);
+		const float* current = (const float*)m_current.getRow(y);
+		for (int x = 0; x < width * 4; x += 4)
+		{
+			const __m128 h = _mm_loadu_ps(history + x);
+			const __m128 c = _mm_loadu_ps(current + x);
+			_mm_storeu_ps(history + x, _mm_add_ps(h, _mm_mul_ps(_mm_sub_ps(c, h), alpha4)));
+		}
+	}
+}
+
+void PrefilterAccumulator::shutdown()
+{
+	m_history.shutdown();
+	m_current.shutdown();
+	m_prefilter = nullptr;
+	m_frame = 0;
+}
+
+float GetPrefilterPsnr(const PrefilterBlur& _prefilter, int _blurWidth, int _sampleCount, float _lodBias)
+{
+	const Image& src = _prefilter.getLevel(0);
+	const float radius = (float)_blurWidth * 0.5f;
+	Image reference, dst;
+	InitPrefilterReference(src, radius, reference);
+	dst.init(src.getWidth(), src.getHeight(), Format_RGBA32F);
+	_prefilter.blur(dst, radius, GetPrefilterLod(radius, _sampleCount, _lodBias), _sampleCount);
+	return (float)GetPsnr(reference, dst);
+}
+
+PrefilterSetting TunePrefilter(const PrefilterBlur& _prefilter, int _blurWidth, float _targetPsnr, int _maxSampleCount, int _minSampleCount)
+{
+	const Image& src = _prefilter.getLevel(0);
+	const float radius = (float)_blurWidth * 0.5f;
+
+	Image reference, dst;
+	InitPrefilterReference(src, radius, reference);
+	dst.init(src.getWidth(), src.getHeight(), Format_RGBA32F);
+
+ // sample counts are tried in increasing order, the cost is ~linear in the sample count
+	const int   kSampleCounts[] = { 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+	const float kMinBias  = -1.0f;
+	const float kMaxBias  = 2.0f;
+	const float kBiasStep = 0.25f;
+	PrefilterSetting ret = { _blurWidth, 0, 0.0f, -1.0f };
+	for (int sampleCount : kSampleCounts)
+	{
+		if (sampleCount < _minSampleCount)
+		{
+			continue;
+		}
+		if (sampleCount > _maxSampleCount)
+		{
+			break;
+		}
+		PrefilterSetting best = { _blurWidth, sampleCount, kMaxBias, -1.0f };
+		for (float bias = kMaxBias; bias >= kMinBias; bias -= kBiasStep) // descending, ties (lod clamped to 0) keep the larger bias
+		{
+			_prefilter.blur(dst, radius, GetPrefilterLod(radius, sampleCount, bias), sampleCount);
+			const float psnr = (float)GetPsnr(reference, dst);
+			if (psnr > best.m_psnr)
+			{
+				best.m_lodBias = bias;
+				best.m_psnr    = psnr;
+			}
+		}
+		ret = best;
+		if (best.m_psnr >= _targetPsnr)
+		{
+			break;
+		}
+	}
+	return ret;
+}
+
+bool WritePrefilterTable(const char* _path, const PrefilterSetting* _settings, int _count, float _targetPsnr)
+{
+	std::string table = "\"PrefilterTable\": {\n";
+	char buf[256];
+	snprintf(buf, sizeof(buf), "\t\t\"targetPsnr\": %.2f,\n\t\t\"entries\": [\n", _targetPsnr);
+	table += buf;
+	for (int i = 0; i < _count; ++i)
+	{
+		const PrefilterSetting& setting = _settings[i];
+		snprintf(buf, sizeof(buf), "\t\t\t{ \"blurWidth\": %d, \"sampleCount\": %d, \"lodBias\": %.3f, \"psnr\": %.2f }%s\n", setting.m_blurWidth, setting.m_sampleCount, setting.m_lodBias, setting.m_psnr, i + 1 < _count ? "," : "");
+		table += buf;
+	}
+	table += "\t\t]\n\t}";
+
+	bool exists;
+	std::string json = ReadTextFile(_path, &exists);
+	const char* name;
+	const char* begin;
+	const char* end;
+	if (exists && FindTable(json.c_str(), &name, &begin, &end))
+	{
+		json.replace(name - json.c_str(), end - name, table);
+	}
+	else
+	{
+		const size_t open = json.find('{');
+		if (open == std::string::npos)
+		{
+			json = "{\n\t" + table + "\n}\n";
+		}
+		else
+		{
+			const bool empty = json.find_first_not_of(" \t\r\n", open + 1) == json.find('}', open);
+			json.insert(open + 1, "\n\t" + table + (empty ? "" : ","));
+		}
+	}
+
+	FILE* file = fopen(_path, "wb");
+	if (!file)
+	{
+		return false;
+	}
+	const bool ret = fwrite(json.data(), 1, json.size(), file) == json.size();
+	fclose(file);
+	return ret;
+}
+
+int ReadPrefilterTable(const char* _path, PrefilterSetting* settings_, int _maxCount)
+{
+	bool exists;
+	const std::string json = ReadTextFile(_path, &exists);
+	const char* name;
+	const char* begin;
+	const char* end;
+	if (!exists || !FindTable(json.c_str(), &name, &begin, &end))
+	{
+		return 0;
+	}
+
+	int count = 0;
+	for (const char* entry = strstr(begin, "\"blurWidth\""); entry && entry < end && count < _maxCount; entry = strstr(entry + 1, "\"blurWidth\""))
+	{
+		const char* entryEnd = strchr(entry, '}');
+		float blurWidth, sampleCount, lodBias, psnr = 0.0f;
+		if (!entryEnd || !FindNumber(entry, entryEnd, "blurWidth", &blurWidth) || !FindNumber(entry, entryEnd, "sampleCount", &sampleCount) || !FindNumber(entry, entryEnd, "lodBias", &lodBias))
+		{
+			continue;
+		}
+		FindNumber(entry, entryEnd, "psnr", &psnr);
+		PrefilterSetting& setting = settings_[count++];
+		setting.m_blurWidth   = (int)blurWidth;
+		setting.m_sampleCount = (int)sampleCount;
+		setting.m_lodBias     = lodBias;
+		setting.m_psnr        = psnr;
+	}
+	return count;
+}
+
+const PrefilterSetting* FindPrefilterSetting(const PrefilterSetting* _settings, int _count, int _blurWidth)
+{
+	if (_count < 1)
+	{
+		return nullptr;
+	}
+	const PrefilterSetting* ret = _settings;
+	for (int i = 1; i < _count && _settings[i].m_blurWidth <= _blurWidth; ++i)
+	{
+		ret = &_settings[i];
+	}
+	return ret;
+}
+
+} // namespace conv
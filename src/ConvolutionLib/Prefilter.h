@@ -0,0 +1,132 @@
+#pragma once
+
+// CPU reference of the Convolution sample's Mode_Prefilter pipeline: a mip chain (Prefilter_cs.glsl, see MipChain) then
+// a stochastic blur (ConvolutionPrefiltered_cs.glsl) which takes _sampleCount trilinear samples at _lod, Hammersley
+// points in [-radius, radius]^2 rotated per pixel by interleaved gradient noise (Jimenez, "Next Generation Post
+// Processing in Call of Duty: Advanced Warfare", SIGGRAPH 2014).
+//
+// The auto tuner measures the blur against a Gaussian with the same variance as the sample distribution (uniform over
+// the square of half width radius, i.e. sigma = radius / sqrt(3)) and finds, per blur width, the cheapest sample count
+// and the LOD bias which meet a target PSNR. The table is written to/read from a JSON file of its own (the sample's is
+// data/Convolution/PrefilterTable.json, not the properties file which frm rewrites) as a top level "PrefilterTable"
+// member:
+//
+//   "PrefilterTable": {
+//       "targetPsnr": 30.0,
+//       "entries": [
+//           { "blurWidth": 3, "sampleCount": 2, "lodBias": 0.25, "psnr": 36.1 },
+//           ...
+//       ]
+//   }
+//
+// Temporal accumulation (PrefilterAccumulator): each frame takes a slice of _frameSampleCount samples of the
+// _sampleCount pattern (consecutive, wrapping), and the pattern is rotated by the golden ratio sequence each time the
+// slices complete a cycle. The running average of the frames converges to the _sampleCount blur after
+// _sampleCount / _frameSampleCount frames, then continues to converge as the rotations fill in.
+
+#include "Image.h"
+#include "Pyramid.h"
+
+namespace conv {
+
+class SamplePatternSet;
+
+// LOD at which the sample footprint (the disc area / _sampleCount) is ~1 texel, + _lodBias. As per Convolution::draw.
+float GetPrefilterLod(float _radius, int _sampleCount, float _lodBias);
+
+// Sigma of the reference Gaussian for _radius.
+float GetPrefilterReferenceSigma(float _radius);
+
+// Reference Gaussian (sigma as per GetPrefilterReferenceSigma(), truncated at +-3 sigma) of _src, reference_ is RGBA32F.
+void InitPrefilterReference(const Image& _src, float _radius, Image& reference_);
+
+// First sample (sampleBegin_) of the slice and the pattern rotation (cosSin_) for _frame, see PrefilterAccumulator.
+void GetPrefilterFrame(int _frame, int _sampleCount, int _frameSampleCount, int* sampleBegin_, float* cosSin_);
+
+class PrefilterBlur
+{
+public:
+	// Copy _src to level 0 (RGBA32F) and build the mip chain. _src can be any format.
+	void init(const Image& _src);
+
+	// Blur with _sampleCount samples at _lod; dst_ must be the size of the source passed to init(). If _frameSampleCount > 0
+	// take only the slice of _frameSampleCount samples for _frame (see GetPrefilterFrame()).
+	void blur(Image& dst_, float _radius, float _lod, int _sampleCount, int _frameSampleCount = 0, int _frame = 0) const;
+
+	void shutdown();
+
+	// Use the point sets and rotation texture from _patterns rather than Hammersley points and interleaved gradient noise
+	// (nullptr), as per ConvolutionPrefiltered_cs.glsl with SAMPLE_TABLES. _patterns must outlive any calls to blur().
+	void setSamplePatterns(const SamplePatternSet* _patterns)  { m_patterns = _patterns; ++m_version; }
+
+	// Incremented by init() and setSamplePatterns(), i.e. whenever the result of blur() may change for the same arguments.
+	unsigned     getVersion() const                { return m_version; }
+
+	int          getLevelCount() const             { return m_mips.getLevelCount() + 1; }
+	// Level _i in [0, getLevelCount()), level 0 is the RGBA32F copy of the source.
+	const Image& getLevel(int _i) const            { return _i == 0 ? m_level0 : m_mips.getLevel(_i); }
+
+private:
+	Image                   m_level0;
+	MipChain                m_mips;
+	const SamplePatternSet* m_patterns = nullptr;
+	unsigned                m_version  = 0;
+};
+
+class PrefilterAccumulator
+{
+public:
+	// Blur the next frame's slice of _frameSampleCount samples and blend it into the history with weight
+	// max(1 / n, _minAlpha) for the nth frame since the reset: a running average if _minAlpha is 0, else an exponential
+	// moving average, which tracks changes the accumulator can't detect at the cost of some residual noise. The history
+	// is reset if _prefilter (or its version) or any of the other arguments differ from the previous call.
+	void         accumulate(const PrefilterBlur& _prefilter, float _radius, float _lod, int _sampleCount, int _frameSampleCount, float _minAlpha = 0.0f);
+
+	void         reset()                           { m_frame = 0; }
+	void         shutdown();
+
+	// RGBA32F, the size of the source passed to the PrefilterBlur.
+	const Image& getHistory() const                { return m_history; }
+	// Frames accumulated since the reset.
+	int          getFrame() const                  { return m_frame; }
+
+private:
+	Image                m_history;
+	Image                m_current;
+	int                  m_frame            = 0;
+	const PrefilterBlur* m_prefilter        = nullptr;
+	unsigned             m_prefilterVersion = 0;
+	float                m_radius           = 0.0f;
+	float                m_lod              = 0.0f;
+	int                  m_sampleCount      = 0;
+	int                  m_frameSampleCount = 0;
+};
+
+struct PrefilterSetting
+{
+	int   m_blurWidth;
+	int   m_sampleCount;
+	float m_lodBias;
+	float m_psnr;        // vs. the reference Gaussian, RGB
+};
+
+// PSNR of the blur vs. the reference Gaussian for the source passed to _prefilter.init().
+float GetPrefilterPsnr(const PrefilterBlur& _prefilter, int _blurWidth, int _sampleCount, float _lodBias);
+
+// Find the cheapest (lowest sample count in [_minSampleCount, _maxSampleCount], then the best bias in [-1, 2]) setting
+// for _blurWidth which meets _targetPsnr for the source passed to _prefilter.init(). If none does, return the best
+// setting at the highest sample count tried (m_psnr < _targetPsnr).
+PrefilterSetting TunePrefilter(const PrefilterBlur& _prefilter, int _blurWidth, float _targetPsnr, int _maxSampleCount = 32, int _minSampleCount = 1);
+
+// Write the table into the JSON file at _path, replacing an existing "PrefilterTable" member or inserting one if the
+// file exists, else creating it. Return false if the file couldn't be written.
+bool WritePrefilterTable(const char* _path, const PrefilterSetting* _settings, int _count, float _targetPsnr);
+
+// Read up to _maxCount entries of the table in the JSON file at _path, return the number read (0 if the file or the
+// table don't exist).
+int  ReadPrefilterTable(const char* _path, PrefilterSetting* settings_, int _maxCount);
+
+// Entry with the largest m_blurWidth <= _blurWidth (or the first), _settings must be sorted by m_blurWidth.
+const PrefilterSetting* FindPrefilterSetting(const PrefilterSetting* _settings, int _count, int _blurWidth);
+
+} // namespace conv
@@ -0,0 +1,504 @@
+#include "Pyramid.h"
+
+#include "Line.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace conv {
+
+namespace {
+
+// Bilinear tap at _offset source texels from the position of output texel _i (mapped via normalized coordinates).
+struct Tap
+{
+	int   m_i0;     // first texel (the second is m_i0 + 1), both clamped
+	int   m_i1;
+	float m_frac;
+};
+
+Tap GetTap(int _i, int _dstSize, int _srcSize, float _offset)
+{
+	const float scale = (float)_srcSize / (float)_dstSize;
+	const float p = ((float)_i + 0.5f) * scale - 0.5f + _offset;
+	const float p0 = floorf(p);
+	Tap ret;
+	ret.m_frac = p - p0;
+	ret.m_i0   = (int)p0;
+	ret.m_i1   = ret.m_i0 + 1;
+	ret.m_i0   = ret.m_i0 < 0 ? 0 : (ret.m_i0 >= _srcSize ? _srcSize - 1 : ret.m_i0);
+	ret.m_i1   = ret.m_i1 < 0 ? 0 : (ret.m_i1 >= _srcSize ? _srcSize - 1 : ret.m_i1);
+	return ret;
+}
+
+// Source rows cached as RGBA float, indexed by the (clamped) row index. kMaxRows must cover the rows spanned by the
+// taps of an output row, else rows are re-read.
+class RowCache
+{
+public:
+	static const int kMaxRows = 16;
+
+	RowCache(const Image& _src)
+		: m_src(_src)
+	{
+		for (int i = 0; i < kMaxRows; ++i)
+		{
+			m_rows[i]    = (float*)AlignedAlloc(sizeof(float) * 4 * _src.getWidth());
+			m_indices[i] = -1;
+		}
+	}
+
+	~RowCache()
+	{
+		for (float* row : m_rows)
+		{
+			AlignedFree(row);
+		}
+	}
+
+	const float* get(int _y)
+	{
+		float*& row = m_rows[_y % kMaxRows];
+		int& index = m_indices[_y % kMaxRows];
+		if (index != _y)
+		{
+			ReadLine(m_src, Direction_Horizontal, _y, 0, m_src.getWidth(), row);
+			index = _y;
+		}
+		return row;
+	}
+
+private:
+	const Image& m_src;
+	float*       m_rows[kMaxRows];
+	int          m_indices[kMaxRows];
+};
+
+inline __m128 Lerp(__m128 _a, __m128 _b, __m128 _t)
+{
+	return _mm_add_ps(_a, _mm_mul_ps(_mm_sub_ps(_b, _a), _t));
+}
+
+// Bilinear sample between _row0 and _row1 at _x, _weight applied.
+inline __m128 Sample(const float* _row0, const float* _row1, const Tap& _x, __m128 _fy, __m128 _weight)
+{
+	const __m128 fx = _mm_set1_ps(_x.m_frac);
+	const __m128 r0 = Lerp(_mm_loadu_ps(_row0 + _x.m_i0 * 4), _mm_loadu_ps(_row0 + _x.m_i1 * 4), fx);
+	const __m128 r1 = Lerp(_mm_loadu_ps(_row1 + _x.m_i0 * 4), _mm_loadu_ps(_row1 + _x.m_i1 * 4), fx);
+	return _mm_mul_ps(Lerp(r0, r1, _fy), _weight);
+}
+
+struct TapDesc
+{
+	float m_x, m_y, m_weight;
+};
+
+const TapDesc kDownsampleTaps[] =
+{
+	{  0.0f,  0.0f, 4.0f / 8.0f },
+	{ -1.0f, -1.0f, 1.0f / 8.0f },
+	{  1.0f, -1.0f, 1.0f / 8.0f },
+	{ -1.0f,  1.0f, 1.0f / 8.0f },
+	{  1.0f,  1.0f, 1.0f / 8.0f },
+};
+
+const TapDesc kUpsampleTaps[] =
+{
+	{ -1.0f,  0.0f, 1.0f / 12.0f },
+	{  1.0f,  0.0f, 1.0f / 12.0f },
+	{  0.0f, -1.0f, 1.0f / 12.0f },
+	{  0.0f,  1.0f, 1.0f / 12.0f },
+	{ -0.5f, -0.5f, 2.0f / 12.0f },
+	{  0.5f, -0.5f, 2.0f / 12.0f },
+	{ -0.5f,  0.5f, 2.0f / 12.0f },
+	{  0.5f,  0.5f, 2.0f / 12.0f },
+};
+
+template <int kTapCount>
+void Resample(const Image& _src, Image& dst_, const TapDesc (&_taps)[kTapCount], int _rowBegin, int _rowEnd)
+{
+	_rowEnd = _rowEnd < 0 ? dst_.getHeight() : _rowEnd;
+	if (_rowEnd <= _rowBegin)
+	{
+		return;
+	}
+	const int dstWidth = dst_.getWidth();
+	const int srcWidth = _src.getWidth();
+
+ // x taps are the same for every row
+	Tap* xTaps = (Tap*)AlignedAlloc(sizeof(Tap) * kTapCount * dstWidth);
+	for (int x = 0; x < dstWidth; ++x)
+	{
+		for (int i = 0; i < kTapCount; ++i)
+		{
+			xTaps[x * kTapCount + i] = GetTap(x, dstWidth, srcWidth, _taps[i].m_x);
+		}
+	}
+
+	RowCache rows(_src);
+	float* rowOut = (float*)AlignedAlloc(sizeof(float) * 4 * dstWidth);
+	for (int y = _rowBegin; y < _rowEnd; ++y)
+	{
+	 // y taps are the same for the whole row
+		const float* rows0[kTapCount];
+		const float* rows1[kTapCount];
+		__m128 fy[kTapCount];
+		__m128 weights[kTapCount];
+		for (int i = 0; i < kTapCount; ++i)
+		{
+			const Tap yTap = GetTap(y, dst_.getHeight(), _src.getHeight(), _taps[i].m_y);
+			rows0[i]   = rows.get(yTap.m_i0);
+			rows1[i]   = rows.get(yTap.m_i1);
+			fy[i]      = _mm_set1_ps(yTap.m_frac);
+			weights[i] = _mm_set1_ps(_taps[i].m_weight);
+		}
+		for (int x = 0; x < dstWidth; ++x)
+		{
+			const Tap* xTap = xTaps + x * kTapCount;
+			__m128 acc = _mm_setzero_ps();
+			for (int i = 0; i < kTapCount; ++i)
+			{
+				acc = _mm_add_ps(acc, Sample(rows0[i], rows1[i], xTap[i], fy[i], weights[i]));
+			}
+			_mm_storeu_ps(rowOut + x * 4, acc);
+		}
+		WriteLine(dst_, Direction_Horizontal, y, 0, dstWidth, rowOut);
+	}
+	AlignedFree(rowOut);
+	AlignedFree(xTaps);
+}
+
+// Mip filters, see Prefilter_cs.glsl and Downsample_cs.glsl. Offsets are in source texels, or destination texels if
+// m_dstTexels (Downsample_cs.glsl scales the offsets by 2 / destination size).
+const TapDesc kPrefilterTaps[] =
+{
+	{ -1.223379f, -1.223379f, 0.099162f }, { 0.397811f, -1.223379f, 0.193587f }, { 2.000000f, -1.223379f, 0.022151f },
+	{ -1.223379f,  0.397811f, 0.193587f }, { 0.397811f,  0.397811f, 0.377927f }, { 2.000000f,  0.397811f, 0.043243f },
+	{ -1.223379f,  2.000000f, 0.022151f }, { 0.397811f,  2.000000f, 0.043243f }, { 2.500000f,  2.500000f, 0.004948f },
+};
+
+const TapDesc kGaussian3x3Taps[] =
+{
+	{ -2.0f, -2.0f, 0.077847f }, { 0.0f, -2.0f, 0.123317f }, { 2.0f, -2.0f, 0.077847f },
+	{ -2.0f,  0.0f, 0.123317f }, { 0.0f,  0.0f, 0.195346f }, { 2.0f,  0.0f, 0.123317f },
+	{ -2.0f,  2.0f, 0.077847f }, { 0.0f,  2.0f, 0.123317f }, { 2.0f,  2.0f, 0.077847f },
+};
+
+struct MipFilterDesc
+{
+	const char*    m_name;
+	const TapDesc* m_taps;
+	int            m_tapCount;
+	bool           m_dstTexels;
+};
+
+const MipFilterDesc kMipFilters[] =
+{
+	{ "Prefilter",    kPrefilterTaps,   9, false },
+	{ "Gaussian 3x3", kGaussian3x3Taps, 9, true  },
+};
+static_assert(sizeof(kMipFilters) / sizeof(kMipFilters[0]) == MipFilter_Count, "kMipFilters must match MipFilter_");
+
+const int kMaxMipTapCount = 9;
+
+// Resample rows of a mip level from the previous level, the source rows are provided by the caller.
+class MipResampler
+{
+public:
+	MipResampler(int _srcWidth, int _srcHeight, int _dstWidth, int _dstHeight, MipFilter _filter)
+		: m_filter(kMipFilters[_filter])
+		, m_srcHeight(_srcHeight)
+		, m_dstWidth(_dstWidth)
+		, m_dstHeight(_dstHeight)
+	{
+		assert(m_filter.m_tapCount <= kMaxMipTapCount);
+		const float scale = m_filter.m_dstTexels ? (float)_srcWidth / (float)_dstWidth : 1.0f;
+		m_xTaps = (Tap*)AlignedAlloc(sizeof(Tap) * m_filter.m_tapCount * _dstWidth);
+		for (int x = 0; x < _dstWidth; ++x)
+		{
+			for (int i = 0; i < m_filter.m_tapCount; ++i)
+			{
+				m_xTaps[x * m_filter.m_tapCount + i] = GetTap(x, _dstWidth, _srcWidth, m_filter.m_taps[i].m_x * scale);
+			}
+		}
+	}
+
+	~MipResampler()
+	{
+		AlignedFree(m_xTaps);
+	}
+
+	// _getRow(y) returns source row y as RGBA float.
+	template <typename tGetRow>
+	void resampleRow(int _y, tGetRow&& _getRow, float* out_) const
+	{
+		const int tapCount = m_filter.m_tapCount;
+		const float scale = m_filter.m_dstTexels ? (float)m_srcHeight / (float)m_dstHeight : 1.0f;
+		const float* rows0[kMaxMipTapCount];
+		const float* rows1[kMaxMipTapCount];
+		__m128 fy[kMaxMipTapCount];
+		__m128 weights[kMaxMipTapCount];
+		for (int i = 0; i < tapCount; ++i)
+		{
+			const Tap yTap = GetTap(_y, m_dstHeight, m_srcHeight, m_filter.m_taps[i].m_y * scale);
+			rows0[i]   = _getRow(yTap.m_i0);
+			rows1[i]   = _getRow(yTap.m_i1);
+			fy[i]      = _mm_set1_ps(yTap.m_frac);
+			weights[i] = _mm_set1_ps(m_filter.m_taps[i].m_weight);
+		}
+		for (int x = 0; x < m_dstWidth; ++x)
+		{
+			const Tap* xTap = m_xTaps + x * tapCount;
+			__m128 acc = _mm_setzero_ps();
+			for (int i = 0; i < tapCount; ++i)
+			{
+				acc = _mm_add_ps(acc, Sample(rows0[i], rows1[i], xTap[i], fy[i], weights[i]));
+			}
+			_mm_storeu_ps(out_ + x * 4, acc);
+		}
+	}
+
+private:
+	const MipFilterDesc& m_filter;
+	int                  m_srcHeight;
+	int                  m_dstWidth;
+	int                  m_dstHeight;
+	Tap*                 m_xTaps;
+};
+
+// Rows of a mip level produced on demand and in order, the last kRingSize rows are kept as RGBA float. Level 0 reads
+// the source image, other levels resample rows pulled from the previous level and write them to their image.
+class MipLevelStream
+{
+public:
+	static const int kRingSize = 16; // must cover the rows spanned by the taps of an output row, see getRow()
+
+	MipLevelStream(const Image& _src)
+		: m_image(_src)
+	{
+		init();
+	}
+
+	MipLevelStream(MipLevelStream& _parent, Image& _level, MipFilter _filter)
+		: m_image(_level)
+		, m_parent(&_parent)
+		, m_level(&_level)
+		, m_resampler(new MipResampler(_parent.m_image.getWidth(), _parent.m_image.getHeight(), _level.getWidth(), _level.getHeight(), _filter))
+	{
+		init();
+	}
+
+	~MipLevelStream()
+	{
+		delete m_resampler;
+		AlignedFree(m_ring);
+	}
+
+	const float* getRow(int _y)
+	{
+		assert(_y >= m_rowEnd - kRingSize); // evicted, kRingSize is too small
+		while (m_rowEnd <= _y)
+		{
+			produceRow(m_rowEnd++);
+		}
+		return getRingRow(_y);
+	}
+
+	int getHeight() const { return m_image.getHeight(); }
+
+private:
+	const Image&    m_image;
+	MipLevelStream* m_parent    = nullptr;
+	Image*          m_level     = nullptr;
+	MipResampler*   m_resampler = nullptr;
+	float*          m_ring      = nullptr;
+	int             m_rowEnd    = 0; // rows [0, m_rowEnd) have been produced
+
+	void init()
+	{
+		m_ring = (float*)AlignedAlloc(sizeof(float) * 4 * m_image.getWidth() * kRingSize);
+	}
+
+	float* getRingRow(int _y)
+	{
+		return m_ring + (size_t)(_y % kRingSize) * m_image.getWidth() * 4;
+	}
+
+	void produceRow(int _y)
+	{
+		float* row = getRingRow(_y);
+		const int width = m_image.getWidth();
+		if (!m_parent)
+		{
+			ReadLine(m_image, Direction_Horizontal, _y, 0, width, row);
+			return;
+		}
+		m_resampler->resampleRow(_y, [this](int _i) { return m_parent->getRow(_i); }, row);
+		WriteLine(*m_level, Direction_Horizontal, _y, 0, width, row);
+		if (m_level->getFormat() != Format_RGBA32F)
+		{
+		 // the next level must see the stored (quantized) values, as per buildPerLevel()
+			ReadLine(*m_level, Direction_Horizontal, _y, 0, width, row);
+		}
+	}
+};
+
+} // namespace
+
+void PyramidDownsample(const Image& _src, Image& dst_, int _rowBegin, int _rowEnd)
+{
+	Resample(_src, dst_, kDownsampleTaps, _rowBegin, _rowEnd);
+}
+
+void PyramidUpsample(const Image& _src, Image& dst_, int _rowBegin, int _rowEnd)
+{
+	Resample(_src, dst_, kUpsampleTaps, _rowBegin, _rowEnd);
+}
+
+const char* GetMipFilterName(MipFilter _filter)
+{
+	assert(_filter >= 0 && _filter < MipFilter_Count);
+	return kMipFilters[_filter].m_name;
+}
+
+void MipDownsample(const Image& _src, Image& dst_, MipFilter _filter, int _rowBegin, int _rowEnd)
+{
+	_rowEnd = _rowEnd < 0 ? dst_.getHeight() : _rowEnd;
+	if (_rowEnd <= _rowBegin)
+	{
+		return;
+	}
+	const MipResampler resampler(_src.getWidth(), _src.getHeight(), dst_.getWidth(), dst_.getHeight(), _filter);
+	RowCache rows(_src);
+	float* rowOut = (float*)AlignedAlloc(sizeof(float) * 4 * dst_.getWidth());
+	for (int y = _rowBegin; y < _rowEnd; ++y)
+	{
+		resampler.resampleRow(y, [&rows](int _i) { return rows.get(_i); }, rowOut);
+		WriteLine(dst_, Direction_Horizontal, y, 0, dst_.getWidth(), rowOut);
+	}
+	AlignedFree(rowOut);
+}
+
+void PyramidBlur::blur(const Image& _src, Image& dst_, int _levelCount)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	const int levelCount = init(_src, _levelCount);
+	for (int i = 0; i < levelCount; ++i)
+	{
+		PyramidDownsample(i == 0 ? _src : m_levels[i - 1], m_levels[i]);
+	}
+	for (int i = levelCount - 1; i > 0; --i)
+	{
+		PyramidUpsample(m_levels[i], m_levels[i - 1]);
+	}
+	PyramidUpsample(m_levels[0], dst_);
+}
+
+void PyramidBlur::blur(ThreadPool& _pool, const Image& _src, Image& dst_, int _levelCount)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	const int levelCount = init(_src, _levelCount);
+
+	auto runPass = [&_pool](void (*_pass)(const Image&, Image&, int, int), const Image& _passSrc, Image& _passDst)
+		{
+		 // ~4 chunks per thread for load balancing
+			const int height = _passDst.getHeight();
+			int chunkSize = (height + _pool.getThreadCount() * 4 - 1) / (_pool.getThreadCount() * 4);
+			chunkSize = chunkSize < 8 ? 8 : chunkSize;
+
+			ThreadPool::TaskGroup group;
+			for (int rowBegin = 0; rowBegin < height; rowBegin += chunkSize)
+			{
+				const int rowEnd = rowBegin + chunkSize < height ? rowBegin + chunkSize : height;
+				_pool.run(group, [_pass, &_passSrc, &_passDst, rowBegin, rowEnd]() { _pass(_passSrc, _passDst, rowBegin, rowEnd); });
+			}
+			_pool.wait(group);
+		};
+
+	for (int i = 0; i < levelCount; ++i)
+	{
+		runPass(PyramidDownsample, i == 0 ? _src : m_levels[i - 1], m_levels[i]);
+	}
+	for (int i = levelCount - 1; i > 0; --i)
+	{
+		runPass(PyramidUpsample, m_levels[i], m_levels[i - 1]);
+	}
+	runPass(PyramidUpsample, m_levels[0], dst_);
+}
+
+void PyramidBlur::shutdown()
+{
+	for (Image& level : m_levels)
+	{
+		level.shutdown();
+	}
+}
+
+int PyramidBlur::init(const Image& _src, int _levelCount)
+{
+	_levelCount = _levelCount < 1 ? 1 : (_levelCount > kMaxLevelCount ? kMaxLevelCount : _levelCount);
+	for (int i = 0; i < _levelCount; ++i)
+	{
+		const int w = _src.getWidth() >> (i + 1);
+		const int h = _src.getHeight() >> (i + 1);
+		m_levels[i].init(w < 1 ? 1 : w, h < 1 ? 1 : h, m_levelFormat);
+	}
+	return _levelCount;
+}
+
+void MipChain::build(const Image& _src, int _levelCount, MipFilter _filter)
+{
+	init(_src, _levelCount);
+
+	MipLevelStream* streams[kMaxLevelCount + 1];
+	streams[0] = new MipLevelStream(_src);
+	for (int i = 1; i <= m_levelCount; ++i)
+	{
+		streams[i] = new MipLevelStream(*streams[i - 1], m_levels[i - 1], _filter);
+	}
+
+ // pulling the last row of each level (last level first) produces every row of every level, in order
+	for (int i = m_levelCount; i > 0; --i)
+	{
+		streams[i]->getRow(streams[i]->getHeight() - 1);
+	}
+
+	for (int i = 0; i <= m_levelCount; ++i)
+	{
+		delete streams[i];
+	}
+}
+
+void MipChain::buildPerLevel(const Image& _src, int _levelCount, MipFilter _filter)
+{
+	init(_src, _levelCount);
+	for (int i = 0; i < m_levelCount; ++i)
+	{
+		MipDownsample(i == 0 ? _src : m_levels[i - 1], m_levels[i], _filter);
+	}
+}
+
+void MipChain::shutdown()
+{
+	for (Image& level : m_levels)
+	{
+		level.shutdown();
+	}
+	m_levelCount = 0;
+}
+
+void MipChain::init(const Image& _src, int _levelCount)
+{
+	m_levelCount = _levelCount < 1 ? 1 : (_levelCount > kMaxLevelCount ? kMaxLevelCount : _levelCount);
+	for (int i = 0; i < m_levelCount; ++i)
+	{
+		const int w = _src.getWidth() >> (i + 1);
+		const int h = _src.getHeight() >> (i + 1);
+		m_levels[i].init(w < 1 ? 1 : w, h < 1 ? 1 : h, m_levelFormat);
+	}
+}
+
+} // namespace conv
@@ -0,0 +1,116 @@
+#pragma once
+
+// Dual filter pyramid blur (Bjorge, "Bandwidth-Efficient Rendering", SIGGRAPH 2015). The source is downsampled N times
+// with a 5 tap filter then upsampled back with an 8 tap tent filter; the blur radius roughly doubles per level while
+// the total cost is bounded by ~4/3 of the cost of the first level, regardless of N.
+//
+// The CPU implementation is the reference for DualFilter_cs.glsl: taps are bilinear samples at the same positions
+// (GL_LINEAR, GL_CLAMP_TO_EDGE), in source texel units:
+//
+//   Downsample:  (0,0) x4, (+-1,+-1) x1                        / 8
+//   Upsample:    (+-1,0) x1, (0,+-1) x1, (+-0.5,+-0.5) x2      / 12
+//
+// Level i is max(1, size >> i), intermediate levels are RGBA32F by default (RGBA16F halves their footprint and bandwidth,
+// see setLevelFormat()). Taps are positioned via normalized coordinates, as on the GPU, hence odd sizes are handled the
+// same way as the texture unit would.
+
+#include "Image.h"
+
+namespace conv {
+
+class ThreadPool;
+
+class PyramidBlur
+{
+public:
+	static const int kMaxLevelCount = 12;
+
+	PyramidBlur() = default;
+	~PyramidBlur()                                 { shutdown(); }
+
+	PyramidBlur(const PyramidBlur&)            = delete;
+	PyramidBlur& operator=(const PyramidBlur&) = delete;
+
+	// Blur _src into dst_ with _levelCount downsample/upsample passes (clamped to [1, kMaxLevelCount]).
+	// _src and dst_ must be the same size but the formats may differ. The levels are only reallocated if the size changes.
+	void blur(const Image& _src, Image& dst_, int _levelCount);
+
+	// Multi-threaded blur(). Rows of each pass are distributed across the pool, passes are separated by a barrier.
+	void blur(ThreadPool& _pool, const Image& _src, Image& dst_, int _levelCount);
+
+	void shutdown();
+
+	// Format of the intermediate levels, the levels are reallocated on the next call to blur() if it changes.
+	void   setLevelFormat(Format _format)          { m_levelFormat = _format; }
+	Format getLevelFormat() const                  { return m_levelFormat; }
+
+private:
+	Image  m_levels[kMaxLevelCount]; // [i] is level i + 1, the down chain then reused for the up chain
+	Format m_levelFormat = Format_RGBA32F;
+
+	// Allocate the levels for _src, return the clamped level count.
+	int  init(const Image& _src, int _levelCount);
+};
+
+// Downsample/upsample rows [_rowBegin, _rowEnd) of dst_ from _src, see PyramidBlur.
+void PyramidDownsample(const Image& _src, Image& dst_, int _rowBegin = 0, int _rowEnd = -1);
+void PyramidUpsample(const Image& _src, Image& dst_, int _rowBegin = 0, int _rowEnd = -1);
+
+// Mip chain downsample filters, the CPU references for the GPU mip chains. Taps are bilinear samples as per PyramidBlur.
+enum MipFilter_
+{
+	MipFilter_Prefilter,  // 9 tap 5x5 Gaussian (Convolution, Prefilter_cs.glsl)
+	MipFilter_Gaussian3x3, // 3x3 Gaussian with taps at +-2 destination texels (LensFlare_ScreenSpace, Downsample_cs.glsl)
+
+	MipFilter_Count
+};
+typedef int MipFilter;
+
+const char* GetMipFilterName(MipFilter _filter);
+
+// Downsample rows [_rowBegin, _rowEnd) of dst_ (the next mip level) from _src with _filter.
+void MipDownsample(const Image& _src, Image& dst_, MipFilter _filter, int _rowBegin = 0, int _rowEnd = -1);
+
+// Mip chain builder. build() produces all levels in a single traversal of the source: rows are pulled recursively from
+// the last level, each level keeps a ring of the last few rows it produced (as RGBA float) which is all the next level
+// needs. Hence each level is written once and never re-read, and the working set is a few rows per level rather than
+// a whole level. buildPerLevel() is the level by level loop (one pass per level, as the GPU dispatches), the results are
+// identical.
+//
+// Cf. single pass downsamplers which recurse within 2d tiles: these are limited to 2x2 box filters, wider footprints
+// need halos which grow per level, whereas full width rows need no halo.
+class MipChain
+{
+public:
+	static const int kMaxLevelCount = 12;
+
+	MipChain() = default;
+	~MipChain()                                    { shutdown(); }
+
+	MipChain(const MipChain&)            = delete;
+	MipChain& operator=(const MipChain&) = delete;
+
+	// Build _levelCount levels (clamped to [1, kMaxLevelCount]) from _src. The levels are only reallocated if the size
+	// changes.
+	void build(const Image& _src, int _levelCount, MipFilter _filter);
+	void buildPerLevel(const Image& _src, int _levelCount, MipFilter _filter);
+
+	void shutdown();
+
+	int          getLevelCount() const             { return m_levelCount; }
+	// Level _i in [1, getLevelCount()], level 0 is the source.
+	const Image& getLevel(int _i) const            { return m_levels[_i - 1]; }
+
+	// Format of the levels, the levels are reallocated on the next call to build() if it changes.
+	void   setLevelFormat(Format _format)          { m_levelFormat = _format; }
+	Format getLevelFormat() const                  { return m_levelFormat; }
+
+private:
+	Image  m_levels[kMaxLevelCount];
+	int    m_levelCount  = 0;
+	Format m_levelFormat = Format_RGBA32F;
+
+	void init(const Image& _src, int _levelCount);
+};
+
+} // namespace conv
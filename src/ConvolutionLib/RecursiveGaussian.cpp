@@ -0,0 +1,467 @@
+#include "RecursiveGaussian.h"
+
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <immintrin.h>
+
+namespace conv {
+
+namespace {
+
+// Filter _count RGBA texels of _line into out_. tmp_ is _count * 4 doubles.
+typedef void (RecursiveGaussianLineFunc)(const float* _line, float* out_, double* tmp_, int _count, const RecursiveGaussianKernel& _kernel);
+
+void RecursiveGaussianLine_Scalar(const float* _line, float* out_, double* tmp_, int _count, const RecursiveGaussianKernel& _kernel)
+{
+	const double  b = _kernel.getB();
+	const double* a = _kernel.getA();
+	const double* m = _kernel.getBoundaryMatrix();
+
+	for (int c = 0; c < 4; ++c)
+	{
+	 // causal, the steady state for a constant input is the input
+		double w1 = _line[c], w2 = w1, w3 = w1;
+		for (int x = 0; x < _count; ++x)
+		{
+			const double w0 = b * (double)_line[x * 4 + c] + a[0] * w1 + a[1] * w2 + a[2] * w3;
+			tmp_[x * 4 + c] = w0;
+			w3 = w2; w2 = w1; w1 = w0;
+		}
+
+	 // anti-causal
+		const double edge = (double)_line[(_count - 1) * 4 + c];
+		const double u0 = w1 - edge, u1 = w2 - edge, u2 = w3 - edge;
+		double y1 = m[0] * u0 + m[1] * u1 + m[2] * u2 + edge;
+		double y2 = m[3] * u0 + m[4] * u1 + m[5] * u2 + edge;
+		double y3 = m[6] * u0 + m[7] * u1 + m[8] * u2 + edge;
+		for (int x = _count - 1; x >= 0; --x)
+		{
+			const double y0 = b * tmp_[x * 4 + c] + a[0] * y1 + a[1] * y2 + a[2] * y3;
+			out_[x * 4 + c] = (float)y0;
+			y3 = y2; y2 = y1; y1 = y0;
+		}
+	}
+}
+
+CONV_TARGET_SSE4 void RecursiveGaussianLine_Sse4(const float* _line, float* out_, double* tmp_, int _count, const RecursiveGaussianKernel& _kernel)
+{
+ // RGBA split across 2 registers (RG, BA)
+	const __m128d b  = _mm_set1_pd(_kernel.getB());
+	const __m128d a0 = _mm_set1_pd(_kernel.getA()[0]);
+	const __m128d a1 = _mm_set1_pd(_kernel.getA()[1]);
+	const __m128d a2 = _mm_set1_pd(_kernel.getA()[2]);
+	const double* m  = _kernel.getBoundaryMatrix();
+
+	for (int h = 0; h < 2; ++h)
+	{
+		const float* line = _line + h * 2;
+		double*      tmp  = tmp_ + h * 2;
+
+		__m128d w1 = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)line)));
+		__m128d w2 = w1, w3 = w1;
+		for (int x = 0; x < _count; ++x)
+		{
+			const __m128d in = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)(line + x * 4))));
+			const __m128d w0 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b, in), _mm_mul_pd(a0, w1)), _mm_add_pd(_mm_mul_pd(a1, w2), _mm_mul_pd(a2, w3)));
+			_mm_storeu_pd(tmp + x * 4, w0);
+			w3 = w2; w2 = w1; w1 = w0;
+		}
+
+		const __m128d edge = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)(line + (_count - 1) * 4))));
+		const __m128d u0 = _mm_sub_pd(w1, edge), u1 = _mm_sub_pd(w2, edge), u2 = _mm_sub_pd(w3, edge);
+		__m128d y1 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[0]), u0), _mm_mul_pd(_mm_set1_pd(m[1]), u1)), _mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[2]), u2), edge));
+		__m128d y2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[3]), u0), _mm_mul_pd(_mm_set1_pd(m[4]), u1)), _mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[5]), u2), edge));
+		__m128d y3 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[6]), u0), _mm_mul_pd(_mm_set1_pd(m[7]), u1)), _mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[8]), u2), edge));
+		for (int x = _count - 1; x >= 0; --x)
+		{
+			const __m128d y0 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b, _mm_loadu_pd(tmp + x * 4)), _mm_mul_pd(a0, y1)), _mm_add_pd(_mm_mul_pd(a1, y2), _mm_mul_pd(a2, y3)));
+			_mm_store_sd((double*)(out_ + x * 4 + h * 2), _mm_castps_pd(_mm_cvtpd_ps(y0)));
+			y3 = y2; y2 = y1; y1 = y0;
+		}
+	}
+}
+
+CONV_TARGET_AVX2 void RecursiveGaussianLine_Avx2(const float* _line, float* out_, double* tmp_, int _count, const RecursiveGaussianKernel& _kernel)
+{
+ // RGBA in a single register
+	const __m256d b  = _mm256_set1_pd(_kernel.getB());
+	const __m256d a0 = _mm256_set1_pd(_kernel.getA()[0]);
+	const __m256d a1 = _mm256_set1_pd(_kernel.getA()[1]);
+	const __m256d a2 = _mm256_set1_pd(_kernel.getA()[2]);
+	const double* m  = _kernel.getBoundaryMatrix();
+
+	__m256d w1 = _mm256_cvtps_pd(_mm_loadu_ps(_line));
+	__m256d w2 = w1, w3 = w1;
+	for (int x = 0; x < _count; ++x)
+	{
+		__m256d w0 = _mm256_mul_pd(b, _mm256_cvtps_pd(_mm_loadu_ps(_line + x * 4)));
+		w0 = _mm256_fmadd_pd(a0, w1, w0);
+		w0 = _mm256_fmadd_pd(a1, w2, w0);
+		w0 = _mm256_fmadd_pd(a2, w3, w0);
+		_mm256_storeu_pd(tmp_ + x * 4, w0);
+		w3 = w2; w2 = w1; w1 = w0;
+	}
+
+	const __m256d edge = _mm256_cvtps_pd(_mm_loadu_ps(_line + (_count - 1) * 4));
+	const __m256d u0 = _mm256_sub_pd(w1, edge), u1 = _mm256_sub_pd(w2, edge), u2 = _mm256_sub_pd(w3, edge);
+	__m256d y1 = _mm256_fmadd_pd(_mm256_set1_pd(m[0]), u0, _mm256_fmadd_pd(_mm256_set1_pd(m[1]), u1, _mm256_fmadd_pd(_mm256_set1_pd(m[2]), u2, edge)));
+	__m256d y2 = _mm256_fmadd_pd(_mm256_set1_pd(m[3]), u0, _mm256_fmadd_pd(_mm256_set1_pd(m[4]), u1, _mm256_fmadd_pd(_mm256_set1_pd(m[5]), u2, edge)));
+	__m256d y3 = _mm256_fmadd_pd(_mm256_set1_pd(m[6]), u0, _mm256_fmadd_pd(_mm256_set1_pd(m[7]), u1, _mm256_fmadd_pd(_mm256_set1_pd(m[8]), u2, edge)));
+	for (int x = _count - 1; x >= 0; --x)
+	{
+		__m256d y0 = _mm256_mul_pd(b, _mm256_loadu_pd(tmp_ + x * 4));
+		y0 = _mm256_fmadd_pd(a0, y1, y0);
+		y0 = _mm256_fmadd_pd(a1, y2, y0);
+		y0 = _mm256_fmadd_pd(a2, y3, y0);
+		_mm_storeu_ps(out_ + x * 4, _mm256_cvtpd_ps(y0));
+		y3 = y2; y2 = y1; y1 = y0;
+	}
+}
+
+RecursiveGaussianLineFunc* GetRecursiveGaussianLineFunc()
+{
+	switch (GetIsa())
+	{
+		case Isa_Avx2: return RecursiveGaussianLine_Avx2;
+		case Isa_Sse4: return RecursiveGaussianLine_Sse4;
+		default:       return RecursiveGaussianLine_Scalar;
+	};
+}
+
+// As RecursiveGaussianLineFunc but along the columns of _count rows of _width texels, all columns advance a row at a
+// time. tmp_ is (_count + 6) * _width * 4 doubles; rows -3..-1 and _count.._count + 2 hold the initial state of the
+// causal and anti-causal passes, the anti-causal output overwrites the causal output in place. The arithmetic matches
+// the line function of the same instruction set, hence the result is identical to filtering each column as a line.
+typedef void (RecursiveGaussianRowsFunc)(const float* _rows, float* out_, double* tmp_, int _count, int _width, const RecursiveGaussianKernel& _kernel);
+
+void RecursiveGaussianRows_Scalar(const float* _rows, float* out_, double* tmp_, int _count, int _width, const RecursiveGaussianKernel& _kernel)
+{
+	const double  b = _kernel.getB();
+	const double* a = _kernel.getA();
+	const double* m = _kernel.getBoundaryMatrix();
+	const int     n = _width * 4;
+	double* tmp = tmp_ + 3 * n; // row 0
+
+ // causal
+	for (int c = 0; c < n; ++c)
+	{
+		tmp[c - n] = tmp[c - 2 * n] = tmp[c - 3 * n] = (double)_rows[c];
+	}
+	for (int y = 0; y < _count; ++y)
+	{
+		const float* in = _rows + y * n;
+		double*      w  = tmp + y * n;
+		for (int c = 0; c < n; ++c)
+		{
+			w[c] = b * (double)in[c] + a[0] * w[c - n] + a[1] * w[c - 2 * n] + a[2] * w[c - 3 * n];
+		}
+	}
+
+ // anti-causal
+	const float* edge = _rows + (_count - 1) * n;
+	double*      w    = tmp + (_count - 1) * n;
+	for (int c = 0; c < n; ++c)
+	{
+		const double e = (double)edge[c];
+		const double u0 = w[c] - e, u1 = w[c - n] - e, u2 = w[c - 2 * n] - e;
+		w[c + n]     = m[0] * u0 + m[1] * u1 + m[2] * u2 + e;
+		w[c + 2 * n] = m[3] * u0 + m[4] * u1 + m[5] * u2 + e;
+		w[c + 3 * n] = m[6] * u0 + m[7] * u1 + m[8] * u2 + e;
+	}
+	for (int y = _count - 1; y >= 0; --y)
+	{
+		float*  out = out_ + y * n;
+		double* t   = tmp + y * n;
+		for (int c = 0; c < n; ++c)
+		{
+			t[c] = b * t[c] + a[0] * t[c + n] + a[1] * t[c + 2 * n] + a[2] * t[c + 3 * n];
+			out[c] = (float)t[c];
+		}
+	}
+}
+
+CONV_TARGET_SSE4 void RecursiveGaussianRows_Sse4(const float* _rows, float* out_, double* tmp_, int _count, int _width, const RecursiveGaussianKernel& _kernel)
+{
+	const __m128d b  = _mm_set1_pd(_kernel.getB());
+	const __m128d a0 = _mm_set1_pd(_kernel.getA()[0]);
+	const __m128d a1 = _mm_set1_pd(_kernel.getA()[1]);
+	const __m128d a2 = _mm_set1_pd(_kernel.getA()[2]);
+	const double* m  = _kernel.getBoundaryMatrix();
+	const int     n  = _width * 4;
+	double* tmp = tmp_ + 3 * n;
+
+	for (int c = 0; c < n; c += 2)
+	{
+		const __m128d w = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)(_rows + c))));
+		_mm_storeu_pd(tmp + c - n, w);
+		_mm_storeu_pd(tmp + c - 2 * n, w);
+		_mm_storeu_pd(tmp + c - 3 * n, w);
+	}
+	for (int y = 0; y < _count; ++y)
+	{
+		const float* in = _rows + y * n;
+		double*      w  = tmp + y * n;
+		for (int c = 0; c < n; c += 2)
+		{
+			const __m128d x  = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)(in + c))));
+			const __m128d w0 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b, x), _mm_mul_pd(a0, _mm_loadu_pd(w + c - n))), _mm_add_pd(_mm_mul_pd(a1, _mm_loadu_pd(w + c - 2 * n)), _mm_mul_pd(a2, _mm_loadu_pd(w + c - 3 * n))));
+			_mm_storeu_pd(w + c, w0);
+		}
+	}
+
+	const float* edgeRow = _rows + (_count - 1) * n;
+	double*      w       = tmp + (_count - 1) * n;
+	for (int c = 0; c < n; c += 2)
+	{
+		const __m128d edge = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)(edgeRow + c))));
+		const __m128d u0 = _mm_sub_pd(_mm_loadu_pd(w + c), edge), u1 = _mm_sub_pd(_mm_loadu_pd(w + c - n), edge), u2 = _mm_sub_pd(_mm_loadu_pd(w + c - 2 * n), edge);
+		_mm_storeu_pd(w + c + n,     _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[0]), u0), _mm_mul_pd(_mm_set1_pd(m[1]), u1)), _mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[2]), u2), edge)));
+		_mm_storeu_pd(w + c + 2 * n, _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[3]), u0), _mm_mul_pd(_mm_set1_pd(m[4]), u1)), _mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[5]), u2), edge)));
+		_mm_storeu_pd(w + c + 3 * n, _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[6]), u0), _mm_mul_pd(_mm_set1_pd(m[7]), u1)), _mm_add_pd(_mm_mul_pd(_mm_set1_pd(m[8]), u2), edge)));
+	}
+	for (int y = _count - 1; y >= 0; --y)
+	{
+		float*  out = out_ + y * n;
+		double* t   = tmp + y * n;
+		for (int c = 0; c < n; c += 2)
+		{
+			const __m128d y0 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b, _mm_loadu_pd(t + c)), _mm_mul_pd(a0, _mm_loadu_pd(t + c + n))), _mm_add_pd(_mm_mul_pd(a1, _mm_loadu_pd(t + c + 2 * n)), _mm_mul_pd(a2, _mm_loadu_pd(t + c + 3 * n))));
+			_mm_storeu_pd(t + c, y0);
+			_mm_store_sd((double*)(out + c), _mm_castps_pd(_mm_cvtpd_ps(y0)));
+		}
+	}
+}
+
+CONV_TARGET_AVX2 void RecursiveGaussianRows_Avx2(const float* _rows, float* out_, double* tmp_, int _count, int _width, const RecursiveGaussianKernel& _kernel)
+{
+	const __m256d b  = _mm256_set1_pd(_kernel.getB());
+	const __m256d a0 = _mm256_set1_pd(_kernel.getA()[0]);
+	const __m256d a1 = _mm256_set1_pd(_kernel.getA()[1]);
+	const __m256d a2 = _mm256_set1_pd(_kernel.getA()[2]);
+	const double* m  = _kernel.getBoundaryMatrix();
+	const int     n  = _width * 4;
+	double* tmp = tmp_ + 3 * n;
+
+	for (int c = 0; c < n; c += 4)
+	{
+		const __m256d w = _mm256_cvtps_pd(_mm_loadu_ps(_rows + c));
+		_mm256_storeu_pd(tmp + c - n, w);
+		_mm256_storeu_pd(tmp + c - 2 * n, w);
+		_mm256_storeu_pd(tmp + c - 3 * n, w);
+	}
+	for (int y = 0; y < _count; ++y)
+	{
+		const float* in = _rows + y * n;
+		double*      w  = tmp + y * n;
+		for (int c = 0; c < n; c += 4)
+		{
+			__m256d w0 = _mm256_mul_pd(b, _mm256_cvtps_pd(_mm_loadu_ps(in + c)));
+			w0 = _mm256_fmadd_pd(a0, _mm256_loadu_pd(w + c - n), w0);
+			w0 = _mm256_fmadd_pd(a1, _mm256_loadu_pd(w + c - 2 * n), w0);
+			w0 = _mm256_fmadd_pd(a2, _mm256_loadu_pd(w + c - 3 * n), w0);
+			_mm256_storeu_pd(w + c, w0);
+		}
+	}
+
+	const float* edgeRow = _rows + (_count - 1) * n;
+	double*      w       = tmp + (_count - 1) * n;
+	for (int c = 0; c < n; c += 4)
+	{
+		const __m256d edge = _mm256_cvtps_pd(_mm_loadu_ps(edgeRow + c));
+		const __m256d u0 = _mm256_sub_pd(_mm256_loadu_pd(w + c), edge), u1 = _mm256_sub_pd(_mm256_loadu_pd(w + c - n), edge), u2 = _mm256_sub_pd(_mm256_loadu_pd(w + c - 2 * n), edge);
+		_mm256_storeu_pd(w + c + n,     _mm256_fmadd_pd(_mm256_set1_pd(m[0]), u0, _mm256_fmadd_pd(_mm256_set1_pd(m[1]), u1, _mm256_fmadd_pd(_mm256_set1_pd(m[2]), u2, edge))));
+		_mm256_storeu_pd(w + c + 2 * n, _mm256_fmadd_pd(_mm256_set1_pd(m[3]), u0, _mm256_fmadd_pd(_mm256_set1_pd(m[4]), u1, _mm256_fmadd_pd(_mm256_set1_pd(m[5]), u2, edge))));
+		_mm256_storeu_pd(w + c + 3 * n, _mm256_fmadd_pd(_mm256_set1_pd(m[6]), u0, _mm256_fmadd_pd(_mm256_set1_pd(m[7]), u1, _mm256_fmadd_pd(_mm256_set1_pd(m[8]), u2, edge))));
+	}
+	for (int y = _count - 1; y >= 0; --y)
+	{
+		float*  out = out_ + y * n;
+		double* t   = tmp + y * n;
+		for (int c = 0; c < n; c += 4)
+		{
+			__m256d y0 = _mm256_mul_pd(b, _mm256_loadu_pd(t + c));
+			y0 = _mm256_fmadd_pd(a0, _mm256_loadu_pd(t + c + n), y0);
+			y0 = _mm256_fmadd_pd(a1, _mm256_loadu_pd(t + c + 2 * n), y0);
+			y0 = _mm256_fmadd_pd(a2, _mm256_loadu_pd(t + c + 3 * n), y0);
+			_mm256_storeu_pd(t + c, y0);
+			_mm_storeu_ps(out + c, _mm256_cvtpd_ps(y0));
+		}
+	}
+}
+
+RecursiveGaussianRowsFunc* GetRecursiveGaussianRowsFunc()
+{
+	switch (GetIsa())
+	{
+		case Isa_Avx2: return RecursiveGaussianRows_Avx2;
+		case Isa_Sse4: return RecursiveGaussianRows_Sse4;
+		default:       return RecursiveGaussianRows_Scalar;
+	};
+}
+
+// Columns per tile of the vertical pass.
+constexpr int kTileWidth = 64;
+
+} // namespace
+
+void RecursiveGaussianKernel::init(float _sigma)
+{
+	m_sigma = _sigma < 0.5f ? 0.5f : _sigma;
+
+ // Poles for sigma = 2 (van Vliet, Young & Verbeek, "Recursive Gaussian derivative filters", 1998, L2 optimized).
+ // Poles for other sigmas are d^(1/q); find q such that the variance of the causal + anti-causal pair, sum of
+ // 2d / (d - 1)^2 over the poles, is sigma^2. The variance increases monotonically with q so bisect.
+	const std::complex<double> kPoles[3] =
+	{
+		std::complex<double>(1.41650,  1.00829),
+		std::complex<double>(1.41650, -1.00829),
+		std::complex<double>(1.86543,  0.0),
+	};
+	auto scalePole = [](const std::complex<double>& _d, double _q)
+		{
+			return std::polar(pow(std::abs(_d), 1.0 / _q), std::arg(_d) / _q);
+		};
+	auto getVariance = [&](double _q)
+		{
+			double ret = 0.0;
+			for (const std::complex<double>& d : kPoles)
+			{
+				const std::complex<double> dq = scalePole(d, _q);
+				ret += (2.0 * dq / ((dq - 1.0) * (dq - 1.0))).real();
+			}
+			return ret;
+		};
+	const double sigma = (double)m_sigma;
+	double qMin = 0.0, qMax = sigma;
+	for (int i = 0; i < 64; ++i)
+	{
+		const double q = (qMin + qMax) * 0.5;
+		(getVariance(q) < sigma * sigma ? qMin : qMax) = q;
+	}
+	const double q = (qMin + qMax) * 0.5;
+
+ // expand 1 / ((1 - p0 z^-1)(1 - p1 z^-1)(1 - p2 z^-1)) where p = 1 / d, normalize for unit DC gain
+	std::complex<double> p[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		p[i] = 1.0 / scalePole(kPoles[i], q);
+	}
+	m_a[0] = (p[0] + p[1] + p[2]).real();
+	m_a[1] = -(p[0] * p[1] + p[0] * p[2] + p[1] * p[2]).real();
+	m_a[2] = (p[0] * p[1] * p[2]).real();
+	m_b    = 1.0 - (m_a[0] + m_a[1] + m_a[2]);
+
+ // Boundary matrix. Relative to the edge value the input beyond the right edge is 0, so the causal pass continues as
+ // the homogeneous recursion of its last 3 outputs and the anti-causal pass starts from 0 at infinity. Both are linear
+ // in the causal state, hence column k of M is the response to a unit causal state e_k, evaluated directly. The
+ // responses decay at least as fast as the Gaussian tail so a window of 40 sigma is exact to double precision.
+	const int window = (int)ceil(40.0 * sigma) + 16;
+	double* w = new double[window];
+	for (int k = 0; k < 3; ++k)
+	{
+		double w1 = k == 0 ? 1.0 : 0.0;
+		double w2 = k == 1 ? 1.0 : 0.0;
+		double w3 = k == 2 ? 1.0 : 0.0;
+		for (int i = 0; i < window; ++i)
+		{
+			w[i] = m_a[0] * w1 + m_a[1] * w2 + m_a[2] * w3;
+			w3 = w2; w2 = w1; w1 = w[i];
+		}
+		double y1 = 0.0, y2 = 0.0, y3 = 0.0;
+		for (int i = window - 1; i >= 0; --i)
+		{
+			const double y0 = m_b * w[i] + m_a[0] * y1 + m_a[1] * y2 + m_a[2] * y3;
+			y3 = y2; y2 = y1; y1 = y0;
+		}
+	 // y1..y3 are now y[N], y[N + 1], y[N + 2]
+		m_boundary[0 * 3 + k] = y1;
+		m_boundary[1 * 3 + k] = y2;
+		m_boundary[2 * 3 + k] = y3;
+	}
+	delete[] w;
+}
+
+void RecursiveGaussianPass(const Image& _src, Image& dst_, const RecursiveGaussianKernel& _kernel, Direction _direction, int _lineBegin, int _lineEnd)
+{
+	assert(_src.getWidth() == dst_.getWidth() && _src.getHeight() == dst_.getHeight());
+	_lineEnd = _lineEnd < 0 ? GetLineCount(dst_, _direction) : _lineEnd;
+	if (_lineEnd <= _lineBegin)
+	{
+		return;
+	}
+
+	RecursiveGaussianLineFunc* recursiveGaussianLine = GetRecursiveGaussianLineFunc();
+	RecursiveGaussianRowsFunc* recursiveGaussianRows = GetRecursiveGaussianRowsFunc();
+	const int texelCount = GetLineLength(dst_, _direction);
+
+ // The vertical pass filters tiles of kTileWidth columns a row at a time rather than walking single columns.
+	const int tileWidth = _direction == Direction_Horizontal ? 1 : kTileWidth;
+
+	float*  lineIn  = (float*)AlignedAlloc(sizeof(float) * 4 * texelCount * tileWidth);
+	float*  lineOut = (float*)AlignedAlloc(sizeof(float) * 4 * texelCount * tileWidth);
+	double* lineTmp = (double*)AlignedAlloc(sizeof(double) * 4 * (texelCount + 6) * tileWidth);
+	for (int line = _lineBegin; line < _lineEnd; line += tileWidth)
+	{
+		if (_direction == Direction_Horizontal)
+		{
+			ReadLine(_src, _direction, line, 0, texelCount, lineIn);
+			recursiveGaussianLine(lineIn, lineOut, lineTmp, texelCount, _kernel);
+			WriteLine(dst_, _direction, line, 0, texelCount, lineOut);
+			continue;
+		}
+
+		const int width = _lineEnd - line < tileWidth ? _lineEnd - line : tileWidth;
+		for (int y = 0; y < texelCount; ++y)
+		{
+			ReadLine(_src, Direction_Horizontal, y, line, width, lineIn + y * width * 4);
+		}
+		recursiveGaussianRows(lineIn, lineOut, lineTmp, texelCount, width, _kernel);
+		for (int y = 0; y < texelCount; ++y)
+		{
+			WriteLine(dst_, Direction_Horizontal, y, line, width, lineOut + y * width * 4);
+		}
+	}
+	AlignedFree(lineIn);
+	AlignedFree(lineOut);
+	AlignedFree(lineTmp);
+}
+
+void RecursiveGaussian(const Image& _src, Image& dst_, Image& tmp_, const RecursiveGaussianKernel& _kernel)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), dst_.getFormat());
+	RecursiveGaussianPass(_src, tmp_, _kernel, Direction_Horizontal);
+	RecursiveGaussianPass(tmp_, dst_, _kernel, Direction_Vertical);
+}
+
+void RecursiveGaussian(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const RecursiveGaussianKernel& _kernel)
+{
+	tmp_.init(dst_.getWidth(), dst_.getHeight(), dst_.getFormat());
+
+	for (Direction direction = 0; direction < Direction_Count; ++direction)
+	{
+		const Image& src = direction == Direction_Horizontal ? _src : tmp_;
+		Image&       dst = direction == Direction_Horizontal ? tmp_ : dst_;
+
+	 // ~4 chunks per thread for load balancing
+		const int lineCount = GetLineCount(dst, direction);
+		int chunkSize = (lineCount + _pool.getThreadCount() * 4 - 1) / (_pool.getThreadCount() * 4);
+		chunkSize = chunkSize < 16 ? 16 : chunkSize;
+
+		ThreadPool::TaskGroup group;
+		for (int lineBegin = 0; lineBegin < lineCount; lineBegin += chunkSize)
+		{
+			const int lineEnd = lineBegin + chunkSize < lineCount ? lineBegin + chunkSize : lineCount;
+			_pool.run(group, [&src, &dst, &_kernel, direction, lineBegin, lineEnd]()
+				{
+					RecursiveGaussianPass(src, dst, _kernel, direction, lineBegin, lineEnd);
+				});
+		}
+		_pool.wait(group);
+	}
+}
+
+} // namespace conv
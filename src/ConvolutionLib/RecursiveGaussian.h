@@ -0,0 +1,57 @@
+#pragma once
+
+// Recursive (IIR) Gaussian filter after Young & van Vliet ("Recursive implementation of the Gaussian filter", 1995): a
+// causal then an anti-causal 3rd order recursion per line. The poles are from van Vliet, Young & Verbeek ("Recursive
+// Gaussian derivative filters", 1998), scaled such that the variance is exactly sigma^2. The cost per texel is constant
+// (3 multiply-adds per pass) regardless of sigma, hence it's practical for sigmas far beyond what fits in
+// KernelBank::kMaxWidth. The result is an approximation of KernelGaussian1d() with an untruncated support, the error is
+// ~1% of the peak for sigma >= 8 and larger for small sigmas (see the 'recursive' benchmark).
+//
+// Edges are clamped (GL_CLAMP_TO_EDGE). The left edge is exact via the steady state of the causal pass, the right edge
+// via the boundary matrix of Triggs & Sdika ("Boundary conditions for Young-van Vliet recursive filtering", 2006).
+// The recursions are evaluated in double precision; for large sigmas the poles approach the unit circle and single
+// precision would drift.
+
+#include "Image.h"
+#include "Line.h"
+
+namespace conv {
+
+class ThreadPool;
+
+class RecursiveGaussianKernel
+{
+public:
+	// _sigma is clamped to >= 0.5, below which a 3 pole approximation is poor.
+	void          init(float _sigma);
+
+	float         getSigma() const                  { return m_sigma; }
+
+	// y[n] = b * x[n] + a[0] * y[n - 1] + a[1] * y[n - 2] + a[2] * y[n - 3] (causal pass, the anti-causal pass mirrors it).
+	double        getB() const                      { return m_b; }
+	const double* getA() const                      { return m_a; }
+
+	// Initial anti-causal state (y[N], y[N + 1], y[N + 2]) = M * (w[N - 1], w[N - 2], w[N - 3]) where w is the causal
+	// output and both are relative to the clamped edge value. 3x3, row major.
+	const double* getBoundaryMatrix() const         { return m_boundary; }
+
+private:
+	float  m_sigma        = 0.0f;
+	double m_b            = 1.0;
+	double m_a[3]         = {};
+	double m_boundary[9]  = {};
+};
+
+// Filter lines [_lineBegin, _lineEnd) of dst_ along _direction (_lineEnd < 0 means GetLineCount()). Unlike the FIR
+// passes the recursion requires the whole line, hence the range is of lines rather than rows. _src and dst_ must be the
+// same size but the formats may differ.
+void RecursiveGaussianPass(const Image& _src, Image& dst_, const RecursiveGaussianKernel& _kernel, Direction _direction, int _lineBegin = 0, int _lineEnd = -1);
+
+// Horizontal then vertical pass, see ConvolveSeparable(). tmp_ is (re)initialized if required.
+void RecursiveGaussian(const Image& _src, Image& dst_, Image& tmp_, const RecursiveGaussianKernel& _kernel);
+
+// Multi-threaded RecursiveGaussian(). The vertical pass reads whole columns of tmp_, so the passes are separated by a
+// barrier (rows are distributed for the horizontal pass, columns for the vertical pass).
+void RecursiveGaussian(ThreadPool& _pool, const Image& _src, Image& dst_, Image& tmp_, const RecursiveGaussianKernel& _kernel);
+
+} // namespace conv
@@ -0,0 +1,53 @@
+#include "Region.h"
+
+#include <cstddef>
+
+namespace conv {
+
+long long GetArea(const std::vector<Rect>& _rects)
+{
+	long long ret = 0;
+	for (const Rect& rect : _rects)
+	{
+		ret += rect.getArea();
+	}
+	return ret;
+}
+
+void MergeRects(std::vector<Rect>& rects_)
+{
+	for (size_t i = 0; i < rects_.size();)
+	{
+		if (rects_[i].isEmpty())
+		{
+			rects_[i] = rects_.back();
+			rects_.pop_back();
+			continue;
+		}
+		++i;
+	}
+
+ // the bounding rect of a merge may overlap rects which were already checked, repeat until nothing is merged
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (size_t i = 0; i < rects_.size(); ++i)
+		{
+			for (size_t j = i + 1; j < rects_.size();)
+			{
+				if (!Intersect(rects_[i], rects_[j]).isEmpty())
+				{
+					rects_[i] = Union(rects_[i], rects_[j]);
+					rects_[j] = rects_.back();
+					rects_.pop_back();
+					merged = true;
+					continue;
+				}
+				++j;
+			}
+		}
+	}
+}
+
+} // namespace conv
@@ -0,0 +1,54 @@
+#pragma once
+
+// Rectangular image regions for partial (region of interest/dirty rectangle) convolution, see ConvolveSeparableRect()
+// and ConvolveSeparableDirty().
+
+#include <vector>
+
+namespace conv {
+
+// Texels [m_x0, m_x1) x [m_y0, m_y1).
+struct Rect
+{
+	int m_x0 = 0;
+	int m_y0 = 0;
+	int m_x1 = 0;
+	int m_y1 = 0;
+
+	Rect() = default;
+	Rect(int _x0, int _y0, int _x1, int _y1): m_x0(_x0), m_y0(_y0), m_x1(_x1), m_y1(_y1) {}
+
+	int  getWidth() const                            { return m_x1 - m_x0; }
+	int  getHeight() const                           { return m_y1 - m_y0; }
+	bool isEmpty() const                             { return m_x1 <= m_x0 || m_y1 <= m_y0; }
+	long long getArea() const                        { return isEmpty() ? 0 : (long long)getWidth() * (long long)getHeight(); }
+};
+
+inline Rect Intersect(const Rect& _a, const Rect& _b)
+{
+	return Rect(
+		_a.m_x0 > _b.m_x0 ? _a.m_x0 : _b.m_x0,
+		_a.m_y0 > _b.m_y0 ? _a.m_y0 : _b.m_y0,
+		_a.m_x1 < _b.m_x1 ? _a.m_x1 : _b.m_x1,
+		_a.m_y1 < _b.m_y1 ? _a.m_y1 : _b.m_y1
+		);
+}
+
+inline Rect Union(const Rect& _a, const Rect& _b)
+{
+	return Rect(
+		_a.m_x0 < _b.m_x0 ? _a.m_x0 : _b.m_x0,
+		_a.m_y0 < _b.m_y0 ? _a.m_y0 : _b.m_y0,
+		_a.m_x1 > _b.m_x1 ? _a.m_x1 : _b.m_x1,
+		_a.m_y1 > _b.m_y1 ? _a.m_y1 : _b.m_y1
+		);
+}
+
+// Total area of _rects, overlaps are counted once per rect.
+long long GetArea(const std::vector<Rect>& _rects);
+
+// Remove empty rects and replace overlapping rects with their bounding rect until none overlap. The result covers (at
+// least) the input, each texel is covered once.
+void MergeRects(std::vector<Rect>& rects_);
+
+} // namespace conv
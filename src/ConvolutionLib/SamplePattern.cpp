@@ -0,0 +1,339 @@
+#include "SamplePattern.h"
+
+#include "Kernel.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace conv {
+
+namespace {
+
+inline uint32_t Xorshift32(uint32_t& state_)
+{
+	state_ ^= state_ << 13;
+	state_ ^= state_ >> 17;
+	state_ ^= state_ << 5;
+	return state_;
+}
+
+inline float RandFloat(uint32_t& state_)
+{
+	return (float)(Xorshift32(state_) >> 8) * (1.0f / 16777216.0f);
+}
+
+inline float DistanceSquared(const float* _a, const float* _b)
+{
+	const float dx = _a[0] - _b[0];
+	const float dy = _a[1] - _b[1];
+	return dx * dx + dy * dy;
+}
+
+} // namespace
+
+void SamplePatternSet::init(uint32_t _seed)
+{
+	for (int count = 1; count <= kMaxSampleCount; ++count)
+	{
+		GenerateSamplePattern(count, _seed + (uint32_t)count, m_points + GetPatternOffset(count) * 2);
+	}
+
+	const int texelCount = kRotationSize * kRotationSize;
+	std::vector<float> noise(texelCount);
+	GenerateBlueNoise(kRotationSize, _seed, noise.data());
+	m_rotation.init(kRotationSize, kRotationSize, Format_RGBA8);
+	uint8_t* texels = (uint8_t*)m_rotation.getData();
+	for (int i = 0; i < texelCount; ++i)
+	{
+		const float theta = noise[i] * 2.0f * kPi;
+		texels[i * 4 + 0] = (uint8_t)(cosf(theta) * 127.5f + 127.5f + 0.5f);
+		texels[i * 4 + 1] = (uint8_t)(sinf(theta) * 127.5f + 127.5f + 0.5f);
+		texels[i * 4 + 2] = (uint8_t)(noise[i] * 255.0f + 0.5f);
+		texels[i * 4 + 3] = 255;
+	}
+}
+
+void SamplePatternSet::getRotation(int _x, int _y, float* cosSin_) const
+{
+	const uint8_t* texel = (const uint8_t*)m_rotation.getRow(_y & (kRotationSize - 1)) + (_x & (kRotationSize - 1)) * 4;
+	cosSin_[0] = (float)texel[0] / 255.0f * 2.0f - 1.0f;
+	cosSin_[1] = (float)texel[1] / 255.0f * 2.0f - 1.0f;
+}
+
+SamplePatternQuality GetSamplePatternQuality(const float* _xy, int _count)
+{
+	SamplePatternQuality ret;
+
+ // Warnock's formula for the L2 star discrepancy, points mapped to [0, 1]^2
+	std::vector<float> p(_count * 2);
+	for (int i = 0; i < _count * 2; ++i)
+	{
+		p[i] = _xy[i] * 0.5f + 0.5f;
+	}
+	double sum1 = 0.0, sum2 = 0.0;
+	for (int i = 0; i < _count; ++i)
+	{
+		sum1 += (1.0 - (double)p[i * 2] * p[i * 2]) * (1.0 - (double)p[i * 2 + 1] * p[i * 2 + 1]) / 4.0;
+		for (int j = 0; j < _count; ++j)
+		{
+			sum2 += (1.0 - (double)fmaxf(p[i * 2], p[j * 2])) * (1.0 - (double)fmaxf(p[i * 2 + 1], p[j * 2 + 1]));
+		}
+	}
+	const double n = (double)_count;
+	const double d2 = 1.0 / 9.0 - 2.0 / n * sum1 + sum2 / (n * n);
+	ret.m_discrepancy = (float)sqrt(d2 > 0.0 ? d2 : 0.0);
+
+ // relative to the distance of a hexagonal packing of _count points over the area (4)
+	float minDistance2 = 1e30f;
+	for (int i = 0; i < _count; ++i)
+	{
+		for (int j = i + 1; j < _count; ++j)
+		{
+			minDistance2 = fminf(minDistance2, DistanceSquared(_xy + i * 2, _xy + j * 2));
+		}
+	}
+	const float hexDistance = sqrtf(2.0f * 4.0f / (sqrtf(3.0f) * (float)_count));
+	ret.m_minDistance = _count > 1 ? sqrtf(minDistance2) / hexDistance : 1.0f;
+
+	const int binCount = (int)(sqrtf((float)_count) * 0.5f) + 1;
+	std::vector<float> spectrum(binCount);
+	GetRadialSpectrum(_xy, _count, binCount, spectrum.data());
+	float lowPower = 0.0f;
+	for (int i = 1; i < binCount; ++i) // skip DC
+	{
+		lowPower += spectrum[i];
+	}
+	ret.m_lowFrequencyPower = binCount > 1 ? lowPower / (float)(binCount - 1) : 0.0f;
+
+	return ret;
+}
+
+void GetRadialSpectrum(const float* _xy, int _count, int _binCount, float* spectrum_)
+{
+	std::vector<double> power(_binCount, 0.0);
+	std::vector<int> samples(_binCount, 0);
+	for (int fy = -_binCount; fy <= _binCount; ++fy)
+	{
+		for (int fx = -_binCount; fx <= _binCount; ++fx)
+		{
+			const int bin = (int)(sqrtf((float)(fx * fx + fy * fy)) + 0.5f);
+			if (bin >= _binCount)
+			{
+				continue;
+			}
+			double re = 0.0, im = 0.0;
+			for (int i = 0; i < _count; ++i)
+			{
+				const double phase = -2.0 * (double)kPi * ((double)fx * (_xy[i * 2] * 0.5 + 0.5) + (double)fy * (_xy[i * 2 + 1] * 0.5 + 0.5));
+				re += cos(phase);
+				im += sin(phase);
+			}
+			power[bin] += (re * re + im * im) / (double)_count;
+			++samples[bin];
+		}
+	}
+	for (int i = 0; i < _binCount; ++i)
+	{
+		spectrum_[i] = samples[i] > 0 ? (float)(power[i] / (double)samples[i]) : 0.0f;
+	}
+}
+
+void GenerateHammersley2d(int _count, float* xy_)
+{
+	const float rn = 1.0f / (float)_count;
+	for (int i = 0; i < _count; ++i)
+	{
+		uint32_t bits = (uint32_t)i;
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xaaaaaaaau) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xccccccccu) >> 2);
+		bits = ((bits & 0x0f0f0f0fu) << 4) | ((bits & 0xf0f0f0f0u) >> 4);
+		bits = ((bits & 0x00ff00ffu) << 8) | ((bits & 0xff00ff00u) >> 8);
+		xy_[i * 2 + 0] = (float)i * rn * 2.0f - 1.0f;
+		xy_[i * 2 + 1] = (float)bits * 2.3283064365386963e-10f * 2.0f - 1.0f;
+	}
+}
+
+void GenerateSamplePattern(int _count, uint32_t _seed, float* xy_)
+{
+	assert(_count > 0);
+	uint32_t rng = _seed * 0x9e3779b9u + 1u;
+
+ // best candidate start (Mitchell 1991)
+	for (int i = 0; i < _count; ++i)
+	{
+		float best[2] = { 0.0f, 0.0f };
+		float bestDistance2 = -1.0f;
+		const int candidateCount = i == 0 ? 1 : i * 8 + 1;
+		for (int j = 0; j < candidateCount; ++j)
+		{
+			const float candidate[2] = { RandFloat(rng) * 2.0f - 1.0f, RandFloat(rng) * 2.0f - 1.0f };
+			float distance2 = 1e30f;
+			for (int k = 0; k < i; ++k)
+			{
+				distance2 = fminf(distance2, DistanceSquared(candidate, xy_ + k * 2));
+			}
+			if (distance2 > bestDistance2)
+			{
+				best[0] = candidate[0];
+				best[1] = candidate[1];
+				bestDistance2 = distance2;
+			}
+		}
+		xy_[i * 2 + 0] = best[0];
+		xy_[i * 2 + 1] = best[1];
+	}
+
+ // Lloyd's algorithm over a grid of the square, each point moves to the centroid of its Voronoi cell
+	const int kGridSize = 64;
+	const int kIterationCount = 48;
+	std::vector<float> centroids(_count * 3);
+	for (int iteration = 0; iteration < kIterationCount; ++iteration)
+	{
+		std::fill(centroids.begin(), centroids.end(), 0.0f);
+		for (int gy = 0; gy < kGridSize; ++gy)
+		{
+			for (int gx = 0; gx < kGridSize; ++gx)
+			{
+				const float p[2] = { ((float)gx + 0.5f) / (float)kGridSize * 2.0f - 1.0f, ((float)gy + 0.5f) / (float)kGridSize * 2.0f - 1.0f };
+				int nearest = 0;
+				float nearestDistance2 = 1e30f;
+				for (int i = 0; i < _count; ++i)
+				{
+					const float distance2 = DistanceSquared(p, xy_ + i * 2);
+					if (distance2 < nearestDistance2)
+					{
+						nearest = i;
+						nearestDistance2 = distance2;
+					}
+				}
+				centroids[nearest * 3 + 0] += p[0];
+				centroids[nearest * 3 + 1] += p[1];
+				centroids[nearest * 3 + 2] += 1.0f;
+			}
+		}
+		for (int i = 0; i < _count; ++i)
+		{
+			if (centroids[i * 3 + 2] > 0.0f)
+			{
+				xy_[i * 2 + 0] = centroids[i * 3 + 0] / centroids[i * 3 + 2];
+				xy_[i * 2 + 1] = centroids[i * 3 + 1] / centroids[i * 3 + 2];
+			}
+		}
+	}
+}
+
+void GenerateBlueNoise(int _size, uint32_t _seed, float* values_)
+{
+	assert((_size & (_size - 1)) == 0);
+	const int   count = _size * _size;
+	const int   mask  = _size - 1;
+	const float kSigma = 1.5f;
+
+ // toroidal Gaussian energy of a point at (0, 0)
+	std::vector<float> kernel(count);
+	for (int y = 0; y < _size; ++y)
+	{
+		for (int x = 0; x < _size; ++x)
+		{
+			const int dx = x < _size / 2 ? x : _size - x;
+			const int dy = y < _size / 2 ? y : _size - y;
+			kernel[y * _size + x] = expf(-(float)(dx * dx + dy * dy) / (2.0f * kSigma * kSigma));
+		}
+	}
+
+	std::vector<uint8_t> pattern(count, 0);
+	std::vector<float> energy(count, 0.0f);
+	auto update = [&](int _i, float _sign)
+		{
+			const int px = _i & mask, py = _i / _size;
+			for (int y = 0; y < _size; ++y)
+			{
+				const float* k = kernel.data() + ((y - py) & mask) * _size;
+				float* e = energy.data() + y * _size;
+				for (int x = 0; x < _size; ++x)
+				{
+					e[x] += _sign * k[(x - px) & mask];
+				}
+			}
+		};
+	auto tightestCluster = [&]()
+		{
+			int ret = 0;
+			float maxEnergy = -1e30f;
+			for (int i = 0; i < count; ++i)
+			{
+				if (pattern[i] && energy[i] > maxEnergy)
+				{
+					ret = i;
+					maxEnergy = energy[i];
+				}
+			}
+			return ret;
+		};
+	auto largestVoid = [&]()
+		{
+			int ret = 0;
+			float minEnergy = 1e30f;
+			for (int i = 0; i < count; ++i)
+			{
+				if (!pattern[i] && energy[i] < minEnergy)
+				{
+					ret = i;
+					minEnergy = energy[i];
+				}
+			}
+			return ret;
+		};
+
+ // initial binary pattern (~10% random), relaxed by moving the tightest cluster to the largest void until stable
+	uint32_t rng = _seed * 0x9e3779b9u + 1u;
+	int onesCount = 0;
+	while (onesCount < count / 10)
+	{
+		const int i = (int)(Xorshift32(rng) % (uint32_t)count);
+		if (!pattern[i])
+		{
+			pattern[i] = 1;
+			update(i, 1.0f);
+			++onesCount;
+		}
+	}
+	for (;;)
+	{
+		const int cluster = tightestCluster();
+		pattern[cluster] = 0;
+		update(cluster, -1.0f);
+		const int gap = largestVoid();
+		pattern[gap] = 1;
+		update(gap, 1.0f);
+		if (gap == cluster)
+		{
+			break;
+		}
+	}
+
+ // rank the initial pattern by removing the tightest clusters, then fill the largest voids
+	std::vector<uint8_t> initialPattern = pattern;
+	std::vector<float> initialEnergy = energy;
+	for (int rank = onesCount - 1; rank >= 0; --rank)
+	{
+		const int cluster = tightestCluster();
+		pattern[cluster] = 0;
+		update(cluster, -1.0f);
+		values_[cluster] = ((float)rank + 0.5f) / (float)count;
+	}
+	pattern = initialPattern;
+	energy = initialEnergy;
+	for (int rank = onesCount; rank < count; ++rank)
+	{
+		const int gap = largestVoid();
+		pattern[gap] = 1;
+		update(gap, 1.0f);
+		values_[gap] = ((float)rank + 0.5f) / (float)count;
+	}
+}
+
+} // namespace conv
@@ -0,0 +1,77 @@
+#pragma once
+
+// Sample patterns for the stochastic blur (ConvolutionPrefiltered_cs.glsl, see PrefilterBlur). The shader evaluates
+// Hammersley points and a sin/cos of an interleaved gradient noise rotation per sample per pixel; SamplePatternSet
+// replaces both with tables which are generated once:
+//
+//  - Point sets for 1..kMaxSampleCount samples in [-1, 1]^2, relaxed towards a centroidal Voronoi tessellation (Lloyd's
+//    algorithm from a best candidate start) which spaces the points evenly (Poisson disc like) with a low discrepancy.
+//    vs. Hammersley (see 'patterns' in ConvolutionBench): the discrepancy is lower at every count and the min distance
+//    is larger at every count except 2 (0.66 vs 0.93, Hammersley's pair is already optimal). The low frequency power is
+//    not uniformly better: it's lower at 64 but higher at e.g. 12, 32 and 48 (~0.013 vs 0.004-0.008), relaxation
+//    trades some of the spectral shaping for uniformity.
+//  - A tiled blue noise rotation texture (void and cluster, Ulichney 1993), the per pixel rotation is uniform in angle
+//    but neighbouring pixels have dissimilar rotations, hence the error is high frequency and less visible.
+//
+// Quality metrics: the L2 star discrepancy (Warnock's formula, lower is more uniform), the min distance between points
+// and the radial power spectrum (periodogram averaged over annuli; white noise is 1 everywhere, blue noise is low below
+// ~sqrt(N) cycles).
+
+#include "Image.h"
+
+#include <cstdint>
+
+namespace conv {
+
+class SamplePatternSet
+{
+public:
+	static const int kMaxSampleCount = 64;
+	static const int kRotationSize   = 64; // rotation texture size (power of 2, tiled)
+
+	// Generate the point sets and the rotation texture (deterministic for a given _seed). This is slow (~1s), call it
+	// from a worker in interactive code.
+	void         init(uint32_t _seed = 1);
+
+	// Points for _count samples as x,y pairs in [-1, 1]^2, _count in [1, kMaxSampleCount].
+	const float* getPattern(int _count) const          { return m_points + GetPatternOffset(_count) * 2; }
+
+	// All point sets packed as x,y pairs in order of sample count (i.e. a vec2 buffer), see GetPatternOffset().
+	const float* getData() const                       { return m_points; }
+	size_t       getDataSize() const                   { return sizeof(m_points); }
+	static int   GetPatternOffset(int _count)          { return _count * (_count - 1) / 2; } // in points
+
+	// Rotation texture, RGBA8 with RG = (cos, sin) * 0.5 + 0.5 of the rotation angle and B = the blue noise value.
+	const Image& getRotationTexture() const            { return m_rotation; }
+
+	// Decoded rotation at pixel (_x, _y) (tiled), as the GPU would see it.
+	void         getRotation(int _x, int _y, float* cosSin_) const;
+
+private:
+	float m_points[kMaxSampleCount * (kMaxSampleCount + 1)];
+	Image m_rotation;
+};
+
+struct SamplePatternQuality
+{
+	float m_discrepancy;        // L2 star discrepancy of the points mapped to [0, 1]^2
+	float m_minDistance;        // min distance between points, relative to the ideal hexagonal packing distance
+	float m_lowFrequencyPower;  // mean radial power for frequencies in (0, sqrt(N) / 2] cycles, white noise ~1
+};
+
+// Quality of _count points (x,y pairs in [-1, 1]^2).
+SamplePatternQuality GetSamplePatternQuality(const float* _xy, int _count);
+
+// Radial power spectrum of _count points (x,y pairs in [-1, 1]^2), _binCount bins of 1 cycle over the unit square.
+void GetRadialSpectrum(const float* _xy, int _count, int _binCount, float* spectrum_);
+
+// _count Hammersley points in [-1, 1]^2, as per ConvolutionPrefiltered_cs.glsl.
+void GenerateHammersley2d(int _count, float* xy_);
+
+// _count relaxed points in [-1, 1]^2, see SamplePatternSet.
+void GenerateSamplePattern(int _count, uint32_t _seed, float* xy_);
+
+// _size x _size (power of 2) tileable blue noise, values_ is a permutation of (i + 0.5) / (_size * _size).
+void GenerateBlueNoise(int _size, uint32_t _seed, float* values_);
+
+} // namespace conv
@@ -0,0 +1,73 @@
+#include "Schedule.h"
+
+#include "ThreadPool.h"
+
+#include <atomic>
+
+namespace conv {
+
+void RunSeparablePasses(ThreadPool& _pool, int _height, int _minOffset, int _maxOffset, int _bandHeight, const PassFunc& _horizontal, const PassFunc& _vertical)
+{
+	const int height = _height;
+	if (height <= 0)
+	{
+		return;
+	}
+	if (_bandHeight <= 0)
+	{
+	 // ~4 bands per thread for load balancing, but not so small that the vertical pass reads mostly halo rows (at least
+	 // the kernel extent, else large kernels would read more halo rows than output rows)
+		const int bandsPerThread = 4;
+		const int minBandHeight  = _maxOffset - _minOffset > 16 ? _maxOffset - _minOffset : 16;
+		_bandHeight = (height + _pool.getThreadCount() * bandsPerThread - 1) / (_pool.getThreadCount() * bandsPerThread);
+		_bandHeight = _bandHeight < minBandHeight ? minBandHeight : _bandHeight;
+	}
+	const int bandCount = (height + _bandHeight - 1) / _bandHeight;
+	const int minOffset = _minOffset < 0 ? _minOffset : 0;
+	const int maxOffset = _maxOffset > 0 ? _maxOffset : 0;
+
+ // vertical band v reads rows [v * _bandHeight + minOffset, (v + 1) * _bandHeight - 1 + maxOffset] of tmp_
+	auto getFirstDependency = [=](int _v) { int row = _v * _bandHeight + minOffset;            return (row < 0 ? 0 : row) / _bandHeight; };
+	auto getLastDependency  = [=](int _v) { int row = (_v + 1) * _bandHeight - 1 + maxOffset;  return (row >= height ? height - 1 : row) / _bandHeight; };
+	std::atomic<int>* dependencyCounts = new std::atomic<int>[bandCount];
+	for (int v = 0; v < bandCount; ++v)
+	{
+		dependencyCounts[v] = getLastDependency(v) - getFirstDependency(v) + 1;
+	}
+	const int radiusBands = ((-minOffset > maxOffset ? -minOffset : maxOffset) + _bandHeight - 1) / _bandHeight + 1;
+
+	ThreadPool::TaskGroup group;
+	auto runVertical = [&](int _v)
+		{
+			int rowEnd = (_v + 1) * _bandHeight;
+			_vertical(_v * _bandHeight, rowEnd < height ? rowEnd : height);
+		};
+	for (int h = 0; h < bandCount; ++h)
+	{
+		_pool.run(group, [&, h]()
+			{
+				int rowEnd = (h + 1) * _bandHeight;
+				_horizontal(h * _bandHeight, rowEnd < height ? rowEnd : height);
+
+			 // release the vertical bands which read this band, they're queued on this thread's queue so they'll likely run next
+				int vBegin = h - radiusBands < 0 ? 0 : h - radiusBands;
+				int vEnd   = h + radiusBands + 1 > bandCount ? bandCount : h + radiusBands + 1;
+				for (int v = vBegin; v < vEnd; ++v)
+				{
+					if (h < getFirstDependency(v) || h > getLastDependency(v))
+					{
+						continue;
+					}
+					if (dependencyCounts[v].fetch_sub(1) == 1)
+					{
+						_pool.run(group, [&runVertical, v]() { runVertical(v); });
+					}
+				}
+			});
+	}
+	_pool.wait(group);
+
+	delete[] dependencyCounts;
+}
+
+} // namespace conv
@@ -0,0 +1,20 @@
+#pragma once
+
+// Banded scheduling of a pair of separable passes on a ThreadPool.
+
+#include <functional>
+
+namespace conv {
+
+class ThreadPool;
+
+// Convolve rows [_rowBegin, _rowEnd) of the destination of a pass.
+typedef std::function<void(int _rowBegin, int _rowEnd)> PassFunc;
+
+// Split _height rows into bands of _bandHeight rows (0 = choose automatically) and run _horizontal then _vertical over
+// the bands. Horizontal bands are independent. The vertical pass for a band is queued as soon as the horizontal bands
+// which it reads are complete; vertical band [b0, b1) reads rows [b0 + _minOffset, b1 - 1 + _maxOffset] of the output
+// of the horizontal pass. The passes therefore overlap rather than being separated by a full barrier.
+void RunSeparablePasses(ThreadPool& _pool, int _height, int _minOffset, int _maxOffset, int _bandHeight, const PassFunc& _horizontal, const PassFunc& _vertical);
+
+} // namespace conv
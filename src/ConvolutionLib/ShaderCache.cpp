@@ -0,0 +1,385 @@
+#include "ShaderCache.h"
+
+#include <cassert>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _MSC_VER
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+namespace conv {
+
+namespace {
+
+const uint32_t kBinaryMagic = 0x42535643; // 'CVSB'
+
+bool ReadFile(const char* _path, std::string& data_)
+{
+	FILE* file = fopen(_path, "rb");
+	if (!file)
+	{
+		return false;
+	}
+	data_.clear();
+	char buf[4096];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+	{
+		data_.append(buf, n);
+	}
+	fclose(file);
+	return true;
+}
+
+bool WriteFile(const char* _path, const void* _data, size_t _size)
+{
+	FILE* file = fopen(_path, "wb");
+	if (!file)
+	{
+		return false;
+	}
+	const bool ret = fwrite(_data, 1, _size, file) == _size;
+	return fclose(file) == 0 && ret;
+}
+
+void MakeDirectory(const char* _path)
+{
+	#ifdef _MSC_VER
+		_mkdir(_path);
+	#else
+		mkdir(_path, 0755);
+	#endif
+}
+
+// If _line is an include directive set path_ and return true.
+bool ParseInclude(const char* _line, const char* _end, std::string& path_)
+{
+	const char* c = _line;
+	while (c < _end && (*c == ' ' || *c == '\t'))
+	{
+		++c;
+	}
+	if (c == _end || *c != '#')
+	{
+		return false;
+	}
+	++c;
+	while (c < _end && (*c == ' ' || *c == '\t'))
+	{
+		++c;
+	}
+	if (_end - c < 7 || strncmp(c, "include", 7) != 0)
+	{
+		return false;
+	}
+	const char* begin = (const char*)memchr(c + 7, '"', _end - (c + 7));
+	if (!begin)
+	{
+		return false;
+	}
+	++begin;
+	const char* end = (const char*)memchr(begin, '"', _end - begin);
+	if (!end)
+	{
+		return false;
+	}
+	path_.assign(begin, end);
+	return true;
+}
+
+} // namespace
+
+void ShaderPreprocessor::addSearchPath(const char* _path)
+{
+	std::string path = _path;
+	if (!path.empty() && path.back() != '/' && path.back() != '\\')
+	{
+		path += '/';
+	}
+	m_searchPaths.push_back(path);
+}
+
+void ShaderPreprocessor::addFile(const char* _path, const char* _source)
+{
+	m_addedFiles[_path] = _source;
+	m_resolved.clear();
+}
+
+const std::string* ShaderPreprocessor::preprocess(const char* _path)
+{
+	auto it = m_resolved.find(_path);
+	if (it != m_resolved.end())
+	{
+		return &it->second.m_source;
+	}
+
+	m_error.clear();
+	std::vector<std::string> stack, included;
+	Resolved resolved;
+	if (!resolve(_path, stack, included, resolved.m_source))
+	{
+		return nullptr;
+	}
+	resolved.m_hash = HashFnv1a64(resolved.m_source.data(), resolved.m_source.size());
+	++m_resolveCount;
+	return &m_resolved.emplace(_path, std::move(resolved)).first->second.m_source;
+}
+
+uint64_t ShaderPreprocessor::getHash(const char* _path)
+{
+	if (!preprocess(_path))
+	{
+		return 0;
+	}
+	return m_resolved.find(_path)->second.m_hash;
+}
+
+void ShaderPreprocessor::clear()
+{
+	m_files.clear();
+	m_resolved.clear();
+}
+
+const std::string* ShaderPreprocessor::findFile(const std::string& _path)
+{
+	auto added = m_addedFiles.find(_path);
+	if (added != m_addedFiles.end())
+	{
+		return &added->second;
+	}
+	auto it = m_files.find(_path);
+	if (it != m_files.end())
+	{
+		return &it->second;
+	}
+
+	std::string data;
+	bool found = false;
+	for (const std::string& searchPath : m_searchPaths)
+	{
+		if (ReadFile((searchPath + _path).c_str(), data))
+		{
+			found = true;
+			break;
+		}
+	}
+	if (!found && !ReadFile(_path.c_str(), data))
+	{
+		return nullptr;
+	}
+	++m_fileReadCount;
+	return &m_files.emplace(_path, std::move(data)).first->second;
+}
+
+bool ShaderPreprocessor::resolve(const std::string& _path, std::vector<std::string>& _stack, std::vector<std::string>& _included, std::string& source_)
+{
+	const std::string* file = findFile(_path);
+	if (!file)
+	{
+		m_error = "File not found: '" + _path + "'";
+		if (!_stack.empty())
+		{
+			m_error += " (included from '" + _stack.back() + "')";
+		}
+		return false;
+	}
+	const int fileIndex = (int)_included.size();
+	_included.push_back(_path);
+	_stack.push_back(_path);
+
+	const char* c   = file->data();
+	const char* end = c + file->size();
+	int lineNumber = 1;
+	std::string includePath;
+	while (c < end)
+	{
+		const char* lineEnd = (const char*)memchr(c, '\n', end - c);
+		lineEnd = lineEnd ? lineEnd : end;
+		if (ParseInclude(c, lineEnd, includePath))
+		{
+			bool alreadyIncluded = false;
+			for (const std::string& path : _included)
+			{
+				alreadyIncluded |= path == includePath;
+			}
+			if (!alreadyIncluded)
+			{
+				char line[64];
+				snprintf(line, sizeof(line), "#line 1 %d\n", (int)_included.size());
+				source_ += line;
+				if (!resolve(includePath, _stack, _included, source_))
+				{
+					return false;
+				}
+				if (!source_.empty() && source_.back() != '\n')
+				{
+					source_ += '\n';
+				}
+			}
+			char line[64];
+			snprintf(line, sizeof(line), "#line %d %d\n", lineNumber + 1, fileIndex);
+			source_ += line;
+		}
+		else
+		{
+			source_.append(c, lineEnd);
+			if (lineEnd < end)
+			{
+				source_ += '\n';
+			}
+		}
+		c = lineEnd + 1;
+		++lineNumber;
+	}
+
+	_stack.pop_back();
+	return true;
+}
+
+void ShaderDefines::add(const char* _name, int _value)
+{
+	char value[16];
+	snprintf(value, sizeof(value), "%d", _value);
+	m_defines[_name] = value;
+}
+
+void ShaderDefines::add(const char* _name, const char* _value)
+{
+	m_defines[_name] = _value;
+}
+
+std::string ShaderDefines::getSource() const
+{
+	std::string ret;
+	for (auto& define : m_defines)
+	{
+		ret += "#define " + define.first + " " + define.second + "\n";
+	}
+	return ret;
+}
+
+uint64_t ShaderDefines::getHash() const
+{
+	const std::string source = getSource();
+	return HashFnv1a64(source.data(), source.size());
+}
+
+void ShaderPermutationCache::init(ShaderPreprocessor* _preprocessor, const char* _dir, const char* _binaryTag)
+{
+	shutdown();
+	m_preprocessor = _preprocessor;
+	m_dir          = _dir ? _dir : "";
+	m_binaryTag    = HashFnv1a64(_binaryTag, strlen(_binaryTag));
+	if (!m_dir.empty())
+	{
+		MakeDirectory(m_dir.c_str());
+	}
+}
+
+void ShaderPermutationCache::shutdown()
+{
+	for (auto& it : m_permutations)
+	{
+		delete it.second;
+	}
+	m_permutations.clear();
+	m_hitCount        = 0;
+	m_missCount       = 0;
+	m_binaryLoadCount = 0;
+}
+
+const ShaderPermutation* ShaderPermutationCache::get(const char* _path, const ShaderDefines& _defines)
+{
+	assert(m_preprocessor);
+	const uint64_t sourceHash = m_preprocessor->getHash(_path);
+	if (sourceHash == 0)
+	{
+		return nullptr;
+	}
+	const uint64_t definesHash = _defines.getHash();
+	const uint64_t key = HashFnv1a64(&definesHash, sizeof(definesHash), sourceHash);
+	auto it = m_permutations.find(key);
+	if (it != m_permutations.end())
+	{
+		++m_hitCount;
+		return it->second;
+	}
+	++m_missCount;
+
+	ShaderPermutation* ret = new ShaderPermutation;
+	ret->m_key  = key;
+	ret->m_path = _path;
+
+ // defines go after #version (which must be first), #line restores the line numbers of the top level file
+	const std::string& source = *m_preprocessor->preprocess(_path);
+	size_t bodyBegin = 0;
+	int    bodyLine  = 1;
+	if (source.compare(0, 8, "#version") == 0)
+	{
+		bodyBegin = source.find('\n');
+		bodyBegin = bodyBegin == std::string::npos ? source.size() : bodyBegin + 1;
+		bodyLine  = 2;
+	}
+	char line[32];
+	snprintf(line, sizeof(line), "#line %d 0\n", bodyLine);
+	ret->m_source = source.substr(0, bodyBegin) + _defines.getSource() + line + source.substr(bodyBegin);
+
+	if (!m_dir.empty())
+	{
+		WriteFile(getPath(key, "glsl").c_str(), ret->m_source.data(), ret->m_source.size());
+
+		std::string binary;
+		if (ReadFile(getPath(key, "bin").c_str(), binary) && binary.size() >= sizeof(uint32_t) * 2 + sizeof(uint64_t))
+		{
+			uint32_t magic, format;
+			uint64_t tag;
+			memcpy(&magic,  binary.data(), sizeof(magic));
+			memcpy(&tag,    binary.data() + sizeof(magic), sizeof(tag));
+			memcpy(&format, binary.data() + sizeof(magic) + sizeof(tag), sizeof(format));
+			if (magic == kBinaryMagic && tag == m_binaryTag)
+			{
+				const size_t headerSize = sizeof(magic) + sizeof(tag) + sizeof(format);
+				ret->m_binaryFormat = format;
+				ret->m_binary.assign(binary.begin() + headerSize, binary.end());
+				++m_binaryLoadCount;
+			}
+		}
+	}
+
+	m_permutations[key] = ret;
+	return ret;
+}
+
+bool ShaderPermutationCache::setBinary(const ShaderPermutation* _permutation, uint32_t _format, const void* _data, size_t _size)
+{
+	auto it = m_permutations.find(_permutation->m_key);
+	assert(it != m_permutations.end() && it->second == _permutation);
+	ShaderPermutation* permutation = it->second;
+	permutation->m_binaryFormat = _format;
+	permutation->m_binary.assign((const char*)_data, (const char*)_data + _size);
+	if (m_dir.empty())
+	{
+		return true;
+	}
+
+	std::vector<char> file(sizeof(kBinaryMagic) + sizeof(m_binaryTag) + sizeof(_format) + _size);
+	char* c = file.data();
+	memcpy(c, &kBinaryMagic, sizeof(kBinaryMagic)); c += sizeof(kBinaryMagic);
+	memcpy(c, &m_binaryTag,  sizeof(m_binaryTag));  c += sizeof(m_binaryTag);
+	memcpy(c, &_format,      sizeof(_format));      c += sizeof(_format);
+	memcpy(c, _data, _size);
+	return WriteFile(getPath(_permutation->m_key, "bin").c_str(), file.data(), file.size());
+}
+
+std::string ShaderPermutationCache::getPath(uint64_t _key, const char* _ext) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016" PRIx64 ".%s", _key, _ext);
+	return m_dir + "/" + name;
+}
+
+} // namespace conv
@@ -0,0 +1,125 @@
+#pragma once
+
+// GLSL preprocessing and permutation caching for the Convolution sample's shaders. initKernel() recreates the
+// convolution shaders with new TYPE/MODE/KERNEL_SIZE/DIMENSION defines on every kernel change, previously each
+// recreation re-read and re-resolved the includes and recompiled the program.
+//
+//  - ShaderPreprocessor resolves #include "path" directives against a list of search paths. Each file is read once and
+//    each top level file is resolved once; the result is reused until clear(). Files are included at most once per top
+//    level file (as if they had include guards), #line directives map the result back to the files.
+//  - ShaderPermutationCache keys a permutation by a hash of the preprocessed source and the define set. Permutations are
+//    kept in memory and, if a directory is given, on disk as <key>.glsl (the final source, for inspection) and <key>.bin
+//    (an opaque program binary, e.g. from glGetProgramBinary). Binaries are tagged with a caller supplied string (e.g.
+//    GL_VENDOR + GL_RENDERER + GL_VERSION) and discarded if the tag changes, since they're only valid for the driver
+//    which produced them.
+
+#include "Hash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace conv {
+
+class ShaderPreprocessor
+{
+public:
+	// Search paths are tried in the order they were added.
+	void        addSearchPath(const char* _path);
+
+	// Add a file which isn't on disk (or override one which is). Clears the resolved sources.
+	void        addFile(const char* _path, const char* _source);
+
+	// Resolve the includes in _path, return nullptr on failure (missing file), see getError(). Include cycles are harmless
+	// since each file is included at most once.
+	const std::string* preprocess(const char* _path);
+
+	// Hash of preprocess(_path), 0 on failure.
+	uint64_t    getHash(const char* _path);
+
+	// Drop the file and resolved source caches (e.g. after editing a shader), added files are kept.
+	void        clear();
+
+	const char* getError() const                  { return m_error.c_str(); }
+	int         getFileReadCount() const          { return m_fileReadCount; }   // files read from disk
+	int         getResolveCount() const           { return m_resolveCount; }    // top level files resolved
+
+private:
+	struct Resolved
+	{
+		std::string m_source;
+		uint64_t    m_hash;
+	};
+
+	std::vector<std::string>            m_searchPaths;
+	std::map<std::string, std::string>  m_addedFiles;
+	std::map<std::string, std::string>  m_files;       // path -> contents, as read
+	std::map<std::string, Resolved>     m_resolved;    // top level path -> preprocessed source
+	std::string                         m_error;
+	int                                 m_fileReadCount = 0;
+	int                                 m_resolveCount  = 0;
+
+	const std::string* findFile(const std::string& _path);
+	bool resolve(const std::string& _path, std::vector<std::string>& _stack, std::vector<std::string>& _included, std::string& source_);
+};
+
+// Sorted NAME -> VALUE pairs, as per frm::ShaderDesc::addDefine().
+class ShaderDefines
+{
+public:
+	void        add(const char* _name, int _value);
+	void        add(const char* _name, const char* _value);
+
+	// #define lines in name order.
+	std::string getSource() const;
+	uint64_t    getHash() const;
+
+	const std::map<std::string, std::string>& getDefines() const { return m_defines; }
+
+private:
+	std::map<std::string, std::string> m_defines;
+};
+
+struct ShaderPermutation
+{
+	uint64_t          m_key          = 0;
+	std::string       m_path;
+	std::string       m_source;      // defines + preprocessed source, #version (if any) first
+	uint32_t          m_binaryFormat = 0;
+	std::vector<char> m_binary;      // empty if not set
+};
+
+class ShaderPermutationCache
+{
+public:
+	// _dir == nullptr keeps the cache in memory only, else _dir is created if it doesn't exist.
+	void init(ShaderPreprocessor* _preprocessor, const char* _dir = nullptr, const char* _binaryTag = "");
+	void shutdown();
+
+	// Find or create the permutation of _path with _defines, loading the binary from disk if present (and tagged with the
+	// current binary tag). Return nullptr if preprocessing fails. The pointer is valid until shutdown().
+	const ShaderPermutation* get(const char* _path, const ShaderDefines& _defines);
+
+	// Set the binary for _permutation and write it to disk. Return false if the file couldn't be written.
+	bool setBinary(const ShaderPermutation* _permutation, uint32_t _format, const void* _data, size_t _size);
+
+	int  getCount() const                          { return (int)m_permutations.size(); }
+	int  getHitCount() const                       { return m_hitCount; }       // get() found in memory
+	int  getMissCount() const                      { return m_missCount; }      // get() created a permutation
+	int  getBinaryLoadCount() const                { return m_binaryLoadCount; }
+
+private:
+	ShaderPreprocessor*                       m_preprocessor = nullptr;
+	std::string                               m_dir;
+	uint64_t                                  m_binaryTag    = 0;
+	std::map<uint64_t, ShaderPermutation*>    m_permutations;
+	int                                       m_hitCount        = 0;
+	int                                       m_missCount       = 0;
+	int                                       m_binaryLoadCount = 0;
+
+	std::string getPath(uint64_t _key, const char* _ext) const;
+};
+
+} // namespace conv
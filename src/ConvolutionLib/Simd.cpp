@@ -0,0 +1,74 @@
+#include "Simd.h"
+
+#include <atomic>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+	#include <immintrin.h>
+#endif
+
+namespace conv {
+
+namespace {
+
+Isa DetectIsa()
+{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+		__cpuid(info, 1);
+		const bool sse41 = (info[2] & (1 << 19)) != 0;
+		const bool fma   = (info[2] & (1 << 12)) != 0;
+		const bool f16c  = (info[2] & (1 << 29)) != 0;
+		const bool avx   = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6; // OS saves ymm
+		bool avx2 = false;
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+		if (avx && avx2 && fma && f16c)
+		{
+			return Isa_Avx2;
+		}
+		return sse41 ? Isa_Sse4 : Isa_Scalar;
+	#elif defined(__x86_64__) || defined(__i386__)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c"))
+		{
+			return Isa_Avx2;
+		}
+		return __builtin_cpu_supports("sse4.1") ? Isa_Sse4 : Isa_Scalar;
+	#else
+		return Isa_Scalar;
+	#endif
+}
+
+const Isa        s_bestIsa = DetectIsa();
+std::atomic<int> s_isa(s_bestIsa);
+
+} // namespace
+
+Isa GetIsa()
+{
+	return s_isa.load(std::memory_order_relaxed);
+}
+
+void SetIsa(Isa _isa)
+{
+	s_isa = _isa > s_bestIsa ? s_bestIsa : (_isa < 0 ? 0 : _isa);
+}
+
+const char* GetIsaName(Isa _isa)
+{
+	switch (_isa)
+	{
+		case Isa_Scalar: return "Scalar";
+		case Isa_Sse4:   return "SSE4";
+		case Isa_Avx2:   return "AVX2";
+		default:         return "?";
+	};
+}
+
+} // namespace conv
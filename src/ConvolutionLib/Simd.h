@@ -0,0 +1,34 @@
+#pragma once
+
+// Instruction set selection for the CPU convolution engine. Each SIMD kernel is compiled for all instruction sets
+// (via CONV_TARGET_* on gcc/clang, MSVC doesn't require it) and selected at runtime via GetIsa().
+
+namespace conv {
+
+enum Isa_
+{
+	Isa_Scalar,
+	Isa_Sse4,  // SSE4.1
+	Isa_Avx2,  // AVX2 + FMA + F16C
+
+	Isa_Count
+};
+typedef int Isa;
+
+// Best instruction set supported by the CPU, or the instruction set passed to SetIsa().
+Isa         GetIsa();
+
+// Override the instruction set (e.g. to compare implementations). _isa is clamped to the best supported.
+void        SetIsa(Isa _isa);
+
+const char* GetIsaName(Isa _isa);
+
+} // namespace conv
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#define CONV_TARGET_SSE4
+	#define CONV_TARGET_AVX2
+#else
+	#define CONV_TARGET_SSE4 __attribute__((target("sse4.1")))
+	#define CONV_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#endif
@@ -0,0 +1,149 @@
+#include "ThreadPool.h"
+
+#include <cassert>
+
+namespace conv {
+
+namespace {
+
+// Pool and queue index of the current thread if it's a worker.
+thread_local const ThreadPool* s_pool      = nullptr;
+thread_local int               s_poolIndex = -1;
+
+} // namespace
+
+ThreadPool::ThreadPool(int _threadCount)
+{
+	if (_threadCount <= 0)
+	{
+		_threadCount = (int)std::thread::hardware_concurrency();
+		_threadCount = _threadCount < 1 ? 1 : _threadCount;
+	}
+	m_workerCount = _threadCount - 1;
+	m_queues      = new Queue[m_workerCount + 1];
+	m_workers     = new std::thread[m_workerCount];
+	for (int i = 0; i < m_workerCount; ++i)
+	{
+		m_workers[i] = std::thread(&ThreadPool::workerMain, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{	std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_quit = true;
+	}
+	m_sleepCv.notify_all();
+	for (int i = 0; i < m_workerCount; ++i)
+	{
+		m_workers[i].join();
+	}
+	delete[] m_workers;
+	delete[] m_queues;
+}
+
+void ThreadPool::run(TaskGroup& _group, Task&& _task)
+{
+	_group.m_pending.fetch_add(1);
+
+	Queue& queue = m_queues[getQueueIndex()];
+	{	std::lock_guard<std::mutex> lock(queue.m_mutex);
+		queue.m_tasks.push_back({ std::move(_task), &_group });
+	}
+	m_queuedCount.fetch_add(1);
+
+ // lock to avoid a lost wakeup between a worker checking m_queuedCount and sleeping
+	if (m_workerCount > 0)
+	{
+		{	std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_sleepCv.notify_one();
+	}
+}
+
+void ThreadPool::wait(TaskGroup& _group)
+{
+	while (!_group.isComplete())
+	{
+		if (!tryRunTask())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+int ThreadPool::getQueueIndex() const
+{
+	return s_pool == this ? s_poolIndex : m_workerCount;
+}
+
+bool ThreadPool::tryPop(int _queueIndex, QueuedTask& task_)
+{
+	Queue& queue = m_queues[_queueIndex];
+	std::lock_guard<std::mutex> lock(queue.m_mutex);
+	if (queue.m_tasks.empty())
+	{
+		return false;
+	}
+	task_ = std::move(queue.m_tasks.back());
+	queue.m_tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::trySteal(int _queueIndex, QueuedTask& task_)
+{
+	Queue& queue = m_queues[_queueIndex];
+	std::lock_guard<std::mutex> lock(queue.m_mutex);
+	if (queue.m_tasks.empty())
+	{
+		return false;
+	}
+	task_ = std::move(queue.m_tasks.front());
+	queue.m_tasks.pop_front();
+	return true;
+}
+
+bool ThreadPool::tryRunTask()
+{
+	if (m_queuedCount.load() == 0)
+	{
+		return false;
+	}
+
+	const int queueCount = m_workerCount + 1;
+	const int ownIndex   = getQueueIndex();
+	QueuedTask task;
+	bool found = tryPop(ownIndex, task);
+	for (int i = 1; i < queueCount && !found; ++i)
+	{
+		found = trySteal((ownIndex + i) % queueCount, task);
+	}
+	if (!found)
+	{
+		return false;
+	}
+
+	m_queuedCount.fetch_sub(1);
+	task.m_task();
+	task.m_group->m_pending.fetch_sub(1);
+	return true;
+}
+
+void ThreadPool::workerMain(int _index)
+{
+	s_pool      = this;
+	s_poolIndex = _index;
+
+	while (!m_quit)
+	{
+		if (tryRunTask())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepCv.wait(lock, [this]{ return m_quit || m_queuedCount.load() > 0; });
+	}
+}
+
+} // namespace conv
@@ -0,0 +1,76 @@
+#pragma once
+
+// Work-stealing thread pool for the CPU convolution engine. Each worker owns a task queue; workers pop from the back
+// of their own queue (most recently pushed, likely in cache) and steal from the front of the other queues when empty.
+// Tasks pushed from a worker go to its own queue, tasks pushed from other threads go to a shared queue.
+//
+// Completion is tracked per TaskGroup. wait() executes tasks on the calling thread until the group is complete, hence a
+// pool with 0 workers is valid (everything runs in wait()).
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace conv {
+
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	class TaskGroup
+	{
+		friend class ThreadPool;
+		std::atomic<int> m_pending = { 0 };
+	public:
+		bool isComplete() const { return m_pending.load() == 0; }
+	};
+
+	// _threadCount is the total number of threads which execute tasks, including the thread which calls wait(). 0 means
+	// std::thread::hardware_concurrency().
+	explicit ThreadPool(int _threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&)            = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int  getThreadCount() const            { return m_workerCount + 1; }
+
+	// Queue _task as part of _group. May be called from within a task.
+	void run(TaskGroup& _group, Task&& _task);
+
+	// Execute tasks until all tasks in _group are complete.
+	void wait(TaskGroup& _group);
+
+private:
+	struct QueuedTask
+	{
+		Task       m_task;
+		TaskGroup* m_group;
+	};
+
+	struct Queue
+	{
+		std::mutex             m_mutex;
+		std::deque<QueuedTask> m_tasks;
+	};
+
+	int                     m_workerCount = 0;
+	std::thread*            m_workers     = nullptr;
+	Queue*                  m_queues      = nullptr; // m_workerCount + 1, the last is shared by non-worker threads
+	std::atomic<int>        m_queuedCount = { 0 };
+	std::atomic<bool>       m_quit        = { false };
+	std::mutex              m_sleepMutex;
+	std::condition_variable m_sleepCv;
+
+	int  getQueueIndex() const;
+	bool tryPop(int _queueIndex, QueuedTask& task_);
+	bool trySteal(int _queueIndex, QueuedTask& task_);
+	bool tryRunTask();
+	void workerMain(int _index);
+};
+
+} // namespace conv
@@ -0,0 +1,772 @@
+// ConvolutionTest: correctness checks for ConvolutionLib, the properties which the benchmarks report are asserted here.
+// Return 0 if all checks pass, else 1 (failed checks are printed).
+//
+//   ConvolutionTest [name ...]   Run the named tests, or all of them if no names are given.
+//   ConvolutionTest --list       List the tests.
+
+#include <ConvolutionBench/Bench.h>
+
+#include <ConvolutionLib/AsyncBuilder.h>
+#include <ConvolutionLib/BoxFilter.h>
+#include <ConvolutionLib/Convolve.h>
+#include <ConvolutionLib/ConvolveFft.h>
+#include <ConvolutionLib/ConvolveFixed.h>
+#include <ConvolutionLib/Half.h>
+#include <ConvolutionLib/Kernel.h>
+#include <ConvolutionLib/KernelBank.h>
+#include <ConvolutionLib/Line.h>
+#include <ConvolutionLib/LowRank.h>
+#include <ConvolutionLib/OutOfCore.h>
+#include <ConvolutionLib/RecursiveGaussian.h>
+#include <ConvolutionLib/Region.h>
+#include <ConvolutionLib/ShaderCache.h>
+#include <ConvolutionLib/Simd.h>
+#include <ConvolutionLib/ThreadPool.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace conv;
+
+namespace {
+
+int g_checkCount = 0;
+int g_failCount  = 0;
+
+#define CHECK(_cond) \
+	do { \
+		++g_checkCount; \
+		if (!(_cond)) \
+		{ \
+			++g_failCount; \
+			fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #_cond); \
+		} \
+	} while (0)
+
+// Gaussian of _width (integer offsets) for the separable passes.
+void InitGaussianKernel(SeparableKernel& kernel_, int _width)
+{
+	std::vector<float> weights(_width), offsets(_width);
+	KernelGaussian1d(_width, (float)_width / 6.0f, weights.data());
+	for (int i = 0; i < _width; ++i)
+	{
+		offsets[i] = (float)(i - _width / 2);
+	}
+	kernel_.init(weights.data(), offsets.data(), _width);
+}
+
+bool Equal(const Image& _a, const Image& _b)
+{
+	return _a.getSize() == _b.getSize() && memcmp(_a.getData(), _b.getData(), _a.getSize()) == 0;
+}
+
+// Compare the texels of _rect.
+bool Equal(const Image& _a, const Image& _b, const Rect& _rect)
+{
+	for (int y = _rect.m_y0; y < _rect.m_y1; ++y)
+	{
+		const char* a = (const char*)_a.getRow(y) + _a.getTexelSize() * _rect.m_x0;
+		const char* b = (const char*)_b.getRow(y) + _b.getTexelSize() * _rect.m_x0;
+		if (memcmp(a, b, _a.getTexelSize() * _rect.getWidth()) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// The constexpr tables must be identical to the runtime generators (the runtime sigma prevents constant folding).
+void Test_Kernel()
+{
+	volatile float sigma = 2.0f;
+	float weights[9 * 9];
+
+	constexpr auto kGaussian1d = MakeKernelGaussian1d<9>(2.0f);
+	CHECK(KernelGaussian1d(9, sigma, weights) == kGaussian1d.sum);
+	CHECK(memcmp(weights, kGaussian1d.weights, sizeof(kGaussian1d.weights)) == 0);
+
+	constexpr auto kGaussian2d = MakeKernelGaussian2d<9>(2.0f);
+	CHECK(KernelGaussian2d(9, sigma, weights) == kGaussian2d.sum);
+	CHECK(memcmp(weights, kGaussian2d.weights, sizeof(kGaussian2d.weights)) == 0);
+
+	constexpr auto kBinomial2d = MakeKernelBinomial2d<7>();
+	CHECK(KernelBinomial2d(7, weights) == kBinomial2d.sum);
+	CHECK(memcmp(weights, kBinomial2d.weights, sizeof(kBinomial2d.weights)) == 0);
+
+	constexpr auto kBox1d = MakeKernelBox1d<5>();
+	KernelBox1d(5, weights);
+	CHECK(memcmp(weights, kBox1d.weights, sizeof(kBox1d.weights)) == 0);
+
+	constexpr auto kBilinear = MakeKernelBilinear(kGaussian1d);
+	float bilinearWeights[5], bilinearOffsets[5];
+	KernelGaussian1d(9, sigma, weights);
+	KernelOptimizeBilinear1d(9, weights, bilinearWeights, bilinearOffsets);
+	CHECK(memcmp(bilinearWeights, kBilinear.weights, sizeof(kBilinear.weights)) == 0);
+	CHECK(memcmp(bilinearOffsets, kBilinear.offsets, sizeof(kBilinear.offsets)) == 0);
+}
+
+// Every bank kernel vs. the generators, exactly. A sigma change regenerates the Gaussian kernels of one width in place,
+// the dirty range must cover them and nothing else may change.
+void Test_KernelBank()
+{
+	KernelBank bank;
+	bank.init(2.0f);
+	const int kMaxWidth = KernelBank::kMaxWidth;
+
+	int mismatchCount = 0;
+	for (KernelType type = 0; type < KernelType_Count; ++type)
+	{
+		for (int width = KernelBank::kMinWidth; width <= kMaxWidth; width += 2)
+		{
+			float weights2d[kMaxWidth * kMaxWidth], weights1d[kMaxWidth];
+			float sum2d = 0.0f, sum1d = 0.0f;
+			switch (type)
+			{
+				case KernelType_Box:      sum2d = KernelBox2d(width, weights2d);            sum1d = KernelBox1d(width, weights1d);            break;
+				case KernelType_Gaussian: sum2d = KernelGaussian2d(width, 2.0f, weights2d); sum1d = KernelGaussian1d(width, 2.0f, weights1d); break;
+				default:                  sum2d = KernelBinomial2d(width, weights2d);       sum1d = KernelBinomial1d(width, weights1d);       break;
+			};
+			float bilinearWeights[kMaxWidth * kMaxWidth], bilinearOffsets[kMaxWidth * kMaxWidth * 2];
+			for (KernelMode mode = 0; mode < KernelMode_Count; ++mode)
+			{
+				const KernelBank::Kernel& kernel = bank.getKernel(type, mode, width, 2.0f);
+				const float* weights = IsKernelMode2d(mode) ? weights2d : weights1d;
+				bool equal = kernel.m_width == width && kernel.m_sum == (IsKernelMode2d(mode) ? sum2d : sum1d);
+				switch (mode)
+				{
+					case KernelMode_2d:
+					case KernelMode_Separable:
+						equal &= memcmp(bank.get(kernel.m_weights), weights, sizeof(float) * kernel.m_tapCount) == 0;
+						for (int i = 0; i < kernel.m_tapCount; ++i)
+						{
+							const float* offset = bank.get(kernel.m_offsets) + (mode == KernelMode_2d ? i * 2 : i);
+							equal &= offset[0] == (float)(i % width - width / 2);
+							equal &= mode == KernelMode_Separable || offset[1] == (float)(i / width - width / 2);
+						}
+						break;
+					case KernelMode_2dBilinear:
+						KernelOptimizeBilinear2d(width, weights, bilinearWeights, bilinearOffsets);
+						equal &= memcmp(bank.get(kernel.m_weights), bilinearWeights, sizeof(float) * kernel.m_tapCount) == 0;
+						equal &= memcmp(bank.get(kernel.m_offsets), bilinearOffsets, sizeof(float) * kernel.m_tapCount * 2) == 0;
+						break;
+					default:
+						KernelOptimizeBilinear1d(width, weights, bilinearWeights, bilinearOffsets);
+						equal &= memcmp(bank.get(kernel.m_weights), bilinearWeights, sizeof(float) * kernel.m_tapCount) == 0;
+						equal &= memcmp(bank.get(kernel.m_offsets), bilinearOffsets, sizeof(float) * kernel.m_tapCount) == 0;
+						break;
+				};
+				equal &= memcmp(bank.get(kernel.m_display), weights, sizeof(float) * width) == 0;
+				mismatchCount += equal ? 0 : 1;
+			}
+		}
+	}
+	CHECK(mismatchCount == 0);
+
+	bank.clearDirtyRange();
+	bank.getKernel(KernelType_Box, KernelMode_Separable, 9, 3.0f);
+	bank.getKernel(KernelType_Gaussian, KernelMode_2d, 9, 2.0f);
+	CHECK(bank.getDirtyRange().m_count == 0);
+
+	std::vector<float> before(bank.getArena(), bank.getArena() + bank.getArenaCount());
+	bank.getKernel(KernelType_Gaussian, KernelMode_Separable, 9, 3.0f);
+	const KernelBank::Range dirty = bank.getDirtyRange();
+	for (KernelMode mode = 0; mode < KernelMode_Count; ++mode)
+	{
+		const KernelBank::Kernel& kernel = bank.getKernel(KernelType_Gaussian, mode, 9, 3.0f);
+		for (const KernelBank::Range& range : { kernel.m_weights, kernel.m_offsets })
+		{
+			CHECK(range.m_offset >= dirty.m_offset && range.m_offset + range.m_count <= dirty.m_offset + dirty.m_count);
+		}
+	}
+	for (int width : { 7, 11 })
+	{
+		const KernelBank::Kernel& kernel = bank.getKernel(KernelType_Gaussian, KernelMode_2d, width, 2.0f);
+		CHECK(kernel.m_weights.m_offset + kernel.m_weights.m_count <= dirty.m_offset || kernel.m_weights.m_offset >= dirty.m_offset + dirty.m_count);
+	}
+	int changedOutsideCount = 0;
+	for (uint32_t i = 0; i < bank.getArenaCount(); ++i)
+	{
+		const bool inside = i >= dirty.m_offset && i < dirty.m_offset + dirty.m_count;
+		changedOutsideCount += !inside && bank.getArena()[i] != before[i] ? 1 : 0;
+	}
+	CHECK(changedOutsideCount == 0);
+	CHECK(memcmp(bank.get(bank.getKernel(KernelType_Gaussian, KernelMode_Separable, 9, 3.0f).m_weights), MakeKernelGaussian1d<9>(3.0f).weights, sizeof(float) * 9) == 0);
+
+ // greedy 2d bilinear merge, used if it needs fewer taps than the fixed merge; the reconstructed weights must then be
+ // within the max error (relative to the largest weight, up to rounding)
+	for (float maxError : { 1e-3f, 1e-2f, 5e-2f })
+	{
+		bank.setBilinearMaxError(maxError);
+		float worstError = 0.0f;
+		int greedyCount = 0, mismatchCount = 0;
+		for (KernelType type = 0; type < KernelType_Count; ++type)
+		{
+			for (int width = KernelBank::kMinWidth; width <= kMaxWidth; width += 2)
+			{
+				const KernelBank::Kernel& kernel2d = bank.getKernel(type, KernelMode_2d, width, 2.0f);
+				const KernelBank::Kernel& kernel   = bank.getKernel(type, KernelMode_2dBilinear, width, 2.0f);
+				const float* weights  = bank.get(kernel2d.m_weights);
+				const int    capacity = (width / 2 + 1) * (width / 2 + 1);
+				float tapWeights[kMaxWidth * kMaxWidth], tapOffsets[kMaxWidth * kMaxWidth * 2];
+				const int tapCount = KernelOptimizeBilinearGreedy2d(width, width, weights, maxError, tapWeights, tapOffsets);
+				if (tapCount > capacity)
+				{
+					KernelOptimizeBilinear2d(width, weights, tapWeights, tapOffsets);
+					mismatchCount += kernel.m_tapCount == capacity && memcmp(bank.get(kernel.m_weights), tapWeights, sizeof(float) * capacity) == 0 ? 0 : 1;
+					continue;
+				}
+				float maxWeight = 0.0f;
+				for (int i = 0; i < width * width; ++i)
+				{
+					maxWeight = weights[i] > maxWeight ? weights[i] : maxWeight;
+				}
+				const float error = KernelBilinearError2d(width, width, weights, bank.get(kernel.m_weights), bank.get(kernel.m_offsets), kernel.m_tapCount) / maxWeight;
+				worstError = error > worstError ? error : worstError;
+				mismatchCount += kernel.m_tapCount == tapCount && memcmp(bank.get(kernel.m_weights), tapWeights, sizeof(float) * tapCount) == 0 ? 0 : 1;
+				++greedyCount;
+			}
+		}
+		printf("  max error %.0e: %d greedy kernels, worst error %.2e\n", maxError, greedyCount, worstError);
+		CHECK(mismatchCount == 0);
+		CHECK(greedyCount > 0);
+		CHECK(worstError <= maxError * 1.001f);
+	}
+}
+
+// Each instruction set vs. scalar: the float path within rounding (FMA contracts differently), the fixed point path and
+// the half conversions exactly.
+void Test_Isa()
+{
+	const Isa bestIsa = GetIsa();
+	const int kSize   = 128;
+
+	SeparableKernel kernel;
+	InitGaussianKernel(kernel, 11);
+	SeparableKernelFixed kernelFixed;
+	kernelFixed.init(kernel);
+
+	Image src8, src32;
+	bench::InitTestImage(src8, kSize, kSize, Format_RGBA8);
+	bench::InitTestImage(src32, kSize, kSize, Format_RGBA32F);
+
+	std::vector<float> f(4096);
+	for (size_t i = 0; i < f.size(); ++i)
+	{
+		f[i] = ((float)i - 2048.0f) * 0.37f;
+	}
+	std::vector<uint16_t> h(f.size());
+
+	SetIsa(Isa_Scalar);
+	Image ref8, ref32, refFixed, tmp;
+	ref8.init(kSize, kSize, Format_RGBA8);
+	ref32.init(kSize, kSize, Format_RGBA32F);
+	refFixed.init(kSize, kSize, Format_RGBA8);
+	ConvolveSeparable(src8, ref8, tmp, kernel);
+	ConvolveSeparable(src32, ref32, tmp, kernel);
+	ConvolveSeparableFixed(src8, refFixed, tmp, kernelFixed);
+	std::vector<uint16_t> refHalf(f.size());
+	std::vector<float> refFloat(f.size());
+	ConvertFloatToHalf(f.data(), refHalf.data(), f.size());
+	ConvertHalfToFloat(refHalf.data(), refFloat.data(), f.size());
+
+	for (Isa isa = Isa_Scalar + 1; isa <= bestIsa; ++isa)
+	{
+		SetIsa(isa);
+		Image dst8, dst32, dstFixed;
+		dst8.init(kSize, kSize, Format_RGBA8);
+		dst32.init(kSize, kSize, Format_RGBA32F);
+		dstFixed.init(kSize, kSize, Format_RGBA8);
+		ConvolveSeparable(src8, dst8, tmp, kernel);
+		ConvolveSeparable(src32, dst32, tmp, kernel);
+		ConvolveSeparableFixed(src8, dstFixed, tmp, kernelFixed);
+		printf("  %s: RGBA8 %.2e, RGBA32F %.2e\n", GetIsaName(isa), bench::GetMaxError(ref8, dst8), bench::GetMaxError(ref32, dst32));
+		CHECK(bench::GetMaxError(ref8, dst8) <= 1.0f / 255.0f + 1e-6f);
+		CHECK(bench::GetMaxError(ref32, dst32) <= 1e-5f);
+		CHECK(Equal(refFixed, dstFixed));
+
+		std::vector<float> g(f.size());
+		ConvertFloatToHalf(f.data(), h.data(), f.size());
+		ConvertHalfToFloat(h.data(), g.data(), f.size());
+		CHECK(h == refHalf);
+		CHECK(g == refFloat);
+	}
+	SetIsa(bestIsa);
+}
+
+// Multi-threaded vs. single threaded separable convolution exactly, for band heights which don't divide the image.
+void Test_Threads()
+{
+	const int kSize = 256;
+	SeparableKernel kernel;
+	InitGaussianKernel(kernel, 21);
+	ThreadPool pool(4);
+
+	Image src, ref, dst, tmp;
+	bench::InitTestImage(src, kSize, kSize + 7, Format_RGBA8);
+	ref.init(kSize, kSize + 7, Format_RGBA8);
+	dst.init(kSize, kSize + 7, Format_RGBA8);
+	ConvolveSeparable(src, ref, tmp, kernel);
+	for (int bandHeight : { 0, 1, 16, 100 })
+	{
+		memset(dst.getData(), 0, dst.getSize());
+		ConvolveSeparable(pool, src, dst, tmp, kernel, bandHeight);
+		CHECK(Equal(ref, dst));
+	}
+}
+
+// FFT and low rank convolution vs. the direct 2d convolution, for a separable (Gaussian) and non-separable (disc) kernel.
+void Test_Fft()
+{
+	const int kSize       = 96;
+	const int kKernelSize = 15;
+	ThreadPool pool(4);
+
+	Image src, ref, dst, tmp;
+	bench::InitTestImage(src, kSize, kSize + 7, Format_RGBA32F);
+	ref.init(kSize, kSize + 7, Format_RGBA32F);
+	dst.init(kSize, kSize + 7, Format_RGBA32F);
+
+	float weights[2][kKernelSize * kKernelSize];
+	KernelGaussian2d(kKernelSize, 3.0f, weights[0]);
+	KernelDisc2d(kKernelSize, weights[1]);
+	for (const float* w : weights)
+	{
+		Convolve2d(src, ref, w, kKernelSize);
+
+		FftKernel fftKernel;
+		fftKernel.init(w, kKernelSize, src.getWidth(), src.getHeight());
+		ConvolveFft(src, dst, fftKernel);
+		const float fftError = bench::GetMaxError(ref, dst);
+		CHECK(fftError <= 1e-5f);
+		ConvolveFft(pool, src, dst, fftKernel);
+		CHECK(bench::GetMaxError(ref, dst) <= 1e-5f);
+
+		LowRankKernel lowRankKernel;
+		CHECK(lowRankKernel.init(w, kKernelSize, 1e-4f));
+		ConvolveLowRank(src, dst, tmp, lowRankKernel);
+		const float lowRankError = bench::GetMaxError(ref, dst);
+		printf("  %s: FFT %.2e, low rank (rank %d) %.2e\n", w == weights[0] ? "gaussian" : "disc", fftError, lowRankKernel.getRank(), lowRankError);
+		CHECK(lowRankError <= 1e-3f);
+		ConvolveLowRank(pool, src, dst, tmp, lowRankKernel);
+		CHECK(bench::GetMaxError(ref, dst) <= 1e-3f);
+		if (w == weights[0])
+		{
+			CHECK(lowRankKernel.getRank() == 1);
+		}
+	}
+}
+
+// Fixed point weights must sum to exactly 1 << kFixedPointBits, hence a constant image is unchanged.
+void Test_Fixed()
+{
+	Image constant, dst, tmp;
+	constant.init(64, 64, Format_RGBA8);
+	memset(constant.getData(), 0xb7, constant.getSize());
+	dst.init(64, 64, Format_RGBA8);
+
+	for (int width = 3; width <= 31; width += 4)
+	{
+		float weights[31], offsets[31];
+		float weightsBilinear[16], offsetsBilinear[16];
+		KernelGaussian1d(width, (float)width / 6.0f, weights);
+		for (int i = 0; i < width; ++i)
+		{
+			offsets[i] = (float)(i - width / 2);
+		}
+		KernelOptimizeBilinear1d(width, weights, weightsBilinear, offsetsBilinear);
+
+		for (int bilinear = 0; bilinear < 2; ++bilinear)
+		{
+			SeparableKernel kernel;
+			if (bilinear)
+			{
+				kernel.init(weightsBilinear, offsetsBilinear, width / 2 + 1);
+			}
+			else
+			{
+				kernel.init(weights, offsets, width);
+			}
+			SeparableKernelFixed kernelFixed;
+			kernelFixed.init(kernel);
+
+			int sum = 0;
+			for (int i = 0; i < kernelFixed.getTapCount(); ++i)
+			{
+				sum += kernelFixed.getTapWeights()[i];
+			}
+			CHECK(sum == 1 << SeparableKernelFixed::kFixedPointBits);
+			CHECK(kernelFixed.getMaxWeightError() <= 0.5f / (float)(1 << SeparableKernelFixed::kFixedPointBits) * 2.0f);
+
+			ConvolveSeparableFixed(constant, dst, tmp, kernelFixed);
+			CHECK(Equal(constant, dst));
+		}
+	}
+}
+
+// Every non-NaN half must survive half -> float -> half; RGBA16F images round trip via readTexel()/writeTexel().
+void Test_Half()
+{
+	int roundTripErrors = 0;
+	for (uint32_t h = 0; h < 0x10000; ++h)
+	{
+		const bool isNan = (h & 0x7c00) == 0x7c00 && (h & 0x03ff) != 0;
+		roundTripErrors += !isNan && FloatToHalf(HalfToFloat((uint16_t)h)) != h ? 1 : 0;
+	}
+	CHECK(roundTripErrors == 0);
+	CHECK(HalfToFloat(FloatToHalf(1.0f)) == 1.0f);
+	CHECK(HalfToFloat(FloatToHalf(65504.0f)) == 65504.0f);
+	CHECK(HalfToFloat(FloatToHalf(1e6f)) == HalfToFloat(0x7c00)); // overflow to infinity
+
+	Image src, dst;
+	bench::InitTestImage(src, 64, 64, Format_RGBA16F);
+	dst.init(64, 64, Format_RGBA16F);
+	for (int y = 0; y < 64; ++y)
+	{
+		for (int x = 0; x < 64; ++x)
+		{
+			float rgba[4];
+			src.readTexel(x, y, rgba);
+			dst.writeTexel(x, y, rgba);
+		}
+	}
+	CHECK(Equal(src, dst));
+}
+
+// Each vertical pass vs. transpose, horizontal pass, transpose, exactly. The vertical passes work on tiles of columns and
+// bands of rows, the size isn't a multiple of either.
+void Test_Vertical()
+{
+	const Isa bestIsa = GetIsa();
+	const int kWidth  = 150;
+	const int kHeight = 600;
+
+	SeparableKernel kernel;
+	InitGaussianKernel(kernel, 11);
+	SeparableKernelFixed kernelFixed;
+	kernelFixed.init(kernel);
+	RecursiveGaussianKernel kernelRecursive;
+	kernelRecursive.init(3.0f);
+	const int boxWidths[3] = { 7, 9, 9 };
+
+	auto transpose = [](const Image& _src, Image& dst_)
+		{
+			dst_.init(_src.getHeight(), _src.getWidth(), _src.getFormat());
+			std::vector<float> line(_src.getWidth() * 4);
+			for (int y = 0; y < _src.getHeight(); ++y)
+			{
+				ReadLine(_src, Direction_Horizontal, y, 0, _src.getWidth(), line.data());
+				WriteLine(dst_, Direction_Vertical, y, 0, _src.getWidth(), line.data());
+			}
+		};
+
+	for (Isa isa = Isa_Scalar; isa <= bestIsa; ++isa)
+	{
+		SetIsa(isa);
+		for (Format format = 0; format < Format_Count; ++format)
+		{
+			Image src, srcT;
+			bench::InitTestImage(src, kWidth, kHeight, format);
+			transpose(src, srcT);
+			for (int pass = 0; pass < 4; ++pass)
+			{
+				if (pass == 1 && format != Format_RGBA8)
+				{
+					continue;
+				}
+				auto run = [&](const Image& _src, Image& _dst, Direction _direction)
+					{
+						switch (pass)
+						{
+							case 0:  ConvolvePass(_src, _dst, kernel, _direction); break;
+							case 1:  ConvolvePassFixed(_src, _dst, kernelFixed, _direction); break;
+							case 2:  BoxFilterPass(_src, _dst, boxWidths, 3, _direction); break;
+							default: RecursiveGaussianPass(_src, _dst, kernelRecursive, _direction); break;
+						};
+					};
+				Image dst, dstT, ref;
+				dst.init(kWidth, kHeight, format);
+				dstT.init(kHeight, kWidth, format);
+				run(src, dst, Direction_Vertical);
+				run(srcT, dstT, Direction_Horizontal);
+				transpose(dstT, ref);
+				CHECK(Equal(dst, ref));
+			}
+		}
+	}
+	SetIsa(bestIsa);
+}
+
+// Includes resolve once per top level file with #line directives mapping back to the files, defines go after #version
+// and are keyed independently of their order, binaries with another tag are discarded.
+void Test_ShaderCache()
+{
+	ShaderPreprocessor preprocessor;
+	preprocessor.addFile("a.glsl", "#version 450\n#include \"b.glsl\"\n#include \"c.glsl\"\nvoid main() {}\n");
+	preprocessor.addFile("b.glsl", "#include \"c.glsl\"\nfloat b;\n");
+	preprocessor.addFile("c.glsl", "float c;\n");
+	preprocessor.addFile("cycle.glsl", "#include \"cycle.glsl\"\n");
+	const std::string* source = preprocessor.preprocess("a.glsl");
+	CHECK(source && *source == "#version 450\n#line 1 1\n#line 1 2\nfloat c;\n#line 2 1\nfloat b;\n#line 3 0\n#line 4 0\nvoid main() {}\n");
+	CHECK(preprocessor.preprocess("a.glsl") == source);
+	CHECK(preprocessor.getResolveCount() == 1);
+	CHECK(preprocessor.getFileReadCount() == 0);
+	CHECK(preprocessor.preprocess("b.glsl") && *preprocessor.preprocess("b.glsl") == "#line 1 1\nfloat c;\n#line 2 0\nfloat b;\n");
+	CHECK(preprocessor.preprocess("cycle.glsl") && *preprocessor.preprocess("cycle.glsl") == "#line 2 0\n");
+	CHECK(!preprocessor.preprocess("missing.glsl") && preprocessor.getHash("missing.glsl") == 0);
+
+	ShaderDefines definesA, definesB;
+	definesA.add("TYPE", 1);
+	definesA.add("MODE", "2");
+	definesB.add("MODE", 2);
+	definesB.add("TYPE", 1);
+	CHECK(definesA.getHash() == definesB.getHash());
+
+	ShaderPermutationCache memoryCache;
+	memoryCache.init(&preprocessor);
+	const ShaderPermutation* permutation = memoryCache.get("a.glsl", definesA);
+	CHECK(permutation && permutation->m_source == "#version 450\n#define MODE 2\n#define TYPE 1\n#line 2 0\n" + source->substr(13));
+	CHECK(memoryCache.get("a.glsl", definesB) == permutation);
+	CHECK(memoryCache.getHitCount() == 1 && memoryCache.getMissCount() == 1);
+	permutation = memoryCache.get("b.glsl", definesA);
+	CHECK(permutation && permutation->m_source == "#define MODE 2\n#define TYPE 1\n#line 1 0\n" + *preprocessor.preprocess("b.glsl"));
+	definesB.add("TYPE", 3);
+	CHECK(memoryCache.get("a.glsl", definesB) != memoryCache.get("a.glsl", definesA));
+	CHECK(!memoryCache.get("missing.glsl", definesA));
+	memoryCache.shutdown();
+
+ // binary round trip via disk, then discarded by a new tag
+	const char* kCacheDir = "ConvolutionTest_ShaderCache";
+	const char* kTags[]   = { "driver 1", "driver 1", "driver 2" };
+	const uint32_t kBinary = 0xdecafbad;
+	uint64_t key = 0;
+	for (int run = 0; run < 3; ++run)
+	{
+		ShaderPermutationCache diskCache;
+		diskCache.init(&preprocessor, kCacheDir, kTags[run]);
+		permutation = diskCache.get("a.glsl", definesA);
+		CHECK(permutation != nullptr);
+		if (!permutation)
+		{
+			continue;
+		}
+		key = permutation->m_key;
+		const bool loaded = permutation->m_binaryFormat == 7 && permutation->m_binary.size() == sizeof(kBinary) && memcmp(permutation->m_binary.data(), &kBinary, sizeof(kBinary)) == 0;
+		CHECK(loaded == (run == 1));
+		CHECK(permutation->m_binary.empty() == (run != 1));
+		if (permutation->m_binary.empty())
+		{
+			CHECK(diskCache.setBinary(permutation, 7, &kBinary, sizeof(kBinary)));
+		}
+	}
+	char path[64];
+	for (const char* ext : { "glsl", "bin" })
+	{
+		snprintf(path, sizeof(path), "%s/%016llx.%s", kCacheDir, (unsigned long long)key, ext);
+		remove(path);
+	}
+	remove(kCacheDir);
+}
+
+// Requests made during a build are coalesced, only the latest parameters are built and swapped to the front by acquire()
+// and the front doesn't change in between. The first build of each pair is held until the test releases it.
+void Test_AsyncBuilder()
+{
+	std::atomic<bool> started(false), released(false);
+	std::vector<int> built; // worker only, read after wait()/shutdown()
+	AsyncBuilder<int, int> builder;
+	builder.init([&](const int& _params, int& result_)
+		{
+			started = true;
+			while (!released)
+			{
+				std::this_thread::yield();
+			}
+			built.push_back(_params);
+			result_ = _params * 10;
+		});
+	auto waitStarted = [&]()
+		{
+			while (!started)
+			{
+				std::this_thread::yield();
+			}
+		};
+
+	builder.request(1);
+	waitStarted();
+	for (int i = 2; i <= 10; ++i)
+	{
+		builder.request(i);
+	}
+	CHECK(builder.isBusy());
+	CHECK(!builder.acquire());
+	released = true;
+	builder.wait();
+	CHECK(!builder.isBusy());
+	CHECK((built == std::vector<int>{ 1, 10 }));
+	CHECK(builder.getRequestCount() == 10 && builder.getBuildCount() == 2);
+	CHECK(builder.acquire());
+	CHECK(builder.getFrontParams() == 10 && builder.getFront() == 100);
+	CHECK(!builder.acquire());
+
+	started = released = false;
+	builder.request(11);
+	waitStarted();
+	CHECK(builder.getFrontParams() == 10 && builder.getFront() == 100);
+	released = true;
+	builder.wait();
+	CHECK(builder.getFrontParams() == 10 && builder.getFront() == 100);
+	CHECK(builder.acquire());
+	CHECK(builder.getFrontParams() == 11 && builder.getFront() == 110);
+
+ // shutdown waits for the build in progress (released while shutdown() blocks), the pending request may be dropped
+	started = released = false;
+	builder.request(12);
+	waitStarted();
+	builder.request(13);
+	std::thread releaser([&]{ std::this_thread::sleep_for(std::chrono::milliseconds(20)); released = true; });
+	builder.shutdown();
+	releaser.join();
+	CHECK(!builder.isBusy() && !builder.acquire());
+	CHECK(built.size() >= 4 && built[3] == 12);
+	CHECK(builder.getFrontParams() == 11);
+	builder.wait();
+
+	builder.init([](const int& _params, int& result_) { result_ = _params * 10; }, false);
+	builder.request(14);
+	CHECK(builder.acquire());
+	CHECK(builder.getFrontParams() == 14 && builder.getFront() == 140);
+}
+
+// Dirty rect, region of interest and out-of-core tiled convolution must match the full convolution exactly.
+void Test_Roi()
+{
+	const int kSize = 256;
+	SeparableKernel kernel;
+	InitGaussianKernel(kernel, 21);
+	ThreadPool pool(4);
+
+	Image src, ref, refTmp, dst, tmp;
+	bench::InitTestPattern(src, kSize, kSize, Format_RGBA8);
+	ref.init(kSize, kSize, Format_RGBA8);
+	dst.init(kSize, kSize, Format_RGBA8);
+
+ // edit a few rects (including the edges), update dst incrementally
+	ConvolveSeparable(src, dst, tmp, kernel);
+	const Rect kEdits[] = { Rect(0, 0, 16, 8), Rect(100, 120, 140, 130), Rect(110, 125, 118, 200), Rect(kSize - 5, kSize - 30, kSize, kSize) };
+	for (const Rect& rect : kEdits)
+	{
+		for (int y = rect.m_y0; y < rect.m_y1; ++y)
+		{
+			for (int x = rect.m_x0; x < rect.m_x1; ++x)
+			{
+				float rgba[4];
+				src.readTexel(x, y, rgba);
+				rgba[0] = 1.0f - rgba[0];
+				rgba[2] = 1.0f - rgba[2];
+				src.writeTexel(x, y, rgba);
+			}
+		}
+	}
+	std::vector<Rect> updated;
+	ConvolveSeparableDirty(src, dst, tmp, kernel, kEdits, (int)(sizeof(kEdits) / sizeof(kEdits[0])), &updated);
+	ConvolveSeparable(src, ref, refTmp, kernel);
+	CHECK(Equal(ref, dst));
+	CHECK(GetArea(updated) < (long long)kSize * kSize);
+
+	const Rect viewport(37, 80, 200, 171);
+	Image roiDst, roiTmp;
+	roiDst.init(kSize, kSize, Format_RGBA8);
+	ConvolveSeparableRect(src, roiDst, roiTmp, kernel, viewport);
+	CHECK(Equal(ref, roiDst, viewport));
+
+	const char* kSrcPath = "ConvolutionTest_src.raw";
+	const char* kDstPath = "ConvolutionTest_dst.raw";
+	{	MappedImage srcFile;
+		CHECK(srcFile.open(kSrcPath, kSize, kSize, Format_RGBA8, true));
+		if (srcFile.getImage().getData())
+		{
+			memcpy(srcFile.getImage().getData(), src.getData(), src.getSize());
+		}
+	}
+	for (int tileSize : { 64, 100, 256 })
+	{
+		MappedImage srcFile, dstFile;
+		const bool opened = srcFile.open(kSrcPath, kSize, kSize, Format_RGBA8, false) && dstFile.open(kDstPath, kSize, kSize, Format_RGBA8, true);
+		CHECK(opened);
+		if (opened)
+		{
+			ConvolveSeparableTiled(pool, srcFile, dstFile, kernel, tileSize);
+			CHECK(Equal(ref, dstFile.getImage()));
+		}
+	}
+	remove(kSrcPath);
+	remove(kDstPath);
+}
+
+struct Test
+{
+	const char* m_name;
+	const char* m_description;
+	void      (*m_func)();
+};
+
+const Test kTests[] =
+{
+	{ "kernel",     "constexpr tables vs. the runtime generators.",              Test_Kernel },
+	{ "kernelbank", "Kernel bank vs. generators, regeneration, greedy merge.",   Test_KernelBank },
+	{ "isa",        "SIMD vs. scalar per instruction set.",                      Test_Isa },
+	{ "threads",    "Multi-threaded vs. single threaded passes, exactly.",       Test_Threads },
+	{ "fft",        "FFT and low rank vs. direct 2d convolution.",               Test_Fft },
+	{ "fixed",      "Fixed point weights sum to 1 << kFixedPointBits.",          Test_Fixed },
+	{ "half",       "Half float round trip.",                                    Test_Half },
+	{ "vertical",   "Vertical vs. transposed horizontal pass, exactly.",         Test_Vertical },
+	{ "shader",     "Include resolution, define keys, binary tags.",             Test_ShaderCache },
+	{ "async",      "Coalesced requests, front only changes on acquire().",      Test_AsyncBuilder },
+	{ "roi",        "Dirty rect/ROI/tiled vs. full convolution, exactly.",       Test_Roi },
+};
+
+} // namespace
+
+int main(int _argc, char** _argv)
+{
+	if (_argc > 1 && strcmp(_argv[1], "--list") == 0)
+	{
+		for (const Test& test : kTests)
+		{
+			printf("%-16s %s\n", test.m_name, test.m_description);
+		}
+		return 0;
+	}
+
+	int runCount = 0;
+	for (const Test& test : kTests)
+	{
+		bool run = _argc == 1;
+		for (int i = 1; i < _argc && !run; ++i)
+		{
+			run = strcmp(_argv[i], test.m_name) == 0;
+		}
+		if (run)
+		{
+			const int failCount = g_failCount;
+			printf("%s: %s\n", test.m_name, test.m_description);
+			test.m_func();
+			printf("  %s\n", g_failCount == failCount ? "passed" : "FAILED");
+			++runCount;
+		}
+	}
+	if (runCount == 0)
+	{
+		fprintf(stderr, "No tests matched, use --list to see the available tests.\n");
+		return 1;
+	}
+	printf("%d checks, %d failed\n", g_checkCount, g_failCount);
+	return g_failCount == 0 ? 0 : 1;
+}